@@ -80,15 +80,14 @@ int unTmissed=0;
 
 MEM_TRACKER	*pMemTracker = NULL;
 static uint32 last_reported_allocations;
-static uint32 total_allocations;
+static ATOMIC_UINT total_allocations;
 static uint32 last_reported_secs;
-static uint32 current_allocations;
-static uint32 current_allocated;
-static uint32 max_allocations;
-static uint32 max_allocated;
+static ATOMIC_UINT current_allocations;
+static ATOMIC_UINT current_allocated;
+static ATOMIC_UINT max_allocations;
+static ATOMIC_UINT max_allocated;
 
 static void MemoryTrackerDereference(MemoryTrackerFileName_t *trk);
-static MemoryTrackerFileName_t *MemoryTrackerBuckets[MEMORY_TRACKER_BUCKETS];
 #endif	// MEM_TRACK_ON
 
 #ifdef VXWORKS
@@ -136,6 +135,76 @@ StringConcat(const char* str1, ...)
 	return string;
 }
 
+// value of each character as a hex digit, 16 if not a hex digit
+static const uint8 StringHexDigit[256] = {
+	16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+	16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+	16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+	 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 16, 16, 16, 16, 16, 16,
+	16, 10, 11, 12, 13, 14, 15, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+	16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+	16, 10, 11, 12, 13, 14, 15, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+	16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+	16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+	16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+	16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+	16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+	16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+	16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+	16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+	16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16
+};
+
+// Fast path for StringToUint64 and StringToInt64.
+// Converts the common case of a string which starts with a digit, without
+// using strtoull, its locale handling nor errno.  To avoid overflow checks,
+// at most max_dec decimal or max_hex hex digits are accepted.
+// Follows the same base rules as StringToUint64, including the retry of
+// base 0 input as base 16 when a 0 is followed by 'x'.
+// Returns FALSE if the input needs the full strtoull/strtoll handling, such
+// as leading whitespace or sign, other bases or more digits than allowed.
+static boolean
+StringToUint64Fast(uint64 *value, const char *str, char **endptr, int base,
+					unsigned max_dec, unsigned max_hex)
+{
+	const char *p = str;
+	const char *start;
+	uint64 temp = 0;
+	unsigned d;
+
+	if (base == 0 || base == 10) {
+		while ((d = (unsigned)(unsigned char)*p - '0') <= 9) {
+			if ((unsigned)(p - str) >= max_dec)
+				return FALSE;
+			temp = temp*10 + d;
+			p++;
+		}
+		if (p == str)
+			return FALSE;
+		if (base == 10 || temp != 0 || *p != 'x')
+			goto done;
+		// try again as base 16
+		p = str;
+	} else if (base != 16) {
+		return FALSE;
+	}
+	if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X') && StringHexDigit[(uint8)p[2]] < 16)
+		p += 2;
+	start = p;
+	while ((d = StringHexDigit[(uint8)*p]) < 16) {
+		if ((unsigned)(p - start) >= max_hex)
+			return FALSE;
+		temp = (temp << 4) | d;
+		p++;
+	}
+	if (p == start)
+		return FALSE;
+done:
+	*value = temp;
+	*endptr = (char*)p;
+	return TRUE;
+}
+
 // convert a string to a uint64.  Very similar to strtoull except that
 // base=0 implies base 10 or 16, but excludes base 8
 // hence allowing leading 0's for base 10.
@@ -160,6 +229,9 @@ FSTATUS StringToUint64(uint64 *value, const char* str, char **endptr, int base,
 
 	if (! str || ! value)
 		return FINVALID_PARAMETER;
+	// up to 19 decimal or 16 hex digits can't overflow
+	if (StringToUint64Fast(&temp, str, &end, base, 19, 16))
+		goto converted;
 	errno = 0;
 	temp = strtoull(str, &end, base?base:10);
 	if ( ! base && ! (temp == IB_UINT64_MAX && errno)
@@ -175,6 +247,7 @@ FSTATUS StringToUint64(uint64 *value, const char* str, char **endptr, int base,
 			return FERROR;
 	}
 
+converted:
 	// skip whitespace
 	if (end && skip_trail_whitespace) {
 		while (isspace(*end)) {
@@ -255,6 +328,9 @@ FSTATUS StringToInt64(int64 *value, const char* str, char **endptr, int base, bo
 
 	if (! str || ! value)
 		return FINVALID_PARAMETER;
+	// up to 18 decimal or 15 hex digits can't overflow
+	if (StringToUint64Fast((uint64*)&temp, str, &end, base, 18, 15))
+		goto converted;
 	errno = 0;
 	temp = strtoll(str, &end, base?base:10);
 	if ( ! base && ! ((temp == IB_INT64_MAX || temp == IB_INT64_MIN) && errno)
@@ -270,6 +346,7 @@ FSTATUS StringToInt64(int64 *value, const char* str, char **endptr, int base, bo
 			return FERROR;
 	}
 
+converted:
 	// skip whitespace
 	if (end && skip_trail_whitespace) {
 		while (isspace(*end)) {
@@ -739,6 +816,175 @@ FSTATUS StringToTuple(uint32 *select, uint8 *comparator, uint64 *argument, char*
 #endif
 
 #if defined(MEM_TRACK_ON)
+//
+// Select the shard of a user pointer and the home slot of the pointer in the
+// shard's index. Both come from a multiplicative hash of the pointer, the
+// shard from its top bits.
+//
+static __inline uint64
+MemoryTrackerHash( IN const void *pMem )
+{
+	return (uint64)(uintn)pMem * 0x9E3779B97F4A7C15ULL;
+}
+
+static __inline MEM_TRACKER_SHARD *
+MemoryTrackerShard( IN const void *pMem )
+{
+	return &pMemTracker->Shards[MemoryTrackerHash(pMem) >> MEM_TRACKER_SHARD_SHIFT];
+}
+
+static __inline uint32
+MemoryTrackerHomeSlot(
+		IN MEM_TRACKER_SHARD *pShard,
+		IN const void *pMem )
+{
+	return (uint32)(MemoryTrackerHash(pMem) >> 20) & (pShard->IndexSize - 1);
+}
+
+/* find the header of an allocation which is not being deallocated */
+/* must be called with pShard->Lock held */
+static MEM_ALLOC_HDR *
+MemoryTrackerIndexFind(
+		IN MEM_TRACKER_SHARD *pShard,
+		IN const void *pMem )
+{
+	uint32 mask = pShard->IndexSize - 1;
+	uint32 slot = MemoryTrackerHomeSlot(pShard, pMem);
+	MEM_ALLOC_HDR *pHdr;
+
+	// a freed allocation still being displayed may share its address with
+	// a newer one, the newer one is the one we want
+	for ( ; (pHdr = pShard->Index[slot]) != NULL; slot = (slot + 1) & mask) {
+		if (pHdr->ListItem.pObject == pMem && ! pHdr->deallocate)
+			return pHdr;
+	}
+	return NULL;
+}
+
+/* double the size of the index, FALSE if out of memory */
+/* must be called with pShard->Lock held */
+static boolean
+MemoryTrackerIndexGrow(
+		IN MEM_TRACKER_SHARD *pShard )
+{
+	MEM_ALLOC_HDR **oldIndex = pShard->Index;
+	uint32 oldSize = pShard->IndexSize;
+	uint32 newSize = oldSize * 2;
+	MEM_ALLOC_HDR **newIndex;
+	uint32 i, slot;
+
+	newIndex = (MEM_ALLOC_HDR**)MEMORY_ALLOCATE_PRIV(
+					newSize * sizeof(MEM_ALLOC_HDR*), IBA_MEM_FLAG_LEGACY, TRK_TAG );
+	if (! newIndex)
+		return FALSE;
+	MemoryClear(newIndex, newSize * sizeof(MEM_ALLOC_HDR*));
+
+	pShard->Index = newIndex;
+	pShard->IndexSize = newSize;
+	for (i = 0; i < oldSize; i++) {
+		if (! oldIndex[i])
+			continue;
+		slot = MemoryTrackerHomeSlot(pShard, oldIndex[i]->ListItem.pObject);
+		while (newIndex[slot])
+			slot = (slot + 1) & (newSize - 1);
+		newIndex[slot] = oldIndex[i];
+	}
+	MEMORY_DEALLOCATE_PRIV( oldIndex );
+	return TRUE;
+}
+
+/* add a header to the index, FALSE if it is full */
+/* must be called with pShard->Lock held */
+static boolean
+MemoryTrackerIndexInsert(
+		IN MEM_TRACKER_SHARD *pShard,
+		IN MEM_ALLOC_HDR	*pHdr )
+{
+	uint32 slot;
+
+	// keep the load factor at or below 1/2 so probe sequences stay short.
+	// If we can't grow, keep filling, but always leave an empty slot to
+	// terminate the probes
+	if ((pShard->IndexCount + 1) * 2 > pShard->IndexSize
+			&& ! MemoryTrackerIndexGrow(pShard)
+			&& pShard->IndexCount + 1 >= pShard->IndexSize)
+		return FALSE;
+
+	slot = MemoryTrackerHomeSlot(pShard, pHdr->ListItem.pObject);
+	while (pShard->Index[slot])
+		slot = (slot + 1) & (pShard->IndexSize - 1);
+	pShard->Index[slot] = pHdr;
+	pShard->IndexCount++;
+	return TRUE;
+}
+
+static boolean
+MemoryTrackerListMatch(
+		IN LIST_ITEM *pListItem,
+		IN void *Context )
+{
+	MEM_ALLOC_HDR *pHdr = PARENT_STRUCT( pListItem, MEM_ALLOC_HDR, ListItem );
+
+	return ! pHdr->indexed && pListItem->pObject == Context && ! pHdr->deallocate;
+}
+
+/* find the header of an allocation the index could not grow for */
+/* must be called with pShard->Lock held */
+static MEM_ALLOC_HDR *
+MemoryTrackerListFind(
+		IN MEM_TRACKER_SHARD *pShard,
+		IN void *pMem )
+{
+	LIST_ITEM *pListItem;
+
+	if (! pShard->Unindexed)
+		return NULL;
+	pListItem = QListFindFromTail( &pShard->AllocList, MemoryTrackerListMatch, pMem );
+	return pListItem ? PARENT_STRUCT( pListItem, MEM_ALLOC_HDR, ListItem ) : NULL;
+}
+
+/* remove a header from the index */
+/* must be called with pShard->Lock held */
+static void
+MemoryTrackerIndexRemove(
+		IN MEM_TRACKER_SHARD *pShard,
+		IN MEM_ALLOC_HDR	*pHdr )
+{
+	uint32 mask = pShard->IndexSize - 1;
+	uint32 i = MemoryTrackerHomeSlot(pShard, pHdr->ListItem.pObject);
+	uint32 j, home;
+
+	for ( ; pShard->Index[i] != pHdr; i = (i + 1) & mask) {
+		if (! pShard->Index[i])
+			return;	// shouldn't happen
+	}
+
+	// shift back the following entries of the probe sequence which can't
+	// be found anymore once slot i is empty
+	for (j = (i + 1) & mask; pShard->Index[j]; j = (j + 1) & mask) {
+		home = MemoryTrackerHomeSlot(pShard, pShard->Index[j]->ListItem.pObject);
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			pShard->Index[i] = pShard->Index[j];
+			i = j;
+		}
+	}
+	pShard->Index[i] = NULL;
+	pShard->IndexCount--;
+}
+
+/* raise a maximum to value */
+static __inline void
+MemoryTrackerUpdateMax(
+		IN ATOMIC_UINT *pMax,
+		IN uint32 value )
+{
+	uint32 max;
+
+	while ((max = AtomicRead(pMax)) < value
+			&& ! AtomicCompareStore(pMax, max, value))
+		;
+}
+
 //
 // Destroy the memory tracker object.
 //
@@ -746,6 +992,9 @@ static __inline void
 DestroyMemTracker( void )
 {
 	MEM_TRACKER *tmp;
+	MEM_TRACKER_SHARD *pShard;
+	int i;
+
 	if( !pMemTracker )
 		return;
 
@@ -753,9 +1002,15 @@ DestroyMemTracker( void )
 	pMemTracker = NULL; /* so no one uses it while we're destroying it */
 
 	// Destory all objects in the memory tracker object.
-	QListDestroy( &tmp->FreeHrdList );
-	SpinLockDestroy( &tmp->Lock );
-	QListDestroy( &tmp->AllocList );
+	for (i = 0; i < MEM_TRACKER_SHARDS; i++) {
+		pShard = &tmp->Shards[i];
+		QListDestroy( &pShard->FreeHrdList );
+		SpinLockDestroy( &pShard->Lock );
+		QListDestroy( &pShard->AllocList );
+		if (pShard->Index)
+			MEMORY_DEALLOCATE_PRIV( pShard->Index );
+	}
+	SpinLockDestroy( &tmp->UntrackedLock );
 
 	// Free the memory allocated for the memory tracker object.
 	MEMORY_DEALLOCATE_PRIV( tmp );
@@ -768,6 +1023,8 @@ static __inline boolean
 CreateMemTracker( void )
 {
 	MEM_TRACKER *tmp;
+	MEM_TRACKER_SHARD *pShard;
+	int i;
 
 	if( pMemTracker )
 		return TRUE;
@@ -777,39 +1034,35 @@ CreateMemTracker( void )
 
 	if( !tmp )
 		return FALSE;
+	MemoryClear(tmp, sizeof(MEM_TRACKER));
 
 	// Pre-initialize all objects in the memory tracker object.
-	QListInitState( &tmp->AllocList );
-	SpinLockInitState( &tmp->Lock );
-	QListInitState( &tmp->FreeHrdList );
-
-	// Initialize the list.
-	if( !QListInit( &tmp->AllocList ) )
-	{
-		/* global isn't initialize, don't call Destroy func; do the clean up */
-		MEMORY_DEALLOCATE_PRIV( tmp );
-		return FALSE;
+	for (i = 0; i < MEM_TRACKER_SHARDS; i++) {
+		pShard = &tmp->Shards[i];
+		QListInitState( &pShard->AllocList );
+		SpinLockInitState( &pShard->Lock );
+		QListInitState( &pShard->FreeHrdList );
 	}
-
-	// Initialize the spin lock to protect list operations.
-	if( !SpinLockInit( &tmp->Lock ) )
-	{
-		/* global isn't initialize, don't call Destroy func; do the clean up */
-		QListDestroy( &tmp->AllocList );
-		SpinLockDestroy( &tmp->Lock );
-		MEMORY_DEALLOCATE_PRIV( tmp );
-		return FALSE;
-	}
-
-	// Initialize the free list.
-	if( !QListInit( &tmp->FreeHrdList ) )
-	{
-		/* global isn't initialize, don't call Destroy func; do the clean up */
-		QListDestroy( &tmp->AllocList );
-		SpinLockDestroy( &tmp->Lock );
-		MEMORY_DEALLOCATE_PRIV( tmp );
-		return FALSE;
+	SpinLockInitState( &tmp->UntrackedLock );
+
+	for (i = 0; i < MEM_TRACKER_SHARDS; i++) {
+		pShard = &tmp->Shards[i];
+		// Initialize the lists, the spin lock to protect list operations
+		// and the index.
+		if( !QListInit( &pShard->AllocList )
+				|| !SpinLockInit( &pShard->Lock )
+				|| !QListInit( &pShard->FreeHrdList ) )
+			goto fail;
+		pShard->Index = (MEM_ALLOC_HDR**)MEMORY_ALLOCATE_PRIV(
+					MEM_TRACKER_INDEX_SIZE * sizeof(MEM_ALLOC_HDR*),
+					IBA_MEM_FLAG_LEGACY, TRK_TAG );
+		if( !pShard->Index )
+			goto fail;
+		MemoryClear(pShard->Index, MEM_TRACKER_INDEX_SIZE * sizeof(MEM_ALLOC_HDR*));
+		pShard->IndexSize = MEM_TRACKER_INDEX_SIZE;
 	}
+	if( !SpinLockInit( &tmp->UntrackedLock ) )
+		goto fail;
 
 //	MsgOut( "\n\n\n*** Memory tracker object address = %p ***\n\n\n", tmp );
 	MsgOut( "\n*** Memory tracker enabled ***\n" );
@@ -818,6 +1071,20 @@ CreateMemTracker( void )
 	pMemTracker = tmp;
 
 	return TRUE;
+
+fail:
+	/* global isn't initialize, don't call Destroy func; do the clean up */
+	for (i = 0; i < MEM_TRACKER_SHARDS; i++) {
+		pShard = &tmp->Shards[i];
+		QListDestroy( &pShard->FreeHrdList );
+		SpinLockDestroy( &pShard->Lock );
+		QListDestroy( &pShard->AllocList );
+		if (pShard->Index)
+			MEMORY_DEALLOCATE_PRIV( pShard->Index );
+	}
+	SpinLockDestroy( &tmp->UntrackedLock );
+	MEMORY_DEALLOCATE_PRIV( tmp );
+	return FALSE;
 }
 #endif
 
@@ -844,35 +1111,43 @@ MemoryTrackStop( void )
 {
 #if defined(MEM_TRACK_ON)
 	LIST_ITEM	*pListItem;
+	MEM_TRACKER_SHARD *pShard;
+	uint32		count = 0;
+	int			i;
 
 	if( !pMemTracker )
 		return;
 
-	if( QListCount( &pMemTracker->AllocList ) )
+	for (i = 0; i < MEM_TRACKER_SHARDS; i++)
+		count += QListCount( &pMemTracker->Shards[i].AllocList );
+	if( count )
 	{
 		// There are still items in the list.  Print them out.
 		MemoryDisplayUsage(1, 0, 0);
 	} else {
 		MsgOut( "\n*** Memory tracker stopped, no leaks detected ***\n" );
 		MsgOut("IbAccess max allocations=%u bytes=%u\n",
-						max_allocations, max_allocated);
+						AtomicRead(&max_allocations), AtomicRead(&max_allocated));
 	}
 
 	// Free all allocated headers.
-	SpinLockAcquire( &pMemTracker->Lock );
-	while( (pListItem = QListRemoveHead( &pMemTracker->AllocList )) != NULL )
-	{
-		SpinLockRelease( &pMemTracker->Lock );
-		MEMORY_DEALLOCATE_PRIV( PARENT_STRUCT( pListItem, MEM_ALLOC_HDR, ListItem ) );
-		SpinLockAcquire( &pMemTracker->Lock );
-	}
-	while( (pListItem = QListRemoveHead( &pMemTracker->FreeHrdList )) != NULL )
-	{
-		SpinLockRelease( &pMemTracker->Lock );
-		MEMORY_DEALLOCATE_PRIV( PARENT_STRUCT( pListItem, MEM_ALLOC_HDR, ListItem ) );
-		SpinLockAcquire( &pMemTracker->Lock );
+	for (i = 0; i < MEM_TRACKER_SHARDS; i++) {
+		pShard = &pMemTracker->Shards[i];
+		SpinLockAcquire( &pShard->Lock );
+		while( (pListItem = QListRemoveHead( &pShard->AllocList )) != NULL )
+		{
+			SpinLockRelease( &pShard->Lock );
+			MEMORY_DEALLOCATE_PRIV( PARENT_STRUCT( pListItem, MEM_ALLOC_HDR, ListItem ) );
+			SpinLockAcquire( &pShard->Lock );
+		}
+		while( (pListItem = QListRemoveHead( &pShard->FreeHrdList )) != NULL )
+		{
+			SpinLockRelease( &pShard->Lock );
+			MEMORY_DEALLOCATE_PRIV( PARENT_STRUCT( pListItem, MEM_ALLOC_HDR, ListItem ) );
+			SpinLockAcquire( &pShard->Lock );
+		}
+		SpinLockRelease( &pShard->Lock );
 	}
-	SpinLockRelease( &pMemTracker->Lock );
 
 	DestroyMemTracker();
 #endif	// MEM_TRACK_ON
@@ -929,21 +1204,26 @@ MemoryTrackerCheckOverrun(
 }
 
 /* unlink a header from the allocated list */
-/* must be called with pMemTracker->Lock held */
+/* must be called with pShard->Lock held */
 static void
 MemoryTrackerUnlink(
+		IN MEM_TRACKER_SHARD *pShard,
 		IN MEM_ALLOC_HDR	*pHdr )
 {
-	// Remove the item from the list.
-	QListRemoveItem( &pMemTracker->AllocList, &pHdr->ListItem );
+	// Remove the item from the list and the index.
+	QListRemoveItem( &pShard->AllocList, &pHdr->ListItem );
+	if (pHdr->indexed)
+		MemoryTrackerIndexRemove( pShard, pHdr );
+	else
+		pShard->Unindexed--;
 
-	--current_allocations;
-	current_allocated -= pHdr->Bytes;
+	AtomicDecrementVoid(&current_allocations);
+	AtomicSubtractVoid(&current_allocated, pHdr->Bytes);
 	if (pHdr->reported)
 		MemoryTrackerShow("", pHdr, " FREED");
 	MemoryTrackerDereference(pHdr->trk);
 	// Return the header to the free header list.
-	QListInsertHead( &pMemTracker->FreeHrdList, &pHdr->ListItem );
+	QListInsertHead( &pShard->FreeHrdList, &pHdr->ListItem );
 }
 #endif	// MEM_TRACK_ON
 
@@ -957,10 +1237,14 @@ MemoryDisplayUsage( int method, uint32 minSize, uint32 minTick )
 	uint32 allocated = 0;
 	uint32 allocations = 0;
 	MEM_ALLOC_HDR	*pHdr;
-	LIST_ITEM *item, *next, *tail, *head;
+	MEM_TRACKER_SHARD *pShard;
+	LIST_ITEM *item, *next;
+	LIST_ITEM *items[MEM_TRACKER_SHARDS], *tails[MEM_TRACKER_SHARDS];
 	unsigned int allocations_per_sec = 0;
 	uint32 currentTime;
+	uint32 total;
 	boolean all = (method == 1);
+	int i, shard;
 
 	if( !pMemTracker ) {
 		MsgOut( "*** IbAccess Memory Tracking is disabled ***\n" );
@@ -971,58 +1255,77 @@ MemoryDisplayUsage( int method, uint32 minSize, uint32 minTick )
 	 * displaying flag, so other allocates/frees will not affect them
 	 * This gives us a snapshot while permitting the system to run
 	 * while we perform the output (the output itself may use memory allocate)
-	 * However, our report loop below must stay within head/tail
+	 * However, our report loop below must stay within head/tail of each shard
 	 */
-	SpinLockAcquire( &pMemTracker->Lock );
-	tail = QListTail(&pMemTracker->AllocList);
-	head = QListHead(&pMemTracker->AllocList);
-	for(item = head; item != NULL; item = QListNext(&pMemTracker->AllocList, item)) {
-		pHdr = PARENT_STRUCT( item, MEM_ALLOC_HDR, ListItem );
-		pHdr->displaying = TRUE;
+	for (i = 0; i < MEM_TRACKER_SHARDS; i++) {
+		pShard = &pMemTracker->Shards[i];
+		SpinLockAcquire( &pShard->Lock );
+		tails[i] = QListTail(&pShard->AllocList);
+		items[i] = QListHead(&pShard->AllocList);
+		for(item = items[i]; item != NULL; item = QListNext(&pShard->AllocList, item)) {
+			pHdr = PARENT_STRUCT( item, MEM_ALLOC_HDR, ListItem );
+			pHdr->displaying = TRUE;
+		}
+		SpinLockRelease (&pShard->Lock);
 	}
-	SpinLockRelease (&pMemTracker->Lock);
 	
 	MsgOut( "*** IbAccess Memory Usage %s minSize=%d minTick=%d ***\n", all?"All":"Unreported", minSize, minTick );
 
-	if (head && tail) {
-		item = head;
-		do {
-			next = QListNext(&pMemTracker->AllocList, item);
-			pHdr = PARENT_STRUCT( item, MEM_ALLOC_HDR, ListItem );
-	
-	#ifdef MEM_TRACK_FTR
-			// Check that the user did not overrun his memory allocation.
-			if (pHdr->deallocate == FALSE) {
-				MemoryTrackerCheckOverrun(pHdr);
-			}
-	#endif	// MEM_TRACK_FTR
-			if ((pHdr->Bytes >= minSize) && (pHdr->tick >= minTick) && (all || (pHdr->reported == 0))) {
-				// method 2 just marks all current allocations as reported, without actually reporting them
-				// method 3 displays the items without changing their reported state (allows us to avoid the FREED messages)
-				if (method != 2)
-					MemoryTrackerShow("", pHdr, "");
-				if (method != 3)
-					pHdr->reported = 1;
-			}
-			allocated += pHdr->Bytes;
-			++allocations;
-			SpinLockAcquire( &pMemTracker->Lock );
-			pHdr->displaying = FALSE;
-			if (pHdr->deallocate) {
-				MemoryTrackerUnlink(pHdr);
-			}
-			SpinLockRelease (&pMemTracker->Lock);
-			item = next;
-		} while (&pHdr->ListItem != tail && item != NULL);
+	/* each shard's list is in allocation order, so merge them to report
+	 * all allocations in the order they were made
+	 */
+	total = AtomicRead(&total_allocations);
+	for (;;) {
+		shard = -1;
+		for (i = 0; i < MEM_TRACKER_SHARDS; i++) {
+			if (items[i] == NULL)
+				continue;
+			pHdr = PARENT_STRUCT( items[i], MEM_ALLOC_HDR, ListItem );
+			// sequence numbers may wrap, compare their age instead
+			if (shard < 0 || total - pHdr->Seq >
+					total - PARENT_STRUCT( items[shard], MEM_ALLOC_HDR, ListItem )->Seq)
+				shard = i;
+		}
+		if (shard < 0)
+			break;
+
+		pShard = &pMemTracker->Shards[shard];
+		item = items[shard];
+		next = QListNext(&pShard->AllocList, item);
+		pHdr = PARENT_STRUCT( item, MEM_ALLOC_HDR, ListItem );
+
+#ifdef MEM_TRACK_FTR
+		// Check that the user did not overrun his memory allocation.
+		if (pHdr->deallocate == FALSE) {
+			MemoryTrackerCheckOverrun(pHdr);
+		}
+#endif	// MEM_TRACK_FTR
+		if ((pHdr->Bytes >= minSize) && (pHdr->tick >= minTick) && (all || (pHdr->reported == 0))) {
+			// method 2 just marks all current allocations as reported, without actually reporting them
+			// method 3 displays the items without changing their reported state (allows us to avoid the FREED messages)
+			if (method != 2)
+				MemoryTrackerShow("", pHdr, "");
+			if (method != 3)
+				pHdr->reported = 1;
+		}
+		allocated += pHdr->Bytes;
+		++allocations;
+		SpinLockAcquire( &pShard->Lock );
+		pHdr->displaying = FALSE;
+		if (pHdr->deallocate) {
+			MemoryTrackerUnlink(pShard, pHdr);
+		}
+		SpinLockRelease (&pShard->Lock);
+		items[shard] = (item == tails[shard]) ? NULL : next;
 	}
 	currentTime = GetTimeStampSec();
 	if (last_reported_secs && currentTime != last_reported_secs) {
-		allocations_per_sec = (total_allocations - last_reported_allocations) / (currentTime - last_reported_secs);
+		allocations_per_sec = (AtomicRead(&total_allocations) - last_reported_allocations) / (currentTime - last_reported_secs);
 	}
 	last_reported_secs = currentTime;
-	last_reported_allocations = total_allocations;
+	last_reported_allocations = AtomicRead(&total_allocations);
 	MsgOut("IbAccess current allocations=%u bytes=%u max allocations=%u bytes=%u p/s=%d\n",
-			allocations, allocated, max_allocations, max_allocated, allocations_per_sec);
+			allocations, allocated, AtomicRead(&max_allocations), AtomicRead(&max_allocated), allocations_per_sec);
 #else
 MemoryDisplayUsage( int method _UNUSED_, uint32 minSize _UNUSED_, uint32 minTick _UNUSED_ )
 {
@@ -1038,7 +1341,7 @@ unsigned int hashValue(const char *key) {
 	return nHash;
 }
 
-static MemoryTrackerFileName_t *MemoryTrackerFileNameLookup(const char *filename, unsigned int *hash) {
+static MemoryTrackerFileName_t *MemoryTrackerFileNameLookup(MEM_TRACKER_SHARD *pShard, const char *filename, unsigned int *hash) {
 	unsigned int hashVal;
 	MemoryTrackerFileName_t *trk;
 	int len = strlen(filename);
@@ -1046,7 +1349,7 @@ static MemoryTrackerFileName_t *MemoryTrackerFileNameLookup(const char *filename
 	hashVal = hashValue(filename) % MEMORY_TRACKER_BUCKETS;
 	*hash = hashVal;
 
-	for(trk = MemoryTrackerBuckets[hashVal]; trk != NULL; trk = trk->next) {
+	for(trk = pShard->Buckets[hashVal]; trk != NULL; trk = trk->next) {
 		if (trk->filenameLen == len) {
 			if (memcmp(&trk->filename[0], filename, len) == 0) {
 				return trk;
@@ -1056,7 +1359,7 @@ static MemoryTrackerFileName_t *MemoryTrackerFileNameLookup(const char *filename
 	return NULL;
 }
 
-static MemoryTrackerFileName_t *MemoryTrackerFileNameAlloc(const char *filename, int filenameLen, unsigned int hash) {
+static MemoryTrackerFileName_t *MemoryTrackerFileNameAlloc(MEM_TRACKER_SHARD *pShard, const char *filename, int filenameLen, unsigned int hash) {
 	MemoryTrackerFileName_t *trk;
 
 	trk = (MemoryTrackerFileName_t*)MEMORY_ALLOCATE_PRIV(
@@ -1066,21 +1369,22 @@ static MemoryTrackerFileName_t *MemoryTrackerFileNameAlloc(const char *filename,
 		trk->referenceCount = 1;
 		trk->filenameLen = filenameLen;
 		memcpy(&trk->filename, filename, filenameLen + 1);
-		trk->next = MemoryTrackerBuckets[hash];
-		MemoryTrackerBuckets[hash] = trk;
+		trk->next = pShard->Buckets[hash];
+		pShard->Buckets[hash] = trk;
 		// MsgOut("Added len=%d name=(%p)%s\n", filenameLen, trk->filename, trk->filename);
 	}
 	return trk;
 }
 
-static MemoryTrackerFileName_t *MemoryTrackerReference(const char *filename) {
+/* must be called with pShard->Lock held */
+static MemoryTrackerFileName_t *MemoryTrackerReference(MEM_TRACKER_SHARD *pShard, const char *filename) {
 	MemoryTrackerFileName_t *trk;
 	int len = strlen(filename);
 	unsigned int hash;
 
-	trk = MemoryTrackerFileNameLookup(filename, &hash);
+	trk = MemoryTrackerFileNameLookup(pShard, filename, &hash);
 	if (trk == NULL) {
-		trk = MemoryTrackerFileNameAlloc(filename, len, hash);
+		trk = MemoryTrackerFileNameAlloc(pShard, filename, len, hash);
 		if (trk == NULL)
 			return NULL;
 	} else {
@@ -1108,6 +1412,7 @@ MemoryTrackerTrackAllocation(
 {
 	MEM_ALLOC_HDR	*pHdr;
 	LIST_ITEM		*pListItem;
+	MEM_TRACKER_SHARD *pShard;
 
 #ifdef MEM_TRACK_FTR
 	if (pFtr)
@@ -1127,11 +1432,12 @@ MemoryTrackerTrackAllocation(
 		}
 		return;
 	}
+	pShard = MemoryTrackerShard(pMem);
 
 	// Get a header from the free header list.
-	SpinLockAcquire( &pMemTracker->Lock );
-	pListItem = QListRemoveHead( &pMemTracker->FreeHrdList );
-	SpinLockRelease( &pMemTracker->Lock );
+	SpinLockAcquire( &pShard->Lock );
+	pListItem = QListRemoveHead( &pShard->FreeHrdList );
+	SpinLockRelease( &pShard->Lock );
 
 	if( pListItem )
 	{
@@ -1168,17 +1474,22 @@ MemoryTrackerTrackAllocation(
 	pHdr->pFtr = NULL;
 #endif  // MEM_TRACK_FTR
 
-	SpinLockAcquire( &pMemTracker->Lock );
-	pHdr->trk = MemoryTrackerReference(pFileName);
-	++total_allocations;
-	if (++current_allocations > max_allocations)
-		max_allocations = current_allocations;
-	if ((current_allocated += pHdr->Bytes) > max_allocated)
-		max_allocated = current_allocated;
+	SpinLockAcquire( &pShard->Lock );
+	pHdr->indexed = MemoryTrackerIndexInsert(pShard, pHdr);
+	if (! pHdr->indexed) {
+		// We failed to grow the index, the free will have to search the
+		// allocation list for this one
+		pShard->Unindexed++;
+	}
+	pHdr->trk = MemoryTrackerReference(pShard, pFileName);
+	// taken with the lock held, so the shard's list stays in Seq order
+	pHdr->Seq = AtomicIncrement(&total_allocations);
+	MemoryTrackerUpdateMax(&max_allocations, AtomicIncrement(&current_allocations));
+	MemoryTrackerUpdateMax(&max_allocated, AtomicAdd(&current_allocated, pHdr->Bytes));
 
 	// Insert the header structure into our allocation list.
-	QListInsertTail( &pMemTracker->AllocList, &pHdr->ListItem );
-	SpinLockRelease( &pMemTracker->Lock );
+	QListInsertTail( &pShard->AllocList, &pHdr->ListItem );
+	SpinLockRelease( &pShard->Lock );
 
 	return;
 }
@@ -1188,23 +1499,22 @@ MemoryTrackerTrackDeallocate(
 	IN void *pMemory )
 {
 	MEM_ALLOC_HDR	*pHdr;
-	LIST_ITEM		*pListItem;
+	MEM_TRACKER_SHARD *pShard;
 	int				result = 0;
 
 	if( pMemTracker )
 	{
-		SpinLockAcquire( &pMemTracker->Lock );
+		pShard = MemoryTrackerShard(pMemory);
+		SpinLockAcquire( &pShard->Lock );
 
-		// Removes an item from the allocation tracking list given a pointer
-		// To the user's data and returns the pointer to header referencing the
-		// allocated memory block.
-		pListItem = 
-			QListFindFromTail( &pMemTracker->AllocList, NULL, pMemory );
+		// Finds the header referencing the allocated memory block given a
+		// pointer to the user's data.
+		pHdr = MemoryTrackerIndexFind( pShard, pMemory );
+		if (! pHdr)
+			pHdr = MemoryTrackerListFind( pShard, pMemory );
 
-		if( pListItem )
+		if( pHdr )
 		{
-			// Get the pointer to the header.
-			pHdr = PARENT_STRUCT( pListItem, MEM_ALLOC_HDR, ListItem );
 #ifdef MEM_TRACK_FTR
 			MemoryTrackerCheckOverrun(pHdr);
 #endif	// MEM_TRACK_FTR
@@ -1213,10 +1523,14 @@ MemoryTrackerTrackDeallocate(
 				pHdr->deallocate = TRUE;
 			} else {
 				// Remove the item from the list.
-				MemoryTrackerUnlink(pHdr);
+				MemoryTrackerUnlink(pShard, pHdr);
 			}
+			SpinLockRelease( &pShard->Lock );
 		} else {
 			int ii, found; 
+
+			SpinLockRelease( &pShard->Lock );
+			SpinLockAcquire( &pMemTracker->UntrackedLock );
 			for (ii=0, found=0; ii<unTindex; ii++) {
 				if (unTAddr[ii] == pMemory) {
 					int nextii = ii+1;
@@ -1233,6 +1547,7 @@ MemoryTrackerTrackDeallocate(
 					break;
 				}
 			}
+			SpinLockRelease( &pMemTracker->UntrackedLock );
 			if (!found) {
 				result = 1;
 #if defined(VXWORKS)
@@ -1244,7 +1559,6 @@ MemoryTrackerTrackDeallocate(
 #endif
 			}
 		}
-		SpinLockRelease( &pMemTracker->Lock );
 	}
 	return result;
 }
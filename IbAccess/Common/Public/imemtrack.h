@@ -52,15 +52,40 @@ typedef struct MemoryTrackerFileName {
 
 #define MEMORY_TRACKER_BUCKETS 53
 
-/* Structure to track memory allocations. */
-typedef struct _MEM_TRACKER
+/* Number of shards, selected by address bits of the user's pointer.
+ * Must be a power of 2 and match MEM_TRACKER_SHARD_SHIFT. */
+#define MEM_TRACKER_SHARDS		16
+#define MEM_TRACKER_SHARD_SHIFT	60	/* 64 - log2(MEM_TRACKER_SHARDS) */
+/* Initial number of slots in a shard's index, must be a power of 2. */
+#define MEM_TRACKER_INDEX_SIZE	1024
+
+struct _MEM_ALLOC_HDR;
+
+/* One shard of the allocations being tracked. */
+typedef struct _MEM_TRACKER_SHARD
 {
-	/* List for tracking memory allocations. */
+	/* List for tracking memory allocations, in allocation order. */
 	QUICK_LIST	AllocList;
 	/* Lock for synchronization. */
 	SPIN_LOCK	Lock;
 	/* List to manage free headers. */
 	QUICK_LIST	FreeHrdList;
+	/* Open addressed hash of the AllocList headers, keyed by user pointer. */
+	struct _MEM_ALLOC_HDR **Index;
+	uint32		IndexSize;
+	uint32		IndexCount;
+	/* AllocList headers not in Index because it could not grow. */
+	uint32		Unindexed;
+	/* File names referenced by the headers of this shard. */
+	MemoryTrackerFileName_t *Buckets[MEMORY_TRACKER_BUCKETS];
+} MEM_TRACKER_SHARD;
+
+/* Structure to track memory allocations. */
+typedef struct _MEM_TRACKER
+{
+	MEM_TRACKER_SHARD	Shards[MEM_TRACKER_SHARDS];
+	/* Lock for the allocations made before the tracker was started. */
+	SPIN_LOCK	UntrackedLock;
 
 } MEM_TRACKER;
 
@@ -79,8 +104,10 @@ typedef struct _MEM_ALLOC_HDR
 	uint32				Bytes;
 	int32				reported;
 	uint32				tick;
+	uint32				Seq;	/* allocation order */
 	volatile boolean displaying;
 	volatile boolean deallocate;
+	boolean				indexed;	/* FALSE if only found via AllocList */
 	MEM_ALLOC_FTR		*pFtr;
 } MEM_ALLOC_HDR;
 
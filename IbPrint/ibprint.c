@@ -70,6 +70,64 @@ void PrintDestInitCallback(PrintDest_t *dest, PrintCallbackFunc_t func, void *co
 	dest->u.callback.context = context;
 }
 
+void PrintDestInitMemory(PrintDest_t *dest, FILE *file, size_t initial)
+{
+	dest->type = PL_MEMORY;
+	dest->u.mem.length = initial ? initial : 4096;
+	dest->u.mem.offset = 0;
+	dest->u.mem.file = file;
+	dest->u.mem.overflow = FALSE;
+	dest->u.mem.buffer = malloc(dest->u.mem.length);
+	if (! dest->u.mem.buffer)
+		dest->u.mem.length = 0;
+}
+
+int PrintDestFlush(PrintDest_t *dest)
+{
+	int ret = 0;
+
+	switch (dest->type) {
+	case PL_FILE:
+		return fflush(dest->u.file);
+	case PL_MEMORY:
+		if (dest->u.mem.file && dest->u.mem.offset) {
+			if (fwrite(dest->u.mem.buffer, 1, dest->u.mem.offset,
+						dest->u.mem.file) != dest->u.mem.offset)
+				ret = EOF;
+			dest->u.mem.offset = 0;
+		}
+		return ret;
+	default:
+		return 0;
+	}
+}
+
+void PrintDestFree(PrintDest_t *dest)
+{
+	if (dest->type != PL_MEMORY)
+		return;
+	free(dest->u.mem.buffer);
+	dest->u.mem.buffer = NULL;
+	dest->u.mem.length = 0;
+	dest->u.mem.offset = 0;
+}
+
+// make room for at least need more bytes in a PL_MEMORY buffer
+static boolean PrintMemGrow(PrintMem_t *mem, size_t need)
+{
+	size_t length = mem->length ? mem->length : 4096;
+	char *buffer;
+
+	while (length - mem->offset < need)
+		length *= 2;
+	buffer = realloc(mem->buffer, length);
+	if (! buffer)
+		return FALSE;
+	mem->buffer = buffer;
+	mem->length = length;
+	return TRUE;
+}
+
 #ifdef LINUX
 void PrintDestInitSyslog(PrintDest_t *dest, int priority)
 {
@@ -109,6 +167,30 @@ void PrintFunc(PrintDest_t *dest, const char *format, ...)
 					   avail, format, args);
 		}
 		break;
+	case PL_MEMORY:
+		{
+		size_t avail = dest->u.mem.length - dest->u.mem.offset;
+		va_list args2;
+		int len;
+
+		va_copy(args2, args);
+		len = vsnprintf(avail ? &dest->u.mem.buffer[dest->u.mem.offset] : NULL,
+					avail, format, args);
+		if (len >= 0 && (size_t)len >= avail) {
+			// didn't fit, grow and format again
+			if (PrintMemGrow(&dest->u.mem, (size_t)len + 1))
+				(void)vsnprintf(&dest->u.mem.buffer[dest->u.mem.offset],
+					   (size_t)len + 1, format, args2);
+			else
+				len = -1;
+		}
+		va_end(args2);
+		if (len >= 0)
+			dest->u.mem.offset += len;
+		else
+			dest->u.mem.overflow = TRUE;
+		}
+		break;
 	case PL_CALLBACK:
 		{
 		char buf[140];
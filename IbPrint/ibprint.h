@@ -48,6 +48,7 @@ typedef enum {
 	PL_LOG,			// output to embedded log
 	// TBD add VxWorks sysprint or simply print?
 #endif
+	PL_MEMORY,		// output to a growing buffer, written out by PrintDestFlush
 } PrintType_t;
 
 typedef struct PrintBuf_s {
@@ -56,6 +57,17 @@ typedef struct PrintBuf_s {
 	char *buffer;
 } PrintBuf_t;
 
+// growing buffer.  Holds all output until PrintDestFlush writes it to file
+// in a single write.  A PrintDest_t has no shared state, so threads may
+// render in parallel as long as each thread uses its own PrintDest_t.
+typedef struct PrintMem_s {
+	char *buffer;
+	size_t length;	// size of buffer
+	size_t offset;	// next place to write in buffer
+	FILE *file;		// where PrintDestFlush writes, NULL to keep output
+	boolean overflow;	// out of memory, some output was lost
+} PrintMem_t;
+
 typedef void (*PrintCallbackFunc_t)(void *context, const char *buf);
 
 typedef struct PrintCallback_s {
@@ -69,6 +81,7 @@ typedef struct PrintDest_s {
 		FILE *file;
 		PrintBuf_t buf;
 		PrintCallback_t callback;
+		PrintMem_t mem;
 #ifdef LINUX
 		int priority;	// for syslog
 #endif
@@ -84,6 +97,13 @@ extern void PrintDestInitFile(PrintDest_t *dest, FILE *file);
 extern void PrintDestInitBuffer(PrintDest_t *dest, char *buffer, uint16 length);
 extern void PrintDestInitCallback(PrintDest_t *dest, PrintCallbackFunc_t func,
 				void *context);
+// initial is the initial buffer size, 0 for a default
+extern void PrintDestInitMemory(PrintDest_t *dest, FILE *file, size_t initial);
+// write out buffered output of a PL_MEMORY dest and empty its buffer,
+// flush the FILE of a PL_FILE dest.  Returns 0 on success, EOF on error
+extern int PrintDestFlush(PrintDest_t *dest);
+// release the buffer of a PL_MEMORY dest, unflushed output is discarded
+extern void PrintDestFree(PrintDest_t *dest);
 #ifdef LINUX
 extern void PrintDestInitSyslog(PrintDest_t *dest, int priority);
 #endif
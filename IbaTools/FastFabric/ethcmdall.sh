@@ -143,6 +143,16 @@ then
 	Usage_full
 fi
 
+# run $cmd on host $1 for ethfanout, same as host_run_cmd in target.exp
+host_run_cmd()
+{
+	if [ "$quiet" -eq 0 ]
+	then
+		echo "[$user@$1]# $cmd"
+	fi
+	ssh -q -o ForwardX11=no "$user@$1" "$cmd"
+}
+
 user=`id -u -n`
 uopt=n
 quiet=0
@@ -228,11 +238,24 @@ then
 	check_host_args $BASENAME
 	if [ $parallel -eq 0 ]
 	then
-		tclproc=hosts_run_cmd
+		$TOOLSDIR/tcl_proc hosts_run_cmd "$HOSTS" "$user" "$1" $quiet $timelimit $output_prefix
 	else
-		tclproc=hosts_parallel_run_cmd
+		# ethfanout keeps FF_MAX_PARALLEL hosts busy, starting the next host
+		# as soon as any host completes
+		fanout_opts="-p $FF_MAX_PARALLEL -T $timelimit"
+		if [ $output_prefix -eq 1 ]
+		then
+			fanout_opts="$fanout_opts -P"
+		fi
+		case "$FF_SERIALIZE_OUTPUT" in
+		[yY]*)	fanout_opts="$fanout_opts -S";;
+		esac
+		cmd="$1"
+		export user cmd quiet
+		export -f host_run_cmd
+		# escape % in cmd so ethfanout only expands the %h we add
+		$TOOLSDIR/ethfanout $fanout_opts -m "$user@%h: ${cmd//%/%%}" 'host_run_cmd "$1"' $HOSTS
 	fi
-	$TOOLSDIR/tcl_proc $tclproc "$HOSTS" "$user" "$1" $quiet $timelimit $output_prefix
 else
 	if [ "$uopt" = n ]
 	then
@@ -38,7 +38,9 @@ fi
 
 . /usr/lib/eth-tools/ethfastfabric.conf.def
 
-. /usr/lib/eth-tools/ff_funcs
+TOOLSDIR=${TOOLSDIR:-/usr/lib/eth-tools}
+
+. $TOOLSDIR/ff_funcs
 
 trap "exit 1" SIGHUP SIGTERM SIGINT
 
@@ -159,7 +161,7 @@ else
 	DESTS="$SWITCHES"
 fi
 
-running=0
+pdests=
 for dest in $DESTS
 do
 	if [ $switches -ne 0 ]
@@ -168,15 +170,16 @@ do
 	fi
 	if [ "$popt" = "y" ]
 	then
-		if [ $running -ge $FF_MAX_PARALLEL ]
-		then
-			wait
-			running=0
-		fi
-		ping_dest $dest &
-		running=$(($running + 1))
+		pdests="$pdests $dest"
 	else
 		ping_dest $dest
 	fi
 done
-wait
+if [ "$popt" = "y" ]
+then
+	# ethfanout keeps FF_MAX_PARALLEL pings running, starting the next
+	# as soon as any completes
+	export FF_PRD_NAME
+	export -f ping_dest ping_host
+	$TOOLSDIR/ethfanout -p $FF_MAX_PARALLEL 'ping_dest "$1"' $pdests
+fi
@@ -39,7 +39,9 @@ fi
 
 . /usr/lib/eth-tools/ethfastfabric.conf.def
 
-. /usr/lib/eth-tools/ff_funcs
+TOOLSDIR=${TOOLSDIR:-/usr/lib/eth-tools}
+
+. $TOOLSDIR/ff_funcs
 
 readonly BASENAME="$(basename $0)"
 
@@ -192,6 +194,31 @@ then
 	Usage_full
 fi
 
+# for -p, ethfanout runs these for each host in $1, in parallel
+copy_to_host()
+{
+	if [ "$ropt" = "R" ]
+	then
+		if [ -n "$Bopt" ]
+		then
+			echo "rsync -a -e 'ssh -B $Bopt' $rsyncopts $files $user@[$1]:$dest"
+			rsync -a -e "ssh -B $Bopt" $rsyncopts $files $user@\[$1\]:$dest
+		else
+			echo "rsync -a $rsyncopts $files $user@[$1]:$dest"
+			rsync -a $rsyncopts $files $user@\[$1\]:$dest
+		fi
+	else
+		echo "scp $scpopts $files $user@[$1]:$dest"
+		scp $scpopts $files $user@\[$1\]:$dest
+	fi
+}
+
+untar_on_host()
+{
+	echo "$user@$1: mkdir -p $destdir; cd $destdir; tar x $tarcomp"
+	ssh $sshopts $user@$1 "mkdir -p $destdir; cd $destdir; tar x $tarcomp" < $temp
+}
+
 # gzip compression by default
 tarcomp='-z'
 user=`id -u -n`
@@ -203,7 +230,6 @@ popt=n
 ropt=
 Bopt=
 status=0
-pids=''
 rsyncverbose='-P'
 tarverbose='-v'
 
@@ -290,35 +316,18 @@ then
 		dest="$file"
 	done
 
-	running=0
-
-	for hostname in $HOSTS
-	do
-	  if [ "$popt" = "y" ]
-	        then
-		   if [ $running -ge $FF_MAX_PARALLEL ]
-		     then
-			   wait
-			   running=0
-		   fi
-		   if [ "$ropt" = "R" ]
-		   then
-			if [ -n "$Bopt" ]
-			then
-			    echo "rsync -a -e 'ssh -B $Bopt' $rsyncopts $files $user@[$hostname]:$dest"
-			    rsync -a -e "ssh -B $Bopt" $rsyncopts $files $user@\[$hostname\]:$dest & 
-			else
-			    echo "rsync -a $rsyncopts $files $user@[$hostname]:$dest"
-			    rsync -a $rsyncopts $files $user@\[$hostname\]:$dest & 
-			fi
-		   else
-			echo "scp $scpopts $files $user@[$hostname]:$dest"
-			scp $scpopts $files $user@\[$hostname\]:$dest & 
-		   fi
-		   pid=$!
-           pids="$pids $pid"
-		   running=$(( $running + 1))
-	    else
+	if [ "$popt" = "y" ]
+	then
+		export files dest user scpopts rsyncopts ropt Bopt
+		export -f copy_to_host
+		$TOOLSDIR/ethfanout -p $FF_MAX_PARALLEL 'copy_to_host "$1"' $HOSTS
+		if [ "$?" -ne 0 ]
+		then
+			status=1
+		fi
+	else
+	  for hostname in $HOSTS
+	  do
 		   if [ "$ropt" = "R" ]
 		   then
 			if [ -n "$Bopt" ]
@@ -337,18 +346,8 @@ then
 		  then
 		    status=1
 	        fi		   
-	  fi
-	done
-
-#checking exit status for background jobs	
-	for pid in $pids
-	do
-	   wait $pid
-   	   if [ "$?" -ne 0 ]
- 	      then
-	         status=1
-	   fi	
-	done
+	  done
+	fi
 
 else
 	if [ $# -lt 2 ]
@@ -371,42 +370,26 @@ else
 	echo "cd $srcdir; tar c $tarcomp $tarverbose -f $temp ."
 	cd $srcdir; tar c $tarcomp $tarverbose -f $temp .
 
-	running=0
-	for hostname in $HOSTS
-	do
-		if [ "$popt" = "y" ]
+	if [ "$popt" = "y" ]
+	then
+		export temp destdir tarcomp sshopts user
+		export -f untar_on_host
+		$TOOLSDIR/ethfanout -p $FF_MAX_PARALLEL 'untar_on_host "$1"' $HOSTS
+		if [ "$?" -ne 0 ]
 		then
-			if [ $running -ge $FF_MAX_PARALLEL ]
-			then
-				wait
-				running=0
-			fi
-			(
-                echo "$user@$hostname: mkdir -p $destdir; cd $destdir; tar x $tarcomp"
-                ssh $sshopts $user@$hostname "mkdir -p $destdir; cd $destdir; tar x $tarcomp" < $temp
-			) &
-			pid=$!
-		   	pids="$pids $pid"
-			running=$(( $running + 1))
-		else
+			status=1
+		fi
+	else
+		for hostname in $HOSTS
+		do
 			echo "$user@$hostname: mkdir -p $destdir; cd $destdir; tar x $tarcomp"
 			ssh $sshopts $user@$hostname "mkdir -p $destdir; cd $destdir; tar x $tarcomp" < $temp
 			if [ "$?" -ne 0 ]
 		  	  then
 		    	     status=1
 	        	fi		   
-		fi
-	done
-
-#checking exit status for background jobs	
-	for pid in $pids
-	do
-	   wait $pid
-   	   if [ "$?" -ne 0 ]
- 	      then
-	         status=1
-	   fi	
-	done
+		done
+	fi
 	rm -f $temp
 fi
 
@@ -59,8 +59,6 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define PROGRESS_FREQ 1000
 
-#define MIN_LIST_ITEMS 10	// for neighbor sw and fi DLISTs
-
 // macro to always return a valid pointer for use in %s formats
 #define OPTIONAL_STR(s) (s?s:"")
 
@@ -82,8 +80,9 @@ FabricData_t	g_Fabric;
 // names into ranges (eg. compute[1-10]) we keep a NameData per
 // name we want to show.  The NameData includes the reformated full name
 // and the parsed elements of body, numeric range and end
+// Each name is parsed once, the NameData are then shared by all the name
+// lists which reference them
 typedef struct NameData_s {
-	cl_map_item_t	NameListEntry;	// nameList, key is name
 	char		name[NODE_DESCRIPTION_ARRAY_SIZE];	// full name
 
 	// a name is broken into four parts, body is alphanumeric
@@ -96,16 +95,45 @@ typedef struct NameData_s {
 	boolean		leadzero;	// did original name have leading zeros for number
 	int8		numlen;		// number of characters in number in original name
 	const char	*suffix;
+	uint32		rank;		// sort order of prefix, body and suffix
+							// amongst all names, see RankNames
 } NameData_t;
 
-// This will be attached to each switch node via ExpectedNode.context 
-typedef struct SwitchLists_s {
-	cl_qmap_t	fiNeighborNames;// filtered list of neighbor NICs NameData_t
-	cl_qmap_t	swNeighborNames;// filtered list of neighbor SWs NameData_t
-	uint8		tier;			// tier in tree of given switch
-								// (distance from NICs)
-	DLIST		swNeighbors;	// list of all neighbor SWs ExpectedNode*
-} SwitchLists_t;
+// A name list is an array of references to NameData which is sorted once
+// all names have been added.  Each entry belongs to one of many lists
+// (eg. one per switch) and the sort groups entries by list, then orders
+// them by name such that sequential names are adjacent:
+//	key[0] - list << 32 | rank
+//	key[1] - numlen << 32 | start
+// Entries with identical keys are duplicates of the same name.
+typedef struct NameEntry_s {
+	uint64		key[2];
+	const NameData_t *namep;
+} NameEntry_t;
+
+typedef struct NameList_s {
+	NameEntry_t	*entries;
+	uint32		count;
+	uint32		alloc;		// number of entries allocated
+} NameList_t;
+
+#define NAME_LIST_MIN_ALLOC 256
+
+// This will be attached to each ExpectedNode via ExpectedNode.context
+typedef struct NodeNames_s {
+	NameData_t	name;		// name of node for output, NIC names use node
+							// name mode, prefix and suffix, SW names use
+							// switch name mode
+	uint32		index;		// index of switch in ExpectedSWs, name lists
+							// use this as the list for the switch
+	uint32		tier;		// tier in tree of given switch
+							// (distance from NICs)
+	boolean		fiNeighbors;	// switch has NICs in g_FiNeighborNames
+} NodeNames_t;
+
+NodeNames_t		*g_NodeNames = NULL;	// NodeNames for all ExpectedFIs and SWs
+NameList_t		g_FiNeighborNames;	// NICs connected to each switch
+NameList_t		g_SwNeighborNames;	// lower tier switches connected to each switch
 
 boolean CompareExpectedNodeFocus(ExpectedNode *enodep);
 boolean CompareExpectedLinkFocus(ExpectedLink *elinkp);
@@ -480,76 +508,6 @@ boolean SequentialNames(const NameData_t *name1p, const NameData_t *name2p)
 	return TRUE;
 }
 
-// compare two names and return:
-// -1 - name1 < name2
-// 0 - name1 == name2
-// 1 - name1 > name2
-int CompareNameData(IN const uint64 name1, IN  const uint64 name2)
-{
-	const NameData_t *name1p = (const NameData_t*)name1;
-	const NameData_t *name2p = (const NameData_t*)name2;
-	int ret;
-
-	DBGPRINT("CompareNameData: %s, %s\n", name1p->name, name2p->name);
-	if (name1p->prefix) {
-		if (!name2p->prefix) {
-			return 1;
-		} else {
-			ret = strncmp(name1p->prefix, name2p->prefix, NODE_DESCRIPTION_ARRAY_SIZE);
-			if (ret)
-				return ret;
-		}
-	} else if (name2p->prefix) {
-		return -1;
-	}
-	ret = strncmp(name1p->body, name2p->body, NODE_DESCRIPTION_ARRAY_SIZE);
-	if (ret)
-		return ret;
-	if (! name1p->numlen || ! name2p->numlen) {
-		// if only 1 has a number, put one without a number 1st
-		if (name1p->numlen)
-			return 1;
-		else if (name2p->numlen)
-			return -1;
-	}
-	// for RANGE_IN_MIDDLE we want items with same suffix together so we can
-	// find best opportunities to combine, so sort by suffix prior to sorting
-	// by numeric field
-	// for ! RANGE_IN_MIDDLE, we want to sort by suffix after sort by numeric
-	if (name1p->suffix) {
-		if (!name2p->suffix) {
-			ret = 1;
-		} else {
-			ret = strncmp(name1p->suffix, name2p->suffix, NODE_DESCRIPTION_ARRAY_SIZE);
-			if (ret)
-				return ret;
-		}
-	} else if (name2p->suffix) {
-		ret = -1;
-	}
-#if RANGE_IN_MIDDLE
-	if (ret)
-		return ret;
-#endif
-	if (! name1p->numlen && ! name2p->numlen)
-		return ret;
-	// if we see two styles of format, we want to sort those with shorter
-	// numeric fields first.  c0, c1, c000, c001 so we can find best
-	// opportunities to combine sequential ranges
-	if (name1p->leadzero || name2p->leadzero) {
-		if (name1p->numlen < name2p->numlen)
-			return -1;
-		else if (name1p->numlen > name2p->numlen)
-			return -1;
-	}
-	if (name1p->start < name2p->start)
-		return -1;
-	else if (name1p->start > name2p->start)
-		return 1;
-	else
-		return ret;
-}
-
 // updates name1p to include name2p
 // only valid if name1p and name2p are sequential
 // before or after this update, name2p should be remove from list
@@ -562,236 +520,338 @@ void CombineNames(NameData_t *name1p, const NameData_t *name2p)
 
 // --------------------- NameData list functions ----------------------------
 
-void InitNameList(cl_qmap_t *listp)
-{
-	cl_qmap_init(listp, CompareNameData);
-}
-
-// add name to list if not already on list
-// the algorithm assumes duplicates are relatively infrequent so its simpler
-// to just build the final NameData for comparison and throw it away on a
-// duplicate. Alternatives would be more complex and have an extra copy
-// of the name string for each non-dup
-// rationale:
-//	- hosts on a switch will have no dups
-//	- ISLs will have dups limited to trunk size of link (1-4 typical)
-FSTATUS AddNameList(cl_qmap_t *listp, const char* name, EUI64 guid, name_mode_t mode,
-				const char *prefix, const char *suffix)
+// compare two optional strings, NULL sorts first
+static int CompareNameStr(const char *str1, const char *str2)
 {
-	NameData_t *namep;
-
-	if (name)
-		DBGPRINT("AddNameList: %s 0x%016"PRIx64"\n", name, guid);
-	else
-		DBGPRINT("AddNameList: NULL 0x%016"PRIx64"\n", guid);
-	namep = (NameData_t *)MemoryAllocate2AndClear(sizeof(NameData_t), IBA_MEM_FLAG_PREMPTABLE, MYTAG);
-	if (! namep) {
-		fprintf(stderr, "Out of memory\n");
-		return FINSUFFICIENT_MEMORY;
-	}
-	CopyName(namep, name, guid, mode, prefix, suffix);
-	if (cl_qmap_insert(listp, (uint64)(uintn)namep, &namep->NameListEntry) != &namep->NameListEntry) {
-		// name already on list
-		MemoryDeallocate(namep);
-		return FSUCCESS;
+	if (str1) {
+		if (! str2)
+			return 1;
+		return strncmp(str1, str2, NODE_DESCRIPTION_ARRAY_SIZE);
+	} else if (str2) {
+		return -1;
 	}
-	DBGPRINT("AddNameList: created new entry\n");
-	return FSUCCESS;
+	return 0;
 }
 
-// take the sorted list and convert sequential names to a numeric range
-// two styles of numeric ranges: name[0-10] and name[00-10] indicate if
-// leading zeros were present in the original names
-void CompactNameList(cl_qmap_t *listp)
+// qsort comparator for NameData_t pointers by prefix, body and suffix
+static int CompareNameRank(const void *p1, const void *p2)
 {
-	cl_map_item_t *p;
-
-	DBGPRINT("compacting name list\n");
-	for (p=cl_qmap_head(listp); p != cl_qmap_end(listp);) {
-		NameData_t *name1p = PARENT_STRUCT(p, NameData_t, NameListEntry);
-		NameData_t *name2p;
-		cl_map_item_t *next= cl_qmap_next(p);
-		if (next == cl_qmap_end(listp))
-			break;
-		DBGPRINT("compacting name list: p: %p, next: %p\n", p, next);
-		name2p = PARENT_STRUCT(next, NameData_t, NameListEntry);
-		if (SequentialNames(name1p, name2p)) {
-			cl_qmap_remove_item(listp, next);
-			CombineNames(name1p, name2p);
-			MemoryDeallocate(name2p);
-		} else {
-			p = cl_qmap_next(p);
-		}
-	}
+	const NameData_t *name1p = *(const NameData_t * const *)p1;
+	const NameData_t *name2p = *(const NameData_t * const *)p2;
+	int ret;
+
+	ret = CompareNameStr(name1p->prefix, name2p->prefix);
+	if (ret)
+		return ret;
+	ret = strncmp(name1p->body, name2p->body, NODE_DESCRIPTION_ARRAY_SIZE);
+	if (ret)
+		return ret;
+	return CompareNameStr(name1p->suffix, name2p->suffix);
 }
 
-void FreeNameList(cl_qmap_t *listp)
+// assign each name a rank such that names with the same prefix, body and
+// suffix have the same rank and ranks sort in the same order as the strings.
+// This way the name lists can be sorted on integer keys alone.
+// namepp is reordered.
+// Since the prefix and suffix are the same for every name in a given list,
+// sorting on rank then number gives the same order as comparing the strings
+// with the number ahead of the suffix.
+void RankNames(NameData_t **namepp, uint32 count)
 {
-	cl_map_item_t *p;
+	uint32 i;
+	uint32 rank = 0;
 
-	for (p=cl_qmap_head(listp); p != cl_qmap_end(listp); p = cl_qmap_head(listp)) {
-		NameData_t *namep = PARENT_STRUCT(p, NameData_t, NameListEntry);
-		cl_qmap_remove_item(listp, p);
-		MemoryDeallocate(namep);
+	if (! count)
+		return;
+	qsort(namepp, count, sizeof(NameData_t *), CompareNameRank);
+	namepp[0]->rank = rank;
+	for (i=1; i < count; i++) {
+		if (CompareNameRank(&namepp[i-1], &namepp[i]))
+			rank++;
+		namepp[i]->rank = rank;
 	}
 }
 
-// --------------------- SwitchLists functions ----------------------------
-
-static __inline cl_qmap_t *GetSwitchFiNeighNameList(ExpectedNode *enodep)
+void InitNameList(NameList_t *listp)
 {
-	return &((SwitchLists_t*)enodep->context)->fiNeighborNames;
+	listp->entries = NULL;
+	listp->count = 0;
+	listp->alloc = 0;
 }
 
-static __inline cl_qmap_t *GetSwitchSwNeighNameList(ExpectedNode *enodep)
+// add a reference to namep to the given list within listp
+// namep must have been ranked via RankNames.  Duplicates are kept here and
+// skipped when the sorted list is output.  Rationale:
+//	- hosts on a switch will have no dups
+//	- ISLs will have dups limited to trunk size of link (1-4 typical)
+FSTATUS AddNameList(NameList_t *listp, uint32 list, const NameData_t *namep)
 {
-	return &((SwitchLists_t*)enodep->context)->swNeighborNames;
+	NameEntry_t *entryp;
+
+	DBGPRINT("AddNameList: %u %s\n", list, namep->name);
+	if (listp->count == listp->alloc) {
+		uint32 alloc = listp->alloc? listp->alloc * 2 : NAME_LIST_MIN_ALLOC;
+		NameEntry_t *entries;
+
+		entries = (NameEntry_t *)MemoryAllocate2(sizeof(NameEntry_t)*alloc, IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+		if (! entries) {
+			fprintf(stderr, "Out of memory\n");
+			return FINSUFFICIENT_MEMORY;
+		}
+		if (listp->entries) {
+			MemoryCopy(entries, listp->entries, sizeof(NameEntry_t)*listp->count);
+			MemoryDeallocate(listp->entries);
+		}
+		listp->entries = entries;
+		listp->alloc = alloc;
+	}
+	entryp = &listp->entries[listp->count++];
+	entryp->key[0] = ((uint64)list << 32) | namep->rank;
+	entryp->key[1] = ((uint64)(uint8)namep->numlen << 32) | namep->start;
+	entryp->namep = namep;
+	return FSUCCESS;
 }
 
-static __inline uint8 GetSwitchTier(ExpectedNode *enodep)
+static __inline uint32 NameEntryList(const NameEntry_t *entryp)
 {
-	return ((SwitchLists_t*)enodep->context)->tier;
+	return (uint32)(entryp->key[0] >> 32);
 }
 
-static __inline DLIST *GetSwitchSwNeighList(ExpectedNode *enodep)
+static int CompareNameEntry(const void *p1, const void *p2)
 {
-	return &((SwitchLists_t*)enodep->context)->swNeighbors;
+	const NameEntry_t *entry1p = (const NameEntry_t *)p1;
+	const NameEntry_t *entry2p = (const NameEntry_t *)p2;
+
+	if (entry1p->key[0] != entry2p->key[0])
+		return (entry1p->key[0] < entry2p->key[0])? -1 : 1;
+	if (entry1p->key[1] != entry2p->key[1])
+		return (entry1p->key[1] < entry2p->key[1])? -1 : 1;
+	return 0;
 }
 
-FSTATUS AllocSwitchLists(ExpectedNode *enodep)
+// sort the list by key using a least significant byte first radix sort.
+// Passes for bytes which are the same in every key are skipped, so typically
+// only the bytes of the list, rank and number which vary are sorted
+void SortNameList(NameList_t *listp)
 {
-	enodep->context = MemoryAllocate2AndClear(sizeof(SwitchLists_t), IBA_MEM_FLAG_PREMPTABLE, MYTAG);
-	if (! enodep->context)
-		return FINSUFFICIENT_MEMORY;
-	InitNameList(GetSwitchFiNeighNameList(enodep));
-	InitNameList(GetSwitchSwNeighNameList(enodep));
-	ListInitState(&((SwitchLists_t*)enodep->context)->swNeighbors);
-	if (! ListInit(&((SwitchLists_t*)enodep->context)->swNeighbors, MIN_LIST_ITEMS))
-		goto fail;
-	return FSUCCESS;
+	uint32 counts[16][256];
+	NameEntry_t *tmp;
+	NameEntry_t *src = listp->entries;
+	NameEntry_t *dst;
+	uint32 i;
+	int pass;
+
+	if (listp->count < 2)
+		return;
+	tmp = (NameEntry_t *)MemoryAllocate2(sizeof(NameEntry_t)*listp->count, IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	if (! tmp) {
+		// just use a slower in place sort
+		qsort(listp->entries, listp->count, sizeof(NameEntry_t), CompareNameEntry);
+		return;
+	}
+	dst = tmp;
 
-fail:
-	MemoryDeallocate(enodep->context);
-	return FINSUFFICIENT_MEMORY;
+	// pass 0-7 are bytes of key[1], 8-15 are bytes of key[0]
+	MemoryClear(counts, sizeof(counts));
+	for (i=0; i < listp->count; i++) {
+		for (pass=0; pass < 16; pass++)
+			counts[pass][(src[i].key[1 - pass/8] >> ((pass%8)*8)) & 0xff]++;
+	}
+	for (pass=0; pass < 16; pass++) {
+		uint32 *count = counts[pass];
+		int key = 1 - pass/8;
+		int shift = (pass%8)*8;
+		uint32 offset = 0;
+		int b;
+		NameEntry_t *swap;
+
+		if (count[(src[0].key[key] >> shift) & 0xff] == listp->count)
+			continue;	// all keys have same value for this byte
+		for (b=0; b < 256; b++) {
+			uint32 c = count[b];
+			count[b] = offset;
+			offset += c;
+		}
+		for (i=0; i < listp->count; i++)
+			dst[count[(src[i].key[key] >> shift) & 0xff]++] = src[i];
+		swap = src;
+		src = dst;
+		dst = swap;
+	}
+	if (src != listp->entries)
+		MemoryCopy(listp->entries, src, sizeof(NameEntry_t)*listp->count);
+	MemoryDeallocate(tmp);
 }
 
-void FreeSwitchLists(ExpectedNode *enodep)
+// output the names in the list starting at *ixp in the sorted listp,
+// as a comma separated list, skipping duplicates and if compact, converting
+// sequential names to a numeric range.
+// two styles of numeric ranges: name[0-10] and name[00-10] indicate if
+// leading zeros were present in the original names
+// *ixp is advanced to the 1st entry of the next list
+void PrintNameList(const NameList_t *listp, uint32 *ixp, boolean compact)
 {
-	if (enodep->context) {
-		FreeNameList(GetSwitchFiNeighNameList(enodep));
-		FreeNameList(GetSwitchSwNeighNameList(enodep));
-		ListDestroy(&((SwitchLists_t*)enodep->context)->swNeighbors);
-		MemoryDeallocate(enodep->context);
-		enodep->context = NULL;
+	const NameEntry_t *entries = listp->entries;
+	uint32 ix = *ixp;
+	uint32 list = NameEntryList(&entries[ix]);
+	NameData_t range = *entries[ix].namep;
+
+	for (ix++; ix < listp->count && NameEntryList(&entries[ix]) == list; ix++) {
+		const NameData_t *namep = entries[ix].namep;
+
+		if (0 == CompareNameEntry(&entries[ix-1], &entries[ix]))
+			continue;	// name already on list
+		if (compact && SequentialNames(&range, namep)) {
+			CombineNames(&range, namep);
+		} else {
+			PrintName(&range);
+			printf(",");
+			range = *namep;
+		}
 	}
+	PrintName(&range);
+	*ixp = ix;
 }
 
-FSTATUS AddSwitchFiNameList(ExpectedNode *enodep, const char* name, EUI64 guid, name_mode_t mode,
-				const char *prefix, const char *suffix)
+void FreeNameList(NameList_t *listp)
 {
-	if (! enodep->context) {
-		FSTATUS status = AllocSwitchLists(enodep);
-		if (FSUCCESS != status)
-			return status;
-	}
-	return AddNameList(GetSwitchFiNeighNameList(enodep), name, guid, mode,
-				prefix, suffix);
+	if (listp->entries)
+		MemoryDeallocate(listp->entries);
+	InitNameList(listp);
 }
 
-FSTATUS AddSwitchSwNameList(ExpectedNode *enodep, const char* name, EUI64 guid, name_mode_t mode,
-				const char *prefix, const char *suffix)
+// --------------------- NodeNames functions ----------------------------
+
+static __inline NodeNames_t *GetNodeNames(ExpectedNode *enodep)
 {
-	if (! enodep->context) {
-		FSTATUS status = AllocSwitchLists(enodep);
-		if (FSUCCESS != status)
-			return status;
-	}
-	return AddNameList(GetSwitchSwNeighNameList(enodep), name, guid, mode,
-				prefix, suffix);
+	return (NodeNames_t*)enodep->context;
 }
 
-FSTATUS SetSwitchTier(ExpectedNode *enodep, uint8 tier)
+// parse the name of every ExpectedFI and ExpectedSW once and rank them all
+FSTATUS AllocNodeNames(name_mode_t switch_name_mode, name_mode_t node_name_mode)
 {
-	if (! enodep->context) {
-		FSTATUS status = AllocSwitchLists(enodep);
-		if (FSUCCESS != status)
-			return status;
+	uint32 num_fis = QListCount(&g_Fabric.ExpectedFIs);
+	uint32 num_sws = QListCount(&g_Fabric.ExpectedSWs);
+	NameData_t **namepp;
+	LIST_ITEM *p;
+	uint32 i = 0;
+
+	if (! (num_fis + num_sws))
+		return FSUCCESS;
+	g_NodeNames = (NodeNames_t*)MemoryAllocate2AndClear(sizeof(NodeNames_t)*(num_fis + num_sws), IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	namepp = (NameData_t**)MemoryAllocate2(sizeof(NameData_t*)*(num_fis + num_sws), IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	if (! g_NodeNames || ! namepp) {
+		fprintf(stderr, "Out of memory\n");
+		if (namepp)
+			MemoryDeallocate(namepp);
+		if (g_NodeNames)
+			MemoryDeallocate(g_NodeNames);
+		g_NodeNames = NULL;
+		return FINSUFFICIENT_MEMORY;
 	}
-	((SwitchLists_t*)enodep->context)->tier = tier;
+	for (p=QListHead(&g_Fabric.ExpectedSWs); p != NULL; p = QListNext(&g_Fabric.ExpectedSWs, p)) {
+		ExpectedNode *enodep = (ExpectedNode *)QListObj(p);
+
+		CopyName(&g_NodeNames[i].name, enodep->NodeDesc, enodep->NodeGUID, switch_name_mode, NULL, NULL);
+		g_NodeNames[i].index = i;
+		namepp[i] = &g_NodeNames[i].name;
+		enodep->context = &g_NodeNames[i++];
+	}
+	for (p=QListHead(&g_Fabric.ExpectedFIs); p != NULL; p = QListNext(&g_Fabric.ExpectedFIs, p)) {
+		ExpectedNode *enodep = (ExpectedNode *)QListObj(p);
+
+		CopyName(&g_NodeNames[i].name, enodep->NodeDesc, enodep->NodeGUID, node_name_mode, g_prefix, g_suffix);
+		namepp[i] = &g_NodeNames[i].name;
+		enodep->context = &g_NodeNames[i++];
+	}
+	RankNames(namepp, i);
+	MemoryDeallocate(namepp);
 	return FSUCCESS;
 }
 
-FSTATUS AddSwitchSwNeighbor(ExpectedNode *enodep, ExpectedNode *swnodep)
+void FreeNodeNames(void)
 {
-	if (! enodep->context) {
-		FSTATUS status = AllocSwitchLists(enodep);
-		if (FSUCCESS != status)
-			return status;
-	}
-	if (! ListInsertTail(&((SwitchLists_t*)enodep->context)->swNeighbors, swnodep))
-		return FINSUFFICIENT_MEMORY;
-	return FSUCCESS;
+	LIST_ITEM *p;
+
+	if (! g_NodeNames)
+		return;
+	for (p=QListHead(&g_Fabric.ExpectedSWs); p != NULL; p = QListNext(&g_Fabric.ExpectedSWs, p))
+		((ExpectedNode *)QListObj(p))->context = NULL;
+	for (p=QListHead(&g_Fabric.ExpectedFIs); p != NULL; p = QListNext(&g_Fabric.ExpectedFIs, p))
+		((ExpectedNode *)QListObj(p))->context = NULL;
+	MemoryDeallocate(g_NodeNames);
+	g_NodeNames = NULL;
 }
 
-// analyze the expected links to determine the swNeighbors for each switch.
+// analyze the expected links to determine the tier of each switch.
 // TBD - Future - would be nice to be able to filter out selected hosts such as
 // service nodes connected to core, but would need to figure out how to
 // filter out edge switches left with no hosts so they aren't mistaken for
 // core switches.  For now, SLURM uses with impure trees or other topologies
 // should use the -o slurm option which will provide a brief report which does
 // not list all the ISLs
-void BuildSwitchNeighList(boolean get_isls)
+FSTATUS BuildSwitchTiers(void)
 {
 	LIST_ITEM *q;
-	LIST_ITEM *p;
-	uint8 tier = 0;
-	boolean found;
-
-	if (! get_isls)
-		return;
+	uint32 num_sws = QListCount(&g_Fabric.ExpectedSWs);
+	uint32 *first;		// index in neighbors of 1st neighbor of each switch
+	uint32 *neighbors;	// neighbors of each switch
+	uint32 *queue;		// switches to visit in breadth first search
+	uint32 num_isls = 0;
+	uint32 head, tail;
+	uint32 i;
+
+	if (! num_sws)
+		return FSUCCESS;
 
-	// now populate swNeighbors for each switch and identify tier 1 switches
+	// Count the SW<->SW links of each switch and identify tier 1 switches
+	first = (uint32*)MemoryAllocate2AndClear(sizeof(uint32)*(num_sws+1), IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	queue = (uint32*)MemoryAllocate2(sizeof(uint32)*num_sws, IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	if (! first || ! queue)
+		goto nomem;
 	for (q=QListHead(&g_Fabric.ExpectedLinks); q != NULL; q = QListNext(&g_Fabric.ExpectedLinks, q)) {
 		ExpectedLink *elinkp = (ExpectedLink *)QListObj(q);
+		ExpectedNode *enode1p, *enode2p;
 
 		if (! elinkp->portselp1 || ! elinkp->portselp1->enodep
 			|| ! elinkp->portselp2 || ! elinkp->portselp2->enodep) {
 			// Skipping Link, unresolved
 			continue;
 		}
-		// figure out the types on both ends
-		switch (elinkp->portselp1->enodep->NodeType) {
-		case STL_NODE_FI:
-			switch (elinkp->portselp2->enodep->NodeType) {
-			case STL_NODE_FI: // NIC<->NIC
-				// Skipping Link, unexpected NIC<->NIC link
-				break;
-			case STL_NODE_SW: // NIC<->SW
-				(void)SetSwitchTier(elinkp->portselp2->enodep, 1);
-				break;
-			default:	// should not happen, enodep should always have type
-				// Skipping Link, unspecified NodeType
-				break;
-			}
-			break;
-		case STL_NODE_SW:
-			switch (elinkp->portselp2->NodeType) {
-			case STL_NODE_FI: // SW<->NIC
-				(void)SetSwitchTier(elinkp->portselp1->enodep, 1);
-				break;
-			case STL_NODE_SW: // SW<->SW
-				(void)AddSwitchSwNeighbor(elinkp->portselp1->enodep, elinkp->portselp2->enodep);
-				(void)AddSwitchSwNeighbor(elinkp->portselp2->enodep, elinkp->portselp1->enodep);
-				break;
-			default:	// should not happen, enodep should always have type
-				// Skipping Link, unspecified NodeType
-				break;
-			}
-			break;
-		default:	// should not happen, enodep should always have type
-			// Skipping Link, unspecified NodeType
-			continue;
+		enode1p = elinkp->portselp1->enodep;
+		enode2p = elinkp->portselp2->enodep;
+		if (enode1p->NodeType == STL_NODE_SW && enode2p->NodeType == STL_NODE_SW) {
+			first[GetNodeNames(enode1p)->index]++;
+			first[GetNodeNames(enode2p)->index]++;
+			num_isls++;
+		} else if (enode1p->NodeType == STL_NODE_SW && enode2p->NodeType == STL_NODE_FI) {
+			GetNodeNames(enode1p)->tier = 1;
+		} else if (enode1p->NodeType == STL_NODE_FI && enode2p->NodeType == STL_NODE_SW) {
+			GetNodeNames(enode2p)->tier = 1;
 		}
+		// else Skipping Link, NIC<->NIC or unspecified NodeType
+	}
+
+	// turn the counts into the end of each switch's neighbors and fill in
+	// the neighbors working backwards so first[] becomes the start
+	for (i=0; i < num_sws; i++)
+		first[i+1] += first[i];
+	neighbors = (uint32*)MemoryAllocate2(sizeof(uint32)*(2*num_isls+1), IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	if (! neighbors)
+		goto nomem;
+	for (q=QListHead(&g_Fabric.ExpectedLinks); q != NULL; q = QListNext(&g_Fabric.ExpectedLinks, q)) {
+		ExpectedLink *elinkp = (ExpectedLink *)QListObj(q);
+		uint32 sw1, sw2;
+
+		if (! elinkp->portselp1 || ! elinkp->portselp1->enodep
+			|| ! elinkp->portselp2 || ! elinkp->portselp2->enodep
+			|| elinkp->portselp1->enodep->NodeType != STL_NODE_SW
+			|| elinkp->portselp2->enodep->NodeType != STL_NODE_SW)
+			continue;
+		sw1 = GetNodeNames(elinkp->portselp1->enodep)->index;
+		sw2 = GetNodeNames(elinkp->portselp2->enodep)->index;
+		neighbors[--first[sw1]] = sw2;
+		neighbors[--first[sw2]] = sw1;
 	}
 
 	// now we have tier 1 switches identified, need to walk up the tree to
@@ -801,41 +861,51 @@ void BuildSwitchNeighList(boolean get_isls)
 	// this works with ExpectedNode while route.c works with NodeData
 	//
 	// switches connected to tier 1 switches are tier 2, etc
+	// A breadth first search starting from all the tier 1 switches reaches
+	// each switch via the shortest path, so each switch is visited once
 	
 	// This algorithm works fine for pure trees, however for impure trees
 	// it can yield unexpected results, for example a core switch with an HFI
 	// will be considered a tier 1 switch.
-	tier=2;
-	do {
-		found = FALSE;
-		for (p=QListHead(&g_Fabric.ExpectedSWs); p != NULL; p = QListNext(&g_Fabric.ExpectedSWs, p)) {
-			ExpectedNode *enodep = (ExpectedNode *)QListObj(p);
-			LIST_ITERATOR i;
-			if (GetSwitchTier(enodep) != tier-1)
-				continue;
-			for (i=ListHead(GetSwitchSwNeighList(enodep)); i != NULL;
-						i = ListNext(GetSwitchSwNeighList(enodep),i)) {
-				ExpectedNode* nswnodep = (ExpectedNode*)ListObj(i);
-				if (! GetSwitchTier(nswnodep)) {
-					SetSwitchTier(nswnodep, tier);
-					found = TRUE;
-				}
+	head = tail = 0;
+	for (i=0; i < num_sws; i++) {
+		if (g_NodeNames[i].tier == 1)
+			queue[tail++] = i;
+	}
+	while (head < tail) {
+		uint32 sw = queue[head++];
+
+		for (i=first[sw]; i < first[sw+1]; i++) {
+			NodeNames_t *neighp = &g_NodeNames[neighbors[i]];
+			if (! neighp->tier) {
+				neighp->tier = g_NodeNames[sw].tier + 1;
+				queue[tail++] = neighbors[i];
 			}
 		}
-		tier++;
-	} while (found);
-	return;
+	}
+	MemoryDeallocate(neighbors);
+	MemoryDeallocate(queue);
+	MemoryDeallocate(first);
+	return FSUCCESS;
+
+nomem:
+	fprintf(stderr, "Out of memory\n");
+	if (queue)
+		MemoryDeallocate(queue);
+	if (first)
+		MemoryDeallocate(first);
+	return FINSUFFICIENT_MEMORY;
 }
 
-// Analyze ExpectedLinks and build lists of neighbors in ExpectedSW's context
-// pointer in preparation for output generation
+// Analyze ExpectedLinks and build lists of neighbors of each ExpectedSW
+// in preparation for output generation
 // The algorithm here assumes:
 //	- ExpectedSWs and ExpectedLinks are both supplied and consistent
 //	- NodeDesc and/or NodeGUID is listed for each entry
 //	- All entries in both have NodeType
 // The above will all be true if the topology.xml was autogenerated by
 // ethxlattopologory or ethreport -o topology
-void BuildAllSwitchLists(name_mode_t switch_name_mode, name_mode_t node_name_mode, boolean get_isls, boolean get_hfis)
+FSTATUS BuildAllSwitchLists(name_mode_t switch_name_mode, name_mode_t node_name_mode, boolean get_isls, boolean get_hfis)
 {
 	LIST_ITEM *q;
 	uint32 input_checked = 0;
@@ -844,8 +914,18 @@ void BuildAllSwitchLists(name_mode_t switch_name_mode, name_mode_t node_name_mod
 	uint32 isl_links = 0;
 	uint32 bad_isl_links = 0;
 	uint32 ix = 0;
-
-	BuildSwitchNeighList(get_isls);
+	FSTATUS status;
+
+	InitNameList(&g_FiNeighborNames);
+	InitNameList(&g_SwNeighborNames);
+	status = AllocNodeNames(switch_name_mode, node_name_mode);
+	if (FSUCCESS != status)
+		return status;
+	if (get_isls) {
+		status = BuildSwitchTiers();
+		if (FSUCCESS != status)
+			return status;
+	}
 
 	PROGRESS_PRINT(TRUE, "Processing Links...");
 	for (q=QListHead(&g_Fabric.ExpectedLinks); q != NULL; q = QListNext(&g_Fabric.ExpectedLinks, q)) {
@@ -923,18 +1003,27 @@ void BuildAllSwitchLists(name_mode_t switch_name_mode, name_mode_t node_name_mod
 			continue;
 		input_checked++;
 		if (fienodep) {	// NIC<->SW
-			(void)AddSwitchFiNameList(swenodep, fienodep->NodeDesc, fienodep->NodeGUID, node_name_mode, g_prefix, g_suffix);
+			NodeNames_t *swnamesp = GetNodeNames(swenodep);
+
+			if (FSUCCESS != AddNameList(&g_FiNeighborNames, swnamesp->index, &GetNodeNames(fienodep)->name))
+				return FINSUFFICIENT_MEMORY;
+			swnamesp->fiNeighbors = TRUE;
 			fi_links++;
 		} else {	// SW<->SW
+			NodeNames_t *swnamesp = GetNodeNames(swenodep);
+			NodeNames_t *nswnamesp = GetNodeNames(nswenodep);
+
 			// only add downlink which goes from upper tier switch to lower tier
 			// SLURM wants just one direction reported for each link, so
 			// we only report downlinks in pure trees and warn if any links are
 			// found which are not tier X to tier X-1 or tier X+1
-			if (GetSwitchTier(swenodep) == GetSwitchTier(nswenodep)+1) {
-				(void)AddSwitchSwNameList(swenodep, nswenodep->NodeDesc, nswenodep->NodeGUID, switch_name_mode, NULL, NULL);
+			if (swnamesp->tier == nswnamesp->tier+1) {
+				if (FSUCCESS != AddNameList(&g_SwNeighborNames, swnamesp->index, &nswnamesp->name))
+					return FINSUFFICIENT_MEMORY;
 				isl_links++;
-			} else if (GetSwitchTier(nswenodep) == GetSwitchTier(swenodep)+1) {
-				(void)AddSwitchSwNameList(nswenodep, swenodep->NodeDesc, swenodep->NodeGUID, switch_name_mode, NULL, NULL);
+			} else if (nswnamesp->tier == swnamesp->tier+1) {
+				if (FSUCCESS != AddNameList(&g_SwNeighborNames, nswnamesp->index, &swnamesp->name))
+					return FINSUFFICIENT_MEMORY;
 				isl_links++;
 			} else {
 				// This is a best attempt but will not catch all issues
@@ -947,6 +1036,8 @@ void BuildAllSwitchLists(name_mode_t switch_name_mode, name_mode_t node_name_mod
 			}
 		}
 	}
+	SortNameList(&g_FiNeighborNames);
+	SortNameList(&g_SwNeighborNames);
 	PROGRESS_PRINT(TRUE, "Done Processing Links");
 	fprintf(stderr, "%u of %u Input Links Selected, %u Bad Input Skipped\n",
 				input_checked, QListCount(&g_Fabric.ExpectedLinks), bad_input);
@@ -956,20 +1047,17 @@ void BuildAllSwitchLists(name_mode_t switch_name_mode, name_mode_t node_name_mod
 	if (get_isls)
 		fprintf(stderr, "%u Input ISLs Shown, %u Bad ISLs Skipped\n",
 					isl_links, bad_isl_links);
-	return;
+	return FSUCCESS;
 }
 
 void FreeAllSwitchNamelists(void)
 {
-	LIST_ITEM *p;
-
-	for (p=QListHead(&g_Fabric.ExpectedSWs); p != NULL; p = QListNext(&g_Fabric.ExpectedSWs, p)) {
-		ExpectedNode *enodep = (ExpectedNode *)QListObj(p);
-
-		FreeSwitchLists(enodep);
-	}
+	FreeNameList(&g_FiNeighborNames);
+	FreeNameList(&g_SwNeighborNames);
+	FreeNodeNames();
 }
 
+
 // --------------------- Focus functions ----------------------------
 
 // compare against all -F options provided
@@ -1032,8 +1120,11 @@ void ShowFastFabricHosts(name_mode_t node_name_mode)
 	LIST_ITEM *p;
 	uint32 input_checked = 0;
 	uint32 bad_input = 0;
-	cl_qmap_t host_list;
-	cl_map_item_t	*q;
+	uint32 num_fis = QListCount(&g_Fabric.ExpectedFIs);
+	NameData_t *names = NULL;
+	NameData_t **namepp = NULL;
+	NameList_t host_list;
+	uint32 ix;
 	char myhostname[NODE_DESCRIPTION_ARRAY_SIZE];
 	size_t i;
 
@@ -1056,6 +1147,15 @@ void ShowFastFabricHosts(name_mode_t node_name_mode)
 	DBGPRINT("myhostname=%.*s\n", NODE_DESCRIPTION_ARRAY_SIZE, myhostname);
 
 	InitNameList(&host_list);
+	if (num_fis) {
+		names = (NameData_t*)MemoryAllocate2(sizeof(NameData_t)*num_fis, IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+		namepp = (NameData_t**)MemoryAllocate2(sizeof(NameData_t*)*num_fis, IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+		if (! names || ! namepp) {
+			fprintf(stderr, "Out of memory\n");
+			goto done;
+		}
+	}
+	ix = 0;
 	for (p=QListHead(&g_Fabric.ExpectedFIs); p != NULL; p = QListNext(&g_Fabric.ExpectedFIs, p)) {
 		ExpectedNode *enodep = (ExpectedNode *)QListObj(p);
 
@@ -1078,44 +1178,61 @@ void ShowFastFabricHosts(name_mode_t node_name_mode)
 			continue;
 		input_checked++;
 		// put hosts in a list, multi-rail hosts will have different NodeDesc for each rail
-		if (FSUCCESS != AddNameList(&host_list, enodep->NodeDesc, 0, node_name_mode, g_prefix, g_suffix)) {
-			// unexpected error
-			continue;
-		}
+		CopyName(&names[ix], enodep->NodeDesc, 0, node_name_mode, g_prefix, g_suffix);
+		namepp[ix] = &names[ix];
+		ix++;
 	}
-	// CompactNameList(&host_list);	// FastFabric does not support ranges
-
-        char* cur_name = NULL;
-        char* tmp = NULL;
-        int myhostname_len = strlen(myhostname);
-	for (q=cl_qmap_head(&host_list); q != cl_qmap_end(&host_list); q = cl_qmap_next(q)) {
-		NameData_t *namep = PARENT_STRUCT(q, NameData_t, NameListEntry);
+	RankNames(namepp, ix);
+	for (i=0; i < ix; i++) {
+		if (FSUCCESS != AddNameList(&host_list, 0, &names[i]))
+			goto done;
+	}
+	SortNameList(&host_list);
+	// FastFabric does not support ranges, so names are never compacted
+
+	char cur_name[NODE_DESCRIPTION_ARRAY_SIZE] = "";
+	boolean have_cur = FALSE;
+	char name[NODE_DESCRIPTION_ARRAY_SIZE];
+	char* tmp = NULL;
+	int myhostname_len = strlen(myhostname);
+	for (ix=0; ix < host_list.count; ix++) {
+		const NameData_t *namep = host_list.entries[ix].namep;
+
+		if (ix && 0 == CompareNameEntry(&host_list.entries[ix-1], &host_list.entries[ix]))
+			continue;	// name already on list
 		// Host NodeDesc shall be in format <hostname>-<ifName>
-		tmp = strrchr(namep->name, '-');
+		StringCopy(name, namep->name, sizeof(name));
+		tmp = strrchr(name, '-');
 		if (tmp)
 		        *tmp = '\0';
 
-		if (!cur_name || strncmp(cur_name, namep->name, NODE_DESCRIPTION_ARRAY_SIZE)) {
-			if (cur_name)
+		if (!have_cur || strncmp(cur_name, name, NODE_DESCRIPTION_ARRAY_SIZE)) {
+			if (have_cur)
 				printf("\n");
 			// new host name
-			if (0 == strncmp(myhostname, namep->name, myhostname_len) &&
-			    (namep->name[myhostname_len] == 0 || namep->name[myhostname_len] == '.'))
+			if (0 == strncmp(myhostname, name, myhostname_len) &&
+			    (name[myhostname_len] == 0 || name[myhostname_len] == '.'))
 				printf("#");	// comment out our host
-			printf("%s",namep->name);
+			printf("%s",name);
 			if (tmp)
 				printf(":%s", tmp+1);
-			cur_name = namep->name;
+			StringCopy(cur_name, name, sizeof(cur_name));
+			have_cur = TRUE;
 		} else if (tmp) {
 			// append interface name
 			printf(",%s", tmp+1);
 		}
 	}
 	printf("\n");
-	FreeNameList(&host_list);
 	fprintf(stderr, "%u of %u Input NICs Shown, %u Bad Input Skipped\n",
-			input_checked, QListCount(&g_Fabric.ExpectedFIs), bad_input);
+			input_checked, num_fis, bad_input);
 
+done:
+	FreeNameList(&host_list);
+	if (namepp)
+		MemoryDeallocate(namepp);
+	if (names)
+		MemoryDeallocate(names);
 	return;
 }
 
@@ -1127,144 +1244,82 @@ void ShowFastFabricHosts(name_mode_t node_name_mode)
 void ShowSlurmFakeISLs(name_mode_t switch_name_mode)
 {
 	LIST_ITEM *p;
-	ExpectedNode fake = {
-		NodeType: STL_NODE_SW,
-		NodeDesc: "fake",
-		NodeGUID: 0x00066A0102FFFFFF
-	};
+	NameList_t neigh_list;
+	NameData_t nameData = { };
+	uint32 ix = 0;
 
 	// build list of neighbors for "fake" core switch listing all switches
 	// which have unfiltered NICs
+	InitNameList(&neigh_list);
 	for (p=QListHead(&g_Fabric.ExpectedSWs); p != NULL; p = QListNext(&g_Fabric.ExpectedSWs, p)) {
 		ExpectedNode *enodep = (ExpectedNode *)QListObj(p);
-		cl_qmap_t *neigh_list;
+		NodeNames_t *namesp = GetNodeNames(enodep);
 
-		if (! enodep->context)	// switch has no neighbors
-			continue;
-		neigh_list = GetSwitchFiNeighNameList(enodep);
-		if (cl_qmap_head(neigh_list) == cl_qmap_end(neigh_list))
+		if (! namesp->fiNeighbors)
 			continue;	// switch has no NIC neighbors
-		(void)AddSwitchSwNameList(&fake, enodep->NodeDesc, enodep->NodeGUID, switch_name_mode, NULL, NULL);
+		if (FSUCCESS != AddNameList(&neigh_list, 0, &namesp->name))
+			goto done;
 	}
 
-	if (! fake.context)
+	if (! neigh_list.count)
 		return;	// there are no switches with NICs
+	SortNameList(&neigh_list);
 
 	printf("# Fake Switch to Switch Connectivity\n");
-	{
-		ExpectedNode *enodep = &fake;
-		int first=1;
-		cl_qmap_t *neigh_list;
-		cl_map_item_t *np;
-
-		neigh_list = GetSwitchSwNeighNameList(enodep);
-		// if using GUIDs for names, simply skip compact and will
-		// get no ranges in output
-		if (switch_name_mode != NAME_MODE_GUID)
-			CompactNameList(neigh_list);
-		for (np=cl_qmap_head(neigh_list); np != cl_qmap_end(neigh_list); np = cl_qmap_next(np)) {
-			NameData_t *namep = PARENT_STRUCT(np, NameData_t, NameListEntry);
-			if (first) {
-				NameData_t nameData = { };
-				printf("SwitchName=");
-				CopyName(&nameData, enodep->NodeDesc, enodep->NodeGUID, switch_name_mode, NULL, NULL);
-				PrintName(&nameData);
-				printf(" Switches=");
-				first=0;
-			} else {
-				printf(",");
-			}
-			PrintName(namep);
-		}
-		if (! first)
-			printf("\n");
-	}
-	FreeSwitchLists(&fake);
+	printf("SwitchName=");
+	CopyName(&nameData, "fake", 0x00066A0102FFFFFF, switch_name_mode, NULL, NULL);
+	PrintName(&nameData);
+	printf(" Switches=");
+	// if using GUIDs for names, simply skip compact and will
+	// get no ranges in output
+	PrintNameList(&neigh_list, &ix, switch_name_mode != NAME_MODE_GUID);
+	printf("\n");
 
+done:
+	FreeNameList(&neigh_list);
 	return;
 }
 
-// Output SLURM topology file ISL lists for each switch of the form:
-//     SwitchName=xyz Switches=abc,def,ghi
-void ShowSlurmISLs(name_mode_t switch_name_mode)
+// Output SLURM topology file lists for each switch of the form:
+//     SwitchName=xyz Label=abc,def,ghi
+// neigh_list has been sorted by switch index
+static void ShowSlurmSwitchLists(const NameList_t *neigh_list, const char *label,
+				name_mode_t name_mode)
 {
-	LIST_ITEM *p;
+	uint32 ix = 0;
 
-	printf("# Switch to Switch Connectivity\n");
-	for (p=QListHead(&g_Fabric.ExpectedSWs); p != NULL; p = QListNext(&g_Fabric.ExpectedSWs, p)) {
-		ExpectedNode *enodep = (ExpectedNode *)QListObj(p);
-		cl_qmap_t *neigh_list;
-		int first=1;
-		cl_map_item_t *np;
+	while (ix < neigh_list->count) {
+		NodeNames_t *swnamesp = &g_NodeNames[NameEntryList(&neigh_list->entries[ix])];
 
-		if (! enodep->context)	// switch has no neighbors
-			continue;
-		neigh_list = GetSwitchSwNeighNameList(enodep);
+		printf("SwitchName=");
+		PrintName(&swnamesp->name);
+		printf(" %s=", label);
 		// if using GUIDs for names, simply skip compact and will
 		// get no ranges in output
-		if (switch_name_mode != NAME_MODE_GUID)
-			CompactNameList(neigh_list);
-		for (np=cl_qmap_head(neigh_list); np != cl_qmap_end(neigh_list); np = cl_qmap_next(np)) {
-			NameData_t *namep = PARENT_STRUCT(np, NameData_t, NameListEntry);
-			if (first) {
-				NameData_t nameData = { };
-				printf("SwitchName=");
-				CopyName(&nameData, enodep->NodeDesc, enodep->NodeGUID, switch_name_mode, NULL, NULL);
-				PrintName(&nameData);
-				printf(" Switches=");
-				first=0;
-			} else {
-				printf(",");
-			}
-			PrintName(namep);
-		}
-		if (! first)
-			printf("\n");
+		PrintNameList(neigh_list, &ix, name_mode != NAME_MODE_GUID);
+		printf("\n");
 	}
+}
 
+// Output SLURM topology file ISL lists for each switch of the form:
+//     SwitchName=xyz Switches=abc,def,ghi
+void ShowSlurmISLs(name_mode_t switch_name_mode)
+{
+	printf("# Switch to Switch Connectivity\n");
+	ShowSlurmSwitchLists(&g_SwNeighborNames, "Switches", switch_name_mode);
 	return;
 }
 
 // Output SLURM topology file NIC lists for each switch of the form:
 //     SwitchName=xyz Nodes=abc,def,ghi
-void ShowSlurmNodes(name_mode_t switch_name_mode, name_mode_t node_name_mode)
+void ShowSlurmNodes(name_mode_t switch_name_mode _UNUSED_, name_mode_t node_name_mode)
 {
-	LIST_ITEM *p;
-
 	printf("# Switch to NIC Connectivity\n");
-	for (p=QListHead(&g_Fabric.ExpectedSWs); p != NULL; p = QListNext(&g_Fabric.ExpectedSWs, p)) {
-		ExpectedNode *enodep = (ExpectedNode *)QListObj(p);
-		cl_qmap_t *neigh_list;
-		int first=1;
-		cl_map_item_t *np;
-
-		if (! enodep->context)	// switch has no NIC neighbors
-			continue;
-		neigh_list = GetSwitchFiNeighNameList(enodep);
-		// if using GUIDs for names, simply skip compact and will
-		// get no ranges in output
-		if (node_name_mode != NAME_MODE_GUID)
-			CompactNameList(neigh_list);
-		for (np=cl_qmap_head(neigh_list); np != cl_qmap_end(neigh_list); np = cl_qmap_next(np)) {
-			NameData_t *namep = PARENT_STRUCT(np, NameData_t, NameListEntry);
-			if (first) {
-				NameData_t nameData = { };
-				printf("SwitchName=");
-				CopyName(&nameData, enodep->NodeDesc, enodep->NodeGUID, switch_name_mode, NULL, NULL);
-				PrintName(&nameData);
-				printf(" Nodes=");
-				first=0;
-			} else {
-				printf(",");
-			}
-			PrintName(namep);
-		}
-		if (! first)
-			printf("\n");
-	}
+	ShowSlurmSwitchLists(&g_FiNeighborNames, "Nodes", node_name_mode);
 	return;
 }
 
+
 // command line options, each has a short and long flag name
 struct option options[] = {
 		{ "verbose", no_argument, NULL, 'v' },
@@ -1558,8 +1613,12 @@ int main(int argc, char ** argv)
 
 	if (report & (REPORT_SLURM|REPORT_SLURMFULL)) {
 	        name_mode_t node_name_mode = NAME_MODE_TRUNC_DASH;
-		BuildAllSwitchLists(switch_name_mode, node_name_mode,
-							 0 != (report&REPORT_SLURMFULL), 1);
+		if (FSUCCESS != BuildAllSwitchLists(switch_name_mode, node_name_mode,
+							 0 != (report&REPORT_SLURMFULL), 1)) {
+			FreeAllSwitchNamelists();
+			exitstatus = 1;
+			goto destroy;
+		}
 		PrintComment("#", argc, argv);
 		ShowSlurmNodes(switch_name_mode, node_name_mode);
 		if (report & REPORT_SLURM) {
@@ -1573,6 +1632,7 @@ int main(int argc, char ** argv)
 		FreeAllSwitchNamelists();
 	}
 
+destroy:
 	DestroyFabricData(&g_Fabric);
 done:
 
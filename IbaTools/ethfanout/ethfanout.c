@@ -0,0 +1,569 @@
+/* BEGIN_ICS_COPYRIGHT7 ****************************************
+
+Copyright (c) 2023, Intel Corporation
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+** END_ICS_COPYRIGHT7   ****************************************/
+
+/* [ICS VERSION STRING: unknown] */
+
+// Run a shell command once per host with a bounded number of commands in
+// flight.  As soon as one command exits the next host is started, so a slow
+// host only occupies its own slot rather than holding up a whole batch.
+// Each command's stdout and stderr are captured in a buffer per command so
+// output from different hosts is never interleaved mid-line.
+//
+// This is used by the FastFabric ethcmdall, ethscpall and ethpingall
+// scripts for their -p (parallel) options.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <getopt.h>
+
+#define BASENAME "ethfanout"
+
+#define SHELL "/bin/bash"	// FastFabric command templates use bash
+#define KILL_GRACE 5		// seconds after SIGTERM before SIGKILL
+#define READ_SIZE 4096
+
+// output captured from one of a command's stdout or stderr
+typedef struct {
+	int		fd;			// read side of pipe, -1 once EOF
+	FILE	*out;		// where output is eventually written
+	char	*buf;
+	size_t	len;
+	size_t	size;
+} Output_t;
+
+// one slot for a running command
+typedef struct {
+	pid_t		pid;		// 0 if slot is free
+	const char	*host;
+	int			status;		// from waitpid, valid once reaped
+	int			reaped;
+	int			timed_out;
+	time_t		deadline;	// when to signal the command, 0 -> no limit
+	Output_t	output[2];	// stdout and stderr
+} Job_t;
+
+int		g_serialize = 0;		// output each command's output when it exits
+int		g_prefix = 0;			// prefix each output line with "host: "
+int		g_timelimit = 0;		// seconds per command, 0 -> unlimited
+const char *g_message = NULL;	// describes command in failure reports
+int		g_sigchld_pipe[2];		// written by SIGCHLD handler to wake poll
+volatile sig_atomic_t g_signaled = 0;	// got SIGINT, SIGTERM or SIGHUP
+
+void Usage_full(void)
+{
+	fprintf(stderr, "Usage: %s [-SP] [-p max_parallel] [-T timelimit] [-m message]\n", BASENAME);
+	fprintf(stderr, "                 'cmd' host ...\n");
+	fprintf(stderr, "              or\n");
+	fprintf(stderr, "       %s --help\n", BASENAME);
+	fprintf(stderr, "   --help - Produces full help text.\n");
+	fprintf(stderr, "   -p max_parallel - Specifies maximum commands to run concurrently.\n");
+	fprintf(stderr, "        Default is 1.\n");
+	fprintf(stderr, "   -T timelimit - Specifies the time limit in seconds for each command.\n");
+	fprintf(stderr, "        Default is 0 (infinite).\n");
+	fprintf(stderr, "   -S - Outputs all of a command's output together when it completes.\n");
+	fprintf(stderr, "        Default is to output each complete line as it arrives.\n");
+	fprintf(stderr, "   -P - Outputs the host name as a prefix to each output line.\n");
+	fprintf(stderr, "   -m message - Reports each failed command to stderr as:\n");
+	fprintf(stderr, "        'message: Command execution FAILED: reason'. Any %%h in message\n");
+	fprintf(stderr, "        is replaced with the host name and %%%% with %%.\n");
+	fprintf(stderr, "   cmd - Specifies the %s command to run for each host. The host name\n", SHELL);
+	fprintf(stderr, "        is available to the command as $1.\n");
+	fprintf(stderr, "   host - Specifies the list of hosts.\n");
+	fprintf(stderr, "The exit status is 0 if every command succeeded and 1 otherwise.\n");
+	exit(0);
+}
+
+void Usage(void)
+{
+	fprintf(stderr, "Usage: %s [-SP] [-p max_parallel] [-T timelimit] [-m message]\n", BASENAME);
+	fprintf(stderr, "                 'cmd' host ...\n");
+	fprintf(stderr, "              or\n");
+	fprintf(stderr, "       %s --help\n", BASENAME);
+	exit(2);
+}
+
+void SigChldHandler(int sig _UNUSED_)
+{
+	int save_errno = errno;
+
+	// pipe is non-blocking, if its full poll will already wake up
+	if (write(g_sigchld_pipe[1], "", 1) < 0) {
+		// ignore
+	}
+	errno = save_errno;
+}
+
+void SigTermHandler(int sig)
+{
+	g_signaled = 1;
+	SigChldHandler(sig);	// wake up poll
+}
+
+static int SetNonBlocking(int fd)
+{
+	int flags = fcntl(fd, F_GETFL);
+
+	if (flags < 0)
+		return -1;
+	return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static void *Alloc(size_t size)
+{
+	void *p = malloc(size);
+
+	if (! p) {
+		fprintf(stderr, "%s: Out of memory\n", BASENAME);
+		exit(1);
+	}
+	return p;
+}
+
+// write len bytes of buf to out, with host prefix at start of each line
+// if -P.  If final is set a trailing partial line is completed with a newline
+static void WriteLines(FILE *out, const char *host, const char *buf, size_t len,
+						int final)
+{
+	if (! g_prefix) {
+		fwrite(buf, 1, len, out);
+	} else {
+		while (len) {
+			const char *nl = memchr(buf, '\n', len);
+			size_t linelen = nl? (size_t)(nl - buf + 1) : len;
+
+			fprintf(out, "%s: ", host);
+			fwrite(buf, 1, linelen, out);
+			if (! nl && final)
+				fputc('\n', out);
+			buf += linelen;
+			len -= linelen;
+		}
+	}
+	fflush(out);
+}
+
+// output and discard the complete lines buffered in outp
+static void FlushLines(Job_t *jobp, Output_t *outp)
+{
+	char *nl;
+	size_t linelen;
+
+	if (! outp->len)
+		return;
+	nl = memrchr(outp->buf, '\n', outp->len);
+	if (! nl)
+		return;
+	linelen = nl - outp->buf + 1;
+	WriteLines(outp->out, jobp->host, outp->buf, linelen, 0);
+	memmove(outp->buf, outp->buf + linelen, outp->len - linelen);
+	outp->len -= linelen;
+}
+
+// read what is available from outp's pipe
+static void ReadOutput(Job_t *jobp, Output_t *outp)
+{
+	for (;;) {
+		ssize_t n;
+
+		if (outp->size - outp->len < READ_SIZE) {
+			size_t size = outp->size? outp->size * 2 : READ_SIZE * 2;
+			char *buf = Alloc(size);
+
+			if (outp->len)
+				memcpy(buf, outp->buf, outp->len);
+			free(outp->buf);
+			outp->buf = buf;
+			outp->size = size;
+		}
+		n = read(outp->fd, outp->buf + outp->len, outp->size - outp->len);
+		if (n > 0) {
+			outp->len += n;
+			continue;
+		}
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		// EOF or error
+		close(outp->fd);
+		outp->fd = -1;
+		break;
+	}
+	if (! g_serialize)
+		FlushLines(jobp, outp);
+}
+
+// fork and exec cmd for host in jobp
+static int StartJob(Job_t *jobp, const char *cmd, const char *host)
+{
+	int pipes[2][2];
+	pid_t pid;
+	int i;
+
+	if (pipe(pipes[0]) < 0)
+		goto fail;
+	if (pipe(pipes[1]) < 0) {
+		close(pipes[0][0]);
+		close(pipes[0][1]);
+		goto fail;
+	}
+	fflush(stdout);
+	fflush(stderr);
+	pid = fork();
+	if (pid < 0) {
+		for (i=0; i < 2; i++) {
+			close(pipes[i][0]);
+			close(pipes[i][1]);
+		}
+		goto fail;
+	}
+	if (pid == 0) {
+		int fd;
+
+		// child, run in its own process group so a time limit can
+		// stop everything it started
+		setpgid(0, 0);
+		signal(SIGCHLD, SIG_DFL);
+		signal(SIGINT, SIG_DFL);
+		signal(SIGTERM, SIG_DFL);
+		signal(SIGHUP, SIG_DFL);
+		fd = open("/dev/null", O_RDONLY);
+		if (fd >= 0) {
+			dup2(fd, 0);
+			close(fd);
+		}
+		dup2(pipes[0][1], 1);
+		dup2(pipes[1][1], 2);
+		for (i=0; i < 2; i++) {
+			close(pipes[i][0]);
+			close(pipes[i][1]);
+		}
+		close(g_sigchld_pipe[0]);
+		close(g_sigchld_pipe[1]);
+		execl(SHELL, SHELL, "-c", cmd, BASENAME, host, (char *)NULL);
+		fprintf(stderr, "%s: Unable to run %s: %s\n", BASENAME, SHELL, strerror(errno));
+		_exit(127);
+	}
+	// parent
+	setpgid(pid, pid);	// avoid race with child's setpgid
+	jobp->pid = pid;
+	jobp->host = host;
+	jobp->status = 0;
+	jobp->reaped = 0;
+	jobp->timed_out = 0;
+	jobp->deadline = g_timelimit? time(NULL) + g_timelimit : 0;
+	for (i=0; i < 2; i++) {
+		close(pipes[i][1]);
+		jobp->output[i].fd = pipes[i][0];
+		jobp->output[i].len = 0;
+		(void)SetNonBlocking(pipes[i][0]);
+	}
+	return 0;
+
+fail:
+	fprintf(stderr, "%s: %s: Unable to start command: %s\n", BASENAME, host, strerror(errno));
+	return -1;
+}
+
+// report a failed command as host_run_cmd in target.exp did
+static void ReportFailure(Job_t *jobp)
+{
+	const char *p;
+	char reason[64];
+
+	if (jobp->timed_out)
+		snprintf(reason, sizeof(reason), "Timeout");
+	else if (WIFEXITED(jobp->status))
+		snprintf(reason, sizeof(reason), "child exit code: %d", WEXITSTATUS(jobp->status));
+	else if (WIFSIGNALED(jobp->status))
+		snprintf(reason, sizeof(reason), "child killed: %s", strsignal(WTERMSIG(jobp->status)));
+	else
+		snprintf(reason, sizeof(reason), "child status: 0x%x", jobp->status);
+
+	if (g_prefix)
+		fprintf(stderr, "%s: ", jobp->host);
+	for (p = g_message; *p; p++) {
+		if (p[0] == '%' && p[1] == 'h') {
+			fputs(jobp->host, stderr);
+			p++;
+		} else if (p[0] == '%' && p[1] == '%') {
+			fputc('%', stderr);
+			p++;
+		} else {
+			fputc(*p, stderr);
+		}
+	}
+	fprintf(stderr, ": Command execution FAILED: %s\n", reason);
+	fflush(stderr);
+}
+
+// output whatever remains for a completed command and free its slot
+// returns 0 if command succeeded
+static int FinishJob(Job_t *jobp)
+{
+	int failed = jobp->timed_out || ! WIFEXITED(jobp->status)
+					|| WEXITSTATUS(jobp->status) != 0;
+	int i;
+
+	for (i=0; i < 2; i++) {
+		Output_t *outp = &jobp->output[i];
+
+		if (outp->fd >= 0) {
+			// command exited but something it started still has the pipe
+			// open, take what's there now rather than waiting for it
+			ReadOutput(jobp, outp);
+			if (outp->fd >= 0) {
+				close(outp->fd);
+				outp->fd = -1;
+			}
+		}
+		if (outp->len)
+			WriteLines(outp->out, jobp->host, outp->buf, outp->len, 1);
+		outp->len = 0;
+	}
+	if (failed && g_message)
+		ReportFailure(jobp);
+	jobp->pid = 0;
+	return failed;
+}
+
+// stop all running commands, used when we are interrupted
+static void KillAll(Job_t *jobs, int max_parallel)
+{
+	int i;
+
+	for (i=0; i < max_parallel; i++) {
+		if (jobs[i].pid && ! jobs[i].reaped)
+			kill(-jobs[i].pid, SIGTERM);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int c;
+	int max_parallel = 1;
+	const char *cmd;
+	char **hosts;
+	int num_hosts;
+	int next_host = 0;
+	int running = 0;
+	int failed = 0;
+	Job_t *jobs;
+	struct pollfd *fds;
+	Job_t **fd_jobs;
+	Output_t **fd_outputs;
+	struct sigaction sa;
+	int i;
+
+	if (argc > 1 && 0 == strcmp(argv[1], "--help"))
+		Usage_full();
+
+	while (-1 != (c = getopt(argc, argv, "+p:T:SPm:"))) {
+		switch (c) {
+		case 'p':
+			max_parallel = atoi(optarg);
+			if (max_parallel < 1) {
+				fprintf(stderr, "%s: Invalid max_parallel: %s\n", BASENAME, optarg);
+				Usage();
+			}
+			break;
+		case 'T':
+			g_timelimit = atoi(optarg);
+			if (g_timelimit < 0)
+				g_timelimit = 0;
+			break;
+		case 'S':
+			g_serialize = 1;
+			break;
+		case 'P':
+			g_prefix = 1;
+			break;
+		case 'm':
+			g_message = optarg;
+			break;
+		default:
+			Usage();
+			break;
+		}
+	}
+	if (optind >= argc)
+		Usage();
+	cmd = argv[optind++];
+	hosts = &argv[optind];
+	num_hosts = argc - optind;
+	if (max_parallel > num_hosts)
+		max_parallel = num_hosts;
+	if (! num_hosts)
+		return 0;
+
+	jobs = Alloc(sizeof(Job_t) * max_parallel);
+	memset(jobs, 0, sizeof(Job_t) * max_parallel);
+	for (i=0; i < max_parallel; i++) {
+		jobs[i].output[0].out = stdout;
+		jobs[i].output[1].out = stderr;
+	}
+	// one pollfd for SIGCHLD pipe plus up to 2 per job
+	fds = Alloc(sizeof(struct pollfd) * (1 + 2 * max_parallel));
+	fd_jobs = Alloc(sizeof(Job_t *) * (1 + 2 * max_parallel));
+	fd_outputs = Alloc(sizeof(Output_t *) * (1 + 2 * max_parallel));
+
+	if (pipe(g_sigchld_pipe) < 0) {
+		fprintf(stderr, "%s: Unable to create pipe: %s\n", BASENAME, strerror(errno));
+		return 1;
+	}
+	(void)SetNonBlocking(g_sigchld_pipe[0]);
+	(void)SetNonBlocking(g_sigchld_pipe[1]);
+	(void)fcntl(g_sigchld_pipe[0], F_SETFD, FD_CLOEXEC);
+	(void)fcntl(g_sigchld_pipe[1], F_SETFD, FD_CLOEXEC);
+	memset(&sa, 0, sizeof(sa));
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+	sa.sa_handler = SigChldHandler;
+	sigaction(SIGCHLD, &sa, NULL);
+	sa.sa_flags = SA_RESTART;
+	sa.sa_handler = SigTermHandler;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	sigaction(SIGHUP, &sa, NULL);
+
+	while (next_host < num_hosts || running) {
+		int nfds = 0;
+		int timeout = -1;
+		time_t now;
+		pid_t pid;
+		int status;
+
+		if (g_signaled) {
+			KillAll(jobs, max_parallel);
+			fprintf(stderr, "%s: Interrupted\n", BASENAME);
+			return 1;
+		}
+
+		// keep every slot busy
+		for (i=0; i < max_parallel && next_host < num_hosts; i++) {
+			if (jobs[i].pid)
+				continue;
+			if (0 == StartJob(&jobs[i], cmd, hosts[next_host]))
+				running++;
+			else
+				failed = 1;
+			next_host++;
+		}
+		if (! running)
+			continue;
+
+		// wait for output, a child to exit or a time limit
+		fds[nfds].fd = g_sigchld_pipe[0];
+		fds[nfds].events = POLLIN;
+		fd_jobs[nfds] = NULL;
+		nfds++;
+		now = time(NULL);
+		for (i=0; i < max_parallel; i++) {
+			Job_t *jobp = &jobs[i];
+			int j;
+
+			if (! jobp->pid)
+				continue;
+			for (j=0; j < 2; j++) {
+				if (jobp->output[j].fd < 0)
+					continue;
+				fds[nfds].fd = jobp->output[j].fd;
+				fds[nfds].events = POLLIN;
+				fd_jobs[nfds] = jobp;
+				fd_outputs[nfds] = &jobp->output[j];
+				nfds++;
+			}
+			if (jobp->deadline && ! jobp->reaped) {
+				int left = (jobp->deadline > now)? (int)(jobp->deadline - now) : 0;
+				if (timeout < 0 || left * 1000 < timeout)
+					timeout = left * 1000;
+			}
+		}
+		if (poll(fds, nfds, timeout) < 0 && errno != EINTR) {
+			fprintf(stderr, "%s: poll failed: %s\n", BASENAME, strerror(errno));
+			KillAll(jobs, max_parallel);
+			return 1;
+		}
+		for (i=1; i < nfds; i++) {
+			if (fds[i].revents)
+				ReadOutput(fd_jobs[i], fd_outputs[i]);
+		}
+		if (fds[0].revents) {
+			char buf[64];
+			while (read(g_sigchld_pipe[0], buf, sizeof(buf)) > 0)
+				;
+		}
+
+		// reap exited children
+		while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+			for (i=0; i < max_parallel; i++) {
+				if (jobs[i].pid == pid) {
+					jobs[i].status = status;
+					jobs[i].reaped = 1;
+					break;
+				}
+			}
+		}
+
+		// apply time limits, SIGTERM then SIGKILL if it doesn't exit
+		now = time(NULL);
+		for (i=0; i < max_parallel; i++) {
+			Job_t *jobp = &jobs[i];
+
+			if (! jobp->pid || jobp->reaped || ! jobp->deadline
+				|| now < jobp->deadline)
+				continue;
+			kill(-jobp->pid, jobp->timed_out? SIGKILL : SIGTERM);
+			jobp->timed_out = 1;
+			jobp->deadline = now + KILL_GRACE;
+		}
+
+		// a command is done when it has exited and its output is read, or
+		// it has exited and there was nothing more to read this time
+		for (i=0; i < max_parallel; i++) {
+			Job_t *jobp = &jobs[i];
+
+			if (! jobp->pid || ! jobp->reaped)
+				continue;
+			failed |= FinishJob(jobp);
+			running--;
+		}
+	}
+	return failed? 1 : 0;
+}
@@ -43,8 +43,9 @@ fi
 . /usr/lib/eth-tools/ff_funcs
 
 tempfile="$(mktemp)"
-trap "rm -f $tempfile; exit 1" SIGHUP SIGTERM SIGINT
-trap "rm -f $tempfile" EXIT
+rowsfile="$(mktemp)"
+trap "rm -f $tempfile $rowsfile; exit 1" SIGHUP SIGTERM SIGINT
+trap "rm -f $tempfile $rowsfile" EXIT
 
 punchlist=$FF_RESULT_DIR/punchlist.csv
 del=';'
@@ -141,90 +142,32 @@ append_punchlist()
 	echo "$timestamp$del$1$del$2" >> $punchlist
 }
 
-gen_errors_punchlist()
-# $@ =  snapshot, port and/or topology selection options for ethreport
+gen_links_punchlist()
+# $1 = report
+# $2 = issue
+# stdin is the ethreport --rows output for all the reports
 {
 	(
 	# TBD - is cable information available?
 	export IFS=';'
 	port1=
-	#$ETHREPORT "$@" -o errors -x | /usr/sbin/ethxmlextract -H -d \; -e LinkErrors.Link.Port.NodeGUID -e LinkErrors.Link.Port.PortNum -e LinkErrors.Link.Port.NodeType -e LinkErrors.Link.Port.NodeDesc|while read line
-	eval $ETHREPORT "$@" -o errors -x | /usr/sbin/ethxmlextract -H -d \; -e LinkErrors.Link.Port.NodeDesc -e LinkErrors.Link.Port.PortNum -e LinkErrors.Link.Port.PortId|while read desc port portid
+	while read report desc port portid portprob linkprob
 	do
-		if [ x"$port1" = x ]
+		if [ "$report" != "$1" ]
 		then
-			port1="$desc p$port $portid"
-		else
-			append_punchlist "$port1 $desc p$port $portid" "Link errors"
-			port1=
+			continue
 		fi
-	done
-	)
-}
-
-gen_slowlinks_punchlist()
-# $@ =  snapshot, port and/or topology selection options for ethreport
-{
-	(
-	# TBD - is cable information available?
-	export IFS=';'
-	port1=
-	#$ETHREPORT "$@" -o slowlinks -x | /usr/sbin/ethxmlextract -H -d \; -e LinksExpected.Link.Port.NodeGUID -e LinksExpected.Link.Port.PortNum -e LinksExpected.Link.Port.NodeType -e LinksExpected.Link.Port.NodeDesc|while read line
-	eval $ETHREPORT "$@" -o slowlinks -x | /usr/sbin/ethxmlextract -H -d \; -e LinksExpected.Link.Port.NodeDesc -e LinksExpected.Link.Port.PortNum -e LinksExpected.Link.Port.PortId|while read desc port portid
-	do
 		if [ x"$port1" = x ]
 		then
 			port1="$desc p$port $portid"
 		else
-			append_punchlist "$port1 $desc p$port $portid" "Link speed/width lower than expected"
+			append_punchlist "$port1 $desc p$port $portid" "$2"
 			port1=
 		fi
 	done
 	)
 }
 
-gen_misconfiglinks_punchlist()
-# $@ =  snapshot, port and/or topology selection options for ethreport
-{
-	(
-	# TBD - is cable information available?
-	export IFS=';'
-	port1=
-	#$ETHREPORT "$@" -o misconfiglinks -x | /usr/sbin/ethxmlextract -H -d \; -e LinksConfig.Link.Port.NodeGUID -e LinksConfig.Link.Port.PortNum -e LinksConfig.Link.Port.NodeType -e LinksConfig.Link.Port.NodeDesc|while read line
-	eval $ETHREPORT "$@" -o misconfiglinks -x | /usr/sbin/ethxmlextract -H -d \; -e LinksConfig.Link.Port.NodeDesc -e LinksConfig.Link.Port.PortNum -e LinksConfig.Link.Port.PortId|while read desc port portid
-	do
-		if [ x"$port1" = x ]
-		then
-			port1="$desc p$port $portid"
-		else
-			append_punchlist "$port1 $desc p$port $portid" "Link speed/width configured lower than supported"
-			port1=
-		fi
-	done
-	)
-}
-
-gen_misconnlinks_punchlist()
-# $@ =  snapshot, port and/or topology selection options for ethreport
-{
-	(
-	# TBD - is cable information available?
-	export IFS=';'
-	line1=
-	#$ETHREPORT "$@" -o misconnlinks -x | /usr/sbin/ethxmlextract -H -d \; -e LinksMismatched.Link.Port.NodeGUID -e LinksMismatched.Link.Port.PortNum -e LinksMismatched.Link.Port.NodeType -e LinksMismatched.Link.Port.NodeDesc|while read line
-	eval $ETHREPORT "$@" -o misconnlinks -x | /usr/sbin/ethxmlextract -H -d \; -e LinksMismatched.Link.Port.NodeDesc -e LinksMismatched.Link.Port.PortNum -e LinksMismatched.Link.Port.PortId|while read desc port portid
-	do
-		if [ x"$line1" = x ]
-		then
-			line1="$desc p$port $portid"
-		else
-			append_punchlist "$line1 $desc p$port $portid" "Link speed/width mismatch"
-			line1=
-		fi
-	done
-	)
-}
-
 append_verify_punchlist()
 # $1 = device
 # $2 = issue
@@ -242,7 +185,8 @@ append_verify_punchlist()
 }
 
 process_links_csv()
-# stdin is a csv with all the bad links from a verify*links report
+# $1 = verify*links report
+# stdin is the ethreport --rows output for all the reports
 {
 	(
 	export IFS=';'
@@ -250,8 +194,12 @@ process_links_csv()
 	port2=
 	foundPort=
 	prob=
-	while read desc port portid portprob linkprob
+	while read report desc port portid portprob linkprob
 	do
+		if [ "$report" != "$1" ]
+		then
+			continue
+		fi
 		if [ x"$port1" = x ]
 		then
 			port1="$desc p$port $portid"
@@ -296,63 +244,18 @@ process_links_csv()
 	)
 }
 
-gen_verifylinks_punchlist()
-# $@ =  snapshot, port and/or topology selection options for ethreport
-{
-	# TBD - is cable information available?
-	eval $ETHREPORT "$@" -o verifylinks -x | /usr/sbin/ethxmlextract -H -d \; -e VerifyLinks.Link.Port.NodeDesc -e VerifyLinks.Link.Port.PortNum -e VerifyLinks.Link.Port.PortId -e VerifyLinks.Link.Port.Problem -e VerifyLinks.Link.Problem|process_links_csv
-}
-
-gen_verifyextlinks_punchlist()
-# $@ =  snapshot, port and/or topology selection options for ethreport
-{
-	# TBD - is cable information available?
-	eval $ETHREPORT "$@" -o verifyextlinks -x | /usr/sbin/ethxmlextract -H -d \; -e VerifyExtLinks.Link.Port.NodeDesc -e VerifyExtLinks.Link.Port.PortNum -e VerifyExtLinks.Link.Port.PortId -e VerifyExtLinks.Link.Port.Problem -e VerifyExtLinks.Link.Problem|process_links_csv
-}
-
-gen_verifyniclinks_punchlist()
-# $@ =  snapshot, port and/or topology selection options for ethreport
-{
-	# TBD - is cable information available?
-	eval $ETHREPORT "$@" -o verifyniclinks -x | /usr/sbin/ethxmlextract -H -d \; -e VerifyNICLinks.Link.Port.NodeDesc -e VerifyNICLinks.Link.Port.PortNum -e VerifyNICLinks.Link.Port.PortId -e VerifyNICLinks.Link.Port.Problem -e VerifyNICLinks.Link.Problem|process_links_csv
-}
-
-gen_verifyislinks_punchlist()
-# $@ =  snapshot, port and/or topology selection options for ethreport
-{
-	# TBD - is cable information available?
-	eval $ETHREPORT "$@" -o verifyislinks -x | /usr/sbin/ethxmlextract -H -d \; -e VerifyISLinks.Link.Port.NodeDesc -e VerifyISLinks.Link.Port.PortNum -e VerifyISLinks.Link.Port.PortId -e VerifyISLinks.Link.Port.Problem -e VerifyISLinks.Link.Problem|process_links_csv
-}
-
-gen_verifyextislinks_punchlist()
-# $@ =  snapshot, port and/or topology selection options for ethreport
-{
-	# TBD - is cable information available?
-	eval $ETHREPORT "$@" -o verifyextislinks -x | /usr/sbin/ethxmlextract -H -d \; -e VerifyExtISLinks.Link.Port.NodeDesc -e VerifyExtISLinks.Link.Port.PortNum -e VerifyExtISLinks.Link.Port.PortId -e VerifyExtISLinks.Link.Port.Problem -e VerifyExtISLinks.Link.Problem|process_links_csv
-}
-
-gen_verifynics_punchlist()
-# $@ =  snapshot, port and/or topology selection options for ethreport
-{
-	(
-	export IFS=';'
-	#eval $ETHREPORT "$@" -o verifynics -x | /usr/sbin/ethxmlextract -H -d \; -e VerifyNICs.Node.NodeGUID -e VerifyNICs.Node.Desc -e VerifyNICs.Node.Problem|while read line
-	eval $ETHREPORT "$@" -o verifynics -x | /usr/sbin/ethxmlextract -H -d \; -e VerifyNICs.Node.NodeDesc -e VerifyNICs.Node.Problem |while read desc prob
-	do
-		append_verify_punchlist "$desc" "$prob"
-	done
-	)
-}
-
-gen_verifysws_punchlist()
-# $@ =  snapshot, port and/or topology selection options for ethreport
+gen_nodes_punchlist()
+# $1 = verifynics or verifysws report
+# stdin is the ethreport --rows output for all the reports
 {
 	(
 	export IFS=';'
-	#eval $ETHREPORT "$@" -o verifysws -x | /usr/sbin/ethxmlextract -H -d \; -e VerifySWs.Node.NodeGUID -e VerifySWs.Node.Desc -e VerifySWs.Node.Problem|while read line
-	eval $ETHREPORT "$@" -o verifysws -x | /usr/sbin/ethxmlextract -H -d \; -e VerifySWs.Node.NodeDesc -e VerifySWs.Node.Problem |while read desc prob
+	while read report desc port portid prob linkprob
 	do
-		append_verify_punchlist "$desc" "$prob"
+		if [ "$report" = "$1" ]
+		then
+			append_verify_punchlist "$desc" "$prob"
+		fi
 	done
 	)
 }
@@ -611,21 +514,32 @@ do_analysis()
 		fi
 	fi
 
-	# now generate punchlist
+	# now generate punchlist, all selected reports come from a single
+	# ethreport pass over the snapshot
+	rows_opts=""
+	rows_topt=""
+	for report in $reports
+	do
+		case "$report" in
+		errors) rows_opts="$rows_opts -o errors -c '$config_file'";;
+		verify*) [ "$top_file" != "" ] && rows_opts="$rows_opts -o $report" && rows_topt="$topt";;
+		*) rows_opts="$rows_opts -o $report";;
+		esac
+	done
+	if [ x"$rows_opts" = x ]
+	then
+		return
+	fi
+	eval $ETHREPORT -X $snapshot_input $rows_topt $rows_opts --rows > $rowsfile
 	for report in $reports
 	do
 		case "$report" in
-		errors) gen_errors_punchlist -X $snapshot_input -c "$config_file";;
-		slowlinks) gen_slowlinks_punchlist -X $snapshot_input;;
-		misconfiglinks) gen_misconfiglinks_punchlist -X $snapshot_input;;
-		misconnlinks) gen_misconnlinks_punchlist -X $snapshot_input;;
-		verifylinks) [ "$top_file" != "" ] && gen_verifylinks_punchlist -X $snapshot_input $topt;;
-		verifyextlinks) [ "$top_file" != "" ] && gen_verifyextlinks_punchlist -X $snapshot_input $topt;;
-		verifyniclinks) [ "$top_file" != "" ] && gen_verifyniclinks_punchlist -X $snapshot_input $topt;;
-		verifyislinks) [ "$top_file" != "" ] && gen_verifyislinks_punchlist -X $snapshot_input $topt;;
-		verifyextislinks) [ "$top_file" != "" ] && gen_verifyextislinks_punchlist -X $snapshot_input $topt;;
-		verifynics) [ "$top_file" != "" ] && gen_verifynics_punchlist -X $snapshot_input $topt;;
-		verifysws) [ "$top_file" != "" ] && gen_verifysws_punchlist -X $snapshot_input $topt;;
+		errors) gen_links_punchlist errors "Link errors" < $rowsfile;;
+		slowlinks) gen_links_punchlist slowlinks "Link speed/width lower than expected" < $rowsfile;;
+		misconfiglinks) gen_links_punchlist misconfiglinks "Link speed/width configured lower than supported" < $rowsfile;;
+		misconnlinks) gen_links_punchlist misconnlinks "Link speed/width mismatch" < $rowsfile;;
+		verify*links) process_links_csv $report < $rowsfile;;
+		verifynics|verifysws) gen_nodes_punchlist $report < $rowsfile;;
 		*) continue;;	# should not happen
 		esac
 	done
@@ -675,5 +589,5 @@ do
 	fi
 done
 
-rm -f $tempfile
+rm -f $tempfile $rowsfile
 exit $status
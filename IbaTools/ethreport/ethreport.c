@@ -40,6 +40,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //#include <umad.h>
 #include <time.h>
 #include <string.h>
+#include <sys/wait.h>
 //#include "stl_print.h"
 
 // Used for expanding various enumarations into text equivalents
@@ -68,6 +69,7 @@ int				g_persist		= 0;	// omit transient data like LIDs
 int				g_hard			= 0;	// omit software configured items
 int				g_noname		= 0;	// omit names
 char*			g_snapshot_in_file	= NULL;	// input file being parsed
+int				g_refresh		= 0;	// refresh counters of -X snapshot from fabric
 char*			g_topology_in_file	= NULL;	// input file being parsed
 int				g_limitstats	= 0;	// limit stats to specific focus ports
 STL_PORT_COUNTERS_DATA g_Thresholds;
@@ -78,6 +80,7 @@ int				g_max_lft       = 0;	// Size of largest switch LFT
 int				g_quiet         = 0;	// omit progress output
 int		        g_use_scsc      = 0;    // should validatecreditloops use scsc tables
 int				g_ms_timeout = OMGT_DEF_TIMEOUT_MS;
+uint32			g_top			= 10;	// entries per list in sweepstats report
 
 // All the information about HPN
 char *g_hpnConfigFile = HPN_CONFIG_FILE;
@@ -254,6 +257,124 @@ void XmlPrintLinkStartTag(const char* tag, PortData *portp, int indent)
 				portp->nodep->NodeInfo.NodeGUID, portp->PortNum);
 }
 
+// --rows output, used by scripts such as ethlinkanalysis to get the
+// issues of several reports from a single run.  Each row is:
+// 	report;NodeDesc;PortNum;PortId;Problem;LinkProblem
+// A row is output for each port or node shown in a report and for each
+// additional Problem found against it.  Problems against a link as a whole
+// are output in the LinkProblem field once the link is complete.  This
+// matches the records ethxmlextract produces from the -x output for the
+// same fields, so scripts can switch between the two.
+typedef struct RowState_s {
+	const char *report;
+	char desc[NODE_DESCRIPTION_ARRAY_SIZE+1];
+	char port[4];
+	char portid[TINY_STR_ARRAY_SIZE+1];
+	char problem[100];		// same size as ShowProblem uses
+	char linkproblem[100];
+	boolean in_item;		// port or node in progress
+	boolean changed;		// fields changed since last row output
+} RowState_t;
+
+static RowState_t g_Rows;
+
+// copy a row field, trimming whitespace like XML parsing and replacing
+// characters which would break the row format
+static void RowsCopyField(char *dest, size_t size, const char *src, size_t len)
+{
+	size_t i = 0;
+
+	if (src) {
+		for (; len && *src && isspace((unsigned char)*src); --len, ++src)
+			;
+		for (; len && *src && i < size-1; --len, ++src) {
+			if (iscntrl((unsigned char)*src) || (unsigned char)*src > 0x7f)
+				dest[i++] = '!';
+			else
+				dest[i++] = *src;
+		}
+		while (i && isspace((unsigned char)dest[i-1]))
+			i--;
+	}
+	dest[i] = '\0';
+}
+
+static void RowsSetField(char *field, size_t size, const char *src, size_t len)
+{
+	RowsCopyField(field, size, src, len);
+	if (field[0])
+		g_Rows.changed = TRUE;
+}
+
+static void RowsOutput(void)
+{
+	if (! g_Rows.changed)
+		return;
+	printf("%s;%s;%s;%s;%s;%s\n", g_Rows.report, g_Rows.desc, g_Rows.port,
+			g_Rows.portid, g_Rows.problem, g_Rows.linkproblem);
+	g_Rows.changed = FALSE;
+}
+
+void RowsStartReport(const char *report)
+{
+	memset(&g_Rows, 0, sizeof(g_Rows));
+	g_Rows.report = report;
+}
+
+// start a port, fields which are not known should be NULL/FALSE
+void RowsStartPort(const char *desc, boolean gotPortNum, uint8 portnum, const char *portid)
+{
+	char buf[sizeof(g_Rows.port)] = "";
+
+	g_Rows.in_item = TRUE;
+	RowsSetField(g_Rows.desc, sizeof(g_Rows.desc),
+			g_noname?NULL:desc, NODE_DESCRIPTION_ARRAY_SIZE);
+	if (gotPortNum)
+		snprintf(buf, sizeof(buf), "%u", portnum);
+	RowsSetField(g_Rows.port, sizeof(g_Rows.port), buf, sizeof(buf));
+	RowsSetField(g_Rows.portid, sizeof(g_Rows.portid), portid, TINY_STR_ARRAY_SIZE);
+}
+
+void RowsStartNode(const char *desc)
+{
+	g_Rows.in_item = TRUE;
+	RowsSetField(g_Rows.desc, sizeof(g_Rows.desc),
+			g_noname?NULL:desc, NODE_DESCRIPTION_ARRAY_SIZE);
+}
+
+// a Problem applies to the port or node in progress, otherwise to the link
+void RowsProblem(const char *problem)
+{
+	char *field = g_Rows.in_item ? g_Rows.problem : g_Rows.linkproblem;
+	char buf[sizeof(g_Rows.problem)];
+
+	RowsCopyField(buf, sizeof(buf), problem, sizeof(buf));
+	if (! buf[0] || 0 == strcmp(field, buf))
+		return;
+	if (field[0]) {
+		// row for the previous problem of the same port, node or link
+		RowsOutput();
+	}
+	strcpy(field, buf);
+	g_Rows.changed = TRUE;
+}
+
+void RowsEndItem(void)
+{
+	RowsOutput();
+	g_Rows.desc[0] = '\0';
+	g_Rows.port[0] = '\0';
+	g_Rows.portid[0] = '\0';
+	g_Rows.problem[0] = '\0';
+	g_Rows.in_item = FALSE;
+}
+
+void RowsEndLink(void)
+{
+	RowsEndItem();
+	g_Rows.linkproblem[0] = '\0';
+}
+
 void DisplaySeparator(void)
 {
 	printf("-------------------------------------------------------------------------------\n");
@@ -329,6 +450,10 @@ void ShowLinkPortBriefSummary(PortData *portp, const char *prefix,
 			ShowPortCounters(portp->pPortCounters, format, indent+4, detail-3);
 
 		break;
+	case FORMAT_ROWS:
+		RowsStartPort((char*)portp->nodep->NodeDesc.NodeString, TRUE,
+				portp->PortNum, (const char*)portp->PortInfo.LocalPortId);
+		break;
 	default:
 		break;
 	}
@@ -336,6 +461,8 @@ void ShowLinkPortBriefSummary(PortData *portp, const char *prefix,
 		(*callback)(context, portp, format, indent+4, detail-1);
 	if (format == FORMAT_XML)
 		printf("%*s</Port>\n", indent, "");
+	else if (format == FORMAT_ROWS)
+		RowsEndItem();
 }
 
 // show 1 port in a link in multi-line form with heading per field
@@ -455,6 +582,8 @@ void ShowLinkToBriefSummary(PortData *portp2, const char* toprefix, boolean clos
 	}
 	if (format == FORMAT_XML && close_link)
 		printf("%*s</Link>\n", indent-4, "");
+	else if (format == FORMAT_ROWS && close_link)
+		RowsEndLink();
 }
 
 // show both sides of a link, portp1 should be the "from" port
@@ -617,6 +746,14 @@ void ShowExpectedLinkPortSelBriefSummary(const char* prefix,
 			}
 		}
 		break;
+	case FORMAT_ROWS:
+		if (portselp) {
+			PortData *portp = side == 1 ? elinkp->portp1 : elinkp->portp2;
+			RowsStartPort(portselp->NodeDesc, portselp->gotPortNum,
+				portselp->PortNum,
+				portp?(const char*)portp->PortInfo.LocalPortId:portselp->PortId);
+		}
+		break;
 	default:
 		break;
 	}
@@ -624,6 +761,8 @@ void ShowExpectedLinkPortSelBriefSummary(const char* prefix,
 		(*callback)(elinkp, side, format, indent+4, detail-1);
 	if (format == FORMAT_XML)
 		printf("%*s</Port>\n", indent, "");
+	else if (format == FORMAT_ROWS)
+		RowsEndItem();
 }
 
 void ShowPointExpectedLinkBriefSummary(const char* prefix, ExpectedLink *elinkp, Format_t format, int indent, int detail)
@@ -874,7 +1013,7 @@ void ShowPointBriefSummary(Point* point, uint8 find_flag, Format_t format, int i
 
 void ShowPointFocus(Point* focus, uint8 find_flag, Format_t format, int indent, int detail)
 {
-	if (! focus || g_quietfocus)
+	if (! focus || g_quietfocus || format == FORMAT_ROWS)
 		return;
 	if (PointValid(focus)) {
 		switch (format) {
@@ -2289,6 +2428,9 @@ void ShowNodeBriefSummary(NodeData *nodep, Point *focus,
 	case FORMAT_XML:
 		PrintXmlNodeSummaryBrief(nodep, indent);
 		break;
+	case FORMAT_ROWS:
+		RowsStartNode((char*)nodep->NodeDesc.NodeString);
+		break;
 	default:
 		break;
 	}
@@ -2297,6 +2439,8 @@ void ShowNodeBriefSummary(NodeData *nodep, Point *focus,
 
 	if (close_node && format == FORMAT_XML) {
 		printf("%*s</Node>\n", indent, "");
+	} else if (close_node && format == FORMAT_ROWS) {
+		RowsEndItem();
 	}
 }
 
@@ -2345,11 +2489,16 @@ void ShowExpectedNodeBriefSummary(const char *prefix, ExpectedNode *enodep,
 		if (enodep->details)
 			XmlPrintOptionalStr("NodeDetails", enodep->details, indent+4);
 		break;
+	case FORMAT_ROWS:
+		RowsStartNode(enodep->NodeDesc);
+		break;
 	default:
 		break;
 	}
 	if (close_node && format == FORMAT_XML) {
 		printf("%*s</%s>\n", indent, "", xml_tag);
+	} else if (close_node && format == FORMAT_ROWS) {
+		RowsEndItem();
 	}
 }
 
@@ -3193,6 +3342,9 @@ void ShowSlowLinkReport(LinkReport_t report, boolean one_report, Point *focus, F
 			printf("%*s<LinksExpected> <!-- Links running slower than expected Summary -->\n", indent, "");
 			xmltag="LinksExpected";
 			break;
+		case FORMAT_ROWS:
+			RowsStartReport("slowlinks");
+			break;
 		default:
 			break;
 		}
@@ -3209,6 +3361,9 @@ void ShowSlowLinkReport(LinkReport_t report, boolean one_report, Point *focus, F
 				printf("%*s<LinksConfig> <!-- Links configured slower than supported Summary -->\n", indent, "");
 				xmltag="LinksConfig";
 				break;
+			case FORMAT_ROWS:
+				RowsStartReport("misconfiglinks");
+				break;
 			default:
 				break;
 			}
@@ -3238,6 +3393,9 @@ void ShowSlowLinkReport(LinkReport_t report, boolean one_report, Point *focus, F
 				printf("%*s<LinksMismatched> <!-- Links connected with mismatched supported speeds Summary -->\n", indent, "");
 				xmltag="LinksMismatched";
 				break;
+			case FORMAT_ROWS:
+				RowsStartReport("misconnlinks");
+				break;
 			default:
 				break;
 			}
@@ -3555,6 +3713,58 @@ void ShowLinkInfoReport(Point *focus, Format_t format, int indent, int detail)
 
 }
 
+// output host to switch port map and inter-switch links in a simple
+// whitespace separated form for use by MPI apps such as deviation and
+// mpi_groupstress to choose topology aware test pairs
+void ShowHostMapReport(Point *focus, int indent, int detail _UNUSED_)
+{
+	LIST_ITEM *p;
+	PortData *portp1, *portp2;
+	uint32 hosts = 0;
+	uint32 isls = 0;
+
+	printf("%*s# HostMap Summary\n", indent, "");
+	printf("%*s# hostname switchname switchport\n", indent, "");
+	printf("%*s# isl switchname switchport switchname switchport\n", indent, "");
+
+	for (p=QListHead(&g_Fabric.AllPorts); p != NULL; p = QListNext(&g_Fabric.AllPorts, p)) {
+		portp1 = (PortData *)QListObj(p);
+		// to avoid duplicated processing, only process "from" ports in link
+		if (! portp1->from)
+			continue;
+		if (! ComparePortPoint(portp1, focus) && ! ComparePortPoint(portp1->neighbor, focus))
+			continue;
+
+		portp2 = portp1->neighbor;
+		if (isISLink(portp1)) {
+			printf("%*sisl %.*s %u %.*s %u\n", indent, "",
+				NODE_DESCRIPTION_ARRAY_SIZE,
+				g_noname?g_name_marker:(char*)portp1->nodep->NodeDesc.NodeString,
+				portp1->PortNum,
+				NODE_DESCRIPTION_ARRAY_SIZE,
+				g_noname?g_name_marker:(char*)portp2->nodep->NodeDesc.NodeString,
+				portp2->PortNum);
+			isls++;
+		} else if (isFILink(portp1)) {
+			// report NIC side first, switch side second
+			if (portp1->nodep->NodeInfo.NodeType != STL_NODE_FI) {
+				portp2 = portp1;
+				portp1 = portp1->neighbor;
+			}
+			if (portp2->nodep->NodeInfo.NodeType != STL_NODE_SW)
+				continue;
+			printf("%*s%.*s %.*s %u\n", indent, "",
+				NODE_DESCRIPTION_ARRAY_SIZE,
+				g_noname?g_name_marker:(char*)portp1->nodep->NodeDesc.NodeString,
+				NODE_DESCRIPTION_ARRAY_SIZE,
+				g_noname?g_name_marker:(char*)portp2->nodep->NodeDesc.NodeString,
+				portp2->PortNum);
+			hosts++;
+		}
+	}
+	printf("%*s# %u host links, %u inter-switch links\n", indent, "", hosts, isls);
+}
+
 // output summary of all IB Links with errors > threshold
 void ShowLinkErrorReport(Point *focus, Format_t format, int indent, int detail)
 {
@@ -3572,6 +3782,9 @@ void ShowLinkErrorReport(Point *focus, Format_t format, int indent, int detail)
 				g_threshold_compare?">=":">");
 		indent+=4;
 		break;
+	case FORMAT_ROWS:
+		RowsStartReport("errors");
+		break;
 	default:
 		break;
 	}
@@ -3815,6 +4028,281 @@ void ShowAllIPReport(Point *focus, Format_t format, int indent, int detail)
 
 }	// End of ShowAllIPReport()
 
+// SNMP sweep telemetry aggregated over all hosts of one model (sysObjectID)
+typedef struct SweepModelStats_s {
+	const char *sysObjectID;
+	uint32 hosts;
+	uint32 timeouts;
+	uint64 totalTime;
+} SweepModelStats_t;
+
+static int CompareHostStatsTime(const void *a, const void *b)
+{
+	const SnmpHostStats_t *h1 = *(const SnmpHostStats_t **)a;
+	const SnmpHostStats_t *h2 = *(const SnmpHostStats_t **)b;
+
+	return (h1->totalTime < h2->totalTime) - (h1->totalTime > h2->totalTime);
+}
+
+static uint64 ColumnAvgLatency(const SnmpColumnStats_t *c)
+{
+	return c->requests ? c->latency / c->requests : 0;
+}
+
+static int CompareColumnStatsLatency(const void *a, const void *b)
+{
+	uint64 l1 = ColumnAvgLatency((const SnmpColumnStats_t *)a);
+	uint64 l2 = ColumnAvgLatency((const SnmpColumnStats_t *)b);
+
+	return (l1 < l2) - (l1 > l2);
+}
+
+static uint64 ModelAvgTime(const SweepModelStats_t *m)
+{
+	return m->hosts ? m->totalTime / m->hosts : 0;
+}
+
+static int CompareModelStatsTime(const void *a, const void *b)
+{
+	uint64 t1 = ModelAvgTime((const SweepModelStats_t *)a);
+	uint64 t2 = ModelAvgTime((const SweepModelStats_t *)b);
+
+	return (t1 < t2) - (t1 > t2);
+}
+
+// show the slowest hosts, models and OID columns of the SNMP sweep
+void ShowSweepStatsReport(Format_t format, int indent, int detail)
+{
+	SnmpHostStats_t **hosts = NULL;
+	SnmpColumnStats_t *columns = NULL;
+	SweepModelStats_t *models = NULL;
+	uint32 numHosts = 0, numColumns = 0, numModels = 0;
+	uint32 requests = 0, timeouts = 0;
+	uint32 i, j, k;
+
+	switch (format) {
+	case FORMAT_TEXT:
+		printf("%*sSNMP Sweep Statistics Summary\n", indent, "");
+		break;
+	case FORMAT_XML:
+		printf("%*s<SweepStatsSummary>\n", indent, "");
+		indent+=4;
+		break;
+	default:
+		break;
+	}
+
+	if (g_Fabric.SnmpStatsCount) {
+		hosts = (SnmpHostStats_t **)MemoryAllocate2AndClear(
+					g_Fabric.SnmpStatsCount * sizeof(SnmpHostStats_t *),
+					IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+		columns = (SnmpColumnStats_t *)MemoryAllocate2AndClear(
+					g_Fabric.SnmpStatsCount * SNMP_STATS_MAX_COLUMNS * sizeof(SnmpColumnStats_t),
+					IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+		models = (SweepModelStats_t *)MemoryAllocate2AndClear(
+					g_Fabric.SnmpStatsCount * sizeof(SweepModelStats_t),
+					IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+		if (! hosts || ! columns || ! models) {
+			fprintf(stderr, "ethreport: Unable to allocate memory\n");
+			g_exitstatus = 1;
+			goto done;
+		}
+	}
+
+	// aggregate per host columns by OID and hosts by model
+	for (i = 0; i < g_Fabric.SnmpStatsCount; i++) {
+		SnmpHostStats_t *stats = &g_Fabric.SnmpStats[i];
+
+		if (! stats->requests)
+			continue;	// not queried, e.g. out of focus
+		hosts[numHosts++] = stats;
+		requests += stats->requests;
+		timeouts += stats->timeouts;
+		for (j = 0; j < stats->numColumns; j++) {
+			SnmpColumnStats_t *c = &stats->columns[j];
+
+			for (k = 0; k < numColumns && columns[k].oid != c->oid; k++)
+				;
+			if (k == numColumns)
+				columns[numColumns++].oid = c->oid;
+			columns[k].requests += c->requests;
+			columns[k].vars += c->vars;
+			columns[k].latency += c->latency;
+			if (c->maxLatency > columns[k].maxLatency)
+				columns[k].maxLatency = c->maxLatency;
+		}
+		for (k = 0; k < numModels && strcmp(models[k].sysObjectID, stats->sysObjectID); k++)
+			;
+		if (k == numModels)
+			models[numModels++].sysObjectID = stats->sysObjectID;
+		models[k].hosts++;
+		models[k].timeouts += stats->timeouts;
+		models[k].totalTime += stats->totalTime;
+	}
+	if (numHosts) {
+		qsort(hosts, numHosts, sizeof(*hosts), CompareHostStatsTime);
+		qsort(columns, numColumns, sizeof(*columns), CompareColumnStatsLatency);
+		qsort(models, numModels, sizeof(*models), CompareModelStatsTime);
+	}
+
+	switch (format) {
+	case FORMAT_TEXT:
+		printf("%*s%u Hosts Queried, %u Requests, %u Timeouts\n", indent, "",
+				numHosts, requests, timeouts);
+		if (! g_Fabric.SnmpStats)
+			printf("%*sNo statistics, the fabric was not swept\n", indent, "");
+		break;
+	case FORMAT_XML:
+		XmlPrintDec("HostCount", numHosts, indent);
+		XmlPrintDec("Requests", requests, indent);
+		XmlPrintDec("Timeouts", timeouts, indent);
+		break;
+	default:
+		break;
+	}
+	if (! detail || ! numHosts)
+		goto done;
+
+	// slowest hosts
+	switch (format) {
+	case FORMAT_TEXT:
+		printf("%*sSlowest Hosts (times in ms):\n", indent, "");
+		printf("%*s   Total  Connect  Process  Reqs  Tmos  Retr  Type  Name / SysObjectID\n", indent+4, "");
+		break;
+	case FORMAT_XML:
+		printf("%*s<Hosts>\n", indent, "");
+		break;
+	default:
+		break;
+	}
+	for (i = 0; i < numHosts && i < g_top; i++) {
+		SnmpHostStats_t *stats = hosts[i];
+
+		switch (format) {
+		case FORMAT_TEXT:
+			printf("%*s%8.1f %8.1f %8.1f %5u %5u %5u  %-4s  %s\n", indent+4, "",
+					stats->totalTime / 1000.0, stats->connectTime / 1000.0,
+					stats->processTime / 1000.0, stats->requests,
+					stats->timeouts, stats->retries,
+					StlNodeTypeToText(stats->nodeType),
+					g_noname?g_name_marker:stats->name);
+			if (detail > 1 && stats->sysObjectID[0])
+				printf("%*s%s\n", indent+52, "", stats->sysObjectID);
+			break;
+		case FORMAT_XML:
+			printf("%*s<Host>\n", indent+4, "");
+			XmlPrintStr("Name", g_noname?g_name_marker:stats->name, indent+8);
+			XmlPrintNodeType(stats->nodeType, indent+8);
+			XmlPrintStr("SysObjectID", stats->sysObjectID, indent+8);
+			XmlPrintDec("TotalUsec", stats->totalTime, indent+8);
+			XmlPrintDec("ConnectUsec", stats->connectTime, indent+8);
+			XmlPrintDec("ProcessUsec", stats->processTime, indent+8);
+			XmlPrintDec("Requests", stats->requests, indent+8);
+			XmlPrintDec("Responses", stats->responses, indent+8);
+			XmlPrintDec("Vars", stats->vars, indent+8);
+			XmlPrintDec64("Bytes", stats->bytes, indent+8);
+			XmlPrintDec("Timeouts", stats->timeouts, indent+8);
+			XmlPrintDec("Retries", stats->retries, indent+8);
+			printf("%*s</Host>\n", indent+4, "");
+			break;
+		default:
+			break;
+		}
+	}
+
+	// slowest models
+	switch (format) {
+	case FORMAT_TEXT:
+		printf("%*sSlowest Models (times in ms):\n", indent, "");
+		printf("%*s Average  Hosts  Tmos  SysObjectID\n", indent+4, "");
+		break;
+	case FORMAT_XML:
+		printf("%*s</Hosts>\n", indent, "");
+		printf("%*s<Models>\n", indent, "");
+		break;
+	default:
+		break;
+	}
+	for (i = 0; i < numModels && i < g_top; i++) {
+		SweepModelStats_t *m = &models[i];
+
+		switch (format) {
+		case FORMAT_TEXT:
+			printf("%*s%8.1f %6u %5u  %s\n", indent+4, "",
+					ModelAvgTime(m) / 1000.0, m->hosts, m->timeouts,
+					m->sysObjectID[0] ? m->sysObjectID : "unknown");
+			break;
+		case FORMAT_XML:
+			printf("%*s<Model>\n", indent+4, "");
+			XmlPrintStr("SysObjectID", m->sysObjectID, indent+8);
+			XmlPrintDec("HostCount", m->hosts, indent+8);
+			XmlPrintDec64("AverageUsec", ModelAvgTime(m), indent+8);
+			XmlPrintDec("Timeouts", m->timeouts, indent+8);
+			printf("%*s</Model>\n", indent+4, "");
+			break;
+		default:
+			break;
+		}
+	}
+
+	// slowest OID columns
+	switch (format) {
+	case FORMAT_TEXT:
+		printf("%*sSlowest OID Columns (times in ms):\n", indent, "");
+		printf("%*s Average  Maximum   Reqs     Vars  OID\n", indent+4, "");
+		break;
+	case FORMAT_XML:
+		printf("%*s</Models>\n", indent, "");
+		printf("%*s<Columns>\n", indent, "");
+		break;
+	default:
+		break;
+	}
+	for (i = 0; i < numColumns && i < g_top; i++) {
+		SnmpColumnStats_t *c = &columns[i];
+
+		switch (format) {
+		case FORMAT_TEXT:
+			printf("%*s%8.1f %8.1f %6u %8u  %s\n", indent+4, "",
+					ColumnAvgLatency(c) / 1000.0, c->maxLatency / 1000.0,
+					c->requests, c->vars, c->oid);
+			break;
+		case FORMAT_XML:
+			printf("%*s<Column>\n", indent+4, "");
+			XmlPrintStr("OID", c->oid, indent+8);
+			XmlPrintDec("Requests", c->requests, indent+8);
+			XmlPrintDec("Vars", c->vars, indent+8);
+			XmlPrintDec64("AverageUsec", ColumnAvgLatency(c), indent+8);
+			XmlPrintDec("MaximumUsec", c->maxLatency, indent+8);
+			printf("%*s</Column>\n", indent+4, "");
+			break;
+		default:
+			break;
+		}
+	}
+	if (format == FORMAT_XML)
+		printf("%*s</Columns>\n", indent, "");
+
+done:
+	switch (format) {
+	case FORMAT_TEXT:
+		DisplaySeparator();
+		break;
+	case FORMAT_XML:
+		indent-=4;
+		printf("%*s</SweepStatsSummary>\n", indent, "");
+		break;
+	default:
+		break;
+	}
+	if (hosts)
+		MemoryDeallocate(hosts);
+	if (columns)
+		MemoryDeallocate(columns);
+	if (models)
+		MemoryDeallocate(models);
+}
+
 
 // command line options, each has a short and long flag name
 struct option options[] = {
@@ -3831,8 +4319,10 @@ struct option options[] = {
 		{ "config", required_argument, NULL, 'c' },
 		{ "focus", required_argument, NULL, 'F' },
 		{ "xml", no_argument, NULL, 'x' },
+		{ "rows", no_argument, NULL, '*' },
 		{ "infile", required_argument, NULL, 'X' },
 		{ "topology", required_argument, NULL, 'T' },
+		{ "topocache", required_argument, NULL, '&' },
 		{ "quietfocus", no_argument, NULL, 'Q' },
 		{ "allports", no_argument, NULL, 'A' },
 		{ "rc", required_argument, NULL, 'z' },
@@ -3840,6 +4330,10 @@ struct option options[] = {
 		{ "ethconfig", required_argument, NULL, 'E' },
 		{ "plane", required_argument, NULL, 'p' },
 		{ "hostfile", required_argument, NULL, 'f' },
+		{ "refresh", no_argument, NULL, '@' },
+		{ "capture", required_argument, NULL, '#' },
+		{ "sweepstats", required_argument, NULL, '%' },
+		{ "top", required_argument, NULL, '^' },
 		{ "help", no_argument, NULL, '$' },	// use an invalid option character
 
 		{ 0 }
@@ -3848,8 +4342,9 @@ struct option options[] = {
 void Usage_full(void)
 {
 	fprintf(stderr, "Usage: ethreport [-v][-q] [-o report] [-d detail] [-P|-H]\n"
-	                "                    [-N] [-x] [-X snapshot_input] [-T topology_input] [-s]\n"
-	                "                    [-A] [-c file] [-L] [-F point] [-Q] [-E file] [-p plane] [-f hostfile]\n");
+	                "                    [-N] [-x|--rows] [-X snapshot_input] [-T topology_input] [--topocache file] [-s]\n"
+	                "                    [-A] [-c file] [-L] [-F point] [-Q] [-E file] [-p plane] [-f hostfile]\n"
+	                "                    [--refresh] [--capture file] [--sweepstats file] [--top N]\n");
 	fprintf(stderr, "              or\n");
 	fprintf(stderr, "       ethreport --help\n");
 	fprintf(stderr, "    --help - Produces full help text.\n");
@@ -3864,16 +4359,33 @@ void Usage_full(void)
 	fprintf(stderr, "    -H/--hard                 - Only include permanent hardware data.\n");
 	fprintf(stderr, "    -N/--noname               - Omits node.\n");
 	fprintf(stderr, "    -x/--xml                  - Produces output in XML.\n");
+	fprintf(stderr, "    --rows                    - Produces ';' separated rows for use by scripts, one per\n");
+	fprintf(stderr, "                                port or node with an issue, in the form:\n");
+	fprintf(stderr, "                                report;NodeDesc;PortNum;PortId;Problem;LinkProblem\n");
+	fprintf(stderr, "                                Only for errors, slowlinks, misconfiglinks,\n");
+	fprintf(stderr, "                                misconnlinks and verify* reports.\n");
 	fprintf(stderr, "    -X/--infile snapshot_input\n");
 	fprintf(stderr, "                              - Generates a report using the data in the snapshot_input\n");
 	fprintf(stderr, "                                file. snapshot_input must have been generated during a\n");
 	fprintf(stderr, "                                previous -o snapshot run. '-' may be used as the\n");
 	fprintf(stderr, "                                snapshot_input to specify stdin.\n");
+	fprintf(stderr, "    --refresh                 - With -X, keeps the topology from snapshot_input and only\n");
+	fprintf(stderr, "                                re-reads port counters from the fabric. A full sweep is\n");
+	fprintf(stderr, "                                done instead if the fabric changed since the snapshot.\n");
+	fprintf(stderr, "    --capture file            - Records every SNMP request and response of the sweep to\n");
+	fprintf(stderr, "                                file, for replay by ethsnmpsim.\n");
+	fprintf(stderr, "    --sweepstats file         - Writes per host and per OID timing of the sweep to file,\n");
+	fprintf(stderr, "                                as CSV if file ends in .csv, else as JSON.\n");
+	fprintf(stderr, "    --top N                   - Number of hosts, models and OID columns listed by the\n");
+	fprintf(stderr, "                                sweepstats report. Default is 10.\n");
 	fprintf(stderr, "    -T/--topology topology_input\n");
 	fprintf(stderr, "                              - Uses topology_input file to augment and verify fabric\n");
 	fprintf(stderr, "                                information. When used, various reports can be augmented\n");
 	fprintf(stderr, "                                with information not available electronically. '-' may\n");
 	fprintf(stderr, "                                be used to specify stdin.\n");
+	fprintf(stderr, "    --topocache file          - Keeps the parsed topology_input in file. Later runs\n");
+	fprintf(stderr, "                                with an unchanged topology_input load file instead of\n");
+	fprintf(stderr, "                                parsing topology_input again.\n");
 	fprintf(stderr, "    -s/--stats                - Get performance stats for all ports.\n");
 	fprintf(stderr, "    -A/--allports             - Includes PortInfo for down switch ports.\n");
 	fprintf(stderr, "    -c/--config file          - Specifies the error thresholds configuration file.\n");
@@ -3882,9 +4394,14 @@ void Usage_full(void)
 	fprintf(stderr, "                                Default is %s.\n", HPN_CONFIG_FILE);
 	fprintf(stderr, "    -p/--plane plane          - Specifies the name of the enabled plane defined in Mgt\n");
 	fprintf(stderr, "                                config file. Default is the first enabled plane.\n");
+	fprintf(stderr, "                                For -o fabricinfo a space separated list of planes or\n");
+	fprintf(stderr, "                                'ALL' for all enabled planes may be given. The planes\n");
+	fprintf(stderr, "                                are swept in parallel and reported in order.\n");
 	fprintf(stderr, "    -f/--hostfile file        - Specifies the file with hosts in cluster. It overrides the\n");
 	fprintf(stderr, "                                HostsFile for the selected plane that is defined in the\n");
-	fprintf(stderr, "                                Mgt config file.\n");
+	fprintf(stderr, "                                Mgt config file. With multiple planes, a space separated\n");
+	fprintf(stderr, "                                list with one file per plane, 'DEFAULT' uses the plane's\n");
+	fprintf(stderr, "                                HostsFile.\n");
 	fprintf(stderr, "    -L/--limit                - Limits operation to exact specified focus with -F for port\n");
 	fprintf(stderr, "                                error counters check (-o errors). Normally, the neighbor\n");
 	fprintf(stderr, "                                of each selected port is also checked. Does not affect\n");
@@ -3950,6 +4467,13 @@ void Usage_full(void)
 	fprintf(stderr, "                                with other reports. Use with detail level 3 or more to\n");
 	fprintf(stderr, "                                get Port element under Node in output xml.\n");
 	fprintf(stderr, "    fabricinfo                - Outputs fabric information.\n");
+	fprintf(stderr, "    hostmap                   - Outputs NIC to switch port map and inter-switch\n");
+	fprintf(stderr, "                                links for use by the deviation -rmap and\n");
+	fprintf(stderr, "                                mpi_groupstress --map options. May not be combined\n");
+	fprintf(stderr, "                                with other reports. Does not support XML output.\n");
+	fprintf(stderr, "    sweepstats                - Outputs the slowest hosts, switch models and OID\n");
+	fprintf(stderr, "                                columns of the SNMP sweep, see --top. Not available\n");
+	fprintf(stderr, "                                with -X unless --refresh is used.\n");
 	fprintf(stderr, "    none                      - Outputs no report.\n");
 	fprintf(stderr, "Point Syntax:\n");
 	fprintf(stderr, "   ifid:value                 - value is numeric ifid.\n");
@@ -4279,6 +4803,10 @@ report_t checkOutputType(const char* name)
 				|REPORT_EXTLINKS|REPORT_SLOWCONNLINKS|REPORT_ERRORS;
 	} else if (0 == strcmp(optarg, "fabricinfo")) {
 		return REPORT_FABRICINFO;
+	} else if (0 == strcmp(optarg, "hostmap")) {
+		return REPORT_HOSTMAP;
+	} else if (0 == strcmp(optarg, "sweepstats")) {
+		return REPORT_SWEEPSTATS;
 	} else {
 		fprintf(stderr, "ethreport: Invalid Output Type: %s\n", name);
 		Usage();
@@ -4287,6 +4815,156 @@ report_t checkOutputType(const char* name)
 	}
 }
 
+// one worker process per plane for a multi-plane -o fabricinfo
+typedef struct PlaneWorker_s {
+	char name[HMGT_SHORT_STRING_SIZE];
+	char *hosts_file;		// NULL for the plane's configured HostsFile
+	pid_t pid;
+	FILE *out;				// captured stdout of the worker
+	FILE *err;				// captured stderr of the worker
+} PlaneWorker_t;
+
+// copy the captured output of a worker to stream
+static void ReplayPlaneOutput(FILE *capture, FILE *stream)
+{
+	char buf[4096];
+	size_t len;
+
+	rewind(capture);
+	while ((len = fread(buf, 1, sizeof(buf), capture)) > 0)
+		fwrite(buf, 1, len, stream);
+	fflush(stream);
+}
+
+// Sweep each plane in planes (space separated or ALL for every enabled plane
+// in the mgt config) in its own worker process so the sweeps run in parallel.
+// The Topology sweep and the reports operate on process wide state (g_Fabric,
+// the net-snmp session list), hence processes rather than threads.
+// hosts_files, when not NULL, is a space separated list with one entry per
+// plane, DEFAULT selects the plane's configured HostsFile.
+// Returns TRUE in each worker with g_fabricId and *hosts_file set for its
+// plane, the worker then runs the report as usual.
+// Returns FALSE in the parent once every plane's output has been shown in
+// plane order, with g_exitstatus set.
+static boolean StartPlaneWorkers(const char *planes, char **hosts_files)
+{
+	PlaneWorker_t *workers = NULL;
+	unsigned count = 0;
+	unsigned nhosts = 0;
+	unsigned i;
+	char *list = NULL;
+	char *name;
+	char *save;
+
+	if (0 == strcmp(planes, "ALL")) {
+		QUICK_LIST *fabs = &g_mgt_conf_params.fabric_confs;
+		LIST_ITEM *lip;
+
+		count = QListCount(fabs);
+		workers = (PlaneWorker_t*)calloc(count ? count : 1, sizeof(PlaneWorker_t));
+		if (! workers)
+			goto nomem;
+		for (i = 0, lip = QListHead(fabs); lip != NULL; i++, lip = QListNext(fabs, lip)) {
+			fabric_config_t *fab_conf = QListObj(lip);
+			snprintf(workers[i].name, HMGT_SHORT_STRING_SIZE, "%s", fab_conf->name);
+		}
+	} else {
+		if (NULL == (list = strdup(planes)))
+			goto nomem;
+		for (name = strtok_r(list, " ", &save); name; name = strtok_r(NULL, " ", &save)) {
+			PlaneWorker_t *tmp = (PlaneWorker_t*)realloc(workers, (count+1) * sizeof(PlaneWorker_t));
+			if (! tmp)
+				goto nomem;
+			workers = tmp;
+			memset(&workers[count], 0, sizeof(PlaneWorker_t));
+			snprintf(workers[count++].name, HMGT_SHORT_STRING_SIZE, "%s", name);
+		}
+		free(list);
+		list = NULL;
+	}
+	if (! count) {
+		fprintf(stderr, "ethreport: No plane defined in config file %s\n", g_hpnConfigFile);
+		g_exitstatus = 1;
+		goto done;
+	}
+
+	if (*hosts_files) {
+		// entries are referenced by the workers, so list is not freed
+		if (NULL == (list = strdup(*hosts_files)))
+			goto nomem;
+		for (name = strtok_r(list, " ", &save); name; name = strtok_r(NULL, " ", &save)) {
+			if (nhosts < count)
+				workers[nhosts].hosts_file = strcmp(name, "DEFAULT") ? name : NULL;
+			nhosts++;
+		}
+		if (nhosts != count) {
+			fprintf(stderr, "ethreport: Number of hosts files (%u) doesn't match number of planes (%u)\n",
+				nhosts, count);
+			g_exitstatus = 2;
+			goto done;
+		}
+	}
+
+	fflush(stdout);
+	fflush(stderr);
+	for (i = 0; i < count; i++) {
+		PlaneWorker_t *w = &workers[i];
+
+		w->out = tmpfile();
+		w->err = tmpfile();
+		if (! w->out || ! w->err) {
+			fprintf(stderr, "ethreport: Unable to create output file for plane '%s': %s\n",
+				w->name, strerror(errno));
+			w->pid = -1;
+			continue;
+		}
+		w->pid = fork();
+		if (w->pid == 0) {
+			dup2(fileno(w->out), STDOUT_FILENO);
+			dup2(fileno(w->err), STDERR_FILENO);
+			// progress is meaningless once replayed after the sweep
+			g_quiet = 1;
+			snprintf(g_fabricId, HMGT_SHORT_STRING_SIZE, "%s", w->name);
+			*hosts_files = w->hosts_file;
+			return TRUE;
+		} else if (w->pid < 0) {
+			fprintf(stderr, "ethreport: Unable to start worker for plane '%s': %s\n",
+				w->name, strerror(errno));
+		}
+	}
+
+	// show output in plane order, later workers keep sweeping meanwhile
+	for (i = 0; i < count; i++) {
+		PlaneWorker_t *w = &workers[i];
+		int status = 0;
+
+		printf("Fabric Plane %s Information:\n", w->name);
+		fflush(stdout);
+		if (w->pid > 0 && waitpid(w->pid, &status, 0) == w->pid) {
+			ReplayPlaneOutput(w->err, stderr);
+			ReplayPlaneOutput(w->out, stdout);
+			if (! WIFEXITED(status) || WEXITSTATUS(status))
+				g_exitstatus = 1;
+		} else {
+			g_exitstatus = 1;
+		}
+		DisplaySeparator();
+		if (w->out)
+			fclose(w->out);
+		if (w->err)
+			fclose(w->err);
+	}
+	goto done;
+
+nomem:
+	fprintf(stderr, "ethreport: Unable to allocate memory\n");
+	g_exitstatus = 1;
+	free(list);
+done:
+	free(workers);
+	return FALSE;
+}
+
 int main(int argc, char ** argv)
 {
 	FSTATUS             fstatus;
@@ -4306,6 +4984,12 @@ int main(int argc, char ** argv)
 	uint8				find_flag = FIND_FLAG_FABRIC;	// always check fabric
 	boolean				has_mgt_conf;
 	char *hosts_file = NULL;
+	char *capture_name = NULL;
+	FILE *capture_file = NULL;
+	char *sweepstats_name = NULL;
+	char *topocache_name = NULL;
+	int rows = 0;
+	char *planes = NULL;
 
 	Top_setcmdname("ethreport");
 	PointInit(&focus);
@@ -4333,6 +5017,25 @@ int main(int argc, char ** argv)
 			case 'q':
 				g_quiet = 1;
 				break;
+			case '@':
+				g_refresh = 1;
+				break;
+			case '#':
+				capture_name = optarg;
+				break;
+			case '%':
+				sweepstats_name = optarg;
+				break;
+			case '&':
+				topocache_name = optarg;
+				break;
+			case '^':
+				if (FSUCCESS != StringToUint32(&g_top, optarg, NULL, 0, TRUE) || ! g_top) {
+					fprintf(stderr, "ethreport: Invalid top value: %s\n", optarg);
+					Usage();
+					// NOTREACHED
+				}
+				break;
 			case '!':
 				if (FSUCCESS != StringToInt32(&g_ms_timeout, optarg, NULL, 0, TRUE)) {
 					fprintf(stderr, "ethreport: Invalid timeout value: %s\n", optarg);
@@ -4388,6 +5091,9 @@ int main(int argc, char ** argv)
 			case 'x':	// output in xml
 				format = FORMAT_XML;
 				break;
+			case '*':	// output delimited rows
+				rows = 1;
+				break;
 			case 'X':	// snapshot_input in xml
 				g_snapshot_in_file = optarg;
 				break;
@@ -4403,6 +5109,7 @@ int main(int argc, char ** argv)
 			case 'p':	// fabric plane
 				// in our code a fabric is actually a fabric plane
 				snprintf(g_fabricId, HMGT_SHORT_STRING_SIZE, "%s", optarg);
+				planes = optarg;
 				break;
 			case 'f':	// hosts file
 				hosts_file = optarg;
@@ -4456,6 +5163,35 @@ int main(int argc, char ** argv)
 		Usage();
 		// NOTREACHED
 	}
+	if ((report & REPORT_HOSTMAP) && (report != REPORT_HOSTMAP)) {
+		fprintf(stderr, "ethreport: -o hostmap cannot be run with other reports\n");
+		Usage();
+		// NOTREACHED
+	}
+	if ((report & REPORT_HOSTMAP) && (format == FORMAT_XML)) {
+		fprintf(stderr, "ethreport: -o hostmap option does not support XML output\n");
+		Usage();
+		// NOTREACHED
+	}
+	if (rows) {
+		if (report == REPORT_NONE || (report & ~(REPORT_ERRORS|REPORT_SLOWLINKS
+						|REPORT_MISCONFIGLINKS|REPORT_MISCONNLINKS
+						|REPORT_VERIFYLINKS|REPORT_VERIFYEXTLINKS
+						|REPORT_VERIFYNICLINKS|REPORT_VERIFYISLINKS
+						|REPORT_VERIFYEXTISLINKS|REPORT_VERIFYNICS
+						|REPORT_VERIFYSWS))) {
+			fprintf(stderr, "ethreport: --rows only supports errors, slowlinks, misconfiglinks, misconnlinks\n");
+			fprintf(stderr, "           and verify* reports\n");
+			Usage();
+			// NOTREACHED
+		}
+		if (format == FORMAT_XML) {
+			fprintf(stderr, "ethreport: -x and --rows are mutually exclusive\n");
+			Usage();
+			// NOTREACHED
+		}
+		format = FORMAT_ROWS;
+	}
 
 	// Warn for extraneous arguments and ignore them
 	if (focus_arg) {
@@ -4464,6 +5200,7 @@ int main(int argc, char ** argv)
 		if (report & REPORT_SNAPSHOT) { suppress = 1; name = "snapshot"; }
 		if (report & REPORT_SKIP) { suppress = 1; name = "none"; }
 		if (report & REPORT_FABRICINFO) { suppress = 1; name = "fabricinfo"; }
+		if (report & REPORT_SWEEPSTATS) { suppress = 1; name = "sweepstats"; }
 
 		if (suppress) {
 			fprintf(stderr,"ethreport: %s does not support -F option.\n", name);
@@ -4494,12 +5231,30 @@ int main(int argc, char ** argv)
 		g_persist = 0;
 	}
 
-	if (g_fabricId[0] && strchr(g_fabricId, ' ')) {
-		fprintf(stderr, "ethreport: -p option only supports one plane\n");
-		Usage();
+	if (planes && (strchr(planes, ' ') || 0 == strcmp(planes, "ALL"))) {
+		if (report != REPORT_FABRICINFO || g_snapshot_in_file || g_topology_in_file
+				|| capture_name || sweepstats_name) {
+			fprintf(stderr, "ethreport: -p option only supports multiple planes for -o fabricinfo\n");
+			fprintf(stderr, "           without -X, -T, --capture and --sweepstats\n");
+			Usage();
+		}
+	} else {
+		planes = NULL;
 	}
 
-	if (g_snapshot_in_file) {
+	if (sweepstats_name && g_snapshot_in_file && ! g_refresh) {
+		fprintf(stderr, "ethreport: --sweepstats ignored for -X\n");
+		sweepstats_name = NULL;
+	}
+
+	if (g_refresh && (! g_snapshot_in_file || g_hard || g_persist)) {
+		fprintf(stderr, "ethreport: --refresh ignored without -X or with -H or -P\n");
+		g_refresh = 0;
+	}
+	if (g_refresh) {
+		// counters come from the fabric, everything else from the snapshot
+		sweepFlags |= FF_STATS;
+	} else if (g_snapshot_in_file) {
 		if (sweepFlags & FF_STATS)
 			fprintf(stderr, "ethreport: -s ignored for -X\n");
 		sweepFlags &= ~(FF_STATS);
@@ -4520,6 +5275,10 @@ int main(int argc, char ** argv)
 	if (report == REPORT_NONE)
 		report = REPORT_BRNODES;
 
+	// multiple planes, the parent only collects the output of the workers
+	if (planes && ! StartPlaneWorkers(planes, &hosts_file))
+		goto done;
+
 	// Initialize Sweep Verbose option, for -X still used for Focus processing
 	fstatus = InitSweepVerbose(g_verbose?stderr:NULL);
 	if (fstatus != FSUCCESS) {
@@ -4532,6 +5291,18 @@ int main(int argc, char ** argv)
 		setTopologySnmpVerbose(stderr, g_verbose);
 	}
 
+	if (capture_name) {
+		if (g_snapshot_in_file && !g_refresh) {
+			fprintf(stderr, "ethreport: --capture ignored for -X\n");
+		} else if (NULL == (capture_file = fopen(capture_name, "w"))) {
+			fprintf(stderr, "ethreport: Unable to open capture file %s: %s\n", capture_name, strerror(errno));
+			g_exitstatus = 1;
+			goto done;
+		} else {
+			setTopologySnmpCapture(capture_file);
+		}
+	}
+
 	// get thresholds config file
 	if (report & REPORT_ERRORS) {
 		if (0 != parse(config_file)) {
@@ -4598,7 +5369,17 @@ int main(int argc, char ** argv)
 	}
 
 	// get live fabric data that requires port_conf
-	if (!g_snapshot_in_file) {
+	if (g_refresh) {
+		if (!port_conf) {
+			fprintf(stderr, "ethreport: Couldn't find plane '%s' in config file %s\n", g_fabricId, g_hpnConfigFile);
+			g_exitstatus = 1;
+			goto done;
+		}
+		if (FSUCCESS != SweepCounters(g_portGuid, &g_Fabric, sweepFlags, SWEEP_ALL, g_quiet, g_ms_timeout, port_conf)) {
+			g_exitstatus = 1;
+			goto done;
+		}
+	} else if (!g_snapshot_in_file) {
 		if (!port_conf) {
 			if (g_fabricId[0])
 				fprintf(stderr, "ethreport: Couldn't find plane '%s' in config file %s\n", g_fabricId, g_hpnConfigFile);
@@ -4607,12 +5388,18 @@ int main(int argc, char ** argv)
 			g_exitstatus = 1;
 			goto done;
 		}
-		if (FSUCCESS != Sweep(g_portGuid, &g_Fabric, sweepFlags, SWEEP_ALL, g_quiet, g_ms_timeout, port_conf)) {
+		// node: and nodepat: focus only sweep the focused hosts and their
+		// neighbors, the focus itself is resolved below
+		if (FSUCCESS != SweepFocused(g_portGuid, &g_Fabric, sweepFlags, SWEEP_ALL, g_quiet, g_ms_timeout, port_conf, focus_arg, g_limitstats)) {
 			g_exitstatus = 1;
 			goto done;
 		}
 	}
 
+	if (sweepstats_name && g_Fabric.SnmpStats
+		&& FSUCCESS != WriteSnmpSweepStats(&g_Fabric, sweepstats_name))
+		g_exitstatus = 1;
+
 	// if topology file not specified yet, use what defined in conf file
 	if (!g_topology_in_file && port_conf && port_conf->topology_file[0]) {
 		if (access(port_conf->topology_file, F_OK)) {
@@ -4637,7 +5424,7 @@ int main(int argc, char ** argv)
 	}
 	// parse topology input file and cross reference to fabric data
 	if (g_topology_in_file) {
-		if (FSUCCESS != Xml2ParseTopology(g_topology_in_file, g_quiet, &g_Fabric, TOPOVAL_NONE)) {
+		if (FSUCCESS != Xml2ParseTopologyCached(g_topology_in_file, topocache_name, g_quiet, &g_Fabric, TOPOVAL_NONE)) {
 			g_exitstatus = 1;
 			goto done_fabric;
 		}
@@ -4752,6 +5539,12 @@ int main(int argc, char ** argv)
 	if (report & REPORT_FABRICINFO)
 		ShowFabricinfoReport(0, detail);
 
+	if (report & REPORT_HOSTMAP)
+		ShowHostMapReport(&focus, 0, detail);
+
+	if (report & REPORT_SWEEPSTATS)
+		ShowSweepStatsReport(format, 0, detail);
+
 	if (format == FORMAT_XML && ! (report & REPORT_SNAPSHOT)) {
 		printf("</Report>\n");
 	}
@@ -4760,6 +5553,10 @@ done_fabric:
 	DestroyFabricData(&g_Fabric);
 done:
 	PointDestroy(&focus);
+	if (capture_file) {
+		setTopologySnmpCapture(NULL);
+		fclose(capture_file);
+	}
 	if (g_exitstatus == 2) {
 		Usage();
 		// NOTREACHED
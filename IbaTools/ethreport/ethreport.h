@@ -62,6 +62,7 @@ extern "C" {
 typedef enum {
 	FORMAT_TEXT,
 	FORMAT_XML,
+	FORMAT_ROWS,	// --rows, delimited rows for scripts, see RowsStartReport
 } Format_t;
 
 // list of reports which may be selected, bitmask so can select more than one
@@ -96,8 +97,10 @@ typedef enum {
 	REPORT_VERIFYNICS			=0x4000000,
 	REPORT_VERIFYSWS			=0x8000000,
 	REPORT_LIDS					=0x20000000,
+	REPORT_HOSTMAP				=0x40000000,
 	REPORT_PORTUSAGE			=0x100000000,
 	REPORT_LIDUSAGE				=0x200000000,	// undocumented report LinearFDB LID usage
+	REPORT_SWEEPSTATS			=0x400000000,
 	REPORT_TOPOLOGY				=0x100000000000ULL,
 	REPORT_LINKINFO				=0x10000000000000ULL,
 } report_t;
@@ -199,6 +202,13 @@ extern void XmlPrintLinkWidth(const char* tag_prefix, uint8 value, int indent);
 extern void XmlPrintLinkSpeed(const char* tag_prefix, uint16 value, int indent);
 extern void XmlPrintLinkStartTag(const char* tag, PortData *portp, int indent);
 
+extern void RowsStartReport(const char *report);
+extern void RowsStartPort(const char *desc, boolean gotPortNum, uint8 portnum, const char *portid);
+extern void RowsStartNode(const char *desc);
+extern void RowsProblem(const char *problem);
+extern void RowsEndItem(void);
+extern void RowsEndLink(void);
+
 #ifdef __cplusplus
 };
 #endif
@@ -54,6 +54,10 @@ void ShowProblem(Format_t format, int indent, int detail, const char* pformat, .
 			ASSERT((cnt >= 0) && ((size_t)cnt <= sizeof(buffer)-1));	/* make sure message fits */
 			XmlPrintStr("Problem", buffer, indent);
 			break;
+		case FORMAT_ROWS:
+			(void)vsnprintf(buffer, sizeof(buffer), pformat, args);
+			RowsProblem(buffer);
+			break;
 		default:
 			break;
 		}
@@ -61,96 +65,127 @@ void ShowProblem(Format_t format, int indent, int detail, const char* pformat, .
 	}
 }
 
+// problems found by PortVerify, cached in portp->analysisData.verify
+#define PORT_VERIFY_NODEGUID	0x01
+#define PORT_VERIFY_NODEDESC	0x02
+#define PORT_VERIFY_PORTNUM		0x04
+#define PORT_VERIFY_PORTGUID	0x08
+#define PORT_VERIFY_NODETYPE	0x10
+#define PORT_VERIFY_PORTSTATE	0x20
+
+// problems found by LinkAttrVerify, cached in portp->analysisData.verify
+#define LINK_ATTR_VERIFY_RATE	0x01
+#define LINK_ATTR_VERIFY_MTU	0x02
+
+// problems found by ExpectedLinkVerify, cached in elinkp->verify
+#define ELINK_VERIFY_DUP_PORT1	0x01
+#define ELINK_VERIFY_DUP_PORT2	0x02
+
+// classification of a link, used to select it for each verify*links report
+#define VERIFY_LINK_EXT		0x01	// external link
+#define VERIFY_LINK_NIC		0x02	// NIC link
+#define VERIFY_LINK_IS		0x04	// inter-switch link
+#define VERIFY_LINK_FOCUS	0x08	// link matches focus
+
 // verify a port against its corresponding ExpectedLink->PortSelector
 // Only valid to be called for ports with ExpectedLink
-// returns FALSE if any discrepencies
-// only does output if detail >= 0
-boolean PortVerify(PortData *portp, Format_t format, int indent, int detail)
+// returns PORT_VERIFY_* mask of discrepencies, 0 if none
+uint8 PortVerify(PortData *portp)
 {
-	ExpectedLink *elinkp = portp->elinkp;
-	PortSelector *portselp = NULL;
-	boolean ret=TRUE;
+	PortSelector *portselp = GetPortSelector(portp);
+	uint8 problems = 0;
 
-	if (elinkp->portp1 == portp) {
-		portselp = elinkp->portselp1;
-	} else if (elinkp->portp2 == portp) {
-		portselp = elinkp->portselp2;
-	}
 	if (portselp) { // not specified in input topology xml file; accept any port on the other end of the link
-		if (portselp->NodeGUID && portselp->NodeGUID != portp->nodep->NodeInfo.NodeGUID) {
-			ret = FALSE;
-			ShowProblem(format, indent, detail,
-				"IfAddr mismatch: expected: 0x%016"PRIx64" found: 0x%016"PRIx64,
-				portselp->NodeGUID, portp->nodep->NodeInfo.NodeGUID);
-		}
+		if (portselp->NodeGUID && portselp->NodeGUID != portp->nodep->NodeInfo.NodeGUID)
+			problems |= PORT_VERIFY_NODEGUID;
 		if (portselp->NodeDesc
 			&& 0 != strncmp(portselp->NodeDesc,
 							(char*)portp->nodep->NodeDesc.NodeString,
-							NODE_DESCRIPTION_ARRAY_SIZE)) {
-			ret = FALSE;
-			ShowProblem(format, indent, detail,
-				"NodeDesc mismatch: expected: '%s' found: '%.*s'",
-				portselp->NodeDesc, NODE_DESCRIPTION_ARRAY_SIZE,
-				(char*)portp->nodep->NodeDesc.NodeString);
-		}
-		if (portselp->gotPortNum && portselp->PortNum != portp->PortNum) {
-			ret = FALSE;
-			ShowProblem(format, indent, detail,
-				"PortNum mismatch: expected: %4u found: %4u",
-				portselp->PortNum, portp->PortNum);
-		}
-		if (portselp->PortGUID && portselp->PortGUID != portp->PortGUID) {
-			ret = FALSE;
-			ShowProblem(format, indent, detail, 
-				"MgmtIfAddr mismatch: expected: 0x%016"PRIx64" found: 0x%016"PRIx64,
-				portselp->PortGUID, portp->PortGUID);
-		}
-		if (portselp->NodeType && portselp->NodeType != portp->nodep->NodeInfo.NodeType) {
-			ret = FALSE;
-			ShowProblem(format, indent, detail, 
-				"NodeType mismatch: expected: %s found: %s",
-				StlNodeTypeToText(portselp->NodeType),
-				StlNodeTypeToText(portp->nodep->NodeInfo.NodeType));
-		}
+							NODE_DESCRIPTION_ARRAY_SIZE))
+			problems |= PORT_VERIFY_NODEDESC;
+		if (portselp->gotPortNum && portselp->PortNum != portp->PortNum)
+			problems |= PORT_VERIFY_PORTNUM;
+		if (portselp->PortGUID && portselp->PortGUID != portp->PortGUID)
+			problems |= PORT_VERIFY_PORTGUID;
+		if (portselp->NodeType && portselp->NodeType != portp->nodep->NodeInfo.NodeType)
+			problems |= PORT_VERIFY_NODETYPE;
 	}
 	/* to get here the port must have a neighbor and hence should be linkup
 	 * but it could be quarantined or failing to move to Active
 	 */
-	if (portp->PortInfo.PortStates.s.PortState != ETH_PORT_UP) {
-		ret = FALSE;
+	if (portp->PortInfo.PortStates.s.PortState != ETH_PORT_UP)
+		problems |= PORT_VERIFY_PORTSTATE;
+
+	return problems;
+}
+
+// show the discrepencies PortVerify found for a port
+void ShowPortVerifyProblems(PortData *portp, Format_t format, int indent, int detail)
+{
+	PortSelector *portselp = GetPortSelector(portp);
+	uint8 problems = portp->analysisData.verify.portProblems;
+
+	if (problems & PORT_VERIFY_NODEGUID)
+		ShowProblem(format, indent, detail,
+			"IfAddr mismatch: expected: 0x%016"PRIx64" found: 0x%016"PRIx64,
+			portselp->NodeGUID, portp->nodep->NodeInfo.NodeGUID);
+	if (problems & PORT_VERIFY_NODEDESC)
+		ShowProblem(format, indent, detail,
+			"NodeDesc mismatch: expected: '%s' found: '%.*s'",
+			portselp->NodeDesc, NODE_DESCRIPTION_ARRAY_SIZE,
+			(char*)portp->nodep->NodeDesc.NodeString);
+	if (problems & PORT_VERIFY_PORTNUM)
+		ShowProblem(format, indent, detail,
+			"PortNum mismatch: expected: %4u found: %4u",
+			portselp->PortNum, portp->PortNum);
+	if (problems & PORT_VERIFY_PORTGUID)
+		ShowProblem(format, indent, detail, 
+			"MgmtIfAddr mismatch: expected: 0x%016"PRIx64" found: 0x%016"PRIx64,
+			portselp->PortGUID, portp->PortGUID);
+	if (problems & PORT_VERIFY_NODETYPE)
+		ShowProblem(format, indent, detail, 
+			"NodeType mismatch: expected: %s found: %s",
+			StlNodeTypeToText(portselp->NodeType),
+			StlNodeTypeToText(portp->nodep->NodeInfo.NodeType));
+	if (problems & PORT_VERIFY_PORTSTATE)
 		ShowProblem(format, indent, detail, 
 			"Port not Up: PortState: %s",
 			EthPortStateToText(portp->PortInfo.PortStates.s.PortState));
-	}
-
-	return ret;
 }
 
 // check attributes of link against input topology
 // Only valid to be called for ports with ExpectedLink
-// returns FALSE if link fails to verify
-// only does output if detail >= 0
-boolean LinkAttrVerify(ExpectedLink *elinkp, PortData *portp1, Format_t format, int indent, int detail)
+// returns LINK_ATTR_VERIFY_* mask of discrepencies, 0 if none
+uint8 LinkAttrVerify(ExpectedLink *elinkp, PortData *portp1)
 {
 	PortData *portp2 = portp1->neighbor;
-	boolean ret = TRUE;
+	uint8 problems = 0;
 
-	if (elinkp->expected_rate && elinkp->expected_rate != portp1->rate) {
-		ret = FALSE;
+	if (elinkp->expected_rate && elinkp->expected_rate != portp1->rate)
+		problems |= LINK_ATTR_VERIFY_RATE;
+
+	if (elinkp->expected_mtu2 && elinkp->expected_mtu2 != MIN(portp1->PortInfo.MTU2, portp2->PortInfo.MTU2))
+		problems |= LINK_ATTR_VERIFY_MTU;
+	return problems;
+}
+
+// show the discrepencies LinkAttrVerify found for a link
+void ShowLinkAttrVerifyProblems(PortData *portp1, Format_t format, int indent, int detail)
+{
+	ExpectedLink *elinkp = portp1->elinkp;
+	PortData *portp2 = portp1->neighbor;
+	uint8 problems = portp1->analysisData.verify.linkProblems;
+
+	if (problems & LINK_ATTR_VERIFY_RATE)
 		ShowProblem(format, indent, detail, 
 			"Link Rate mismatch: expected: %4s found: %4s",
 			EthStaticRateToText(elinkp->expected_rate),
 			EthStaticRateToText(portp1->rate));
-	}
-
-	if (elinkp->expected_mtu2 && elinkp->expected_mtu2 != MIN(portp1->PortInfo.MTU2, portp2->PortInfo.MTU2)) {
-		ret = FALSE;
+	if (problems & LINK_ATTR_VERIFY_MTU)
 		ShowProblem(format, indent, detail, 
 			"Link MTU mismatch: expected minimum MTU: %d found MTU: %d",
 			elinkp->expected_mtu,
 			MIN(portp1->PortInfo.MTU2, portp2->PortInfo.MTU2));
-	}
-	return ret;
 }
 
 typedef enum {
@@ -164,71 +199,86 @@ typedef enum {
 } LinkVerifyResult_t;
 
 // check both fabric ports and link attributes against input topology
-// only does output if detail >= 0
-LinkVerifyResult_t LinkFabricVerify(PortData *portp, Format_t format, int indent, int detail)
+// results and problems found are saved in analysisData.verify of both ports
+LinkVerifyResult_t LinkFabricVerify(PortData *portp)
 {
+	PortData *portp2 = portp->neighbor;
 	LinkVerifyResult_t ret = LINK_VERIFY_OK;
 
+	portp->analysisData.verify.portProblems = 0;
+	portp->analysisData.verify.linkProblems = 0;
+	portp2->analysisData.verify.portProblems = 0;
 	// all checks which are based off of found ports/links in fabric
-	if (portp->elinkp && portp->neighbor->elinkp) {
-		ExpectedLink *elinkp = portp->elinkp;
-		DEBUG_ASSERT(portp->elinkp == portp->neighbor->elinkp);
+	if (portp->elinkp && portp2->elinkp) {
+		DEBUG_ASSERT(portp->elinkp == portp2->elinkp);
 		// check both sides for expected characteristics
-		if (! PortVerify(portp, format, indent, detail))
-			ret = LINK_VERIFY_DIFF;
-		if (! PortVerify(portp->neighbor, format, indent, detail))
-			ret = LINK_VERIFY_DIFF;
+		portp->analysisData.verify.portProblems = PortVerify(portp);
+		portp2->analysisData.verify.portProblems = PortVerify(portp2);
 		// check expected link characteristics
-		if (! LinkAttrVerify(elinkp, portp, format, indent, detail))
+		portp->analysisData.verify.linkProblems = LinkAttrVerify(portp->elinkp, portp);
+		if (portp->analysisData.verify.portProblems
+			|| portp2->analysisData.verify.portProblems
+			|| portp->analysisData.verify.linkProblems)
 			ret = LINK_VERIFY_DIFF;
-	} else if (! portp->elinkp && ! portp->neighbor->elinkp) {
+	} else if (! portp->elinkp && ! portp2->elinkp) {
 		ret = LINK_VERIFY_UNEXPECTED; // extra link
-		ShowProblem(format, indent, detail, "Unexpected Link");
 	} else {
 		// only one side resolved
 		DEBUG_ASSERT(0);	// we only set elinkp if both sides resolved
 		ret = LINK_VERIFY_UNEXPECTED; // internal error
 	}
+	portp->analysisData.verify.result = ret;
 	return ret;
 }
 
 // compare ExpectedLink against fabric
 // LinkFabricVerify will have caught links which are different or extra
 // this is focused on duplicate ExpectedLink or missing links
-// only does output if detail >= 0
-// side controls message output:
-// 	0 - both ports and link info - for initial checks
-// 	1 - elinkp->port 1 - when in process of outputting port 1 info
-// 	2 - elinkp->port 2 - when in process of outputting port 2 info
-// 	3 - link info only - when in process of outputting summary link info
-LinkVerifyResult_t ExpectedLinkVerify(ExpectedLink *elinkp, uint8 side, Format_t format, int indent, int detail)
+// results and problems found are saved in elinkp->verify
+LinkVerifyResult_t ExpectedLinkVerify(ExpectedLink *elinkp)
 {
 	LinkVerifyResult_t ret = LINK_VERIFY_OK;
+	uint8 problems = 0;
 
 	if (! elinkp->portp1 && ! elinkp->portp2) {
-		if (side == 0 || side == 3)
-			ShowProblem(format, indent, detail, "Missing Link");
 		ret = LINK_VERIFY_MISSING;	// missing link
 	} else if (elinkp->portp1 && elinkp->portp2) {
-		if (elinkp->portp1->elinkp != elinkp) {
-			// duplicate port, or incomplete/duplicate link in input topology
-			ret = LINK_VERIFY_DUP;
-			if (side == 0 || side == 1)
-				ShowProblem(format, indent, detail, "Duplicate Port in input or incorrectly cabled");
-		}
-		if (elinkp->portp2->elinkp != elinkp) {
-			// duplicate port, or incomplete/duplicate link in input topology
+		// duplicate port, or incomplete/duplicate link in input topology
+		if (elinkp->portp1->elinkp != elinkp)
+			problems |= ELINK_VERIFY_DUP_PORT1;
+		if (elinkp->portp2->elinkp != elinkp)
+			problems |= ELINK_VERIFY_DUP_PORT2;
+		if (problems)
 			ret = LINK_VERIFY_DUP;
-			if (side == 0 || side == 2)
-				ShowProblem(format, indent, detail, "Duplicate Port in input or incorrectly cabled");
-		}
-		if (ret == LINK_VERIFY_DUP && side == 3) {
-			ShowProblem(format, indent, detail, "Duplicate Port in input or incorrectly cabled");
-		}
 	} else { /* elinkp->portp1 || elinkp->portp2 */
 		// only 1 side resolved -> incorrectly cabled
 		ret = LINK_VERIFY_CONN;
-		if (detail >= 0 && (side == 0 || side == 3)) {
+	}
+	elinkp->verify.result = ret;
+	elinkp->verify.problems = problems;
+	return ret;
+}
+
+// show the problems ExpectedLinkVerify found for a link
+// side controls message output:
+// 	1 - elinkp->port 1 - when in process of outputting port 1 info
+// 	2 - elinkp->port 2 - when in process of outputting port 2 info
+// 	3 - link info only - when in process of outputting summary link info
+void ShowExpectedLinkVerifyProblems(ExpectedLink *elinkp, uint8 side, Format_t format, int indent, int detail)
+{
+	switch (elinkp->verify.result) {
+	case LINK_VERIFY_MISSING:
+		if (side == 3)
+			ShowProblem(format, indent, detail, "Missing Link");
+		break;
+	case LINK_VERIFY_DUP:
+		if ((side == 1 && (elinkp->verify.problems & ELINK_VERIFY_DUP_PORT1))
+			|| (side == 2 && (elinkp->verify.problems & ELINK_VERIFY_DUP_PORT2))
+			|| side == 3)
+			ShowProblem(format, indent, detail, "Duplicate Port in input or incorrectly cabled");
+		break;
+	case LINK_VERIFY_CONN:
+		if (detail >= 0 && side == 3) {
 			if (elinkp->portp1) {
 				if (elinkp->portp1->neighbor) {
 					ShowProblem(format, indent, detail, "Incorrect Link, 2nd port found to be:");
@@ -247,15 +297,101 @@ LinkVerifyResult_t ExpectedLinkVerify(ExpectedLink *elinkp, uint8 side, Format_t
 				}
 			}
 		}
+		break;
+	default:
+		break;
+	}
+}
+
+// focus used for last VerifyAllLinks, NULL if not yet run
+static Point *g_links_verified_focus = NULL;
+
+// Verify all fabric links and all input links once, saving the results,
+// problems found and classification of each link so the verify*links
+// reports need only filter and show what was found.
+// The focus is the same for all reports in a given run, so its
+// comparison is saved too.
+static void VerifyAllLinks(Point *focus)
+{
+	LIST_ITEM *p;
+
+	for (p=QListHead(&g_Fabric.AllPorts); p != NULL; p = QListNext(&g_Fabric.AllPorts, p)) {
+		PortData *portp1, *portp2;
+		uint8 flags = 0;
+
+		portp1 = (PortData *)QListObj(p);
+		// to avoid duplicated processing, only process "from" ports in link
+		if (! portp1->from)
+			continue;
+
+		if (! isInternalLink(portp1))
+			flags |= VERIFY_LINK_EXT;
+		if (isFILink(portp1))
+			flags |= VERIFY_LINK_NIC;
+		if (isISLink(portp1))
+			flags |= VERIFY_LINK_IS;
+		portp2 = portp1->neighbor;
+		// We process only links whose PortData or resolved ExpectedLink
+		// match the focus
+		if (ComparePortPoint(portp1, focus)
+				|| ComparePortPoint(portp2, focus)
+				|| (portp1->elinkp && CompareExpectedLinkPoint(portp1->elinkp, focus))
+				|| (portp2->elinkp && CompareExpectedLinkPoint(portp2->elinkp, focus)))
+			flags |= VERIFY_LINK_FOCUS;
+		portp1->analysisData.verify.flags = flags;
+		(void)LinkFabricVerify(portp1);
+	}
+
+	for (p=QListHead(&g_Fabric.ExpectedLinks); p != NULL; p = QListNext(&g_Fabric.ExpectedLinks, p)) {
+		ExpectedLink *elinkp = (ExpectedLink *)QListObj(p);
+		uint8 flags = 0;
+
+		// the is*ExpectedLink functions are purposely generously inclusive
+		if (isExternalExpectedLink(elinkp))
+			flags |= VERIFY_LINK_EXT;
+		if (isFIExpectedLink(elinkp))
+			flags |= VERIFY_LINK_NIC;
+		if (isISExpectedLink(elinkp))
+			flags |= VERIFY_LINK_IS;
+		// We process only elinks whose resolved ports or ExpectedLink
+		// match the focus
+		if ((elinkp->portp1 && ComparePortPoint(elinkp->portp1, focus))
+				|| (elinkp->portp2 && ComparePortPoint(elinkp->portp2, focus))
+				|| CompareExpectedLinkPoint(elinkp, focus))
+			flags |= VERIFY_LINK_FOCUS;
+		elinkp->verify.flags = flags;
+		(void)ExpectedLinkVerify(elinkp);
+	}
+}
+
+// determine if a link with the given VERIFY_LINK_* flags should be
+// included in the given verify*links report
+static boolean VerifyLinkSelected(uint8 flags, report_t report)
+{
+	if (! (flags & VERIFY_LINK_FOCUS))
+		return FALSE;
+	switch (report) {
+	default:	// should not happen, but just in case
+	case REPORT_VERIFYLINKS:
+		// process all links
+		return TRUE;
+	case REPORT_VERIFYEXTLINKS:
+		return (flags & VERIFY_LINK_EXT) != 0;
+	case REPORT_VERIFYNICLINKS:
+		return (flags & VERIFY_LINK_NIC) != 0;
+	case REPORT_VERIFYISLINKS:
+		return (flags & VERIFY_LINK_IS) != 0;
+	case REPORT_VERIFYEXTISLINKS:
+		return (flags & (VERIFY_LINK_EXT|VERIFY_LINK_IS))
+					== (VERIFY_LINK_EXT|VERIFY_LINK_IS);
 	}
-	return ret;
 }
 
 void ShowLinkPortVerifySummaryCallback(uint64 context _UNUSED_, PortData *portp,
 									Format_t format, int indent, int detail)
 {
 	if (portp->elinkp && portp->neighbor->elinkp) {
-		(void)PortVerify(portp, format, indent, detail);
+		ShowPortVerifyProblems(portp, format, indent, detail);
 	}
 }
 
@@ -269,16 +405,18 @@ void ShowLinkVerifySummary(PortData *portp, Format_t format, int indent, int det
 	if (format == FORMAT_XML)
 		indent +=4;
 	if (portp->elinkp && portp->neighbor->elinkp
-		&& (! PortVerify(portp, format, indent, -1)
-			|| ! PortVerify(portp->neighbor, format, indent, -1)))
+		&& (portp->analysisData.verify.portProblems
+			|| portp->neighbor->analysisData.verify.portProblems))
 		ShowProblem(format, indent, detail, "Port Attributes Inconsistent");
 	if (portp->elinkp && portp->neighbor->elinkp) {
-		(void)LinkAttrVerify(portp->elinkp, portp, format, indent, detail);
+		ShowLinkAttrVerifyProblems(portp, format, indent, detail);
 	} else if (! portp->elinkp && ! portp->neighbor->elinkp) {
 		ShowProblem(format, indent, detail, "Unexpected Link");
 	}
 	if (format == FORMAT_XML)
 		printf("%*s</Link>\n", indent-4, "");
+	else if (format == FORMAT_ROWS)
+		RowsEndLink();
 }
 
 // header used before a series of links
@@ -306,7 +444,7 @@ void ShowExpectedLinkBriefSummaryHeader(Format_t format, int indent, int detail)
 void ShowExpectedLinkPortVerifySummaryCallback(ExpectedLink *elinkp, uint8 side,
 									Format_t format, int indent, int detail)
 {
-	(void)ExpectedLinkVerify(elinkp, side, format, indent, detail);
+	ShowExpectedLinkVerifyProblems(elinkp, side, format, indent, detail);
 }
 
 // show input link verify errors
@@ -339,9 +477,11 @@ void ShowExpectedLinkVerifySummary(ExpectedLink *elinkp, Format_t format, int in
 	// Summary information about Link itself
 	if (detail && format != FORMAT_XML)
 		ShowExpectedLinkBriefSummary(elinkp, format, indent+4, detail-1);
-	(void)ExpectedLinkVerify(elinkp, 3, format, indent, detail);
+	ShowExpectedLinkVerifyProblems(elinkp, 3, format, indent, detail);
 	if (format == FORMAT_XML)
 		printf("%*s</Link>\n", indent-4, "");
+	else if (format == FORMAT_ROWS)
+		RowsEndLink();
 }
 
 // Verify links in fabric against specified topology
@@ -397,6 +537,9 @@ void ShowVerifyLinksReport(Point *focus, report_t report, Format_t format, int i
 		printf("%*s<Verify%sLinks> <!-- %sLinks Topology Verification -->\n", indent, "", xml_prefix, prefix);
 		indent+=4;
 		break;
+	case FORMAT_ROWS:
+		RowsStartReport(report_name);
+		break;
 	default:
 		break;
 	}
@@ -433,6 +576,12 @@ void ShowVerifyLinksReport(Point *focus, report_t report, Format_t format, int i
 
 	ShowPointFocus(focus, (FIND_FLAG_FABRIC|FIND_FLAG_ELINK), format, indent, detail);
 
+	// verify all links once, each report then filters the saved results
+	if (g_links_verified_focus != focus) {
+		VerifyAllLinks(focus);
+		g_links_verified_focus = focus;
+	}
+
 	// First we look at all the fabric links
 	switch (format) {
 	case FORMAT_TEXT:
@@ -445,49 +594,16 @@ void ShowVerifyLinksReport(Point *focus, report_t report, Format_t format, int i
 		break;
 	}
 	for (p=QListHead(&g_Fabric.AllPorts); p != NULL; p = QListNext(&g_Fabric.AllPorts, p)) {
-		PortData *portp1, *portp2;
+		PortData *portp1;
 
 		portp1 = (PortData *)QListObj(p);
 		// to avoid duplicated processing, only process "from" ports in link
 		if (! portp1->from)
 			continue;
-
-		switch (report) {
-		default:	// should not happen, but just in case
-		case REPORT_VERIFYLINKS:
-			// process all links
-			break;
-		case REPORT_VERIFYEXTLINKS:
-			if (isInternalLink(portp1))
-				continue;
-			break;
-		case REPORT_VERIFYNICLINKS:
-			if (! isFILink(portp1))
-				continue;
-			break;
-		case REPORT_VERIFYISLINKS:
-			if (! isISLink(portp1))
-				continue;
-			break;
-		case REPORT_VERIFYEXTISLINKS:
-			if (isInternalLink(portp1))
-				continue;
-			if (! isISLink(portp1))
-				continue;
-			break;
-		}
-
-		portp2 = portp1->neighbor;
-		// We process only links whose PortData or resolved ExpectedLink
-		// match the focus
-		if (! ( ComparePortPoint(portp1, focus)
-				|| ComparePortPoint(portp2, focus)
-				|| (portp1->elinkp && CompareExpectedLinkPoint(portp1->elinkp, focus))
-				|| (portp2->elinkp && CompareExpectedLinkPoint(portp2->elinkp, focus))))
+		if (! VerifyLinkSelected(portp1->analysisData.verify.flags, report))
 			continue;
 		fabric_checked++;
-		// detail=-1 in LinkFabricVerify will suppress its output
-		res = LinkFabricVerify(portp1, format, indent, -1);
+		res = (LinkVerifyResult_t)portp1->analysisData.verify.result;
 		counts[res]++;
 		if (res != LINK_VERIFY_OK) {
 			if (detail) {
@@ -532,42 +648,10 @@ void ShowVerifyLinksReport(Point *focus, report_t report, Format_t format, int i
 	for (p=QListHead(&g_Fabric.ExpectedLinks); p != NULL; p = QListNext(&g_Fabric.ExpectedLinks, p)) {
 		ExpectedLink *elinkp = (ExpectedLink *)QListObj(p);
 
-		// do our best to filter expected links
-		// the is*ExpectedLink functions are purposely generously inclusive
-		switch (report) {
-		default:	// should not happen, but just in case
-		case REPORT_VERIFYLINKS:
-			// process all links
-			break;
-		case REPORT_VERIFYEXTLINKS:
-			if (! isExternalExpectedLink(elinkp))
-				continue;
-			break;
-		case REPORT_VERIFYNICLINKS:
-			if (! isFIExpectedLink(elinkp))
-				continue;
-			break;
-		case REPORT_VERIFYISLINKS:
-			if (! isISExpectedLink(elinkp))
-				continue;
-			break;
-		case REPORT_VERIFYEXTISLINKS:
-			if (! isExternalExpectedLink(elinkp))
-				continue;
-			if (! isISExpectedLink(elinkp))
-				continue;
-			break;
-		}
-
-		// We process only elinks whose resolved ports or ExpectedLink
-		// match the focus
-		if (! ( (elinkp->portp1 && ComparePortPoint(elinkp->portp1, focus))
-				|| (elinkp->portp2 && ComparePortPoint(elinkp->portp2, focus))
-				|| CompareExpectedLinkPoint(elinkp, focus)))
+		if (! VerifyLinkSelected(elinkp->verify.flags, report))
 			continue;
 		input_checked++;
-		// detail=-1 in ExpectedLinkVerify will suppress its output
-		res = ExpectedLinkVerify(elinkp, 0, format, indent, -1);
+		res = (LinkVerifyResult_t)elinkp->verify.result;
 		counts[res]++;
 		if (res != LINK_VERIFY_OK) {
 			if (detail) {
@@ -734,6 +818,8 @@ void ShowNodeVerifySummary(NodeData *nodep, Format_t format, int indent, int det
 	}
 	if (format == FORMAT_XML)
 		printf("%*s</Node>\n", indent-4, "");
+	else if (format == FORMAT_ROWS)
+		RowsEndItem();
 }
 
 // show input node verify errors
@@ -745,6 +831,8 @@ void ShowExpectedNodeVerifySummary(ExpectedNode *enodep, Format_t format, int in
 	(void)ExpectedNodeVerify(enodep, format, indent, detail);
 	if (format == FORMAT_XML)
 		printf("%*s</Node>\n", indent-4, "");
+	else if (format == FORMAT_ROWS)
+		RowsEndItem();
 }
 
 // Verify nodes in fabric against specified topology
@@ -784,6 +872,9 @@ void ShowVerifyNodesReport(Point *focus, uint8 NodeType, Format_t format, int in
 		printf("%*s<Verify%ss> <!-- %s Topology Verification -->\n", indent, "", NodeTypeText, NodeTypeText);
 		indent+=4;
 		break;
+	case FORMAT_ROWS:
+		RowsStartReport(NodeType == STL_NODE_FI ? "verifynics" : "verifysws");
+		break;
 	default:
 		break;
 	}
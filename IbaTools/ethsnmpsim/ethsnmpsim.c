@@ -0,0 +1,1578 @@
+/* BEGIN_ICS_COPYRIGHT7 ****************************************
+
+Copyright (c) 2021, Intel Corporation
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+** END_ICS_COPYRIGHT7   ****************************************/
+
+/* [ICS VERSION STRING: unknown] */
+
+//
+// Simulated SNMP agent for sweep benchmarks and regression tests.
+//
+// Replays the variables of an SNMP capture (see ethreport --capture) as the
+// MIB views of N virtual switches. Every virtual switch answers on its own
+// loopback address (127.x.y.z) at the same UDP port, so the switches file of
+// the plane simply lists those addresses. Only SNMPv1/v2c GET, GETNEXT and
+// GETBULK are supported, which is all Topology/hpnmgt_snmp.c sends with
+// SNMP_VERSION_2c.
+//
+// to compile: gcc -O2 ethsnmpsim.c -o ethsnmpsim
+//
+#define _GNU_SOURCE
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define BASENAME "ethsnmpsim"
+#define PFERROR(format, args...) { fprintf(stderr, BASENAME ": Error: "); fprintf(stderr, format, ##args); }
+#define PFWARN(format, args...) { fprintf(stderr, BASENAME ": Warning: "); fprintf(stderr, format, ##args); }
+#define DBGPRINT(format, args...) if (verbose) { fprintf(stderr, format, ##args); }
+
+#define CAPTURE_HEADER "# hpnmgt SNMP capture 1"
+#define DEFAULT_PORT 16100
+#define MAX_OID_LEN 128
+#define MAX_MSG_SIZE 65507	// largest UDP payload over IPv4
+#define MAX_RESPONSE_SIZE 65000	// keep GETBULK responses below MAX_MSG_SIZE
+
+// ASN.1/SNMP tags
+#define ASN_INTEGER		0x02
+#define ASN_OCTET_STR	0x04
+#define ASN_NULL		0x05
+#define ASN_OBJECT_ID	0x06
+#define ASN_SEQUENCE	0x30
+#define ASN_IPADDRESS	0x40
+#define ASN_COUNTER		0x41
+#define ASN_GAUGE		0x42
+#define ASN_TIMETICKS	0x43
+#define ASN_OPAQUE		0x44
+#define ASN_COUNTER64	0x46
+#define SNMP_NOSUCHOBJECT	0x80
+#define SNMP_NOSUCHINSTANCE	0x81
+#define SNMP_ENDOFMIBVIEW	0x82
+#define SNMP_MSG_GET		0xA0
+#define SNMP_MSG_GETNEXT	0xA1
+#define SNMP_MSG_RESPONSE	0xA2
+#define SNMP_MSG_GETBULK	0xA5
+
+typedef struct {
+	uint32_t	name[MAX_OID_LEN];
+	uint32_t	nameLen;
+} Oid;
+
+typedef struct {
+	uint32_t	*name;
+	uint32_t	nameLen;
+	uint32_t	seq;		// capture order, later values replace earlier ones
+	uint8_t		type;
+	uint64_t	num;		// INTEGER, Counter, Gauge, TimeTicks, Counter64
+	uint8_t		*data;		// other types, OBJECT IDENTIFIER as uint32_t subids
+	uint32_t	len;
+} MibVar;
+
+typedef struct {
+	struct in_addr	addr;
+	char		*peer;		// peer name in the capture
+	MibVar		*vars;		// sorted by name after load
+	size_t		numVars;
+	size_t		maxVars;
+	uint64_t	requests;
+} Agent;
+
+typedef struct {
+	double		due;
+	struct sockaddr_in	client;
+	struct in_addr	local;
+	size_t		len;
+	uint8_t		*buf;
+} Pending;
+
+static Agent *agents = NULL;
+static size_t numAgents = 0;
+static size_t maxAgents = 0;
+static uint32_t *agentHash = NULL;	// open addressing, agent index + 1
+static size_t hashSize = 0;
+static uint32_t nextAddr = 0;		// next 127.1.x.y for remapped peers
+
+static Pending *pending = NULL;		// min heap on due
+static size_t numPending = 0;
+static size_t maxPending = 0;
+
+static int verbose = 0;
+static double latency_ms = 0;
+static double jitter_ms = 0;
+static double loss_pct = 0;
+static double start_time;
+static volatile sig_atomic_t stop = 0;
+
+static struct {
+	uint64_t received;
+	uint64_t dropped;
+	uint64_t malformed;
+	uint64_t unknown;
+	uint64_t get;
+	uint64_t getnext;
+	uint64_t getbulk;
+	uint64_t responses;
+	uint64_t varbinds;
+	uint64_t bytesIn;
+	uint64_t bytesOut;
+} stats;
+
+static const uint32_t sysUpTimeOid[] = { 1, 3, 6, 1, 2, 1, 1, 3, 0 };
+
+static void *xrealloc(void *p, size_t size)
+{
+	p = realloc(p, size);
+	if (!p) {
+		PFERROR("Out of memory\n");
+		exit(1);
+	}
+	return p;
+}
+
+static double now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int oid_compare(const uint32_t *a, uint32_t alen, const uint32_t *b, uint32_t blen)
+{
+	uint32_t i, len = alen < blen ? alen : blen;
+
+	for (i = 0; i < len; i++) {
+		if (a[i] != b[i])
+			return a[i] < b[i] ? -1 : 1;
+	}
+	return alen < blen ? -1 : (alen > blen ? 1 : 0);
+}
+
+static int parse_oid(const char *str, Oid *oid)
+{
+	char *end;
+
+	oid->nameLen = 0;
+	while (*str == '.') {
+		if (oid->nameLen >= MAX_OID_LEN)
+			return -1;
+		errno = 0;
+		unsigned long v = strtoul(str + 1, &end, 10);
+		if (errno || end == str + 1 || v > UINT32_MAX)
+			return -1;
+		oid->name[oid->nameLen++] = (uint32_t)v;
+		str = end;
+	}
+	return (*str || oid->nameLen < 2) ? -1 : 0;
+}
+
+//--------- virtual agents ------------------//
+
+static size_t hash_addr(uint32_t addr)
+{
+	return (addr * 2654435761u) & (hashSize - 1);
+}
+
+static void hash_insert(size_t index)
+{
+	size_t h = hash_addr(agents[index].addr.s_addr);
+
+	while (agentHash[h])
+		h = (h + 1) & (hashSize - 1);
+	agentHash[h] = index + 1;
+}
+
+static Agent *find_agent(struct in_addr addr)
+{
+	size_t h;
+
+	if (!hashSize)
+		return NULL;
+	for (h = hash_addr(addr.s_addr); agentHash[h]; h = (h + 1) & (hashSize - 1)) {
+		if (agents[agentHash[h] - 1].addr.s_addr == addr.s_addr)
+			return &agents[agentHash[h] - 1];
+	}
+	return NULL;
+}
+
+static Agent *add_agent(struct in_addr addr, const char *peer)
+{
+	size_t i;
+
+	if (numAgents >= maxAgents) {
+		maxAgents = maxAgents ? maxAgents * 2 : 256;
+		agents = xrealloc(agents, maxAgents * sizeof(Agent));
+	}
+	memset(&agents[numAgents], 0, sizeof(Agent));
+	agents[numAgents].addr = addr;
+	agents[numAgents].peer = strdup(peer);
+	numAgents++;
+	if (numAgents * 2 > hashSize) {
+		free(agentHash);
+		hashSize = hashSize ? hashSize * 2 : 512;
+		agentHash = xrealloc(NULL, hashSize * sizeof(uint32_t));
+		memset(agentHash, 0, hashSize * sizeof(uint32_t));
+		for (i = 0; i < numAgents; i++)
+			hash_insert(i);
+	} else {
+		hash_insert(numAgents - 1);
+	}
+	return &agents[numAgents - 1];
+}
+
+/*
+ * map a capture peer ("udp:host:port", "host:port" or "host") to its agent.
+ * Peers already on a loopback address keep it, all others are given the next
+ * free 127.1.x.y address so a capture of a real fabric can be replayed as is.
+ */
+static Agent *peer_agent(const char *peer)
+{
+	char host[256];
+	char *p;
+	struct in_addr addr;
+	Agent *agent;
+	size_t i;
+
+	if (!strncmp(peer, "udp:", 4))
+		peer += 4;
+	snprintf(host, sizeof(host), "%s", peer);
+	if ((p = strrchr(host, ':')))
+		*p = '\0';
+
+	if (inet_pton(AF_INET, host, &addr) == 1 && (ntohl(addr.s_addr) >> 24) == 127)
+		return (agent = find_agent(addr)) ? agent : add_agent(addr, host);
+
+	for (i = 0; i < numAgents; i++) {
+		if (!strcmp(agents[i].peer, host))
+			return &agents[i];
+	}
+	do {
+		nextAddr = nextAddr ? nextAddr + 1 : 0x7f010001;
+		if ((nextAddr & 0xff) == 0xff)
+			nextAddr += 2;
+		addr.s_addr = htonl(nextAddr);
+	} while (find_agent(addr));
+	return add_agent(addr, host);
+}
+
+static int hex_value(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+static int parse_value(MibVar *var, const char *str)
+{
+	char *end;
+	size_t i, len;
+	Oid oid;
+
+	switch (var->type) {
+	case ASN_INTEGER:
+		errno = 0;
+		var->num = (uint64_t)strtoll(str, &end, 10);
+		return (errno || *end) ? -1 : 0;
+	case ASN_COUNTER:
+	case ASN_GAUGE:
+	case ASN_TIMETICKS:
+	case ASN_COUNTER64:
+		errno = 0;
+		var->num = strtoull(str, &end, 10);
+		return (errno || *end) ? -1 : 0;
+	case ASN_OBJECT_ID:
+		if (parse_oid(str, &oid))
+			return -1;
+		var->len = oid.nameLen * sizeof(uint32_t);
+		var->data = xrealloc(NULL, var->len);
+		memcpy(var->data, oid.name, var->len);
+		return 0;
+	case ASN_NULL:
+		return 0;
+	default:
+		if (!strcmp(str, "-"))
+			return 0;
+		len = strlen(str);
+		if (len & 1)
+			return -1;
+		var->len = len / 2;
+		var->data = xrealloc(NULL, var->len);
+		for (i = 0; i < var->len; i++) {
+			int hi = hex_value(str[2 * i]);
+			int lo = hex_value(str[2 * i + 1]);
+			if (hi < 0 || lo < 0)
+				return -1;
+			var->data[i] = (uint8_t)(hi << 4 | lo);
+		}
+		return 0;
+	}
+}
+
+static int var_compare(const void *a, const void *b)
+{
+	const MibVar *va = a, *vb = b;
+	int res = oid_compare(va->name, va->nameLen, vb->name, vb->nameLen);
+
+	if (res)
+		return res;
+	return va->seq < vb->seq ? -1 : (va->seq > vb->seq ? 1 : 0);
+}
+
+/*
+ * load the "= peer oid type value" lines of a capture, request and response
+ * lines are ignored. Each agent's variables are sorted so GETNEXT is a
+ * binary search, and a variable seen more than once keeps its last value.
+ */
+static int load_capture(const char *filename)
+{
+	FILE *fp;
+	char *line = NULL;
+	size_t lineSize = 0;
+	int lineNum = 0;
+	uint32_t seq = 0;
+	size_t i, j, total = 0;
+
+	if (!strcmp(filename, "-"))
+		fp = stdin;
+	else if (!(fp = fopen(filename, "r"))) {
+		PFERROR("Unable to open %s: %s\n", filename, strerror(errno));
+		return -1;
+	}
+	while (getline(&line, &lineSize, fp) > 0) {
+		char *save, *peer, *name, *type, *value;
+		unsigned long t;
+		Agent *agent;
+		MibVar var;
+		Oid oid;
+
+		lineNum++;
+		if (lineNum == 1 && strncmp(line, CAPTURE_HEADER, strlen(CAPTURE_HEADER))) {
+			PFERROR("%s is not an SNMP capture\n", filename);
+			goto fail;
+		}
+		if (line[0] != '=')
+			continue;
+		strtok_r(line, " \t\r\n", &save);
+		peer = strtok_r(NULL, " \t\r\n", &save);
+		name = strtok_r(NULL, " \t\r\n", &save);
+		type = strtok_r(NULL, " \t\r\n", &save);
+		value = strtok_r(NULL, " \t\r\n", &save);
+		if (!value || parse_oid(name, &oid)) {
+			PFWARN("%s:%d: invalid variable, ignored\n", filename, lineNum);
+			continue;
+		}
+		t = strtoul(type, NULL, 10);
+		if (t == SNMP_NOSUCHOBJECT || t == SNMP_NOSUCHINSTANCE || t == SNMP_ENDOFMIBVIEW)
+			continue;
+
+		memset(&var, 0, sizeof(var));
+		var.type = (uint8_t)t;
+		var.seq = seq++;
+		if (t > 0xff || parse_value(&var, value)) {
+			PFWARN("%s:%d: invalid value, ignored\n", filename, lineNum);
+			free(var.data);
+			continue;
+		}
+		var.nameLen = oid.nameLen;
+		var.name = xrealloc(NULL, oid.nameLen * sizeof(uint32_t));
+		memcpy(var.name, oid.name, oid.nameLen * sizeof(uint32_t));
+
+		agent = peer_agent(peer);
+		if (agent->numVars >= agent->maxVars) {
+			agent->maxVars = agent->maxVars ? agent->maxVars * 2 : 1024;
+			agent->vars = xrealloc(agent->vars, agent->maxVars * sizeof(MibVar));
+		}
+		agent->vars[agent->numVars++] = var;
+	}
+	free(line);
+	if (fp != stdin)
+		fclose(fp);
+
+	for (i = 0; i < numAgents; i++) {
+		Agent *agent = &agents[i];
+		size_t out = 0;
+
+		qsort(agent->vars, agent->numVars, sizeof(MibVar), var_compare);
+		for (j = 0; j < agent->numVars; j++) {
+			if (j + 1 < agent->numVars
+				&& !oid_compare(agent->vars[j].name, agent->vars[j].nameLen,
+						agent->vars[j + 1].name, agent->vars[j + 1].nameLen)) {
+				free(agent->vars[j].name);
+				free(agent->vars[j].data);
+				continue;
+			}
+			agent->vars[out++] = agent->vars[j];
+		}
+		agent->numVars = out;
+		total += out;
+	}
+	DBGPRINT("Loaded %zu variables for %zu agents from %s\n", total, numAgents, filename);
+	return 0;
+
+fail:
+	free(line);
+	if (fp != stdin)
+		fclose(fp);
+	return -1;
+}
+
+static MibVar *agent_get(Agent *agent, const Oid *oid)
+{
+	size_t lo = 0, hi = agent->numVars;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		int res = oid_compare(agent->vars[mid].name, agent->vars[mid].nameLen,
+				oid->name, oid->nameLen);
+		if (!res)
+			return &agent->vars[mid];
+		if (res < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return NULL;
+}
+
+static MibVar *agent_getnext(Agent *agent, const Oid *oid)
+{
+	size_t lo = 0, hi = agent->numVars;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (oid_compare(agent->vars[mid].name, agent->vars[mid].nameLen,
+				oid->name, oid->nameLen) <= 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo < agent->numVars ? &agent->vars[lo] : NULL;
+}
+
+//--------- BER encoding ------------------//
+
+typedef struct {
+	const uint8_t	*p;
+	const uint8_t	*end;
+} BerIn;
+
+static int ber_get_header(BerIn *in, uint8_t *tag, size_t *len)
+{
+	size_t n;
+
+	if (in->end - in->p < 2)
+		return -1;
+	*tag = *in->p++;
+	n = *in->p++;
+	if (n & 0x80) {
+		size_t bytes = n & 0x7f;
+		if (!bytes || bytes > sizeof(size_t) || (size_t)(in->end - in->p) < bytes)
+			return -1;
+		for (n = 0; bytes; bytes--)
+			n = n << 8 | *in->p++;
+	}
+	if (n > (size_t)(in->end - in->p))
+		return -1;
+	*len = n;
+	return 0;
+}
+
+static int ber_get_int(BerIn *in, int64_t *value)
+{
+	uint8_t tag;
+	size_t len, i;
+	int64_t v;
+
+	if (ber_get_header(in, &tag, &len) || tag != ASN_INTEGER || !len || len > 8)
+		return -1;
+	v = (in->p[0] & 0x80) ? -1 : 0;
+	for (i = 0; i < len; i++)
+		v = (int64_t)((uint64_t)v << 8 | in->p[i]);
+	in->p += len;
+	*value = v;
+	return 0;
+}
+
+static int ber_get_oid(BerIn *in, Oid *oid)
+{
+	uint8_t tag;
+	size_t len;
+	const uint8_t *end;
+	uint32_t v = 0;
+
+	if (ber_get_header(in, &tag, &len) || tag != ASN_OBJECT_ID || !len)
+		return -1;
+	end = in->p + len;
+	oid->nameLen = 0;
+	for (; in->p < end; in->p++) {
+		if (v > (UINT32_MAX >> 7))
+			return -1;
+		v = v << 7 | (*in->p & 0x7f);
+		if (*in->p & 0x80)
+			continue;
+		if (!oid->nameLen) {
+			oid->name[0] = v < 80 ? v / 40 : 2;
+			oid->name[1] = v - oid->name[0] * 40;
+			oid->nameLen = 2;
+		} else if (oid->nameLen < MAX_OID_LEN) {
+			oid->name[oid->nameLen++] = v;
+		} else {
+			return -1;
+		}
+		v = 0;
+	}
+	return v ? -1 : 0;
+}
+
+static size_t ber_len_size(size_t len)
+{
+	return len < 0x80 ? 1 : (len < 0x100 ? 2 : (len < 0x10000 ? 3 : 4));
+}
+
+static uint8_t *ber_put_header(uint8_t *p, uint8_t tag, size_t len)
+{
+	*p++ = tag;
+	if (len < 0x80) {
+		*p++ = (uint8_t)len;
+	} else if (len < 0x100) {
+		*p++ = 0x81;
+		*p++ = (uint8_t)len;
+	} else if (len < 0x10000) {
+		*p++ = 0x82;
+		*p++ = (uint8_t)(len >> 8);
+		*p++ = (uint8_t)len;
+	} else {
+		*p++ = 0x83;
+		*p++ = (uint8_t)(len >> 16);
+		*p++ = (uint8_t)(len >> 8);
+		*p++ = (uint8_t)len;
+	}
+	return p;
+}
+
+// two's complement content of a signed integer, returns its length
+static size_t ber_int_content(uint8_t *buf, int64_t v)
+{
+	size_t len = 8, i;
+
+	while (len > 1) {
+		uint8_t top = (uint8_t)(v >> (8 * (len - 1)));
+		uint8_t next = (uint8_t)(v >> (8 * (len - 2)));
+		if ((top == 0x00 && !(next & 0x80)) || (top == 0xff && (next & 0x80)))
+			len--;
+		else
+			break;
+	}
+	for (i = 0; i < len; i++)
+		buf[i] = (uint8_t)(v >> (8 * (len - 1 - i)));
+	return len;
+}
+
+// content of an unsigned integer (Counter, Gauge, TimeTicks, Counter64)
+static size_t ber_uint_content(uint8_t *buf, uint64_t v)
+{
+	size_t len = 1, i;
+
+	while (len < 8 && (v >> (8 * len)))
+		len++;
+	if ((v >> (8 * (len - 1))) & 0x80) {
+		buf[0] = 0;
+		for (i = 0; i < len; i++)
+			buf[i + 1] = (uint8_t)(v >> (8 * (len - 1 - i)));
+		return len + 1;
+	}
+	for (i = 0; i < len; i++)
+		buf[i] = (uint8_t)(v >> (8 * (len - 1 - i)));
+	return len;
+}
+
+static size_t ber_oid_content(uint8_t *buf, const uint32_t *name, uint32_t nameLen)
+{
+	size_t len = 0;
+	uint32_t i;
+
+	if (nameLen < 2) {
+		buf[len++] = 0;
+		return len;
+	}
+	for (i = 1; i < nameLen; i++) {
+		uint32_t v = i == 1 ? name[0] * 40 + name[1] : name[i];
+		int shift;
+
+		for (shift = 28; shift > 0 && !(v >> shift); shift -= 7)
+			;
+		for (; shift > 0; shift -= 7)
+			buf[len++] = (uint8_t)(0x80 | ((v >> shift) & 0x7f));
+		buf[len++] = (uint8_t)(v & 0x7f);
+	}
+	return len;
+}
+
+/*
+ * encode one varbind, name with either the value of var or, when var is NULL,
+ * the given exception (noSuchObject, endOfMibView). Returns the encoded
+ * length or 0 if it does not fit in size.
+ */
+static size_t encode_varbind(uint8_t *out, size_t size, const uint32_t *name,
+		uint32_t nameLen, const MibVar *var, uint8_t exception)
+{
+	uint8_t nameBuf[MAX_OID_LEN * 5];
+	uint8_t numBuf[9];
+	uint8_t oidBuf[MAX_OID_LEN * 5];
+	const uint8_t *value = NULL;
+	size_t nameSize, valueSize = 0, content;
+	uint8_t type = exception;
+	uint8_t *p;
+
+	nameSize = ber_oid_content(nameBuf, name, nameLen);
+	if (var) {
+		uint64_t num = var->num;
+
+		type = var->type;
+		switch (var->type) {
+		case ASN_INTEGER:
+			valueSize = ber_int_content(numBuf, (int64_t)num);
+			value = numBuf;
+			break;
+		case ASN_TIMETICKS:
+			// keep sysUpTime moving so cache checks see a live agent
+			if (!oid_compare(name, nameLen, sysUpTimeOid,
+					sizeof(sysUpTimeOid) / sizeof(sysUpTimeOid[0])))
+				num = (uint32_t)(num + (uint64_t)((now_ms() - start_time) / 10));
+			/* FALLTHROUGH */
+		case ASN_COUNTER:
+		case ASN_GAUGE:
+		case ASN_COUNTER64:
+			valueSize = ber_uint_content(numBuf, num);
+			value = numBuf;
+			break;
+		case ASN_OBJECT_ID:
+			valueSize = ber_oid_content(oidBuf, (const uint32_t *)var->data,
+					var->len / sizeof(uint32_t));
+			value = oidBuf;
+			break;
+		default:
+			valueSize = var->len;
+			value = var->data;
+			break;
+		}
+	}
+	content = 1 + ber_len_size(nameSize) + nameSize + 1 + ber_len_size(valueSize) + valueSize;
+	if (1 + ber_len_size(content) + content > size)
+		return 0;
+
+	p = ber_put_header(out, ASN_SEQUENCE, content);
+	p = ber_put_header(p, ASN_OBJECT_ID, nameSize);
+	memcpy(p, nameBuf, nameSize);
+	p += nameSize;
+	p = ber_put_header(p, type, valueSize);
+	if (valueSize)
+		memcpy(p, value, valueSize);
+	p += valueSize;
+	return p - out;
+}
+
+//--------- request processing ------------------//
+
+/*
+ * decode a request and build its response into out. Returns the response
+ * length, or 0 if the request was malformed or not supported.
+ */
+static size_t process_request(Agent *agent, const uint8_t *msg, size_t msgLen,
+		uint8_t *out, size_t outSize)
+{
+	static uint8_t vbBuf[MAX_MSG_SIZE];
+	static Oid reqOids[MAX_MSG_SIZE / 8];
+	BerIn in = { msg, msg + msgLen };
+	BerIn vbIn;
+	uint8_t tag, command;
+	size_t len, vbLen = 0, vbSize, n, pduContent, msgContent;
+	const uint8_t *community;
+	size_t communityLen;
+	int64_t version, reqid, nonRep, maxRep;
+	size_t numOids = 0, i;
+	uint8_t intBuf[3][9];
+	size_t intSize[3];
+	uint8_t *p;
+
+	if (ber_get_header(&in, &tag, &len) || tag != ASN_SEQUENCE)
+		return 0;
+	if (ber_get_int(&in, &version) || (version != 0 && version != 1))
+		return 0;
+	if (ber_get_header(&in, &tag, &communityLen) || tag != ASN_OCTET_STR)
+		return 0;
+	community = in.p;
+	in.p += communityLen;
+	if (ber_get_header(&in, &command, &len))
+		return 0;
+	if (ber_get_int(&in, &reqid) || ber_get_int(&in, &nonRep) || ber_get_int(&in, &maxRep))
+		return 0;
+	if (ber_get_header(&in, &tag, &len) || tag != ASN_SEQUENCE)
+		return 0;
+	vbIn.p = in.p;
+	vbIn.end = in.p + len;
+	while (vbIn.p < vbIn.end) {
+		BerIn vb;
+
+		if (ber_get_header(&vbIn, &tag, &len) || tag != ASN_SEQUENCE)
+			return 0;
+		vb.p = vbIn.p;
+		vb.end = vbIn.p + len;
+		vbIn.p += len;
+		if (numOids >= sizeof(reqOids) / sizeof(reqOids[0]) || ber_get_oid(&vb, &reqOids[numOids]))
+			return 0;
+		numOids++;
+	}
+
+	agent->requests++;
+	vbSize = outSize - 64 - communityLen;	// room for message and PDU headers
+	if (vbSize > MAX_RESPONSE_SIZE)
+		vbSize = MAX_RESPONSE_SIZE;
+	switch (command) {
+	case SNMP_MSG_GET:
+		stats.get++;
+		for (i = 0; i < numOids; i++) {
+			MibVar *var = agent_get(agent, &reqOids[i]);
+			n = encode_varbind(vbBuf + vbLen, vbSize - vbLen, reqOids[i].name,
+					reqOids[i].nameLen, var, SNMP_NOSUCHOBJECT);
+			if (!n)
+				return 0;
+			vbLen += n;
+		}
+		break;
+	case SNMP_MSG_GETNEXT:
+		stats.getnext++;
+		for (i = 0; i < numOids; i++) {
+			MibVar *var = agent_getnext(agent, &reqOids[i]);
+			n = var ? encode_varbind(vbBuf + vbLen, vbSize - vbLen, var->name, var->nameLen, var, 0)
+				: encode_varbind(vbBuf + vbLen, vbSize - vbLen, reqOids[i].name,
+					reqOids[i].nameLen, NULL, SNMP_ENDOFMIBVIEW);
+			if (!n)
+				return 0;
+			vbLen += n;
+		}
+		break;
+	case SNMP_MSG_GETBULK:
+		stats.getbulk++;
+		if (version == 0)
+			return 0;
+		if (nonRep < 0)
+			nonRep = 0;
+		if ((size_t)nonRep > numOids)
+			nonRep = numOids;
+		if (maxRep < 0)
+			maxRep = 0;
+		for (i = 0; i < (size_t)nonRep; i++) {
+			MibVar *var = agent_getnext(agent, &reqOids[i]);
+			n = var ? encode_varbind(vbBuf + vbLen, vbSize - vbLen, var->name, var->nameLen, var, 0)
+				: encode_varbind(vbBuf + vbLen, vbSize - vbLen, reqOids[i].name,
+					reqOids[i].nameLen, NULL, SNMP_ENDOFMIBVIEW);
+			if (!n)
+				return 0;
+			vbLen += n;
+		}
+		// repetitions are interleaved, a response that would be too big is
+		// truncated after the last complete varbind (RFC 3416 4.2.3)
+		for (; maxRep > 0 && numOids > (size_t)nonRep; maxRep--) {
+			bool more = false, full = false;
+
+			for (i = nonRep; i < numOids; i++) {
+				MibVar *var = agent_getnext(agent, &reqOids[i]);
+				if (var) {
+					n = encode_varbind(vbBuf + vbLen, vbSize - vbLen, var->name, var->nameLen, var, 0);
+					if (n) {
+						memcpy(reqOids[i].name, var->name, var->nameLen * sizeof(uint32_t));
+						reqOids[i].nameLen = var->nameLen;
+						more = true;
+					}
+				} else {
+					n = encode_varbind(vbBuf + vbLen, vbSize - vbLen, reqOids[i].name,
+							reqOids[i].nameLen, NULL, SNMP_ENDOFMIBVIEW);
+				}
+				if (!n) {
+					full = true;
+					break;
+				}
+				vbLen += n;
+			}
+			if (full || !more)
+				break;
+		}
+		break;
+	default:
+		return 0;
+	}
+	stats.varbinds += numOids;
+
+	intSize[0] = ber_int_content(intBuf[0], reqid);
+	intSize[1] = ber_int_content(intBuf[1], 0);	// error-status
+	intSize[2] = ber_int_content(intBuf[2], 0);	// error-index
+	pduContent = 1 + ber_len_size(vbLen) + vbLen;
+	for (i = 0; i < 3; i++)
+		pduContent += 2 + intSize[i];
+	msgContent = 3 + 1 + ber_len_size(communityLen) + communityLen
+		+ 1 + ber_len_size(pduContent) + pduContent;
+	if (1 + ber_len_size(msgContent) + msgContent > outSize)
+		return 0;
+
+	p = ber_put_header(out, ASN_SEQUENCE, msgContent);
+	*p++ = ASN_INTEGER;
+	*p++ = 1;
+	*p++ = (uint8_t)version;
+	p = ber_put_header(p, ASN_OCTET_STR, communityLen);
+	memcpy(p, community, communityLen);
+	p += communityLen;
+	p = ber_put_header(p, SNMP_MSG_RESPONSE, pduContent);
+	for (i = 0; i < 3; i++) {
+		p = ber_put_header(p, ASN_INTEGER, intSize[i]);
+		memcpy(p, intBuf[i], intSize[i]);
+		p += intSize[i];
+	}
+	p = ber_put_header(p, ASN_SEQUENCE, vbLen);
+	memcpy(p, vbBuf, vbLen);
+	p += vbLen;
+	return p - out;
+}
+
+//--------- network ------------------//
+
+static int send_response(int sock, const struct sockaddr_in *client, struct in_addr local,
+		const uint8_t *buf, size_t len)
+{
+	struct iovec iov = { (void *)buf, len };
+	char control[CMSG_SPACE(sizeof(struct in_pktinfo))];
+	struct msghdr msg;
+	struct cmsghdr *cmsg;
+	struct in_pktinfo *pktinfo;
+
+	memset(&msg, 0, sizeof(msg));
+	memset(control, 0, sizeof(control));
+	msg.msg_name = (void *)client;
+	msg.msg_namelen = sizeof(*client);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = IPPROTO_IP;
+	cmsg->cmsg_type = IP_PKTINFO;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(struct in_pktinfo));
+	pktinfo = (struct in_pktinfo *)CMSG_DATA(cmsg);
+	pktinfo->ipi_spec_dst = local;	// answer from the virtual switch address
+
+	if (sendmsg(sock, &msg, 0) < 0) {
+		PFWARN("sendmsg failed: %s\n", strerror(errno));
+		return -1;
+	}
+	stats.responses++;
+	stats.bytesOut += len;
+	return 0;
+}
+
+static void pending_push(const Pending *entry)
+{
+	size_t i;
+
+	if (numPending >= maxPending) {
+		maxPending = maxPending ? maxPending * 2 : 1024;
+		pending = xrealloc(pending, maxPending * sizeof(Pending));
+	}
+	for (i = numPending++; i > 0 && pending[(i - 1) / 2].due > entry->due; i = (i - 1) / 2)
+		pending[i] = pending[(i - 1) / 2];
+	pending[i] = *entry;
+}
+
+static void pending_pop(void)
+{
+	Pending last = pending[--numPending];
+	size_t i = 0, child;
+
+	while ((child = 2 * i + 1) < numPending) {
+		if (child + 1 < numPending && pending[child + 1].due < pending[child].due)
+			child++;
+		if (pending[child].due >= last.due)
+			break;
+		pending[i] = pending[child];
+		i = child;
+	}
+	if (numPending)
+		pending[i] = last;
+}
+
+static void flush_pending(int sock)
+{
+	double now = now_ms();
+
+	while (numPending && pending[0].due <= now) {
+		send_response(sock, &pending[0].client, pending[0].local, pending[0].buf, pending[0].len);
+		free(pending[0].buf);
+		pending_pop();
+	}
+}
+
+static void handle_request(int sock, const uint8_t *buf, size_t len,
+		const struct sockaddr_in *client, struct in_addr local)
+{
+	static uint8_t out[MAX_MSG_SIZE];
+	Agent *agent;
+	size_t outLen;
+	double delay;
+
+	stats.received++;
+	stats.bytesIn += len;
+	if (!(agent = find_agent(local))) {
+		stats.unknown++;
+		DBGPRINT("Request for unknown agent %s\n", inet_ntoa(local));
+		return;
+	}
+	if (loss_pct > 0 && drand48() * 100.0 < loss_pct) {
+		stats.dropped++;
+		return;
+	}
+	if (!(outLen = process_request(agent, buf, len, out, sizeof(out)))) {
+		stats.malformed++;
+		DBGPRINT("Malformed or unsupported request for %s\n", agent->peer);
+		return;
+	}
+
+	delay = latency_ms;
+	if (jitter_ms > 0)
+		delay += (drand48() * 2.0 - 1.0) * jitter_ms;
+	if (delay <= 0) {
+		send_response(sock, client, local, out, outLen);
+	} else {
+		Pending entry;
+
+		entry.due = now_ms() + delay;
+		entry.client = *client;
+		entry.local = local;
+		entry.len = outLen;
+		entry.buf = xrealloc(NULL, outLen);
+		memcpy(entry.buf, out, outLen);
+		pending_push(&entry);
+	}
+}
+
+static void receive_requests(int sock)
+{
+	static uint8_t buf[MAX_MSG_SIZE];
+	char control[CMSG_SPACE(sizeof(struct in_pktinfo))];
+	struct sockaddr_in client;
+	struct iovec iov = { buf, sizeof(buf) };
+	struct msghdr msg;
+	struct cmsghdr *cmsg;
+	ssize_t len;
+
+	for (;;) {
+		struct in_addr local = { 0 };
+
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_name = &client;
+		msg.msg_namelen = sizeof(client);
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		len = recvmsg(sock, &msg, MSG_DONTWAIT);
+		if (len < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				PFWARN("recvmsg failed: %s\n", strerror(errno));
+			return;
+		}
+		for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+			if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO)
+				local = ((struct in_pktinfo *)CMSG_DATA(cmsg))->ipi_addr;
+		}
+		handle_request(sock, buf, (size_t)len, &client, local);
+	}
+}
+
+static int open_socket(const char *bind_addr, int port)
+{
+	struct sockaddr_in addr;
+	int sock, on = 1, bufsize = 8 * 1024 * 1024;
+
+	if ((sock = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+		PFERROR("socket failed: %s\n", strerror(errno));
+		return -1;
+	}
+	if (setsockopt(sock, IPPROTO_IP, IP_PKTINFO, &on, sizeof(on)) < 0) {
+		PFERROR("IP_PKTINFO not supported: %s\n", strerror(errno));
+		close(sock);
+		return -1;
+	}
+	// a sweep sends to all switches at once, avoid drops in the socket
+	(void)setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+	(void)setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &bufsize, sizeof(bufsize));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (bind_addr && inet_pton(AF_INET, bind_addr, &addr.sin_addr) != 1) {
+		PFERROR("Invalid bind address %s\n", bind_addr);
+		close(sock);
+		return -1;
+	}
+	if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		PFERROR("bind to port %d failed: %s\n", port, strerror(errno));
+		close(sock);
+		return -1;
+	}
+	return sock;
+}
+
+static void handle_signal(int sig)
+{
+	(void)sig;
+	stop = 1;
+}
+
+static void print_stats(FILE *out, double elapsed_ms)
+{
+	fprintf(out, "%s: %zu agents, %.3f s\n", BASENAME, numAgents, elapsed_ms / 1000.0);
+	fprintf(out, "  Requests:   %"PRIu64" (GET %"PRIu64", GETNEXT %"PRIu64", GETBULK %"PRIu64")\n",
+			stats.received, stats.get, stats.getnext, stats.getbulk);
+	fprintf(out, "  Responses:  %"PRIu64"\n", stats.responses);
+	fprintf(out, "  Dropped:    %"PRIu64" lost, %"PRIu64" malformed, %"PRIu64" unknown agent\n",
+			stats.dropped, stats.malformed, stats.unknown);
+	fprintf(out, "  Varbinds:   %"PRIu64" requested\n", stats.varbinds);
+	fprintf(out, "  Bytes:      %"PRIu64" in, %"PRIu64" out\n", stats.bytesIn, stats.bytesOut);
+}
+
+static int write_switches(const char *filename)
+{
+	FILE *fp;
+	size_t i;
+
+	if (!(fp = fopen(filename, "w"))) {
+		PFERROR("Unable to open %s: %s\n", filename, strerror(errno));
+		return -1;
+	}
+	for (i = 0; i < numAgents; i++) {
+		char addr[INET_ADDRSTRLEN];
+
+		inet_ntop(AF_INET, &agents[i].addr, addr, sizeof(addr));
+		if (strcmp(addr, agents[i].peer))
+			fprintf(fp, "# %s\n", agents[i].peer);
+		fprintf(fp, "%s\n", addr);
+	}
+	fclose(fp);
+	return 0;
+}
+
+//--------- synthetic fabric ------------------//
+
+#define GEN_VENDOR 8072		// sysObjectID enterprise, objid[6] is the vendor
+
+static uint32_t gen_addr(int sw)
+{
+	return 0x7f010000 | ((sw / 250) << 8) | (sw % 250 + 1);
+}
+
+static void gen_peer(char *buf, size_t size, int sw, int port)
+{
+	struct in_addr addr = { htonl(gen_addr(sw)) };
+
+	snprintf(buf, size, "%s:%d", inet_ntoa(addr), port);
+}
+
+static void gen_num(FILE *fp, const char *peer, const char *name, int type, uint64_t value)
+{
+	fprintf(fp, "= %s %s %d %"PRIu64"\n", peer, name, type, value);
+}
+
+static void gen_raw(FILE *fp, const char *peer, const char *name, int type,
+		const uint8_t *data, size_t len)
+{
+	size_t i;
+
+	fprintf(fp, "= %s %s %d ", peer, name, type);
+	if (!len)
+		fputc('-', fp);
+	for (i = 0; i < len; i++)
+		fprintf(fp, "%02x", data[i]);
+	fputc('\n', fp);
+}
+
+static void gen_str(FILE *fp, const char *peer, const char *name, const char *str)
+{
+	gen_raw(fp, peer, name, ASN_OCTET_STR, (const uint8_t *)str, strlen(str));
+}
+
+static void gen_mac(uint8_t *mac, int sw, int port)
+{
+	mac[0] = 0x02;	// locally administered
+	mac[1] = 0x00;
+	mac[2] = (uint8_t)(sw >> 8);
+	mac[3] = (uint8_t)sw;
+	mac[4] = (uint8_t)(port >> 8);
+	mac[5] = (uint8_t)port;
+}
+
+/*
+ * peer of port (1..numPorts) of switch sw in a two tier leaf/spine fabric.
+ * Switches 0..numSpines-1 are spines, the others are leaves whose last
+ * numUplinks ports go to the spines. Returns -1 for a down port.
+ */
+static int gen_link(int sw, int port, int numSwitches, int numSpines, int numUplinks,
+		int numPorts, int *peerPort)
+{
+	int numLeaves = numSwitches - numSpines;
+
+	if (sw >= numSpines) {
+		int uplink = port - (numPorts - numUplinks) - 1;
+		int link = (sw - numSpines) * numUplinks + uplink;
+
+		if (uplink < 0 || link / numSpines >= numPorts)
+			return -1;
+		*peerPort = link / numSpines + 1;
+		return link % numSpines;
+	} else {
+		int link = (port - 1) * numSpines + sw;
+
+		if (link >= numLeaves * numUplinks)
+			return -1;
+		*peerPort = numPorts - numUplinks + link % numUplinks + 1;
+		return numSpines + link / numUplinks;
+	}
+}
+
+static void gen_switch(FILE *fp, int sw, int numSwitches, int numSpines, int numUplinks,
+		int numPorts, int port)
+{
+	char peer[64], name[128], buf[64];
+	uint8_t mac[6];
+	uint8_t caps = 0x20;	// bridge
+	int ifCount = numPorts + 1;	// front ports and the management interface
+	int mgmt = numPorts + 1;
+	uint32_t addr = gen_addr(sw);
+	int i, col;
+	static const int dot3Cols[] = { 4, 5, 6, 7, 8, 9, 11 };
+	static const int ifErrCols[] = { 13, 14, 15, 19, 20 };
+
+	gen_peer(peer, sizeof(peer), sw, port);
+	snprintf(buf, sizeof(buf), "sw%04d", sw);
+
+	fprintf(fp, "= %s .1.3.6.1.2.1.1.2.0 %d .1.3.6.1.4.1.%d.3.%d\n", peer, ASN_OBJECT_ID,
+			GEN_VENDOR, sw < numSpines ? 2 : 1);
+	gen_num(fp, peer, ".1.3.6.1.2.1.1.3.0", ASN_TIMETICKS, 360000 + sw);
+	gen_str(fp, peer, ".1.3.6.1.2.1.1.5.0", buf);
+	gen_num(fp, peer, ".1.3.6.1.2.1.2.1.0", ASN_INTEGER, ifCount);
+
+	// ifTable, ifXTable, ipAddrTable and EtherLike-MIB
+	for (i = 1; i <= ifCount; i++) {
+		int peerPort, up = (i == mgmt) ||
+			gen_link(sw, i, numSwitches, numSpines, numUplinks, numPorts, &peerPort) >= 0;
+		char ifname[32];
+
+		if (i == mgmt)
+			snprintf(ifname, sizeof(ifname), "mgmt0");
+		else
+			snprintf(ifname, sizeof(ifname), "Ethernet%d", i);
+		gen_mac(mac, sw, i);
+		snprintf(name, sizeof(name), ".1.3.6.1.2.1.2.2.1.1.%d", i);
+		gen_num(fp, peer, name, ASN_INTEGER, i);
+		snprintf(name, sizeof(name), ".1.3.6.1.2.1.2.2.1.2.%d", i);
+		gen_str(fp, peer, name, ifname);
+		snprintf(name, sizeof(name), ".1.3.6.1.2.1.2.2.1.3.%d", i);
+		gen_num(fp, peer, name, ASN_INTEGER, 6);	// ethernetCsmacd
+		snprintf(name, sizeof(name), ".1.3.6.1.2.1.2.2.1.4.%d", i);
+		gen_num(fp, peer, name, ASN_INTEGER, i == mgmt ? 1500 : 9216);
+		snprintf(name, sizeof(name), ".1.3.6.1.2.1.2.2.1.5.%d", i);
+		gen_num(fp, peer, name, ASN_GAUGE, i == mgmt ? 1000000000u : 4294967295u);
+		snprintf(name, sizeof(name), ".1.3.6.1.2.1.2.2.1.6.%d", i);
+		gen_raw(fp, peer, name, ASN_OCTET_STR, mac, sizeof(mac));
+		snprintf(name, sizeof(name), ".1.3.6.1.2.1.2.2.1.8.%d", i);
+		gen_num(fp, peer, name, ASN_INTEGER, up ? 1 : 2);
+		for (col = 0; col < (int)(sizeof(ifErrCols) / sizeof(ifErrCols[0])); col++) {
+			snprintf(name, sizeof(name), ".1.3.6.1.2.1.2.2.1.%d.%d", ifErrCols[col], i);
+			gen_num(fp, peer, name, ASN_COUNTER, 0);
+		}
+
+		snprintf(name, sizeof(name), ".1.3.6.1.2.1.31.1.1.1.1.%d", i);
+		gen_str(fp, peer, name, ifname);
+		for (col = 6; col <= 12; col++) {
+			if (col == 9)
+				continue;
+			snprintf(name, sizeof(name), ".1.3.6.1.2.1.31.1.1.1.%d.%d", col, i);
+			gen_num(fp, peer, name, ASN_COUNTER64, up ? (uint64_t)(sw + 1) * 1000003 * col + i : 0);
+		}
+		snprintf(name, sizeof(name), ".1.3.6.1.2.1.31.1.1.1.15.%d", i);
+		gen_num(fp, peer, name, ASN_GAUGE, i == mgmt ? 1000 : 100000);
+
+		if (i == mgmt)
+			continue;
+		for (col = 0; col < (int)(sizeof(dot3Cols) / sizeof(dot3Cols[0])); col++) {
+			snprintf(name, sizeof(name), ".1.3.6.1.2.1.10.7.2.1.%d.%d", dot3Cols[col], i);
+			gen_num(fp, peer, name, ASN_COUNTER, 0);
+		}
+		for (col = 1; col <= 6; col++) {
+			snprintf(name, sizeof(name), ".1.3.6.1.2.1.10.7.11.1.%d.%d", col, i);
+			gen_num(fp, peer, name, ASN_COUNTER64, 0);
+		}
+		// MAU-MIB, indexed by ifIndex.ifMauIndex
+		snprintf(name, sizeof(name), ".1.3.6.1.2.1.26.2.1.1.4.%d.1", i);
+		gen_num(fp, peer, name, ASN_INTEGER, up ? 3 : 4);	// operational/standby
+		snprintf(name, sizeof(name), ".1.3.6.1.2.1.26.2.1.1.5.%d.1", i);
+		gen_num(fp, peer, name, ASN_INTEGER, up ? 3 : 4);	// available/notAvailable
+		snprintf(name, sizeof(name), ".1.3.6.1.2.1.26.2.1.1.13.%d.1", i);
+		gen_raw(fp, peer, name, ASN_OCTET_STR, (const uint8_t *)"\x00\x00\x00\x00\x00\x00\x00\x00\x00\x10", 10);
+		snprintf(name, sizeof(name), ".1.3.6.1.2.1.26.5.1.1.1.%d.1", i);
+		gen_num(fp, peer, name, ASN_INTEGER, 1);	// enabled
+	}
+	snprintf(name, sizeof(name), ".1.3.6.1.2.1.4.20.1.2.%u.%u.%u.%u",
+			addr >> 24, (addr >> 16) & 0xff, (addr >> 8) & 0xff, addr & 0xff);
+	gen_num(fp, peer, name, ASN_INTEGER, mgmt);
+
+	// ENTITY-MIB, a single chassis
+	snprintf(name, sizeof(name), "Simulated %s switch", sw < numSpines ? "spine" : "leaf");
+	gen_str(fp, peer, ".1.3.6.1.2.1.47.1.1.1.1.2.1", name);
+	gen_num(fp, peer, ".1.3.6.1.2.1.47.1.1.1.1.5.1", ASN_INTEGER, 3);	// chassis
+	gen_str(fp, peer, ".1.3.6.1.2.1.47.1.1.1.1.8.1", "A0");
+	gen_str(fp, peer, ".1.3.6.1.2.1.47.1.1.1.1.9.1", "1.0.0");
+	snprintf(name, sizeof(name), "SIM%08d", sw);
+	gen_str(fp, peer, ".1.3.6.1.2.1.47.1.1.1.1.11.1", name);
+	gen_str(fp, peer, ".1.3.6.1.2.1.47.1.1.1.1.12.1", BASENAME);
+	gen_str(fp, peer, ".1.3.6.1.2.1.47.1.1.1.1.13.1", "SIM-64");
+
+	// LLDP-MIB local system
+	gen_mac(mac, sw, 0);
+	gen_raw(fp, peer, ".1.0.8802.1.1.2.1.3.2.0", ASN_OCTET_STR, mac, sizeof(mac));
+	gen_str(fp, peer, ".1.0.8802.1.1.2.1.3.3.0", buf);
+	gen_raw(fp, peer, ".1.0.8802.1.1.2.1.3.5.0", ASN_OCTET_STR, &caps, 1);
+	gen_raw(fp, peer, ".1.0.8802.1.1.2.1.3.6.0", ASN_OCTET_STR, &caps, 1);
+	for (i = 1; i <= numPorts; i++) {
+		char ifname[32];
+
+		snprintf(ifname, sizeof(ifname), "Ethernet%d", i);
+		snprintf(name, sizeof(name), ".1.0.8802.1.1.2.1.3.7.1.2.%d", i);
+		gen_num(fp, peer, name, ASN_INTEGER, 7);	// local
+		snprintf(name, sizeof(name), ".1.0.8802.1.1.2.1.3.7.1.3.%d", i);
+		gen_str(fp, peer, name, ifname);
+		snprintf(name, sizeof(name), ".1.0.8802.1.1.2.1.3.7.1.4.%d", i);
+		gen_str(fp, peer, name, ifname);
+	}
+	snprintf(name, sizeof(name), ".1.0.8802.1.1.2.1.3.8.1.5.1.4.%u.%u.%u.%u",
+			addr >> 24, (addr >> 16) & 0xff, (addr >> 8) & 0xff, addr & 0xff);
+	gen_num(fp, peer, name, ASN_INTEGER, mgmt);
+
+	// LLDP-MIB remote systems, indexed by timeMark.localPortNum.remIndex
+	for (i = 1; i <= numPorts; i++) {
+		int peerPort, peerSw = gen_link(sw, i, numSwitches, numSpines, numUplinks, numPorts, &peerPort);
+		char ifname[32], sysname[32];
+
+		if (peerSw < 0)
+			continue;
+		snprintf(ifname, sizeof(ifname), "Ethernet%d", peerPort);
+		snprintf(sysname, sizeof(sysname), "sw%04d", peerSw);
+		gen_mac(mac, peerSw, 0);
+		snprintf(name, sizeof(name), ".1.0.8802.1.1.2.1.4.1.1.5.0.%d.1", i);
+		gen_raw(fp, peer, name, ASN_OCTET_STR, mac, sizeof(mac));
+		snprintf(name, sizeof(name), ".1.0.8802.1.1.2.1.4.1.1.6.0.%d.1", i);
+		gen_num(fp, peer, name, ASN_INTEGER, 7);
+		snprintf(name, sizeof(name), ".1.0.8802.1.1.2.1.4.1.1.7.0.%d.1", i);
+		gen_str(fp, peer, name, ifname);
+		snprintf(name, sizeof(name), ".1.0.8802.1.1.2.1.4.1.1.9.0.%d.1", i);
+		gen_str(fp, peer, name, sysname);
+		snprintf(name, sizeof(name), ".1.0.8802.1.1.2.1.4.1.1.12.0.%d.1", i);
+		gen_raw(fp, peer, name, ASN_OCTET_STR, &caps, 1);
+	}
+}
+
+/*
+ * write a synthetic leaf/spine fabric into dir: the capture to replay, the
+ * switches and (empty) hosts files, and an Ethernet Mgt config whose plane
+ * "sim" points at them.
+ */
+static int generate_fabric(const char *dir, int numSwitches, int numPorts, int port)
+{
+	char path[PATH_MAX + 32], absdir[PATH_MAX];
+	int numSpines = numSwitches / 10 > 1 ? numSwitches / 10 : 1;
+	int numUplinks = numSpines < 4 ? numSpines : 4;
+	FILE *fp;
+	int sw;
+
+	if (mkdir(dir, 0755) < 0 && errno != EEXIST) {
+		PFERROR("Unable to create %s: %s\n", dir, strerror(errno));
+		return -1;
+	}
+	if (!realpath(dir, absdir)) {
+		PFERROR("Unable to resolve %s: %s\n", dir, strerror(errno));
+		return -1;
+	}
+	if (numUplinks >= numPorts)
+		numUplinks = numPorts - 1;
+
+	snprintf(path, sizeof(path), "%s/fabric.cap", absdir);
+	if (!(fp = fopen(path, "w"))) {
+		PFERROR("Unable to open %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+	fprintf(fp, "%s\n", CAPTURE_HEADER);
+	fprintf(fp, "# synthetic fabric: %d switches, %d spines, %d uplinks per leaf, %d ports\n",
+			numSwitches, numSpines, numUplinks, numPorts);
+	for (sw = 0; sw < numSwitches; sw++)
+		gen_switch(fp, sw, numSwitches, numSpines, numUplinks, numPorts, port);
+	if (fclose(fp)) {
+		PFERROR("Unable to write %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	snprintf(path, sizeof(path), "%s/switches", absdir);
+	if (!(fp = fopen(path, "w"))) {
+		PFERROR("Unable to open %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+	for (sw = 0; sw < numSwitches; sw++) {
+		struct in_addr addr = { htonl(gen_addr(sw)) };
+		fprintf(fp, "%s\n", inet_ntoa(addr));
+	}
+	fclose(fp);
+
+	snprintf(path, sizeof(path), "%s/allhosts", absdir);
+	if (!(fp = fopen(path, "w"))) {
+		PFERROR("Unable to open %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+	fclose(fp);
+
+	snprintf(path, sizeof(path), "%s/mgt_config.xml", absdir);
+	if (!(fp = fopen(path, "w"))) {
+		PFERROR("Unable to open %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+	fprintf(fp, "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n");
+	fprintf(fp, "<!-- generated by %s -G %d -->\n", BASENAME, numSwitches);
+	fprintf(fp, "<Config>\n");
+	fprintf(fp, "\t<Common>\n");
+	fprintf(fp, "\t\t<ConfigDir>%s</ConfigDir>\n", absdir);
+	fprintf(fp, "\t\t<SnmpPort>%d</SnmpPort>\n", port);
+	fprintf(fp, "\t\t<SnmpVersion>SNMP_VERSION_2c</SnmpVersion>\n");
+	fprintf(fp, "\t\t<SnmpCommunityString>public</SnmpCommunityString>\n");
+	fprintf(fp, "\t</Common>\n");
+	fprintf(fp, "\t<Plane>\n");
+	fprintf(fp, "\t\t<Name>sim</Name>\n");
+	fprintf(fp, "\t\t<Enable>1</Enable>\n");
+	fprintf(fp, "\t\t<HostsFile>%s/allhosts</HostsFile>\n", absdir);
+	fprintf(fp, "\t\t<SwitchesFile>%s/switches</SwitchesFile>\n", absdir);
+	fprintf(fp, "\t</Plane>\n");
+	fprintf(fp, "</Config>\n");
+	fclose(fp);
+
+	printf("%s: generated %d switches (%d spines, %d uplinks per leaf) in %s\n",
+			BASENAME, numSwitches, numSpines, numUplinks, absdir);
+	return 0;
+}
+
+//--------- main ------------------//
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: %s [-v] [-b bind_addr] [-p port] [-l latency_ms] [-j jitter_ms]\n", BASENAME);
+	fprintf(stderr, "                  [-L loss_pct] [-s seed] [-w switches_file] [-f pid_file] capture_file\n");
+	fprintf(stderr, "   or: %s -G switches [-P ports] [-p port] -d dir\n", BASENAME);
+	fprintf(stderr, "    -v              - verbose output\n");
+	fprintf(stderr, "    -b bind_addr    - address to listen on, default is all addresses\n");
+	fprintf(stderr, "    -p port         - UDP port of all virtual switches, default is %d\n", DEFAULT_PORT);
+	fprintf(stderr, "    -l latency_ms   - delay every response by latency_ms\n");
+	fprintf(stderr, "    -j jitter_ms    - add a uniform random -jitter_ms..+jitter_ms to the delay\n");
+	fprintf(stderr, "    -L loss_pct     - drop loss_pct percent of the requests\n");
+	fprintf(stderr, "    -s seed         - random seed for loss and jitter\n");
+	fprintf(stderr, "    -w switches_file- write the virtual switch addresses to switches_file\n");
+	fprintf(stderr, "    -f pid_file     - run in background once listening and write its pid,\n");
+	fprintf(stderr, "                      pid_file is removed on exit\n");
+	fprintf(stderr, "    -G switches     - generate a synthetic leaf/spine fabric instead\n");
+	fprintf(stderr, "    -P ports        - ports per generated switch, default is 64\n");
+	fprintf(stderr, "    -d dir          - directory for the generated capture and config files\n");
+	fprintf(stderr, "Each virtual switch of the capture answers on its own loopback address.\n");
+	fprintf(stderr, "Statistics are printed to stderr on SIGINT or SIGTERM.\n");
+}
+
+int main(int argc, char **argv)
+{
+	int op, sock;
+	int port = DEFAULT_PORT;
+	int gen_switches = 0, gen_ports = 64;
+	long seed = (long)time(NULL);
+	char *bind_addr = NULL, *switches_file = NULL, *pid_file = NULL, *dir = NULL;
+	struct sigaction sa;
+
+	while ((op = getopt(argc, argv, "vb:p:l:j:L:s:w:f:G:P:d:")) != -1) {
+		switch (op) {
+		case 'v':
+			verbose++;
+			break;
+		case 'b':
+			bind_addr = optarg;
+			break;
+		case 'p':
+			port = atoi(optarg);
+			if (port <= 0 || port > 65535) {
+				PFERROR("Invalid value for -p option: %s\n", optarg);
+				exit(1);
+			}
+			break;
+		case 'l':
+			latency_ms = atof(optarg);
+			break;
+		case 'j':
+			jitter_ms = atof(optarg);
+			break;
+		case 'L':
+			loss_pct = atof(optarg);
+			if (loss_pct < 0 || loss_pct > 100) {
+				PFERROR("Invalid value for -L option: %s\n", optarg);
+				exit(1);
+			}
+			break;
+		case 's':
+			seed = atol(optarg);
+			break;
+		case 'w':
+			switches_file = optarg;
+			break;
+		case 'f':
+			pid_file = optarg;
+			break;
+		case 'G':
+			gen_switches = atoi(optarg);
+			if (gen_switches <= 0 || gen_switches > 250 * 256) {
+				PFERROR("Invalid value for -G option: %s\n", optarg);
+				exit(1);
+			}
+			break;
+		case 'P':
+			gen_ports = atoi(optarg);
+			if (gen_ports < 2 || gen_ports > 1024) {
+				PFERROR("Invalid value for -P option: %s\n", optarg);
+				exit(1);
+			}
+			break;
+		case 'd':
+			dir = optarg;
+			break;
+		default:
+			usage();
+			exit(1);
+		}
+	}
+
+	if (gen_switches) {
+		if (!dir || optind != argc) {
+			usage();
+			exit(1);
+		}
+		exit(generate_fabric(dir, gen_switches, gen_ports, port) ? 1 : 0);
+	}
+	if (optind != argc - 1) {
+		usage();
+		exit(1);
+	}
+
+	if (load_capture(argv[optind]))
+		exit(1);
+	if (!numAgents) {
+		PFERROR("No variables in %s\n", argv[optind]);
+		exit(1);
+	}
+	if (switches_file && write_switches(switches_file))
+		exit(1);
+	if ((sock = open_socket(bind_addr, port)) < 0)
+		exit(1);
+	srand48(seed);
+
+	if (pid_file) {
+		FILE *fp;
+		pid_t pid = fork();
+
+		if (pid < 0) {
+			PFERROR("fork failed: %s\n", strerror(errno));
+			exit(1);
+		}
+		if (pid > 0) {
+			if (!(fp = fopen(pid_file, "w"))) {
+				PFERROR("Unable to open %s: %s\n", pid_file, strerror(errno));
+				kill(pid, SIGTERM);
+				exit(1);
+			}
+			fprintf(fp, "%d\n", (int)pid);
+			fclose(fp);
+			exit(0);
+		}
+		setsid();
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = handle_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	DBGPRINT("Serving %zu agents on port %d\n", numAgents, port);
+	start_time = now_ms();
+	while (!stop) {
+		struct pollfd pfd = { sock, POLLIN, 0 };
+		struct timespec ts = { 1, 0 };
+
+		if (numPending) {
+			double wait = pending[0].due - now_ms();
+			if (wait < 0)
+				wait = 0;
+			ts.tv_sec = (time_t)(wait / 1000);
+			ts.tv_nsec = (long)((wait - ts.tv_sec * 1000.0) * 1000000);
+		}
+		if (ppoll(&pfd, 1, &ts, NULL) > 0 && (pfd.revents & POLLIN))
+			receive_requests(sock);
+		flush_pending(sock);
+	}
+
+	print_stats(stderr, now_ms() - start_time);
+	close(sock);
+	if (pid_file)
+		unlink(pid_file);	// tells scripts the statistics are complete
+	return 0;
+}
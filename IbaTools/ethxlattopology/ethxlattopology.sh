@@ -119,6 +119,7 @@ FILE_TEMP=$(mktemp "ethxlattopo-1.XXXX")
 FILE_TEMP2=$(mktemp "ethxlattopo-2.XXXX")
 DIR_TEMP=$(mktemp -d -t "ethff-XXXX")
 FILE_TOPOLOGY_TEMP="topology_temp.xml"
+FILE_RECORDS="topology_records.csv"
 # Note: there are no real limits on numbers of groups, racks or switches;
 #  these defines simply allow error messages before too much thrashing
 #  takes place in cases where FILE_TOPOLOGY_LINKS has bad data
@@ -301,6 +302,9 @@ topology_file_cleanup() {
   if [ -f $FILE_TOPOLOGY_TEMP ]; then
     remove_file "$FILE_TOPOLOGY_TEMP"
   fi
+  if [ -f $FILE_RECORDS ]; then
+    remove_file "$FILE_RECORDS"
+  fi
 }
 
 trap 'clean_tempfiles; topology_file_cleanup; exit 1' SIGINT SIGHUP SIGTERM
@@ -482,7 +486,8 @@ gen_topology()
       # Extract node detail content from NIC node data
       details=""
       if [[ "$node_in" =~ ";" ]]; then
-        details=`echo "$node_in" | cut -d ';' -f 2 -`
+        details=${node_in#*;}
+        details=${details%%;*}
       fi
       # Use node desc to lookup optional XML data (misc entries)
       node=${node_in/;*/}
@@ -539,42 +544,61 @@ gen_topology()
   fi
 
   remove_file "$FILE_TOPOLOGY_TEMP"
+  remove_file "$FILE_RECORDS"
   echo '<?xml version="1.0" encoding="utf-8" ?>' >> $FILE_TOPOLOGY_TEMP
   echo "<Report plane=\"$plane\">" >> $FILE_TOPOLOGY_TEMP
 
+  # The sections below are collected as keyed records (first field selects
+  # the $XML_GENERATE template) so the XML is generated by a single pass
   if [ "$output_section" == "all"  ] || [ "$output_section" == "links" ] ; then
     # Generate LinkSummary section
-    echo "<LinkSummary>" >> $FILE_TOPOLOGY_TEMP
+    echo "LinkSummary" >> $FILE_RECORDS
     if [ -s $FILE_LINKSUM -a $1 == 1 ]
       then
-      $XML_GENERATE -X $FILE_LINKSUM -d \; -i 2 -h Link -g Rate -g MTU -g LinkDetails -g Internal -h Cable -g CableLength -g CableLabel -g CableDetails -e Cable -h Port -g PortNum -g PortId -g NodeType -g NodeDesc -e Port -h Port -g PortNum -g PortId -g NodeType -g NodeDesc -e Port -e Link >> $FILE_TOPOLOGY_TEMP
+      sed -e 's/^/Link;/' $FILE_LINKSUM >> $FILE_RECORDS
     elif [ -s $FILE_LINKSUM_NOCORE -a $1 == 0 ]
       then
-      $XML_GENERATE -X $FILE_LINKSUM_NOCORE -d \; -i 2 -h Link -g Rate -g MTU -g LinkDetails -g Internal -h Cable -g CableLength -g CableLabel -g CableDetails -e Cable -h Port -g PortNum -g PortId -g NodeType -g NodeDesc -e Port -h Port -g PortNum -g PortId -g NodeType -g NodeDesc -e Port -e Link >> $FILE_TOPOLOGY_TEMP
+      sed -e 's/^/Link;/' $FILE_LINKSUM_NOCORE >> $FILE_RECORDS
     fi
 
     if [ -s $FILE_LINKSUM_NOCABLE -a $2 == 1 ]
       then
       # Note: <Cable> header not needed because cable data is null
-      $XML_GENERATE -X $FILE_LINKSUM_NOCABLE -d \; -i 2 -h Link -g Rate -g MTU -g LinkDetails -g Internal -g CableLength -g CableLabel -g CableDetails -h Port -g PortNum -g PortId -g NodeType -g NodeDesc -e Port -h Port -g PortNum -g PortId -g NodeType -g NodeDesc -e Port -e Link >> $FILE_TOPOLOGY_TEMP
+      sed -e 's/^/LinkNoCable;/' $FILE_LINKSUM_NOCABLE >> $FILE_RECORDS
     fi
-    echo "</LinkSummary>" >> $FILE_TOPOLOGY_TEMP
+    echo "EndLinkSummary" >> $FILE_RECORDS
   fi
 
   if [ "$output_section" == "all"  ] || [ "$output_section" == "brnodes" ] ; then
     # Generate Nodes/NICs section
-    echo "<Nodes>" >> $FILE_TOPOLOGY_TEMP
-    echo "<NICs>" >> $FILE_TOPOLOGY_TEMP
+    echo "Nodes" >> $FILE_RECORDS
+    echo "NICs" >> $FILE_RECORDS
     if [ -s $FILE_NODENICS ]
       then
-      $XML_GENERATE -X $FILE_NODENICS -d \; -i 2 -h Node -g NodeDesc -g NodeDetails $misc_params -e Node >> $FILE_TOPOLOGY_TEMP
+      sed -e 's/^/NIC;/' $FILE_NODENICS >> $FILE_RECORDS
     fi
-    echo "</NICs>" >> $FILE_TOPOLOGY_TEMP
+    echo "EndNICs" >> $FILE_RECORDS
 
     # Generate Switch Section
     generate_switch_section
 
-    echo "</Nodes>" >> $FILE_TOPOLOGY_TEMP
+    echo "EndNodes" >> $FILE_RECORDS
+  fi
+
+  if [ -s $FILE_RECORDS ]
+    then
+    $XML_GENERATE -X $FILE_RECORDS -d \; -i 2 \
+      -k LinkSummary -h LinkSummary -k EndLinkSummary -e LinkSummary \
+      -k Link -h Link -g Rate -g MTU -g LinkDetails -g Internal -h Cable -g CableLength -g CableLabel -g CableDetails -e Cable -h Port -g PortNum -g PortId -g NodeType -g NodeDesc -e Port -h Port -g PortNum -g PortId -g NodeType -g NodeDesc -e Port -e Link \
+      -k LinkNoCable -h Link -g Rate -g MTU -g LinkDetails -g Internal -g CableLength -g CableLabel -g CableDetails -h Port -g PortNum -g PortId -g NodeType -g NodeDesc -e Port -h Port -g PortNum -g PortId -g NodeType -g NodeDesc -e Port -e Link \
+      -k Nodes -h Nodes -k EndNodes -e Nodes \
+      -k NICs -h NICs -k EndNICs -e NICs \
+      -k NIC -h Node -g NodeDesc -g NodeDetails $misc_params -e Node \
+      -k Switches -h Switches -k EndSwitches -e Switches \
+      -k Switch -h Node -g NodeDesc \
+      -k SwitchMisc -h Node -g NodeDesc $misc_params \
+      -k SwitchPort -h Port -r PortNum -r PortId -e Port \
+      -k EndSwitch -e Node >> $FILE_TOPOLOGY_TEMP
   fi
 
   echo "</Report>" >> $FILE_TOPOLOGY_TEMP
@@ -1221,21 +1245,16 @@ generate_switch_section()
 {
   local line=""
   local node_desc=""
-  local node_desc_key=""
   local port_list=""
   declare -a port_array
   local portnum=""
-  local switch_entry=""
-  local port_entry=""
   local IFS
 
-  # Generate Nodes/Switches section in XML
-  echo "<Switches>" >> $FILE_TOPOLOGY_TEMP
+  # Generate Nodes/Switches section records for gen_topology
+  echo "Switches" >> $FILE_RECORDS
   if [ -s $FILE_NODESWITCHES ]
     then
     while read -r line; do
-        port_entry=""
-        switch_entry=""
         node_desc=${line//;*}
         if [ "$node_desc" == "" ]; then
           echo "Internal Error: Node Description Empty" >&2
@@ -1249,25 +1268,16 @@ generate_switch_section()
           exit 1
         fi
 
-        # If Switch entry has additional parameters, generate XML entry with $XML_GENERATE
+        # If Switch entry has additional parameters, use the misc template
         unset IFS
         if [[ "$line" =~ ";" ]]; then
-          switch_entry=`echo $line | $XML_GENERATE -X - -d \; -i 2 -h Node -g NodeDesc $misc_params`
+          echo "SwitchMisc;$line" >> $FILE_RECORDS
         else
-          # Otherwise manually create Switch entries
-          switch_entry="<Node>"$'\n'
-          switch_entry=${switch_entry}"<NodeDesc>${node_desc}</NodeDesc>"
-          switch_entry=${switch_entry}$'\n'
+          echo "Switch;$node_desc" >> $FILE_RECORDS
 
           # Add required PortNum 0 definition
           if [ "$port_field" == "required" ]; then
-            port_entry=${port_entry}$'\n'
-            port_entry=${port_entry}"<Port>"
-            port_entry=${port_entry}$'\n'
-            port_entry=${port_entry}"<PortNum>0</PortNum>"
-            port_entry=${port_entry}"<PortId></PortId>"
-            port_entry=${port_entry}$'\n'
-            port_entry=${port_entry}"</Port>"
+            echo "SwitchPort;0;" >> $FILE_RECORDS
           fi
         fi
 
@@ -1282,26 +1292,17 @@ generate_switch_section()
           IFS=$'\n'
           port_array=($(sort -h -u <<< "${port_array[*]}"))
           unset IFS
-          # Insert Port list to XML
+          # Insert Port list
           for port in ${port_array[@]}
           do
-            port_entry=${port_entry}$'\n'
-            port_entry=${port_entry}"<Port>"
-            port_entry=${port_entry}$'\n'
-            port_entry=${port_entry}"<PortNum>${port%%:*}</PortNum>"
-            port_entry=${port_entry}"<PortId>${port#*:}</PortId>"
-            port_entry=${port_entry}$'\n'
-            port_entry=${port_entry}"</Port>"
+            echo "SwitchPort;${port%%:*};${port#*:}" >> $FILE_RECORDS
           done
         fi
 
-        # Write entry to XML file
-        echo $switch_entry >> $FILE_TOPOLOGY_TEMP
-        echo $port_entry >> $FILE_TOPOLOGY_TEMP
-        echo "</Node>" >> $FILE_TOPOLOGY_TEMP
+        echo "EndSwitch" >> $FILE_RECORDS
     done < $FILE_NODESWITCHES
   fi
-  echo "</Switches>" >> $FILE_TOPOLOGY_TEMP
+  echo "EndSwitches" >> $FILE_RECORDS
 }
 
 lookup_misc_table_entry()
@@ -56,7 +56,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *	element name that will be used to generate an enclosing XML header end
  *	tag of the form '</element_name>'.  Enclosing elements do not contain
  *	a value, but serve to separate and organize the elements that do contain
- *	values.
+ *	values.  -r is the same as -g, except that an empty value still
+ *	generates an empty '<element_name></element_name>'.
  *
  *	The operation of ethxmlgenerate is further controlled by the following
  *	command line options:
@@ -66,6 +67,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *	              XML output; default is zero
  *	  -X input_file - input CSV data from input_file
  *	  -P param_file - input command line options (parameters) from param_file
+ *	  -k key - start the element list (template) for input records whose
+ *	           first field is key
  *	  -v - verbose output: output progress reports during generation
  *
  *	ethxmlgenerate generates sequences (fragments) of XML, as opposed to
@@ -76,6 +79,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *	information (XML version or report information) as well as "glue" XML
  *	between fragments.
  *
+ *	When -k is used ethxmlgenerate operates in keyed (batch) mode: every
+ *	-g, -r, -h and -e option belongs to the template of the preceding -k,
+ *	and each line of the CSV input is one record.  The first field of a
+ *	record selects the template and the remaining fields are assigned in
+ *	order to the -g and -r elements of that template; missing fields are
+ *	treated as empty values.  This allows a script to generate a complete
+ *	document made of different kinds of records with a single invocation
+ *	instead of invoking ethxmlgenerate per record.
+ *
  *	NOTES:
  *	Output of start and end tags for enclosing elements is controlled by
  *	the placement of command line options -h and -e respectively with
@@ -110,7 +122,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define NAME_PROG  "ethxmlgenerate"		// Program name
 #define MAX_PARAMS_FILE  512			// Max number of param file parameters
-#define MAX_ELEMENTS  100				// Max number of elements parsable
+#define ELEMENTS_INCREMENT  128		// Elements added when tbElements[] grows
 #define MAX_DELIMIT_CHARS  16			// Max size of delimiter string
 #define MAX_INPUT_BUF  8192				// Max size of input buffer
 #define MAX_PARAM_BUF  8192				// Max size of parameter file
@@ -125,7 +137,10 @@ typedef struct
 	char	*pName;						// Element name
 	int		lenValue;					// Length of element value
 	char	*pValue;					// Element value
-	int		flags;						// Flags as:  xxxx xEHG
+	int		flags;						// Flags as:  xxxx KREHG
+										//   K = 1 - Record key
+										//   R = 1 - Required (empty value
+										//           generates empty element)
 										//   E = 1 - End header
 										//   H = 1 - Header
 										//   G = 1 - Generate value
@@ -135,6 +150,8 @@ typedef struct
 #define ELEM_GENERATE  0x01
 #define ELEM_HEADER  0x02
 #define ELEM_END  0x04
+#define ELEM_REQUIRED  0x08
+#define ELEM_KEY  0x10
 
 
 /*******************************************************************************
@@ -153,6 +170,8 @@ int		g_quiet  = 0;
  */
 
 int  numElementsTable  = 0;				// Number of elements in tbElements[]
+int  maxElementsTable  = 0;				// Allocated entries in tbElements[]
+int  numKeysTable  = 0;					// Number of -k keys in tbElements[]
 uint32  numIndentChars  = 0;		// Num of chars per indent level
 
 FILE  * hFileInput  = NULL;				// Input file handle (default stdin)
@@ -170,8 +189,10 @@ struct option tbOptions[] =
 	// Basic controls
 	{ "verbose", no_argument, NULL, 'v' },
 	{ "generate", required_argument, NULL, 'g' },
+	{ "required", required_argument, NULL, 'r' },
 	{ "header", required_argument, NULL, 'h' },
 	{ "end", required_argument, NULL, 'e' },
+	{ "key", required_argument, NULL, 'k' },
 	{ "infile", required_argument, NULL, 'X' },
 	{ "pfile", required_argument, NULL, 'P' },
 	{ "delimit", required_argument, NULL, 'd' },
@@ -183,7 +204,7 @@ struct option tbOptions[] =
 // Element table; contains information about each element of interest.
 //  Elements are contained in the table (0 - numElementsTable-1) in the
 //	order they appear on the command line.
-ELEMENT_TABLE_ENTRY  tbElements[MAX_ELEMENTS];
+ELEMENT_TABLE_ENTRY  *tbElements = NULL;
 
 // IXml Output State
 IXmlOutputState_t state;
@@ -203,6 +224,9 @@ char  bfInput[MAX_INPUT_BUF + 1];
 void dispElementRecord(ELEMENT_TABLE_ENTRY * pElement, const char * pValue);
 void errUsage(void);
 int findElement(const char *pElement);
+int findKey(const char *pKey);
+char *getField(char **ppNext);
+void genKeyedRecords(void);
 void getRecu_opt( int argc, char ** argv, const char *pOptShort,
 	struct option tbOptLong[] );
 
@@ -235,6 +259,10 @@ void dispElementRecord(ELEMENT_TABLE_ENTRY * pElement, const char * pValue)
 	else if ((pElement->flags & ELEM_GENERATE) && pValue)
 		IXmlOutputStrLen(&state, pElement->pName, pValue, strlen(pValue));
 
+	// Output required element with empty value
+	else if (pElement->flags & ELEM_REQUIRED)
+		IXmlOutputStrLen(&state, pElement->pName, "", 0);
+
 }	// End of dispElementRecord()
 
 
@@ -253,17 +281,25 @@ void dispElementRecord(ELEMENT_TABLE_ENTRY * pElement, const char * pValue)
  */
 void errUsage(void)
 {
-	fprintf(stderr, "Usage: " NAME_PROG " [-v][-d delimiter][-i number][-g element][-h element]\n");
-	fprintf(stderr, "                         [-e element][-X input_file][-P param_file]\n");
+	fprintf(stderr, "Usage: " NAME_PROG " [-v][-d delimiter][-i number][-g element][-r element]\n");
+	fprintf(stderr, "                         [-h element][-e element][-k key][-X input_file]\n");
+	fprintf(stderr, "                         [-P param_file]\n");
 	fprintf(stderr, "  At least 1 element must be specified\n");
 	fprintf(stderr, "  -g/--generate element     - Generates an XML element with given name, using value\n");
 	fprintf(stderr, "                              in next field from the input file. Can be used\n");
 	fprintf(stderr, "                              multiple times on the command line. Values are\n");
-	fprintf(stderr, "                              assigned to elements in order.\n");
+	fprintf(stderr, "                              assigned to elements in order. No element is\n");
+	fprintf(stderr, "                              generated for an empty value.\n");
+	fprintf(stderr, "  -r/--required element     - Same as -g, except an empty element is generated\n");
+	fprintf(stderr, "                              for an empty value.\n");
 	fprintf(stderr, "  -h/--header element       - Specifies the name of the XML element that is the\n");
 	fprintf(stderr, "                              enclosing header start tag.\n");
 	fprintf(stderr, "  -e/--end element          - Specifies the name of the XML element that is the\n");
 	fprintf(stderr, "                              enclosing header end tag.\n");
+	fprintf(stderr, "  -k/--key key              - Starts the list of -g, -r, -h and -e elements to\n");
+	fprintf(stderr, "                              use for input records whose first field is key.\n");
+	fprintf(stderr, "                              When used, each line of the input file is one\n");
+	fprintf(stderr, "                              record and all elements must follow a -k.\n");
 	fprintf(stderr, "  -d/--delimit delimiter    - Specifies the delimiter character that separates\n");
 	fprintf(stderr, "                              values in the input file. Default is semicolon.\n");
 	fprintf(stderr, "  -i/--indent number        - Specifies the number of spaces to indent each\n");
@@ -315,6 +351,161 @@ int findElement(const char *pElement)
 }	// End of findElement()
 
 
+/*******************************************************************************
+ *
+ * findKey()
+ *
+ * Description:
+ *	Find specified record key in element table.
+ *
+ * Inputs:
+ *	pKey - Pointer to key name
+ *
+ * Outputs:
+ *	Index of element table containing key, else
+ *	-1 - Key not found
+ */
+int findKey(const char *pKey)
+{
+	int		ix;
+
+	for (ix = 0; ix < numElementsTable; ix++)
+	{
+		if ((tbElements[ix].flags & ELEM_KEY) && !strcmp(pKey, tbElements[ix].pName))
+			return (ix);
+	}
+
+	return (ERROR);
+
+}	// End of findKey()
+
+
+/*******************************************************************************
+ *
+ * getField()
+ *
+ * Description:
+ *	Get next field of a keyed input record.  The field is null terminated
+ *	in place.  Consecutive delimiters produce an empty field.
+ *
+ * Inputs:
+ *	ppNext - Pointer to pointer to remainder of record (NULL at end of record)
+ *
+ * Outputs:
+ *	Pointer to field, else
+ *	NULL - No more fields in record
+ */
+char *getField(char **ppNext)
+{
+	char	*pField = *ppNext;
+	size_t	len;
+
+	if (!pField)
+		return (NULL);
+
+	len = strcspn(pField, bfDelimit);
+	if (pField[len])
+	{
+		pField[len] = '\0';
+		*ppNext = pField + len + 1;
+	}
+	else
+		*ppNext = NULL;
+
+	return (pField);
+
+}	// End of getField()
+
+
+/*******************************************************************************
+ *
+ * genKeyedRecords()
+ *
+ * Description:
+ *	Generate XML for keyed input records (-k).  Each input line is a record
+ *	whose first field selects the element list of the matching -k; the
+ *	remaining fields are assigned to the -g and -r elements of that list.
+ *	Missing fields are treated as empty values.  Blank lines are ignored.
+ *
+ * Inputs:
+ *	none
+ *
+ * Outputs:
+ *	none
+ */
+void genKeyedRecords(void)
+{
+	int		ix;
+	int		ixKey;
+	int		ixLine = 0;
+	size_t	len;
+	char	*pValue;
+	char	*pValueNext;
+
+	if (g_verbose)
+		fprintf(stderr, NAME_PROG ": Reading Input File: %s\n", nameFileInput);
+
+	while (fgets(bfInput, sizeof(bfInput), hFileInput))
+	{
+		ixLine++;
+		len = strlen(bfInput);
+		if (len && bfInput[len - 1] == '\n')
+			bfInput[--len] = '\0';
+
+		else if (len == MAX_INPUT_BUF)
+		{
+			fprintf( stderr,
+				NAME_PROG ": WARNING Malformed Input file (%s) line %d length >= %d.\n",
+				nameFileInput, ixLine, MAX_INPUT_BUF);
+			g_exitstatus = 2;
+			break;
+		}
+
+		if (!len)
+			continue;
+
+		pValueNext = bfInput;
+		pValue = getField(&pValueNext);
+		if ((ixKey = findKey(pValue)) == ERROR)
+		{
+			fprintf( stderr,
+				NAME_PROG ": WARNING Unknown key (%s) in Input file (%s) line %d\n",
+				pValue, nameFileInput, ixLine);
+			g_exitstatus = 2;
+			continue;
+		}
+
+		for (ix = ixKey + 1; ix < numElementsTable && !(tbElements[ix].flags & ELEM_KEY); ix++)
+		{
+			if (tbElements[ix].flags & ELEM_GENERATE)
+			{
+				pValue = getField(&pValueNext);
+				dispElementRecord(&tbElements[ix], (pValue && *pValue) ? pValue : NULL);
+			}
+
+			else
+				dispElementRecord(&tbElements[ix], NULL);
+		}
+
+		// Trailing empty fields are tolerated
+		if (pValueNext && pValueNext[strspn(pValueNext, bfDelimit)])
+		{
+			fprintf( stderr,
+				NAME_PROG ": WARNING Too many fields for key (%s) in Input file (%s) line %d\n",
+				tbElements[ixKey].pName, nameFileInput, ixLine);
+			g_exitstatus = 2;
+		}
+	}
+
+	if (ferror(hFileInput))
+	{
+		fprintf(stderr, NAME_PROG ": Read Error: %s\n", nameFileInput);
+		errUsage();
+	}
+
+}	// End of genKeyedRecords()
+
+
 /*******************************************************************************
  *
  * getRecu_opt()
@@ -366,22 +557,42 @@ void getRecu_opt( int argc, char ** argv, const char *pOptShort,
 
 		// Generate element name specification
 		case 'g':
+		// Required generate element name specification
+		case 'r':
 		// Header element name specification
 		case 'h':
 		// End (header) element name specification
 		case 'e':
-			if (numElementsTable == MAX_ELEMENTS)
+		// Record key specification
+		case 'k':
+			if (numElementsTable == maxElementsTable)
 			{
-				fprintf(stderr, NAME_PROG ": Too many Element Names\n");
-				errUsage();
+				ELEMENT_TABLE_ENTRY *pElements = realloc(tbElements,
+					(maxElementsTable + ELEMENTS_INCREMENT) * sizeof(ELEMENT_TABLE_ENTRY));
+
+				if (!pElements)
+				{
+					fprintf(stderr, NAME_PROG ": Unable to Allocate Element Memory\n");
+					errUsage();
+				}
+				memset(&pElements[maxElementsTable], 0,
+					ELEMENTS_INCREMENT * sizeof(ELEMENT_TABLE_ENTRY));
+				tbElements = pElements;
+				maxElementsTable += ELEMENTS_INCREMENT;
 			}
 
-			else if (!optarg || ((lenStr = strlen(optarg) + 1) == 1))
+			if (!optarg || ((lenStr = strlen(optarg) + 1) == 1))
 			{
 				fprintf(stderr, NAME_PROG ": Invalid Element Name: %s\n", optarg ? optarg:"");
 				errUsage();
 			}
 
+			else if (cOpt == 'k' && findKey(optarg) != ERROR)
+			{
+				fprintf(stderr, NAME_PROG ": Duplicate Key: %s\n", optarg);
+				errUsage();
+			}
+
 			else
 			{
 				if ( (tbElements[numElementsTable].pName = malloc(lenStr)) )
@@ -399,11 +610,20 @@ void getRecu_opt( int argc, char ** argv, const char *pOptShort,
 				if (cOpt == 'g')
 					tbElements[numElementsTable++].flags |= ELEM_GENERATE;
 
+				else if (cOpt == 'r')
+					tbElements[numElementsTable++].flags |= ELEM_GENERATE | ELEM_REQUIRED;
+
 				else if (cOpt == 'h')
 					tbElements[numElementsTable++].flags |= ELEM_HEADER;
 
 				else if (cOpt == 'e')
 					tbElements[numElementsTable++].flags |= ELEM_END;
+
+				else if (cOpt == 'k')
+				{
+					tbElements[numElementsTable++].flags |= ELEM_KEY;
+					numKeysTable++;
+				}
 			}
 
 			break;
@@ -612,28 +832,36 @@ int main(int argc, char ** argv)
 	hFileInput = stdin;
 	hFileOutput = stdout;
 
-	for (ix = 0; ix < MAX_ELEMENTS; ix++)
-	{
-		tbElements[ix].lenName = 0;
-		tbElements[ix].pName = NULL;
-		tbElements[ix].lenValue = 0;
-		tbElements[ix].pValue = NULL;
-		tbElements[ix].flags = 0;
-	}
-
 	// Get and validate command line arguments
-	getRecu_opt(argc, argv, "vg:h:e:X:P:d:i:Z:", tbOptions);
+	getRecu_opt(argc, argv, "vg:r:h:e:k:X:P:d:i:Z:", tbOptions);
 	if (numElementsTable <= 0)
 	{
 		fprintf(stderr, NAME_PROG ": No Elements Specified\n");
 		errUsage();
 	}
 
+	if (numKeysTable && !(tbElements[0].flags & ELEM_KEY))
+	{
+		fprintf(stderr, NAME_PROG ": Element %s specified before first Key\n",
+			tbElements[0].pName);
+		errUsage();
+	}
+
 	IXmlInit(&state, hFileOutput, numIndentChars, IXML_OUTPUT_FLAG_NONE, NULL);
 
 	// Output Report
 	strcat(bfDelimit, "\n");			// Append New Line to bfDelimit
 
+	if (numKeysTable)
+	{
+		genKeyedRecords();
+
+		if (hFileInput && (hFileInput != stdin))
+			fclose(hFileInput);
+
+		return (g_exitstatus);
+	}
+
 	for (ix = 0; ; )
 	{
 		// Generate element
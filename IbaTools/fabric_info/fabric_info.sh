@@ -139,31 +139,29 @@ elif [[ -z $planes ]]; then
 	fi
 	print_split
 else
-	if [[ "$planes" = "ALL" ]]; then
-		planes="$(/usr/sbin/ethxmlextract -H -e Plane.Name -X "$mgt_file")"
-	fi
-	if [[ -z $hfiles ]]; then
-		for plane in $planes; do
-			echo "Fabric Plane $plane Information:"
-			if ! ethreport $opts -E "$mgt_file" -p "$plane" -o fabricinfo; then
-				status=bad
-			fi
-			print_split
-		done
-	else
+	hfopts=()
+	if [[ -n $hfiles ]]; then
 		a_planes=($planes)
 		a_hfiles=($hfiles)
-		if [[ ${#a_planes[@]} -ne ${#a_hfiles[@]} ]]; then
+		if [[ "$planes" != "ALL" && ${#a_planes[@]} -ne ${#a_hfiles[@]} ]]; then
 			echo "Error: Number of hosts files (${#a_hfiles[@]}) doesn't match number of planes (${#a_planes[@]})!" >&2
 			exit 1
 		fi
-		for i in "${!a_planes[@]}"; do
-			echo "Fabric Plane ${a_planes[i]} Information:"
-			if ! ethreport $opts -E "$mgt_file" -p "${a_planes[i]}" -f "${a_hfiles[i]}" -o fabricinfo; then
-				status=bad
-			fi
-			print_split
-		done
+		if [[ "$hfiles" != "DEFAULT" ]]; then
+			hfopts=(-f "$hfiles")
+		fi
+	fi
+	if [[ "$planes" = "ALL" || "$planes" =~ " " ]]; then
+		# ethreport sweeps the planes in parallel and shows them in order
+		if ! ethreport $opts -E "$mgt_file" -p "$planes" "${hfopts[@]}" -o fabricinfo; then
+			status=bad
+		fi
+	else
+		echo "Fabric Plane $planes Information:"
+		if ! ethreport $opts -E "$mgt_file" -p "$planes" "${hfopts[@]}" -o fabricinfo; then
+			status=bad
+		fi
+		print_split
 	fi
 fi
 
@@ -40,12 +40,19 @@
 /*     program constitutes acceptance of these licensing restrictions.   */
 /*  5. Absolutely no warranty is expressed or implied.                   */
 /*-----------------------------------------------------------------------*/
+# define _GNU_SOURCE
 # include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <errno.h>
+# include <getopt.h>
+# include <sched.h>
 # include <unistd.h>
 # include <math.h>
 # include <float.h>
 # include <limits.h>
 # include <sys/time.h>
+# include <sys/syscall.h>
 
 /*-----------------------------------------------------------------------
  * INSTRUCTIONS:
@@ -152,7 +159,16 @@
  *       provide predefined interfaces to be replaced with tuned code.
  *
  *
- *	4) Optional: Mail the results to mccalpin@cs.virginia.edu
+ *	4) STREAM_ARRAY_SIZE and NTIMES are only defaults.  The array size,
+ *       number of iterations, number of threads and thread pinning can be
+ *       selected at runtime, see "stream --help".  The arrays are first
+ *       touched by the threads which later use each part of them, so when
+ *       threads are pinned each part is placed on the thread's NUMA node.
+ *     The classic report is output by default, "-o json" and "-o csv"
+ *       output every iteration's time along with the thread placement for
+ *       aggregation across many hosts.
+ *
+ *	5) Optional: Mail the results to mccalpin@cs.virginia.edu
  *	   Be sure to include info that will help me understand:
  *		a) the computer hardware configuration (e.g., processor model, memory type)
  *		b) the compiler name/version and compilation flags
@@ -176,9 +192,12 @@
 #define STREAM_TYPE double
 #endif
 
-static STREAM_TYPE	a[STREAM_ARRAY_SIZE+OFFSET],
-			b[STREAM_ARRAY_SIZE+OFFSET],
-			c[STREAM_ARRAY_SIZE+OFFSET];
+#define CMD "stream"
+
+/* arrays are allocated at runtime, STREAM_ARRAY_SIZE is only the default */
+static ssize_t		stream_array_size = STREAM_ARRAY_SIZE;
+static int		ntimes = NTIMES;
+static STREAM_TYPE	*a, *b, *c;
 
 static double	avgtime[4] = {0}, maxtime[4] = {0},
 		mintime[4] = {FLT_MAX,FLT_MAX,FLT_MAX,FLT_MAX};
@@ -186,15 +205,34 @@ static double	avgtime[4] = {0}, maxtime[4] = {0},
 static char	*label[4] = {"Copy:      ", "Scale:     ",
     "Add:       ", "Triad:     "};
 
-static double	bytes[4] = {
-    2 * sizeof(STREAM_TYPE) * STREAM_ARRAY_SIZE,
-    2 * sizeof(STREAM_TYPE) * STREAM_ARRAY_SIZE,
-    3 * sizeof(STREAM_TYPE) * STREAM_ARRAY_SIZE,
-    3 * sizeof(STREAM_TYPE) * STREAM_ARRAY_SIZE
-    };
+static char	*name[4] = {"Copy", "Scale", "Add", "Triad"};
+
+static double	bytes[4];
+
+/* output formats */
+typedef enum {
+	OUTPUT_CLASSIC,	/* original STREAM text report */
+	OUTPUT_JSON,	/* one JSON object per run */
+	OUTPUT_CSV	/* one row per kernel per iteration */
+} output_t;
+static output_t	output = OUTPUT_CLASSIC;
+
+/* thread placement */
+typedef enum {
+	PIN_NONE,	/* leave placement to the OS and OpenMP runtime */
+	PIN_COMPACT,	/* thread i on i-th allowed CPU */
+	PIN_SPREAD	/* round robin across NUMA nodes */
+} pin_t;
+static pin_t	pin = PIN_NONE;
+static char	*pin_name[3] = {"none", "compact", "spread"};
+
+static int	nthreads = 1;		/* threads used for the kernels */
+static int	*pin_cpus;		/* CPU for each thread when pinned */
+static int	*thread_cpu, *thread_node;	/* where each thread ran */
+static int	num_nodes = 1;		/* NUMA nodes with allowed CPUs */
 
 extern double mysecond();
-extern void checkSTREAMresults();
+extern int checkSTREAMresults(FILE *out, int quiet);
 #ifdef TUNED
 extern void tuned_STREAM_Copy();
 extern void tuned_STREAM_Scale(STREAM_TYPE scalar);
@@ -203,23 +241,436 @@ extern void tuned_STREAM_Triad(STREAM_TYPE scalar);
 #endif
 #ifdef _OPENMP
 extern int omp_get_num_threads();
+extern int omp_get_thread_num();
+extern int omp_get_max_threads();
+extern void omp_set_num_threads(int);
+#endif
+
+void Usage(int exit_code)
+{
+	fprintf(stderr, "Usage: " CMD " [-s elements] [-n ntimes] [-t threads] [-p none|compact|spread]\n");
+	fprintf(stderr, "              [-o classic|json|csv]\n");
+	fprintf(stderr, "    -s/--size elements    - elements per array. Default %llu\n",
+		(unsigned long long) STREAM_ARRAY_SIZE);
+	fprintf(stderr, "    -n/--ntimes count     - times to run each kernel, at least 2. Default %d\n", NTIMES);
+	fprintf(stderr, "    -t/--threads count    - OpenMP threads to use. Default is OMP_NUM_THREADS\n");
+	fprintf(stderr, "                            or all CPUs\n");
+	fprintf(stderr, "    -p/--pin placement    - pin each thread to a CPU, one of:\n");
+	fprintf(stderr, "                               none    - no pinning (default)\n");
+	fprintf(stderr, "                               compact - fill one NUMA node's CPUs before the next\n");
+	fprintf(stderr, "                               spread  - round robin across NUMA nodes\n");
+	fprintf(stderr, "    -o/--output format    - output format, one of:\n");
+	fprintf(stderr, "                               classic - original STREAM report (default)\n");
+	fprintf(stderr, "                               json    - JSON object with per-iteration times\n");
+	fprintf(stderr, "                               csv     - one row per kernel per iteration\n");
+	fprintf(stderr, "Arrays are initialized by the threads which later use each part of them, so\n");
+	fprintf(stderr, "with pinning each thread's part is placed on its own NUMA node.\n");
+	fprintf(stderr, "\nfor example:\n");
+	fprintf(stderr, "   " CMD "\n");
+	fprintf(stderr, "   " CMD " -s 100000000 -t 16 -p spread -o json\n");
+	exit(exit_code);
+}
+
+// command line options
+struct option options[] = {
+	{ "help", no_argument, NULL, '$' }, // use an invalid option character
+	{ "size", required_argument, NULL, 's' },
+	{ "ntimes", required_argument, NULL, 'n' },
+	{ "threads", required_argument, NULL, 't' },
+	{ "pin", required_argument, NULL, 'p' },
+	{ "output", required_argument, NULL, 'o' },
+	{ 0 }
+};
+
+/* parse a cpulist such as "0-3,8,10-11" into cpus, returns count found */
+static int parse_cpulist(const char *str, int *cpus, int max)
+{
+	int count = 0;
+	char *end;
+	long first, last;
+
+	while (*str) {
+		first = last = strtol(str, &end, 10);
+		if (end == str)
+			break;
+		if (*end == '-')
+			last = strtol(end+1, &end, 10);
+		for (; first <= last && count < max; first++)
+			cpus[count++] = (int)first;
+		if (*end != ',')
+			break;
+		str = end+1;
+	}
+	return count;
+}
+
+/* read a cpulist format sysfs file, returns count found, 0 if none */
+static int read_cpulist(const char *path, int *cpus, int max)
+{
+	char	buf[4096];
+	FILE	*fp;
+	int	count = 0;
+
+	fp = fopen(path, "r");
+	if (! fp)
+		return 0;
+	if (fgets(buf, sizeof(buf), fp))
+		count = parse_cpulist(buf, cpus, max);
+	fclose(fp);
+	return count;
+}
+
+/* build the list of CPUs to pin each thread to.
+ * only CPUs in our initial affinity mask are used, so taskset and numactl
+ * restrictions are honored.  When /sys/devices/system/node is not available
+ * all CPUs are treated as a single NUMA node.
+ */
+static void setup_pinning(void)
+{
+	cpu_set_t	allowed;
+	int		ncpus = 0, nnodes, i, n, count, round, placed;
+	int		*nodes, *node_cpus, *cpus, *order, *node_start, *node_count;
+	char		path[128];
+
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+		perror(CMD ": sched_getaffinity");
+		exit(1);
+	}
+	nodes = malloc(sizeof(int) * CPU_SETSIZE);
+	node_cpus = malloc(sizeof(int) * CPU_SETSIZE);
+	cpus = malloc(sizeof(int) * CPU_SETSIZE);
+	order = malloc(sizeof(int) * CPU_SETSIZE);
+	node_start = malloc(sizeof(int) * CPU_SETSIZE);
+	node_count = malloc(sizeof(int) * CPU_SETSIZE);
+	pin_cpus = malloc(sizeof(int) * nthreads);
+	if (! nodes || ! node_cpus || ! cpus || ! order || ! node_start
+		|| ! node_count || ! pin_cpus) {
+		fprintf(stderr, CMD ": Unable to allocate memory\n");
+		exit(1);
+	}
+
+	/* group the allowed CPUs by NUMA node */
+	num_nodes = 0;
+	nnodes = read_cpulist("/sys/devices/system/node/online", nodes, CPU_SETSIZE);
+	for (n = 0; n < nnodes; n++) {
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", nodes[n]);
+		count = read_cpulist(path, node_cpus, CPU_SETSIZE);
+		node_start[num_nodes] = ncpus;
+		for (i = 0; i < count && ncpus < CPU_SETSIZE; i++) {
+			if (node_cpus[i] >= 0 && node_cpus[i] < CPU_SETSIZE
+				&& CPU_ISSET(node_cpus[i], &allowed))
+				cpus[ncpus++] = node_cpus[i];
+		}
+		/* skip nodes with only memory or no allowed CPUs */
+		if (ncpus > node_start[num_nodes]) {
+			node_count[num_nodes] = ncpus - node_start[num_nodes];
+			num_nodes++;
+		}
+	}
+	if (! ncpus) {
+		/* no NUMA information, all allowed CPUs on one node */
+		for (i = 0; i < CPU_SETSIZE; i++)
+			if (CPU_ISSET(i, &allowed))
+				cpus[ncpus++] = i;
+		node_start[0] = 0;
+		node_count[0] = ncpus;
+		num_nodes = 1;
+	}
+
+	if (pin == PIN_SPREAD) {
+		/* take one CPU from each node in turn */
+		placed = 0;
+		for (round = 0; placed < ncpus; round++) {
+			for (n = 0; n < num_nodes; n++) {
+				if (round < node_count[n])
+					order[placed++] = cpus[node_start[n] + round];
+			}
+		}
+	} else {
+		/* fill one node before using the next */
+		memcpy(order, cpus, sizeof(int) * ncpus);
+	}
+	/* wrap if more threads than CPUs */
+	for (i = 0; i < nthreads; i++)
+		pin_cpus[i] = order[i % ncpus];
+
+	free(nodes);
+	free(node_cpus);
+	free(cpus);
+	free(order);
+	free(node_start);
+	free(node_count);
+}
+
+static int thread_num(void)
+{
+#ifdef _OPENMP
+	return omp_get_thread_num();
+#else
+	return 0;
 #endif
+}
+
+/* pin the calling thread to its CPU in pin_cpus */
+static void pin_thread(void)
+{
+	cpu_set_t	set;
+	int		t = thread_num();
+
+	CPU_ZERO(&set);
+	CPU_SET(pin_cpus[t], &set);
+	if (sched_setaffinity(0, sizeof(set), &set) != 0)
+		perror(CMD ": sched_setaffinity");
+}
+
+/* record the CPU and NUMA node the calling thread is running on */
+static void sample_thread(void)
+{
+	unsigned	cpu = 0, node = 0;
+	int		t = thread_num();
+
+	if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0)
+		cpu = node = -1;
+	thread_cpu[t] = (int)cpu;
+	thread_node[t] = (int)node;
+}
+
+static int compare_double(const void *p1, const void *p2)
+{
+	double d1 = *(const double *)p1, d2 = *(const double *)p2;
+
+	return (d1 > d2) - (d1 < d2);
+}
+
+/* distribution of the times for a kernel, first iteration excluded */
+typedef struct {
+	double	min, max, avg, median, p90, stddev;
+} dist_t;
+
+static void compute_dist(const double *times, dist_t *dist)
+{
+	int	n = ntimes-1;
+	double	*sorted = malloc(sizeof(double) * n);
+	double	sum = 0, sq = 0;
+	int	k;
+
+	if (! sorted) {
+		fprintf(stderr, CMD ": Unable to allocate memory\n");
+		exit(1);
+	}
+	for (k = 0; k < n; k++) {
+		sorted[k] = times[k+1];
+		sum += sorted[k];
+	}
+	qsort(sorted, n, sizeof(double), compare_double);
+	dist->min = sorted[0];
+	dist->max = sorted[n-1];
+	dist->avg = sum / n;
+	dist->median = (n & 1) ? sorted[n/2] : (sorted[n/2-1] + sorted[n/2]) / 2;
+	dist->p90 = sorted[(int)ceil(0.9 * n) - 1];
+	for (k = 0; k < n; k++)
+		sq += (sorted[k] - dist->avg) * (sorted[k] - dist->avg);
+	dist->stddev = sqrt(sq / n);
+	free(sorted);
+}
+
+static void output_json(const char *host, double *times[4], int quantum, int err)
+{
+	int	j, k;
+	dist_t	dist;
+
+	printf("{\n");
+	printf("  \"version\": \"5.10\",\n");
+	printf("  \"host\": \"%s\",\n", host);
+	printf("  \"bytes_per_element\": %d,\n", (int) sizeof(STREAM_TYPE));
+	printf("  \"array_size\": %llu,\n", (unsigned long long) stream_array_size);
+	printf("  \"offset\": %d,\n", OFFSET);
+	printf("  \"ntimes\": %d,\n", ntimes);
+	printf("  \"clock_granularity_us\": %d,\n", quantum);
+	printf("  \"threads\": %d,\n", nthreads);
+	printf("  \"pin\": \"%s\",\n", pin_name[pin]);
+	printf("  \"numa_nodes\": %d,\n", num_nodes);
+	printf("  \"placement\": [");
+	for (k = 0; k < nthreads; k++)
+		printf("%s{\"thread\": %d, \"cpu\": %d, \"node\": %d}",
+			k ? ", " : "", k, thread_cpu[k], thread_node[k]);
+	printf("],\n");
+	printf("  \"validated\": %s,\n", err ? "false" : "true");
+	printf("  \"kernels\": [\n");
+	for (j = 0; j < 4; j++) {
+		compute_dist(times[j], &dist);
+		printf("    {\n");
+		printf("      \"name\": \"%s\",\n", name[j]);
+		printf("      \"bytes\": %.0f,\n", bytes[j]);
+		printf("      \"best_rate_mbs\": %.1f,\n", 1.0E-06 * bytes[j]/dist.min);
+		printf("      \"min_time\": %.6f,\n", dist.min);
+		printf("      \"avg_time\": %.6f,\n", dist.avg);
+		printf("      \"median_time\": %.6f,\n", dist.median);
+		printf("      \"p90_time\": %.6f,\n", dist.p90);
+		printf("      \"max_time\": %.6f,\n", dist.max);
+		printf("      \"stddev_time\": %.6f,\n", dist.stddev);
+		printf("      \"times\": [");
+		for (k = 0; k < ntimes; k++)
+			printf("%s%.6f", k ? ", " : "", times[j][k]);
+		printf("],\n");
+		printf("      \"rates_mbs\": [");
+		for (k = 0; k < ntimes; k++)
+			printf("%s%.1f", k ? ", " : "", 1.0E-06 * bytes[j]/times[j][k]);
+		printf("]\n");
+		printf("    }%s\n", j < 3 ? "," : "");
+	}
+	printf("  ]\n");
+	printf("}\n");
+}
+
+static void output_csv(const char *host, double *times[4], int err)
+{
+	int	j, k;
+
+	printf("host,threads,pin,array_size,kernel,iteration,time_s,rate_mbs,counted,validated\n");
+	for (j = 0; j < 4; j++) {
+		for (k = 0; k < ntimes; k++) {
+			/* first iteration is excluded from the best rate */
+			printf("%s,%d,%s,%llu,%s,%d,%.6f,%.1f,%d,%d\n",
+				host, nthreads, pin_name[pin],
+				(unsigned long long) stream_array_size, name[j], k,
+				times[j][k], 1.0E-06 * bytes[j]/times[j][k],
+				k != 0, ! err);
+		}
+	}
+}
+
 int
-main()
+main(int argc, char **argv)
     {
     int			quantum, checktick();
     int			BytesPerWord;
     int			k;
     ssize_t		j;
     STREAM_TYPE		scalar;
-    double		t, times[4][NTIMES];
+    double		t, *times[4];
+    int			opt, index, err;
+    unsigned long long	temp;
+    char		*endptr;
+    char		host[256];
+    size_t		array_bytes;
+
+    while (-1 != (opt = getopt_long(argc, argv, "s:n:t:p:o:", options, &index)))
+	{
+	switch (opt) {
+	case '$':
+		Usage(0);
+		break;
+	case 's':
+		errno = 0;
+		temp = strtoull(optarg, &endptr, 0);
+		if (! temp || temp > SSIZE_MAX / (3 * sizeof(STREAM_TYPE)) || errno
+			|| ! endptr || *endptr != '\0') {
+			fprintf(stderr, CMD ": Invalid size: %s\n", optarg);
+			Usage(2);
+		}
+		stream_array_size = (ssize_t)temp;
+		break;
+	case 'n':
+		errno = 0;
+		temp = strtoull(optarg, &endptr, 0);
+		if (temp < 2 || temp > INT_MAX || errno || ! endptr || *endptr != '\0') {
+			fprintf(stderr, CMD ": Invalid ntimes: %s\n", optarg);
+			Usage(2);
+		}
+		ntimes = (int)temp;
+		break;
+	case 't':
+		errno = 0;
+		temp = strtoull(optarg, &endptr, 0);
+		if (! temp || temp > CPU_SETSIZE || errno || ! endptr || *endptr != '\0') {
+			fprintf(stderr, CMD ": Invalid threads: %s\n", optarg);
+			Usage(2);
+		}
+#ifdef _OPENMP
+		omp_set_num_threads((int)temp);
+#else
+		if (temp != 1)
+			fprintf(stderr, CMD ": Warning: not built with OpenMP, using 1 thread\n");
+#endif
+		break;
+	case 'p':
+		if (strcmp(optarg, "none") == 0)
+			pin = PIN_NONE;
+		else if (strcmp(optarg, "compact") == 0)
+			pin = PIN_COMPACT;
+		else if (strcmp(optarg, "spread") == 0)
+			pin = PIN_SPREAD;
+		else {
+			fprintf(stderr, CMD ": Invalid pin: %s\n", optarg);
+			Usage(2);
+		}
+		break;
+	case 'o':
+		if (strcmp(optarg, "classic") == 0)
+			output = OUTPUT_CLASSIC;
+		else if (strcmp(optarg, "json") == 0)
+			output = OUTPUT_JSON;
+		else if (strcmp(optarg, "csv") == 0)
+			output = OUTPUT_CSV;
+		else {
+			fprintf(stderr, CMD ": Invalid output: %s\n", optarg);
+			Usage(2);
+		}
+		break;
+	default:
+		Usage(2);
+		break;
+	}   // switch
+	}  // while
+    if (optind < argc)
+	Usage(2);
+
+    for (j=0; j<4; j++) {
+	bytes[j] = (j < 2 ? 2 : 3) * sizeof(STREAM_TYPE) * (double) stream_array_size;
+	times[j] = malloc(sizeof(double) * ntimes);
+	if (! times[j]) {
+	    fprintf(stderr, CMD ": Unable to allocate memory\n");
+	    exit(1);
+	}
+    }
+
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+    thread_cpu = calloc(nthreads, sizeof(int));
+    thread_node = calloc(nthreads, sizeof(int));
+    if (! thread_cpu || ! thread_node) {
+	fprintf(stderr, CMD ": Unable to allocate memory\n");
+	exit(1);
+    }
+    if (pin != PIN_NONE) {
+	setup_pinning();
+#pragma omp parallel
+	pin_thread();
+    }
+
+    /* page aligned so each thread's part of the arrays starts on its own
+     * pages and first touch places it on the thread's NUMA node
+     */
+    array_bytes = sizeof(STREAM_TYPE) * (stream_array_size+OFFSET);
+    if (posix_memalign((void **)&a, 4096, array_bytes)
+	|| posix_memalign((void **)&b, 4096, array_bytes)
+	|| posix_memalign((void **)&c, 4096, array_bytes)) {
+	fprintf(stderr, CMD ": Unable to allocate %.1f MiB for arrays\n",
+	    3.0 * array_bytes / 1024.0/1024.0);
+	exit(1);
+    }
 
     /* --- SETUP --- determine precision and check timing --- */
 
+    if (output == OUTPUT_CLASSIC) {
     printf(HLINE);
     printf("STREAM version $Revision: 5.10 $\n");
     printf(HLINE);
+    }
     BytesPerWord = sizeof(STREAM_TYPE);
+    if (output == OUTPUT_CLASSIC) {
     printf("This system uses %d bytes per array element.\n",
 	BytesPerWord);
 
@@ -232,14 +683,14 @@ main()
     printf("*****  WARNING: ******\n");
 #endif
 
-    printf("Array size = %llu (elements), Offset = %d (elements)\n" , (unsigned long long) STREAM_ARRAY_SIZE, OFFSET);
+    printf("Array size = %llu (elements), Offset = %d (elements)\n" , (unsigned long long) stream_array_size, OFFSET);
     printf("Memory per array = %.1f MiB (= %.1f GiB).\n", 
-	BytesPerWord * ( (double) STREAM_ARRAY_SIZE / 1024.0/1024.0),
-	BytesPerWord * ( (double) STREAM_ARRAY_SIZE / 1024.0/1024.0/1024.0));
+	BytesPerWord * ( (double) stream_array_size / 1024.0/1024.0),
+	BytesPerWord * ( (double) stream_array_size / 1024.0/1024.0/1024.0));
     printf("Total memory required = %.1f MiB (= %.1f GiB).\n",
-	(3.0 * BytesPerWord) * ( (double) STREAM_ARRAY_SIZE / 1024.0/1024.),
-	(3.0 * BytesPerWord) * ( (double) STREAM_ARRAY_SIZE / 1024.0/1024./1024.));
-    printf("Each kernel will be executed %d times.\n", NTIMES);
+	(3.0 * BytesPerWord) * ( (double) stream_array_size / 1024.0/1024.),
+	(3.0 * BytesPerWord) * ( (double) stream_array_size / 1024.0/1024./1024.));
+    printf("Each kernel will be executed %d times.\n", ntimes);
     printf(" The *best* time for each kernel (excluding the first iteration)\n"); 
     printf(" will be used to compute the reported bandwidth.\n");
 
@@ -262,32 +713,42 @@ main()
 		k++;
     printf ("Number of Threads counted = %i\n",k);
 #endif
+    if (pin != PIN_NONE)
+	printf ("Threads pinned = %s, across %d NUMA node(s)\n", pin_name[pin], num_nodes);
+    }
 
     /* Get initial value for system clock. */
-#pragma omp parallel for
-    for (j=0; j<STREAM_ARRAY_SIZE; j++) {
+    /* also the first touch of the arrays, so it must use the same
+     * static schedule as the kernels below
+     */
+#pragma omp parallel for schedule(static)
+    for (j=0; j<stream_array_size; j++) {
 	    a[j] = 1.0;
 	    b[j] = 2.0;
 	    c[j] = 0.0;
 	}
 
+    if (output == OUTPUT_CLASSIC)
     printf(HLINE);
 
-    if  ( (quantum = checktick()) >= 1) 
+    if  ( (quantum = checktick()) >= 1) {
+	if (output == OUTPUT_CLASSIC)
 	printf("Your clock granularity/precision appears to be "
 	    "%d microseconds.\n", quantum);
-    else {
+    } else {
+	if (output == OUTPUT_CLASSIC)
 	printf("Your clock granularity appears to be "
 	    "less than one microsecond.\n");
 	quantum = 1;
     }
 
     t = mysecond();
-#pragma omp parallel for
-    for (j = 0; j < STREAM_ARRAY_SIZE; j++)
+#pragma omp parallel for schedule(static)
+    for (j = 0; j < stream_array_size; j++)
 		a[j] = 2.0E0 * a[j];
     t = 1.0E6 * (mysecond() - t);
 
+    if (output == OUTPUT_CLASSIC) {
     printf("Each test below will take on the order"
 	" of %d microseconds.\n", (int) t  );
     printf("   (= %d clock ticks)\n", (int) (t/quantum) );
@@ -300,18 +761,19 @@ main()
     printf("For best results, please be sure you know the\n");
     printf("precision of your system timer.\n");
     printf(HLINE);
+    }
     
-    /*	--- MAIN LOOP --- repeat test cases NTIMES times --- */
+    /*	--- MAIN LOOP --- repeat test cases ntimes times --- */
 
     scalar = 3.0;
-    for (k=0; k<NTIMES; k++)
+    for (k=0; k<ntimes; k++)
 	{
 	times[0][k] = mysecond();
 #ifdef TUNED
         tuned_STREAM_Copy();
 #else
-#pragma omp parallel for
-	for (j=0; j<STREAM_ARRAY_SIZE; j++)
+#pragma omp parallel for schedule(static)
+	for (j=0; j<stream_array_size; j++)
 	    c[j] = a[j];
 #endif
 	times[0][k] = mysecond() - times[0][k];
@@ -320,8 +782,8 @@ main()
 #ifdef TUNED
         tuned_STREAM_Scale(scalar);
 #else
-#pragma omp parallel for
-	for (j=0; j<STREAM_ARRAY_SIZE; j++)
+#pragma omp parallel for schedule(static)
+	for (j=0; j<stream_array_size; j++)
 	    b[j] = scalar*c[j];
 #endif
 	times[1][k] = mysecond() - times[1][k];
@@ -330,8 +792,8 @@ main()
 #ifdef TUNED
         tuned_STREAM_Add();
 #else
-#pragma omp parallel for
-	for (j=0; j<STREAM_ARRAY_SIZE; j++)
+#pragma omp parallel for schedule(static)
+	for (j=0; j<stream_array_size; j++)
 	    c[j] = a[j]+b[j];
 #endif
 	times[2][k] = mysecond() - times[2][k];
@@ -340,16 +802,33 @@ main()
 #ifdef TUNED
         tuned_STREAM_Triad(scalar);
 #else
-#pragma omp parallel for
-	for (j=0; j<STREAM_ARRAY_SIZE; j++)
+#pragma omp parallel for schedule(static)
+	for (j=0; j<stream_array_size; j++)
 	    a[j] = b[j]+scalar*c[j];
 #endif
 	times[3][k] = mysecond() - times[3][k];
 	}
 
+    /* where the threads actually ran */
+#pragma omp parallel
+    sample_thread();
+
     /*	--- SUMMARY --- */
 
-    for (k=1; k<NTIMES; k++) /* note -- skip first iteration */
+    if (output != OUTPUT_CLASSIC) {
+	/* validation problems are reported on stderr, results on stdout */
+	err = checkSTREAMresults(stderr, 1);
+	if (gethostname(host, sizeof(host)) != 0)
+	    strcpy(host, "unknown");
+	host[sizeof(host)-1] = '\0';
+	if (output == OUTPUT_JSON)
+	    output_json(host, times, quantum, err);
+	else
+	    output_csv(host, times, err);
+	return 0;
+    }
+
+    for (k=1; k<ntimes; k++) /* note -- skip first iteration */
 	{
 	for (j=0; j<4; j++)
 	    {
@@ -361,7 +840,7 @@ main()
     
     printf("Function    Best Rate MB/s  Avg time     Min time     Max time\n");
     for (j=0; j<4; j++) {
-		avgtime[j] = avgtime[j]/(double)(NTIMES-1);
+		avgtime[j] = avgtime[j]/(double)(ntimes-1);
 
 		printf("%s%12.1f  %11.6f  %11.6f  %11.6f\n", label[j],
 	       1.0E-06 * bytes[j]/mintime[j],
@@ -372,7 +851,7 @@ main()
     printf(HLINE);
 
     /* --- Check Results --- */
-    checkSTREAMresults();
+    (void)checkSTREAMresults(stdout, 0);
     printf(HLINE);
 
     return 0;
@@ -429,7 +908,10 @@ double mysecond()
 #ifndef abs
 #define abs(a) ((a) >= 0 ? (a) : -(a))
 #endif
-void checkSTREAMresults ()
+/* returns number of arrays which failed validation, failures are reported
+ * to out, when quiet a successful validation is not reported
+ */
+int checkSTREAMresults (FILE *out, int quiet)
 {
 	STREAM_TYPE aj,bj,cj,scalar;
 	STREAM_TYPE aSumErr,bSumErr,cSumErr;
@@ -446,7 +928,7 @@ void checkSTREAMresults ()
 	aj = 2.0E0 * aj;
     /* now execute timing loop */
 	scalar = 3.0;
-	for (k=0; k<NTIMES; k++)
+	for (k=0; k<ntimes; k++)
         {
             cj = aj;
             bj = scalar*cj;
@@ -458,15 +940,15 @@ void checkSTREAMresults ()
 	aSumErr = 0.0;
 	bSumErr = 0.0;
 	cSumErr = 0.0;
-	for (j=0; j<STREAM_ARRAY_SIZE; j++) {
+	for (j=0; j<stream_array_size; j++) {
 		aSumErr += abs(a[j] - aj);
 		bSumErr += abs(b[j] - bj);
 		cSumErr += abs(c[j] - cj);
 		// if (j == 417) printf("Index 417: c[j]: %f, cj: %f\n",c[j],cj);	// MCCALPIN
 	}
-	aAvgErr = aSumErr / (STREAM_TYPE) STREAM_ARRAY_SIZE;
-	bAvgErr = bSumErr / (STREAM_TYPE) STREAM_ARRAY_SIZE;
-	cAvgErr = cSumErr / (STREAM_TYPE) STREAM_ARRAY_SIZE;
+	aAvgErr = aSumErr / (STREAM_TYPE) stream_array_size;
+	bAvgErr = bSumErr / (STREAM_TYPE) stream_array_size;
+	cAvgErr = cSumErr / (STREAM_TYPE) stream_array_size;
 
 	if (sizeof(STREAM_TYPE) == 4) {
 		epsilon = 1.e-6;
@@ -475,76 +957,77 @@ void checkSTREAMresults ()
 		epsilon = 1.e-13;
 	}
 	else {
-		printf("WEIRD: sizeof(STREAM_TYPE) = %lu\n",sizeof(STREAM_TYPE));
+		fprintf(out, "WEIRD: sizeof(STREAM_TYPE) = %lu\n",sizeof(STREAM_TYPE));
 		epsilon = 1.e-6;
 	}
 
 	err = 0;
 	if (abs(aAvgErr/aj) > epsilon) {
 		err++;
-		printf ("Failed Validation on array a[], AvgRelAbsErr > epsilon (%e)\n",epsilon);
-		printf ("     Expected Value: %e, AvgAbsErr: %e, AvgRelAbsErr: %e\n",aj,aAvgErr,abs(aAvgErr)/aj);
+		fprintf (out, "Failed Validation on array a[], AvgRelAbsErr > epsilon (%e)\n",epsilon);
+		fprintf (out, "     Expected Value: %e, AvgAbsErr: %e, AvgRelAbsErr: %e\n",aj,aAvgErr,abs(aAvgErr)/aj);
 		ierr = 0;
-		for (j=0; j<STREAM_ARRAY_SIZE; j++) {
+		for (j=0; j<stream_array_size; j++) {
 			if (abs(a[j]/aj-1.0) > epsilon) {
 				ierr++;
 #ifdef VERBOSE
 				if (ierr < 10) {
-					printf("         array a: index: %ld, expected: %e, observed: %e, relative error: %e\n",
+					fprintf(out, "         array a: index: %ld, expected: %e, observed: %e, relative error: %e\n",
 						j,aj,a[j],abs((aj-a[j])/aAvgErr));
 				}
 #endif
 			}
 		}
-		printf("     For array a[], %d errors were found.\n",ierr);
+		fprintf(out, "     For array a[], %d errors were found.\n",ierr);
 	}
 	if (abs(bAvgErr/bj) > epsilon) {
 		err++;
-		printf ("Failed Validation on array b[], AvgRelAbsErr > epsilon (%e)\n",epsilon);
-		printf ("     Expected Value: %e, AvgAbsErr: %e, AvgRelAbsErr: %e\n",bj,bAvgErr,abs(bAvgErr)/bj);
-		printf ("     AvgRelAbsErr > Epsilon (%e)\n",epsilon);
+		fprintf (out, "Failed Validation on array b[], AvgRelAbsErr > epsilon (%e)\n",epsilon);
+		fprintf (out, "     Expected Value: %e, AvgAbsErr: %e, AvgRelAbsErr: %e\n",bj,bAvgErr,abs(bAvgErr)/bj);
+		fprintf (out, "     AvgRelAbsErr > Epsilon (%e)\n",epsilon);
 		ierr = 0;
-		for (j=0; j<STREAM_ARRAY_SIZE; j++) {
+		for (j=0; j<stream_array_size; j++) {
 			if (abs(b[j]/bj-1.0) > epsilon) {
 				ierr++;
 #ifdef VERBOSE
 				if (ierr < 10) {
-					printf("         array b: index: %ld, expected: %e, observed: %e, relative error: %e\n",
+					fprintf(out, "         array b: index: %ld, expected: %e, observed: %e, relative error: %e\n",
 						j,bj,b[j],abs((bj-b[j])/bAvgErr));
 				}
 #endif
 			}
 		}
-		printf("     For array b[], %d errors were found.\n",ierr);
+		fprintf(out, "     For array b[], %d errors were found.\n",ierr);
 	}
 	if (abs(cAvgErr/cj) > epsilon) {
 		err++;
-		printf ("Failed Validation on array c[], AvgRelAbsErr > epsilon (%e)\n",epsilon);
-		printf ("     Expected Value: %e, AvgAbsErr: %e, AvgRelAbsErr: %e\n",cj,cAvgErr,abs(cAvgErr)/cj);
-		printf ("     AvgRelAbsErr > Epsilon (%e)\n",epsilon);
+		fprintf (out, "Failed Validation on array c[], AvgRelAbsErr > epsilon (%e)\n",epsilon);
+		fprintf (out, "     Expected Value: %e, AvgAbsErr: %e, AvgRelAbsErr: %e\n",cj,cAvgErr,abs(cAvgErr)/cj);
+		fprintf (out, "     AvgRelAbsErr > Epsilon (%e)\n",epsilon);
 		ierr = 0;
-		for (j=0; j<STREAM_ARRAY_SIZE; j++) {
+		for (j=0; j<stream_array_size; j++) {
 			if (abs(c[j]/cj-1.0) > epsilon) {
 				ierr++;
 #ifdef VERBOSE
 				if (ierr < 10) {
-					printf("         array c: index: %ld, expected: %e, observed: %e, relative error: %e\n",
+					fprintf(out, "         array c: index: %ld, expected: %e, observed: %e, relative error: %e\n",
 						j,cj,c[j],abs((cj-c[j])/cAvgErr));
 				}
 #endif
 			}
 		}
-		printf("     For array c[], %d errors were found.\n",ierr);
+		fprintf(out, "     For array c[], %d errors were found.\n",ierr);
 	}
-	if (err == 0) {
-		printf ("Solution Validates: avg error less than %e on all three arrays\n",epsilon);
+	if (err == 0 && ! quiet) {
+		fprintf (out, "Solution Validates: avg error less than %e on all three arrays\n",epsilon);
 	}
 #ifdef VERBOSE
-	printf ("Results Validation Verbose Results: \n");
-	printf ("    Expected a(1), b(1), c(1): %f %f %f \n",aj,bj,cj);
-	printf ("    Observed a(1), b(1), c(1): %f %f %f \n",a[1],b[1],c[1]);
-	printf ("    Rel Errors on a, b, c:     %e %e %e \n",abs(aAvgErr/aj),abs(bAvgErr/bj),abs(cAvgErr/cj));
+	fprintf (out, "Results Validation Verbose Results: \n");
+	fprintf (out, "    Expected a(1), b(1), c(1): %f %f %f \n",aj,bj,cj);
+	fprintf (out, "    Observed a(1), b(1), c(1): %f %f %f \n",a[1],b[1],c[1]);
+	fprintf (out, "    Rel Errors on a, b, c:     %e %e %e \n",abs(aAvgErr/aj),abs(bAvgErr/bj),abs(cAvgErr/cj));
 #endif
+	return err;
 }
 
 #ifdef TUNED
@@ -552,32 +1035,32 @@ void checkSTREAMresults ()
 void tuned_STREAM_Copy()
 {
 	ssize_t j;
-#pragma omp parallel for
-        for (j=0; j<STREAM_ARRAY_SIZE; j++)
+#pragma omp parallel for schedule(static)
+        for (j=0; j<stream_array_size; j++)
             c[j] = a[j];
 }
 
 void tuned_STREAM_Scale(STREAM_TYPE scalar)
 {
 	ssize_t j;
-#pragma omp parallel for
-	for (j=0; j<STREAM_ARRAY_SIZE; j++)
+#pragma omp parallel for schedule(static)
+	for (j=0; j<stream_array_size; j++)
 	    b[j] = scalar*c[j];
 }
 
 void tuned_STREAM_Add()
 {
 	ssize_t j;
-#pragma omp parallel for
-	for (j=0; j<STREAM_ARRAY_SIZE; j++)
+#pragma omp parallel for schedule(static)
+	for (j=0; j<stream_array_size; j++)
 	    c[j] = a[j]+b[j];
 }
 
 void tuned_STREAM_Triad(STREAM_TYPE scalar)
 {
 	ssize_t j;
-#pragma omp parallel for
-	for (j=0; j<STREAM_ARRAY_SIZE; j++)
+#pragma omp parallel for schedule(static)
+	for (j=0; j<stream_array_size; j++)
 	    a[j] = b[j]+scalar*c[j];
 }
 /* end of stubs for the "tuned" versions of the kernels */
@@ -91,6 +91,8 @@ typedef struct pairResults
 	int	alone;									/* is this a single */
 	int	failed;									/* did this pair fail */
 	int     valid;                              /* is this a valid pair */
+	int		round;								/* tournament round to run in */
+	int		isl;								/* ISL targeted by pair or -1 */
 } pairResults;
 
 /* host list */
@@ -99,10 +101,24 @@ typedef struct hostListing
 	char			hostname[HOSTNAME_MAXLEN];
 } hostListing;
 
+/* inter-switch link from the switch map */
+typedef struct islListing
+{
+	int		switch1;							/* index in switchNames */
+	int		port1;
+	int		switch2;							/* index in switchNames */
+	int		port2;
+} islListing;
+
 /* global variables */
 int verbose = false;		/* default to quite mode */
 int debug = false;			/* default to no debug statements */
 int concurrent = false;		/* default to sequential testing */
+int tournament = false;		/* run pairs in conflict free rounds */
+int tournamentRounds = 0;	/* rounds to schedule, 0 = log2(hosts) */
+char switchMapFile[256];	/* host to switch map for -rmap */
+int islPairs = false;		/* create one pair per ISL in the switch map */
+int pairSlots = 0;			/* number of entries in the pair arrays */
 int compare_best = false;	/* default to using Avg for comparisons */
 int secondPass = false;		/* start with first pass */
 int trialPass = false;		/* assume no trial pass */
@@ -131,6 +147,14 @@ char baselineHost[HOSTNAME_MAXLEN];
 int baselineRank = 0;
 hostListing* hostList = NULL;		/* list of hosts */
 
+/* switch map, only loaded on rank 0 */
+char (*switchNames)[HOSTNAME_MAXLEN] = NULL;	/* switches in the map */
+int switchCount = 0;
+int *switchOfRank = NULL;			/* switch index per rank, -1 unknown */
+int *portOfRank = NULL;				/* switch port per rank, 0 unknown */
+islListing *islList = NULL;			/* ISLs in the map */
+int islCount = 0;
+
 double latencyMax = 0;				
 double latencyMin = 0;
 double latencyAvg = 0;				
@@ -147,6 +171,11 @@ static void reportTestResults(int pairs, pairResults *pairData);
 static int parseInputParameters(int argc, char *argv[]);
 static int findBaselineHost(int pairs, int loop, pairResults *pairData);
 static void createPairs(int concurrent, pairResults *pairData);
+static int tournamentRoundCount(int ranks);
+static int loadSwitchMap(const char *filename, int ranks);
+static int createTournamentPairs(int rounds, pairResults *pairData);
+static int createRetryPairs(int pairs, pairResults *pairData,
+	pairResults *pairData2);
 static void runConcurrentLatency(int pairs, int doubles, int size, int loop, 
 	pairResults *pairData); 
 static void runConcurrentBandwidth(int pairs, int doubles, int size, int loop, 
@@ -155,6 +184,10 @@ static void runSequentialLatency(int pairs, int size, int loop,
 	pairResults *pairData); 
 static void runSequentialBandwidth(int pairs, int size, int loop, 
 	pairResults *pairData); 
+static void runTournamentLatency(int pairs, int size, int loop, 
+	pairResults *pairData); 
+static void runTournamentBandwidth(int pairs, int size, int loop, 
+	pairResults *pairData); 
 static void hostReport(pairResults *pairData, int latency);
 static void hostBroadcast(pairResults *pairData);
 static void Usage();
@@ -172,6 +205,7 @@ main(int argc, char **argv)
 	int pairs;					/* how many pairings */
 	int doubles;				/* how many unique pairs */
 	int newPairs;				/* pairs for second round of testing */
+	int rounds = 0;				/* tournament rounds */
 	pairResults* pairData;		/* paired data info - first pass */
 	pairResults* pairData2;		/* paired data info - second pass */
 
@@ -207,8 +241,50 @@ main(int argc, char **argv)
 	hostList = malloc(sizeof(hostListing) * ranks);
 	assert(hostList);
 
+	/* gather the list of hostnames */
+    MPI_Allgather((void *)pairedHostname(), HOSTNAME_MAXLEN, MPI_CHAR,
+		  hostList, HOSTNAME_MAXLEN, MPI_CHAR, MPI_COMM_WORLD);
+
+	/* get the list of hosts */
+	if (myrank == 0 && debug == true)
+	{
+    	for (hosts = 0; hosts < ranks; hosts++) 
+			printf("Rank %u: %s\n", hosts, hostList[hosts].hostname);
+	}
+
+	/* load the switch map, with -risl it determines how many pairs we need */
+	if (strlen(switchMapFile) > 0)
+	{
+		int status = 0;
+
+		if (myrank == 0)
+		{
+			status = loadSwitchMap(switchMapFile, ranks);
+			pairs = islCount;
+		}
+		MPI_Bcast(&status, 1, MPI_INT, 0, MPI_COMM_WORLD);
+		MPI_Bcast(&pairs, 1, MPI_INT, 0, MPI_COMM_WORLD);
+		if (status < 0)
+		{
+			MPI_Finalize();
+			exit(1);
+		}
+	}
+
 	/* calculate how many pairs we need for testing */
-	if (concurrent == true)
+	if (tournament == true && islPairs == true)
+	{
+		/* at most one pair per ISL, actual count is known after pairing */
+		rounds = 0;
+		doubles = pairs;
+	}
+	else if (tournament == true)
+	{
+		/* every round pairs up all hosts, less the bye when odd */
+		rounds = tournamentRoundCount(ranks);
+		doubles = pairs = rounds * (ranks / 2);
+	}
+	else if (concurrent == true)
 	{
 		doubles = pairs = ranks / 2;
 		if (ranks % 2 != 0)
@@ -217,10 +293,13 @@ main(int argc, char **argv)
 	else
 		doubles = pairs = ranks - 1;
 
+	/* tournament mode may need more pair entries than there are hosts */
+	pairSlots = (pairs > ranks) ? pairs : ranks;
+
 	/* get memory for tests */
-	pairData = malloc(sizeof(pairResults) * ranks);
+	pairData = malloc(sizeof(pairResults) * pairSlots);
 	assert(pairData);
-	initPairs(&pairData[0], ranks);
+	initPairs(&pairData[0], pairSlots);
 
 	/* get memory for second round of pair testing */
 	if (myrank == 0)
@@ -238,17 +317,6 @@ main(int argc, char **argv)
 			(unsigned)sizeof(pairResults) * pairs);
 	}
 
-	/* gather the list of hostnames */
-    MPI_Allgather((void *)pairedHostname(), HOSTNAME_MAXLEN, MPI_CHAR,
-		  hostList, HOSTNAME_MAXLEN, MPI_CHAR, MPI_COMM_WORLD);
-
-	/* get the list of hosts */
-	if (myrank == 0 && debug == true)
-	{
-    	for (hosts = 0; hosts < ranks; hosts++) 
-			printf("Rank %u: %s\n", hosts, hostList[hosts].hostname);
-	}
-
 	/* if user supplied a baseline host then use that host in sequential tests */
 	if (strlen(baselineHost) > 0)
 	{
@@ -333,8 +401,10 @@ main(int argc, char **argv)
 	MPI_Barrier(MPI_COMM_WORLD);
 
 	/* now that we have the list of hosts create the initial pairs */
-	initPairs(&pairData[0], ranks);
-	if (myrank == 0)
+	initPairs(&pairData[0], pairSlots);
+	if (myrank == 0 && tournament == true)
+		doubles = pairs = createTournamentPairs(rounds, pairData);
+	else if (myrank == 0)
 		createPairs(concurrent, pairData);
 
 	MPI_Barrier(MPI_COMM_WORLD);
@@ -345,13 +415,17 @@ main(int argc, char **argv)
 	MPI_Barrier(MPI_COMM_WORLD);
 
 	/* run the latency tests */
-	if (concurrent == true)
+	if (tournament == true)
+		runTournamentLatency(pairs, latencySize, latencyLoop, &pairData[0]);
+	else if (concurrent == true)
 		runConcurrentLatency(pairs, doubles, latencySize, latencyLoop, &pairData[0]);
 	else
 		runSequentialLatency(pairs, latencySize, latencyLoop, &pairData[0]);
 
 	/* run the bandwidth tests */
-	if (concurrent == true)
+	if (tournament == true)
+		runTournamentBandwidth(pairs, bandwidthSize, bandwidthLoop, &pairData[0]);
+	else if (concurrent == true)
 		runConcurrentBandwidth(pairs, doubles, bandwidthSize, bandwidthLoop, &pairData[0]);
 	else
 		runSequentialBandwidth(pairs, bandwidthSize, bandwidthLoop, &pairData[0]);
@@ -375,8 +449,14 @@ main(int argc, char **argv)
 	   pair them against the baseline rank for a sequential test */
 	secondPass = true;
 
+	/* in tournament mode each host ran in several pairs, so retry the hosts
+	   which failed most of their pairs rather than every failed pair */
+	if (myrank == 0 && tournament == true)
+	{
+		newPairs = createRetryPairs(pairs, &pairData[0], &pairData2[0]);
+	}
 	/* find how many concurrent test failed */
-	if (myrank == 0)
+	else if (myrank == 0)
 	{
 		for (pair = 0; pair < pairs; pair++)
 		{
@@ -397,7 +477,7 @@ main(int argc, char **argv)
 		}
 	}
 
-	if (myrank == 0 && newPairs != 0)
+	if (myrank == 0 && newPairs != 0 && tournament == false)
 	{
 		/* create new sequential pairs for round 2 of testing */
 		pair2 = 0;
@@ -456,7 +536,7 @@ main(int argc, char **argv)
 
 	/* clear out the first round of test pairs so we can get ready for the 
 	   second round and then copy second round to first round pair array */
-	initPairs(&pairData[0], ranks);
+	initPairs(&pairData[0], pairSlots);
 	if (myrank == 0 && newPairs != 0)
 	{
 		for (pair = 0; pair < newPairs; pair++)
@@ -500,6 +580,7 @@ main(int argc, char **argv)
 
 	/* report latency and bandwidth */
 	concurrent = false;
+	tournament = false;
 	if (myrank == 0 && newPairs != 0)
 	{
 		reportTestResults(newPairs, &pairData[0]);
@@ -561,6 +642,8 @@ initPairs(pairResults *pairData, int pairs)
 		pairData[pair].receiveHostname[0] = 0;
 		pairData[pair].alone = true;
 		pairData[pair].failed = false;
+		pairData[pair].round = 0;
+		pairData[pair].isl = -1;
 	}
 }
 
@@ -612,6 +695,29 @@ findBaselineHost(int pairs, int loop, pairResults *pairData)
 	return pairData[bestLatencyPair].sendRank;
 }
 		
+/* when a switch map was supplied, show the switch ports and targeted ISL
+ * for a pair so a slow pair can be attributed to a link
+ */
+static void
+reportPairPath(pairResults *pairData)
+{
+	int send = switchOfRank ? switchOfRank[pairData->sendRank] : -1;
+	int receive = switchOfRank ? switchOfRank[pairData->receiveRank] : -1;
+
+	if (send < 0 || receive < 0)
+		return;
+	printf("                           %s:%d <-> %s:%d",
+		switchNames[send], portOfRank[pairData->sendRank],
+		switchNames[receive], portOfRank[pairData->receiveRank]);
+	if (pairData->isl >= 0)
+		printf("  ISL %s:%d <-> %s:%d",
+			switchNames[islList[pairData->isl].switch1],
+			islList[pairData->isl].port1,
+			switchNames[islList[pairData->isl].switch2],
+			islList[pairData->isl].port2);
+	printf("\n");
+}
+
 /* report test results */
 static void
 reportTestResults(int pairs, pairResults *pairData)
@@ -749,7 +855,10 @@ reportTestResults(int pairs, pairResults *pairData)
 	printf("\n");
 	if (secondPass == false)
 	{
-		if (concurrent == true)
+		if (tournament == true)
+			printf("Tournament MPI Performance Test Results - Rounds %u\n",
+				tournamentRounds);
+		else if (concurrent == true)
 			printf("Concurrent MPI Performance Test Results\n");
 		else
 			printf("Sequential MPI Performance Test Results\n");
@@ -822,6 +931,7 @@ reportTestResults(int pairs, pairResults *pairData)
 					pairData[pair].latency, pairPercentage,
 					pairData[pair].sendHostname, pairData[pair].sendRank, 
 					pairData[pair].receiveHostname, pairData[pair].receiveRank);
+			reportPairPath(&pairData[pair]);
 		}
 	}
 
@@ -845,6 +955,7 @@ reportTestResults(int pairs, pairResults *pairData)
 					pairData[pair].bandwidth, pairPercentage,
 					pairData[pair].sendHostname, pairData[pair].sendRank, 
 					pairData[pair].receiveHostname, pairData[pair].receiveRank);
+			reportPairPath(&pairData[pair]);
 		}
 	}
 
@@ -1054,6 +1165,37 @@ parseInputParameters(int argc,char *argv[])
 			verbose = debug = true;
 		else if (strcasecmp(argv[opt], "-c") == 0)
 			concurrent = true;
+		else if (strcasecmp(argv[opt], "-r") == 0)
+			concurrent = tournament = true;
+		else if (strcasecmp(argv[opt], "-rounds") == 0) {
+			concurrent = tournament = true;
+			errno = 0;
+			opt++;
+			if (argv[opt])
+				tournamentRounds = (long)strtoul(argv[opt], &p, 10);
+			if (argv[opt] == NULL || argv[opt] == p || errno || (p && *p)
+				|| tournamentRounds <= 0 )
+			{
+				if (myrank == 0) {
+					fprintf(stderr, "Invalid tournament round count: %s\n", argv[opt]?argv[opt]:"required parameter missing");
+					Usage();
+				}
+				return -1;
+			}
+		} else if (strcasecmp(argv[opt], "-risl") == 0) {
+			concurrent = tournament = islPairs = true;
+		} else if (strcasecmp(argv[opt], "-rmap") == 0) {
+			concurrent = tournament = true;
+			if (argv[++opt] != NULL) {
+				snprintf(switchMapFile, sizeof(switchMapFile), "%s", argv[opt]);
+			} else {
+				if (myrank == 0) {
+					fprintf(stderr, "-rmap argument requires a filename\n");
+					Usage();
+				}
+				return -1;
+			}
+		}
 		else if (strcasecmp(argv[opt], "-b") == 0)
 			compare_best = true;
 		else {
@@ -1065,9 +1207,18 @@ parseInputParameters(int argc,char *argv[])
 		}
 	}
 
+	if (islPairs == true && strlen(switchMapFile) == 0)
+	{
+		if (myrank == 0) {
+			fprintf(stderr, "-risl requires -rmap\n");
+			Usage();
+		}
+		return -1;
+	}
+
 	if (myrank == 0 && debug == true)
-		printf("Settings - verbose %u concurrent %u debug %u\n", 
-			verbose, concurrent, debug);
+		printf("Settings - verbose %u concurrent %u tournament %u debug %u\n", 
+			verbose, concurrent, tournament, debug);
 
 	return 0;
 }
@@ -1148,6 +1299,441 @@ createPairs(int parallel, pairResults* pairData)
 	}
 }
 
+/* number of tournament rounds to schedule for the given number of hosts */
+static int
+tournamentRoundCount(int ranks)
+{
+	int rounds = tournamentRounds;
+	int maxRounds;
+
+	/* default to log2(hosts) rounds so each host is tested against a few
+	   different partners without testing all pairings */
+	if (rounds == 0)
+	{
+		for (rounds = 1; (1 << rounds) < ranks; rounds++)
+			;
+	}
+	/* a full round robin of N hosts (plus a bye when odd) is N-1 rounds */
+	maxRounds = ranks + (ranks % 2) - 1;
+	if (rounds > maxRounds)
+		rounds = maxRounds;
+	return rounds;
+}
+
+/* find or add a switch name in the switch map, returns its index */
+static int
+switchIndex(const char *name)
+{
+	int i;
+
+	for (i = 0; i < switchCount; i++)
+	{
+		if (strcmp(switchNames[i], name) == 0)
+			return i;
+	}
+	switchNames = realloc(switchNames, sizeof(*switchNames) * (switchCount + 1));
+	assert(switchNames);
+	snprintf(switchNames[switchCount], HOSTNAME_MAXLEN, "%s", name);
+	return switchCount++;
+}
+
+/* compare a MPI hostname against a map hostname, a short name in either
+ * matches the same name with a domain in the other
+ */
+static int
+hostnameMatch(const char *mpiName, const char *mapName)
+{
+	size_t len1 = strcspn(mpiName, ".");
+	size_t len2 = strcspn(mapName, ".");
+
+	if (strcmp(mpiName, mapName) == 0)
+		return true;
+	if (mpiName[len1] != '\0' && mapName[len2] != '\0')
+		return false;
+	return (len1 == len2 && strncmp(mpiName, mapName, len1) == 0);
+}
+
+/* load the optional host to switch map used to schedule tournament pairs.
+ * The map is normally produced by "ethreport -o hostmap" from a snapshot and
+ * has lines of:
+ *     hostname switchname [switchport]
+ *     isl switchname switchport switchname switchport
+ * blank lines and # comments are ignored.  Only loaded on rank 0.
+ * returns 0 on success, -1 on error
+ */
+static int
+loadSwitchMap(const char *filename, int ranks)
+{
+	FILE *fp;
+	char line[512];
+	char field[5][HOSTNAME_MAXLEN];
+	int fields;
+	int rank;
+	int mapped = 0;
+
+	fp = fopen(filename, "r");
+	if (! fp)
+	{
+		fprintf(stderr, "Unable to open switch map %s: %s\n", filename,
+			strerror(errno));
+		return -1;
+	}
+	switchOfRank = malloc(sizeof(int) * ranks);
+	portOfRank = malloc(sizeof(int) * ranks);
+	assert(switchOfRank && portOfRank);
+	for (rank = 0; rank < ranks; rank++)
+	{
+		switchOfRank[rank] = -1;
+		portOfRank[rank] = 0;
+	}
+
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		fields = sscanf(line, "%63s %63s %63s %63s %63s", field[0], field[1],
+					field[2], field[3], field[4]);
+		if (fields < 2 || field[0][0] == '#')
+			continue;
+		if (fields == 5 && strcmp(field[0], "isl") == 0)
+		{
+			islList = realloc(islList, sizeof(islListing) * (islCount + 1));
+			assert(islList);
+			islList[islCount].switch1 = switchIndex(field[1]);
+			islList[islCount].port1 = atoi(field[2]);
+			islList[islCount].switch2 = switchIndex(field[3]);
+			islList[islCount].port2 = atoi(field[4]);
+			islCount++;
+			continue;
+		}
+		for (rank = 0; rank < ranks; rank++)
+		{
+			if (! hostnameMatch(hostList[rank].hostname, field[0]))
+				continue;
+			switchOfRank[rank] = switchIndex(field[1]);
+			portOfRank[rank] = (fields > 2) ? atoi(field[2]) : 0;
+			mapped++;
+		}
+	}
+	fclose(fp);
+	if (debug == true)
+		printf("Switch map %s: %u ranks mapped to %u switches, %u ISLs\n",
+			filename, mapped, switchCount, islCount);
+	return 0;
+}
+
+/* add switch to the list of switches a pair uses, returns new count */
+static int
+addPairSwitch(int *switches, int count, int sw)
+{
+	int i;
+
+	if (sw < 0)
+		return count;
+	for (i = 0; i < count; i++)
+	{
+		if (switches[i] == sw)
+			return count;
+	}
+	switches[count] = sw;
+	return count + 1;
+}
+
+/* reassign pairs to rounds so that in addition to each host being in at most
+ * one pair per round, each switch has at most one inter-switch pair per round.
+ * This keeps pairs from sharing switch uplinks at the cost of more rounds.
+ * ISL pairs also reserve both switches of the ISL they target.
+ * returns the number of rounds used
+ */
+static int
+scheduleSwitchDisjoint(int pairs, pairResults *pairData, int ranks)
+{
+	int *hostRound = malloc(sizeof(int) * ranks);
+	int *switchRound = malloc(sizeof(int) * (switchCount + 1));
+	int scheduled = 0;
+	int round;
+	int pair;
+	int switches[4];
+	int count;
+	int i;
+
+	assert(hostRound && switchRound);
+	for (i = 0; i < ranks; i++)
+		hostRound[i] = -1;
+	for (i = 0; i < switchCount; i++)
+		switchRound[i] = -1;
+	for (pair = 0; pair < pairs; pair++)
+		pairData[pair].round = -1;
+
+	/* greedily fill each round in pair order until all pairs are placed */
+	for (round = 0; scheduled < pairs; round++)
+	{
+		for (pair = 0; pair < pairs; pair++)
+		{
+			if (pairData[pair].round != -1
+				|| hostRound[pairData[pair].sendRank] == round
+				|| hostRound[pairData[pair].receiveRank] == round)
+				continue;
+			count = addPairSwitch(switches, 0,
+						switchOfRank[pairData[pair].sendRank]);
+			count = addPairSwitch(switches, count,
+						switchOfRank[pairData[pair].receiveRank]);
+			if (pairData[pair].isl >= 0)
+			{
+				count = addPairSwitch(switches, count,
+							islList[pairData[pair].isl].switch1);
+				count = addPairSwitch(switches, count,
+							islList[pairData[pair].isl].switch2);
+			}
+			/* pairs within a single switch do not use any uplinks */
+			if (count > 1)
+			{
+				for (i = 0; i < count; i++)
+				{
+					if (switchRound[switches[i]] == round)
+						break;
+				}
+				if (i < count)
+					continue;
+				for (i = 0; i < count; i++)
+					switchRound[switches[i]] = round;
+			}
+			hostRound[pairData[pair].sendRank] = round;
+			hostRound[pairData[pair].receiveRank] = round;
+			pairData[pair].round = round;
+			scheduled++;
+		}
+	}
+	free(hostRound);
+	free(switchRound);
+	return round;
+}
+
+/* pick the next rank attached to the given switch, rotating through the
+ * switch's hosts so ISL pairs are spread across them. returns -1 if none
+ */
+static int
+nextSwitchHost(int sw, int ranks, int *next)
+{
+	int i;
+	int rank;
+
+	for (i = 0; i < ranks; i++)
+	{
+		rank = (next[sw] + i) % ranks;
+		if (switchOfRank[rank] == sw)
+		{
+			next[sw] = rank + 1;
+			return rank;
+		}
+	}
+	return -1;
+}
+
+/* find a switch with hosts, other than avoid, which has an ISL to sw */
+static int
+findHostSwitchNeighbor(int sw, int avoid, const int *hostCount)
+{
+	int isl;
+	int neighbor;
+
+	for (isl = 0; isl < islCount; isl++)
+	{
+		if (islList[isl].switch1 == sw)
+			neighbor = islList[isl].switch2;
+		else if (islList[isl].switch2 == sw)
+			neighbor = islList[isl].switch1;
+		else
+			continue;
+		if (neighbor != avoid && hostCount[neighbor] > 0)
+			return neighbor;
+	}
+	return -1;
+}
+
+/* create one pair per ISL in the switch map.  When both switches of the ISL
+ * have hosts the pair is between those hosts, otherwise (eg. a spine) one
+ * host is taken from a neighbor switch so the path crosses the ISL.
+ * returns the number of pairs created
+ */
+static int
+createIslPairs(pairResults *pairData)
+{
+	int ranks;
+	int *hostCount;
+	int *next;
+	int isl;
+	int rank;
+	int switch1, switch2;
+	int rank1, rank2;
+	int pair = 0;
+	int skipped = 0;
+
+	/* how many hosts are there? */
+	MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+	hostCount = calloc(switchCount + 1, sizeof(int));
+	next = calloc(switchCount + 1, sizeof(int));
+	assert(hostCount && next);
+	for (rank = 0; rank < ranks; rank++)
+	{
+		if (switchOfRank[rank] >= 0)
+			hostCount[switchOfRank[rank]]++;
+	}
+
+	for (isl = 0; isl < islCount; isl++)
+	{
+		switch1 = islList[isl].switch1;
+		switch2 = islList[isl].switch2;
+		if (hostCount[switch1] == 0)
+			switch1 = findHostSwitchNeighbor(switch1, switch2, hostCount);
+		if (hostCount[switch2] == 0)
+			switch2 = findHostSwitchNeighbor(switch2, switch1, hostCount);
+		if (switch1 < 0 || switch2 < 0 || switch1 == switch2)
+		{
+			skipped++;
+			continue;
+		}
+		rank1 = nextSwitchHost(switch1, ranks, next);
+		rank2 = nextSwitchHost(switch2, ranks, next);
+
+		pairData[pair].sendRank = rank1;
+		strcpy(pairData[pair].sendHostname, hostList[rank1].hostname);
+		pairData[pair].receiveRank = rank2;
+		strcpy(pairData[pair].receiveHostname, hostList[rank2].hostname);
+		pairData[pair].alone = false;
+		pairData[pair].valid = true;
+		pairData[pair].isl = isl;
+		pair++;
+	}
+	if (skipped)
+		printf("%u ISLs have no hosts on either side and will not be tested\n",
+			skipped);
+	free(hostCount);
+	free(next);
+	return pair;
+}
+
+/* create tournament pairings using the circle method.  Each round pairs up
+ * every host once (one host sits out when odd) and no pairing repeats.
+ * With islPairs, one pair per ISL in the switch map is created instead.
+ */
+static int
+createTournamentPairs(int rounds, pairResults *pairData)
+{
+	int ranks;
+	int slots;
+	int *slot;
+	int round;
+	int k;
+	int last;
+	int pair = 0;
+
+	/* how many hosts are there? */
+	MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+	if (islPairs == true && switchOfRank)
+	{
+		pair = createIslPairs(pairData);
+	}
+	else
+	{
+		/* an extra slot acts as the bye when there is an odd number of hosts */
+		slots = ranks + (ranks % 2);
+		slot = malloc(sizeof(int) * slots);
+		assert(slot);
+		for (k = 0; k < slots; k++)
+			slot[k] = k;
+
+		for (round = 0; round < rounds; round++)
+		{
+			for (k = 0; k < slots / 2; k++)
+			{
+				/* skip the bye */
+				if (slot[k] >= ranks || slot[slots - 1 - k] >= ranks)
+					continue;
+				pairData[pair].sendRank = slot[k];
+				strcpy(pairData[pair].sendHostname, hostList[slot[k]].hostname);
+				pairData[pair].receiveRank = slot[slots - 1 - k];
+				strcpy(pairData[pair].receiveHostname,
+					hostList[slot[slots - 1 - k]].hostname);
+				pairData[pair].alone = false;
+				pairData[pair].valid = true;
+				pairData[pair].round = round;
+				pair++;
+			}
+			/* keep slot 0 fixed and rotate the others by one position */
+			last = slot[slots - 1];
+			memmove(&slot[2], &slot[1], sizeof(int) * (slots - 2));
+			slot[1] = last;
+		}
+		free(slot);
+	}
+	tournamentRounds = rounds;
+
+	if (switchOfRank)
+		tournamentRounds = scheduleSwitchDisjoint(pair, pairData, ranks);
+
+	if (debug == true)
+	{
+		for (k = 0; k < pair; k++)
+			printf("createTournamentPairs() Round %u Pair %u send rank %u receive rank %u\n", 
+				pairData[k].round, k, pairData[k].sendRank,
+				pairData[k].receiveRank);
+	}
+	return pair;
+}
+
+/* build the sequential second pass pairs for a tournament run.  Every host
+ * which failed at least half of the pairs it was in is paired against the
+ * baseline host.  returns the number of pairs created in pairData2
+ */
+static int
+createRetryPairs(int pairs, pairResults *pairData, pairResults *pairData2)
+{
+	int ranks;
+	int *tested;
+	int *failed;
+	int pair;
+	int rank;
+	int newPairs = 0;
+
+	/* how many hosts are there? */
+	MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+	tested = calloc(ranks, sizeof(int));
+	failed = calloc(ranks, sizeof(int));
+	assert(tested && failed);
+
+	for (pair = 0; pair < pairs; pair++)
+	{
+		if (pairData[pair].valid == false)
+			continue;
+		tested[pairData[pair].sendRank]++;
+		tested[pairData[pair].receiveRank]++;
+		if (pairData[pair].failed == true)
+		{
+			failed[pairData[pair].sendRank]++;
+			failed[pairData[pair].receiveRank]++;
+		}
+	}
+
+	for (rank = 0; rank < ranks; rank++)
+	{
+		if (rank == baselineRank || failed[rank] == 0
+			|| failed[rank] * 2 < tested[rank])
+			continue;
+		pairData2[newPairs].sendRank = baselineRank;
+		strcpy(pairData2[newPairs].sendHostname, baselineHost);
+		pairData2[newPairs].receiveRank = rank;
+		strcpy(pairData2[newPairs].receiveHostname, hostList[rank].hostname);
+		pairData2[newPairs].valid = true;
+		pairData2[newPairs].alone = true;
+		newPairs++;
+	}
+	free(tested);
+	free(failed);
+	return newPairs;
+}
+
 /* this is the heart of the latency test */
 /* because the test is a ping-pong type latency test, their is no need for a
  * barrier.  The first packet (which is part of warmup) will implicitly
@@ -1659,6 +2245,172 @@ runSequentialBandwidth(int pairs, int size, int loop, pairResults* pairData)
 	MPI_Barrier(MPI_COMM_WORLD);
 }
 
+/* number of rounds in a tournament pair list */
+static int
+tournamentRoundsUsed(int pairs, pairResults *pairData)
+{
+	int pair;
+	int rounds = 0;
+
+	for (pair = 0; pair < pairs; pair++)
+	{
+		if (pairData[pair].valid == true && pairData[pair].round >= rounds)
+			rounds = pairData[pair].round + 1;
+	}
+	return rounds;
+}
+
+/* run tournament latency test, all pairs in a round run concurrently and
+ * each host is in at most one pair per round
+ */
+static void
+runTournamentLatency(int pairs, int size, int loop, pairResults* pairData) 
+{
+	int bytes;
+	int pair;
+	int round;
+	int rounds;
+	int validPairs = 0;
+	int myrank;
+
+	/* what is my rank */
+    MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+
+	/* how many pairs are valid */
+	for (pair = 0; pair < pairs; pair++)
+	{
+		if (pairData[pair].valid == true)
+			validPairs++;
+	}
+	rounds = tournamentRoundsUsed(pairs, pairData);
+	if (myrank == 0 && debug == false)
+		printf("Running Tournament MPI Latency Tests - Pairs %u Rounds %u   Testing ",
+		validPairs, rounds);
+
+	if (myrank == 0 && debug == true)
+		printf("\n");
+
+	/* initialize the buffer data */
+	for (bytes = 0; bytes < size; bytes++)
+	{
+		sendBuffer[bytes]= 'a';
+		receiveBuffer[bytes]= 'b';
+	}
+
+	for (round = 0; round < rounds; round++)
+	{
+		if (myrank == 0 && debug == false)
+		{
+			printf("%5u", round + 1);
+			fflush(stdout);
+		}
+
+		/* sync up between rounds so rounds do not overlap */
+		MPI_Barrier(MPI_COMM_WORLD);
+		for (pair = 0; pair < pairs; pair++)
+		{
+			if (pairData[pair].valid == false || pairData[pair].round != round)
+				continue;
+			do_latency(pair, myrank, size, loop, pairData);
+		}
+		if (myrank == 0 && debug == false)
+		{
+			printf("\b\b\b\b\b");
+			fflush(stdout);
+		}
+	}
+	MPI_Barrier(MPI_COMM_WORLD);
+	if (myrank == 0)
+		printf("\n");
+
+	/* report test pair data */
+	hostReport(&pairData[0], /* latency */ true);
+
+	/* wait for all communications to complete */
+	MPI_Barrier(MPI_COMM_WORLD);
+}
+
+/* run tournament bandwidth test, all pairs in a round run concurrently and
+ * each host is in at most one pair per round
+ */
+static void
+runTournamentBandwidth(int pairs, int size, int loop, pairResults* pairData) 
+{
+	int bytes;
+	int pair;
+	int round;
+	int rounds;
+	int validPairs = 0;
+	int myrank;
+	int pageSize;
+	char *s_buf, *r_buf;
+
+	/* what is my rank */
+    MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+
+	/* how many pairs are valid */
+	for (pair = 0; pair < pairs; pair++)
+	{
+		if (pairData[pair].valid == true)
+			validPairs++;
+	}
+	rounds = tournamentRoundsUsed(pairs, pairData);
+	if (myrank == 0 && debug == false)
+		printf("Running Tournament MPI Bandwidth Tests - Pairs %u Rounds %u   Testing ",
+		validPairs, rounds);
+
+	if (myrank == 0 && debug == true)
+		printf("\n");
+
+	/* get memory page size for this host */
+	pageSize = getpagesize();
+
+	/* set send and receive buffer pointers */
+	s_buf = (char*)(((unsigned long)sendBuffer + (pageSize -1))/pageSize * pageSize);
+	r_buf = (char*)(((unsigned long)receiveBuffer + (pageSize -1))/pageSize * pageSize);
+	assert((s_buf != NULL) && (r_buf != NULL));
+
+	/* initialize the buffer data */
+	for (bytes = 0; bytes < size; bytes++)
+	{
+		s_buf[bytes]= 'a';
+		r_buf[bytes]= 'b';
+	}
+
+	for (round = 0; round < rounds; round++)
+	{
+		if (myrank == 0 && debug == false)
+		{
+			printf("%5u", round + 1);
+			fflush(stdout);
+		}
+
+		/* sync up between rounds so rounds do not overlap */
+		MPI_Barrier(MPI_COMM_WORLD);
+		for (pair = 0; pair < pairs; pair++)
+		{
+			if (pairData[pair].valid == false || pairData[pair].round != round)
+				continue;
+			pair_barrier(pair, myrank, pairData);
+			do_bandwidth(pair, myrank, size, loop, s_buf, r_buf, pairData);
+		}
+		if (myrank == 0 && debug == false)
+		{
+			printf("\b\b\b\b\b");
+			fflush(stdout);
+		}
+	}
+	MPI_Barrier(MPI_COMM_WORLD);
+	if (myrank == 0)
+		printf("\n");
+
+	/* report test pair data */
+	hostReport(&pairData[0], /* bandwidth */ false);
+
+	/* wait for all communications to complete */
+	MPI_Barrier(MPI_COMM_WORLD);
+}
+
 /* report results from other ranks to rank 0 */
 static void
 hostReport(pairResults* pairData, int latency)
@@ -1676,7 +2428,7 @@ hostReport(pairResults* pairData, int latency)
 	MPI_Comm_size(MPI_COMM_WORLD, &ranks);
 
 	/* send all reports to rank 0 */
-	for (hosts = 0; hosts < ranks; hosts++)
+	for (hosts = 0; hosts < pairSlots; hosts++)
 	{
 		/* skip invalid pairs */
 		if (pairData[hosts].valid == false)
@@ -1739,7 +2491,7 @@ hostBroadcast(pairResults *pairData)
 	{
 		if (myrank == 0 && hosts != 0)
 		{
-			MPI_Send(&pairData[0], sizeof(pairResults) * ranks, MPI_CHAR, 
+			MPI_Send(&pairData[0], sizeof(pairResults) * pairSlots, MPI_CHAR, 
 				hosts, 1, MPI_COMM_WORLD);
 #ifdef DEBUG
 			printf("Broadcasting pair list from rank %u to rank %u\n",
@@ -1751,7 +2503,7 @@ hostBroadcast(pairResults *pairData)
 	/* receive pair list from rank 0 */
 	if (myrank != 0)
 	{
-		MPI_Recv(&pairData[0], sizeof(pairResults) * ranks, MPI_CHAR,
+		MPI_Recv(&pairData[0], sizeof(pairResults) * pairSlots, MPI_CHAR,
 			0, 1, MPI_COMM_WORLD, &stat);
 #ifdef DEBUG
 		printf("Rank %u receiving broadcast pair list\n", myrank);
@@ -1770,7 +2522,8 @@ Usage()
 					"                 [-bwloop count] [-bwsize size] [-bwbidir|-bwunidir]\n"
 					"                 [-lattol %%] [-latdelta usec] [-latthres usec]\n"
 					"                 [-latloop count] [-latsize size]\n"
-					"                 [-c] [-b] [-v] [-vv] [-h reference_host]\n"
+					"                 [-c] [-r] [-rounds count] [-rmap file] [-risl]\n"
+					"                 [-b] [-v] [-vv] [-h reference_host]\n"
 					"           or\n"
 					"       deviation -help\n");
 	fprintf(stderr, " -help      Output this usage information\n");
@@ -1787,6 +2540,15 @@ Usage()
 	fprintf(stderr, " -latloop   Number of loops to execute each latency test\n");
 	fprintf(stderr, " -latsize   Size of message to use for latency test\n");
 	fprintf(stderr, " -c         Run test pairs concurrently instead of the default of sequential\n");
+	fprintf(stderr, " -r         Run test pairs concurrently in conflict free tournament rounds,\n"
+					"            each host is in at most one pair per round\n");
+	fprintf(stderr, " -rounds    Number of tournament rounds to run, default is log2 of the\n"
+					"            number of hosts, implies -r\n");
+	fprintf(stderr, " -rmap      Host to switch map as output by ethreport -o hostmap, limits\n"
+					"            each switch to one inter-switch pair per tournament round\n"
+					"            and reports switch ports of pairs, implies -r\n");
+	fprintf(stderr, " -risl      Create one pair per inter-switch link in the -rmap file\n"
+					"            instead of round robin pairs, implies -r\n");
 	fprintf(stderr, " -b         When comparing results against tolerance and delta use best\n"     "            instead of Avg\n");
 	fprintf(stderr, " -v         verbose output\n");
 	fprintf(stderr, " -vv        Very verbose output\n");
@@ -1795,6 +2557,8 @@ Usage()
 	fprintf(stderr, "When bwthres is supplied, bwtol and bwdelta are ignored\n");
 	fprintf(stderr, "Both lattol and latdelta must be exceeded to fail latency test when both are supplied\n");
 	fprintf(stderr, "When lathres is supplied, lattol and latdelta are ignored\n");
+	fprintf(stderr, "With -r, hosts failing at least half of their pairs are retried\n"
+					"sequentially against the baseline host\n");
 	fprintf(stderr, "\n");
 	fprintf(stderr, "For consistency with OSU benchmarks MB/s is defined as 1000000 bytes/s\n");
 	fprintf(stderr, "\n");
@@ -86,8 +86,12 @@ are performing, it is not intended as a benchmark.
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <float.h>
+#include <limits.h>
 #include <time.h>
+#include <errno.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 
 #define  stringize(x) #x
 #define  add_quotes(x) stringize(x)
@@ -140,6 +144,55 @@ static   int myid;	   // my rank.
 static   int partnerid;  // my partner's rank.
 static	 int min_msg_size = MIN_MSG_SIZE;
 static   int max_msg_size = MAX_MSG_SIZE;
+static   double pair_bw; // bandwidth of my pair, only valid on senders.
+
+/*
+ * Instead of the rank order groups above, partners may be chosen from a
+ * host to switch map as output by "ethreport -o hostmap".  Lines are:
+ *     hostname switchname [switchport]
+ *     isl switchname switchport switchname switchport
+ * "local" pairing keeps each pair on a single switch so no uplinks are used,
+ * "isl" pairing puts one pair across every inter-switch link.
+ */
+#define  PAIRING_GROUP 0
+#define  PAIRING_LOCAL 1
+#define  PAIRING_ISL 2
+#define  HOSTNAME_MAXLEN 64
+
+typedef struct {
+	int	sw1, port1;
+	int	sw2, port2;
+} isl_t;
+
+static   char *map_file = NULL;
+static   int pairing = PAIRING_GROUP;
+static   char (*hostnames)[HOSTNAME_MAXLEN]; // per rank, rank 0 only
+static   char (*switch_names)[HOSTNAME_MAXLEN];
+static   int num_switches;
+static   int *switch_of; // per rank switch index, -1 if not in map
+static   int *port_of;   // per rank switch port
+static   isl_t *isls;
+static   int num_isls;
+static   int *pair_isl;  // per rank ISL index targeted, -1 if none
+static   int *partners;  // per rank partner, rank 0 only
+
+/*
+ * Windowed mode. Each rank keeps window messages in flight to each of
+ * num_partners partners at once, the partners being the matching rank and
+ * the ranks following it in the other half of the group. Requests may be
+ * persistent (MPI_Send_init/MPI_Recv_init) to take MPI call setup out of
+ * the loop, and buffers may be placed in huge pages.
+ */
+#define  MAX_PARTNERS (MAX_GROUP_SIZE/2)
+#define  CHECK_INTERVAL 16 // windows between checks for the end of a size
+#define  HUGEPAGE_SIZE (2*1024*1024)
+
+static   int window_depth = 0; // 0 uses the default window sizes below
+static   int num_partners = 1;
+static   int persistent = 0;
+static   int hugepages = 0;
+static   int partner_list[MAX_PARTNERS];
+static   int partner_count; // valid entries in partner_list
 
 #if defined(WIDE_PATTERN)
 #define PATTERN_SIZE 80
@@ -219,9 +272,9 @@ find_bibw(int myid, int target, int size, char *s_buf, char *r_buf)
   node and set things up appropriately.*/
 
   double t_start = 0.0, t_end = 0.0, t = 0.0, max_time = 0.0, min_time = 0.0;
-  double seconds_per_message_size, sum_loops, dloops;
+  double t_min, seconds_per_message_size, sum_loops, dloops;
   int i, j, window_size;
-  long skip, loops = 0, min_loops, max_loops;
+  long skip, loops = 0, loops_min, min_loops, max_loops;
 
   if (size < large_message_size)
   {
@@ -277,6 +330,7 @@ find_bibw(int myid, int target, int size, char *s_buf, char *r_buf)
     }
     loops = i - skip;
     t = t_end - t_start;
+    pair_bw = ((size * 2.0) / (1000 * 1000)) * loops * window_size / t;
   }
   else if (target != -1 && myid > target) 
   {
@@ -319,10 +373,22 @@ find_bibw(int myid, int target, int size, char *s_buf, char *r_buf)
   {
     MPI_Barrier(MPI_COMM_WORLD);
   }
+  /* an unpartnered rank 0 is only in mpi_comm_sender to collect the
+   * results, it must not pull the minimums down to 0 */
+  if (target == -1)
+  {
+    t_min = DBL_MAX;
+    loops_min = LONG_MAX;
+  }
+  else
+  {
+    t_min = t;
+    loops_min = loops;
+  }
   MPI_Reduce (&t, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, mpi_comm_sender);
-  MPI_Reduce (&t, &min_time, 1, MPI_DOUBLE, MPI_MIN, 0, mpi_comm_sender);
-  MPI_Reduce (&loops, &max_loops, 1, MPI_INTEGER, MPI_MAX, 0, mpi_comm_sender);
-  MPI_Reduce (&loops, &min_loops, 1, MPI_INTEGER, MPI_MIN, 0, mpi_comm_sender);
+  MPI_Reduce (&t_min, &min_time, 1, MPI_DOUBLE, MPI_MIN, 0, mpi_comm_sender);
+  MPI_Reduce (&loops, &max_loops, 1, MPI_LONG, MPI_MAX, 0, mpi_comm_sender);
+  MPI_Reduce (&loops_min, &min_loops, 1, MPI_LONG, MPI_MIN, 0, mpi_comm_sender);
   dloops = (double) loops;
   MPI_Reduce (&dloops, &sum_loops, 1, MPI_DOUBLE, MPI_SUM, 0, mpi_comm_sender);
 
@@ -342,13 +408,374 @@ find_bibw(int myid, int target, int size, char *s_buf, char *r_buf)
   return 0;
 }
 
-static char *short_options = "g:vl:u:t:h";
+double
+find_bibw_windowed(int size, char *s_buf, char *r_buf)
+{
+  double t_start = 0.0, t = 0.0, max_time = 0.0;
+  double seconds_per_message_size, sent, sum_sent, links, sum_links;
+  int i, j, p, window_size, num_req, stop = 0, done = 0;
+  long skip, loops, min_loops, max_loops;
+
+  if (size < large_message_size)
+  {
+    skip = skip_small;
+    min_loops = min_loops_small;
+    max_loops = max_loops_small;
+    window_size = window_size_small;
+    seconds_per_message_size = seconds_per_message_size_small;
+  }
+  else
+  {
+    skip = skip_large;
+    min_loops = min_loops_large;
+    max_loops = max_loops_large;
+    window_size = window_size_large;
+    seconds_per_message_size = seconds_per_message_size_large;
+  }
+  num_req = window_size * partner_count;
+
+  /* Requests alternate between partners so they all progress together. */
+  if (persistent)
+  {
+    for (j = 0; j < window_size; j++)
+      for (p = 0; p < partner_count; p++)
+      {
+        MPI_Recv_init (r_buf, size, MPI_CHAR, partner_list[p], TAG_DATA,
+                  MPI_COMM_WORLD, recv_request + j * partner_count + p);
+        MPI_Send_init (s_buf, size, MPI_CHAR, partner_list[p], TAG_DATA,
+                  MPI_COMM_WORLD, send_request + j * partner_count + p);
+      }
+  }
+
+  MPI_Barrier (MPI_COMM_WORLD);
+  /* Every rank runs the same number of windows, so the end of the test is
+   * agreed on every CHECK_INTERVAL windows rather than by the handshake
+   * find_bibw uses with its single partner. */
+  for (i = 0; !done && i < max_loops + skip; i++)
+  {
+    if (i == skip)
+    {
+      MPI_Barrier (MPI_COMM_WORLD);
+      t_start = MPI_Wtime();
+    }
+    if (persistent)
+    {
+      MPI_Startall (num_req, recv_request);
+      MPI_Startall (num_req, send_request);
+    }
+    else
+    {
+      for (j = 0; j < window_size; j++)
+        for (p = 0; p < partner_count; p++)
+          MPI_Irecv (r_buf, size, MPI_CHAR, partner_list[p], TAG_DATA,
+                    MPI_COMM_WORLD, recv_request + j * partner_count + p);
+      for (j = 0; j < window_size; j++)
+        for (p = 0; p < partner_count; p++)
+          MPI_Isend (s_buf, size, MPI_CHAR, partner_list[p], TAG_DATA,
+                    MPI_COMM_WORLD, send_request + j * partner_count + p);
+    }
+    MPI_Waitall (num_req, send_request, MPI_STATUSES_IGNORE);
+    MPI_Waitall (num_req, recv_request, MPI_STATUSES_IGNORE);
+
+    if (i >= skip && ((i + 1 - skip) % CHECK_INTERVAL) == 0)
+    {
+      stop = (i + 1 - skip) >= min_loops &&
+             MPI_Wtime() - t_start >= seconds_per_message_size;
+      MPI_Allreduce (&stop, &done, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    }
+  }
+  t = MPI_Wtime() - t_start;
+  loops = i - skip;
+
+  if (persistent)
+  {
+    for (j = 0; j < num_req; j++)
+    {
+      MPI_Request_free (send_request + j);
+      MPI_Request_free (recv_request + j);
+    }
+  }
+
+  pair_bw = ((size * 2.0) / (1000 * 1000)) * loops * window_size / t;
+  sent = (double) size * window_size * loops * partner_count;
+  links = partner_count / 2.0;
+  MPI_Reduce (&t, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  MPI_Reduce (&sent, &sum_sent, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  MPI_Reduce (&links, &sum_links, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+  if (myid==0)
+  {
+    /* Bandwidth per pair of ranks, in both directions, as find_bibw. */
+    double bw = (sum_links > 0) ?
+                (sum_sent / (1000 * 1000)) / sum_links / max_time : 0;
+    VERBOSE("%d bytes, %.2f MB/s, %ld loops, window %d, %d partners, "
+             "%.3f secs\n",
+             size, bw, loops, window_size, num_partners, max_time);
+    return bw;
+  }
+  return 0;
+}
+
+static int
+switch_index(const char *name)
+{
+	int i;
+
+	for (i = 0; i < num_switches; i++) {
+		if (strcmp(switch_names[i], name) == 0)
+			return i;
+	}
+	switch_names = realloc(switch_names, sizeof(*switch_names) * (num_switches + 1));
+	if (!switch_names) {
+		fprintf(stderr, "Out of memory loading %s\n", map_file);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	snprintf(switch_names[num_switches], HOSTNAME_MAXLEN, "%s", name);
+	return num_switches++;
+}
+
+// a short name in either hostname matches the same name with a domain
+static int
+hostname_match(const char *mpi_name, const char *map_name)
+{
+	size_t len1 = strcspn(mpi_name, ".");
+	size_t len2 = strcspn(map_name, ".");
+
+	if (strcmp(mpi_name, map_name) == 0)
+		return 1;
+	if (mpi_name[len1] != '\0' && map_name[len2] != '\0')
+		return 0;
+	return (len1 == len2 && strncmp(mpi_name, map_name, len1) == 0);
+}
+
+// load the host map on rank 0, returns 0 on success
+static int
+load_map(void)
+{
+	FILE *fp;
+	char line[512];
+	char field[5][HOSTNAME_MAXLEN];
+	int fields, r;
+
+	fp = fopen(map_file, "r");
+	if (!fp) {
+		fprintf(stderr, "Unable to open %s: %s\n", map_file, strerror(errno));
+		return -1;
+	}
+	switch_of = malloc(sizeof(int) * num_procs);
+	port_of = calloc(num_procs, sizeof(int));
+	if (!switch_of || !port_of) {
+		fprintf(stderr, "Out of memory loading %s\n", map_file);
+		fclose(fp);
+		return -1;
+	}
+	for (r = 0; r < num_procs; r++)
+		switch_of[r] = -1;
+
+	while (fgets(line, sizeof(line), fp)) {
+		fields = sscanf(line, "%63s %63s %63s %63s %63s", field[0], field[1],
+					field[2], field[3], field[4]);
+		if (fields < 2 || field[0][0] == '#')
+			continue;
+		if (fields == 5 && strcmp(field[0], "isl") == 0) {
+			isls = realloc(isls, sizeof(isl_t) * (num_isls + 1));
+			if (!isls) {
+				fprintf(stderr, "Out of memory loading %s\n", map_file);
+				fclose(fp);
+				return -1;
+			}
+			isls[num_isls].sw1 = switch_index(field[1]);
+			isls[num_isls].port1 = atoi(field[2]);
+			isls[num_isls].sw2 = switch_index(field[3]);
+			isls[num_isls].port2 = atoi(field[4]);
+			num_isls++;
+			continue;
+		}
+		for (r = 0; r < num_procs; r++) {
+			if (hostname_match(hostnames[r], field[0])) {
+				switch_of[r] = switch_index(field[1]);
+				port_of[r] = (fields > 2) ? atoi(field[2]) : 0;
+			}
+		}
+	}
+	fclose(fp);
+	return 0;
+}
+
+// lowest unpaired rank on switch sw not on the same host as rank avoid
+static int
+unpaired_on_switch(int sw, int *partners, int avoid)
+{
+	int r;
+
+	for (r = 0; r < num_procs; r++) {
+		if (switch_of[r] == sw && partners[r] == -1 && r != avoid
+			&& (avoid < 0 || strcmp(hostnames[r], hostnames[avoid]) != 0))
+			return r;
+	}
+	return -1;
+}
+
+// neighbor of switch sw, other than avoid, which still has unpaired ranks
+static int
+neighbor_with_hosts(int sw, int avoid, int *partners)
+{
+	int i, n;
+
+	for (i = 0; i < num_isls; i++) {
+		if (isls[i].sw1 == sw)
+			n = isls[i].sw2;
+		else if (isls[i].sw2 == sw)
+			n = isls[i].sw1;
+		else
+			continue;
+		if (n != avoid && unpaired_on_switch(n, partners, -1) >= 0)
+			return n;
+	}
+	return -1;
+}
+
+static void
+set_partners(int *partners, int r1, int r2, int isl)
+{
+	partners[r1] = r2;
+	partners[r2] = r1;
+	pair_isl[r1] = pair_isl[r2] = isl;
+}
+
+// compute partners for all ranks from the host map, returns number of pairs
+static int
+map_partners(int *partners)
+{
+	int r, r2, i, sw1, sw2, progress;
+	int pairs = 0;
+
+	for (r = 0; r < num_procs; r++)
+		partners[r] = pair_isl[r] = -1;
+
+	if (pairing == PAIRING_LOCAL) {
+		for (r = 0; r < num_procs; r++) {
+			if (partners[r] != -1 || switch_of[r] < 0)
+				continue;
+			partners[r] = r; // reserve while searching
+			r2 = unpaired_on_switch(switch_of[r], partners, r);
+			if (r2 < 0) {
+				partners[r] = -1;
+				continue;
+			}
+			set_partners(partners, r, r2, -1);
+			pairs++;
+		}
+		return pairs;
+	}
+
+	// keep cycling through the ISLs so every ISL carries traffic and
+	// additional pairs are spread evenly across them
+	do {
+		progress = 0;
+		for (i = 0; i < num_isls; i++) {
+			sw1 = isls[i].sw1;
+			sw2 = isls[i].sw2;
+			if (unpaired_on_switch(sw1, partners, -1) < 0)
+				sw1 = neighbor_with_hosts(sw1, sw2, partners);
+			if (unpaired_on_switch(sw2, partners, -1) < 0)
+				sw2 = neighbor_with_hosts(sw2, sw1, partners);
+			if (sw1 < 0 || sw2 < 0 || sw1 == sw2)
+				continue;
+			r = unpaired_on_switch(sw1, partners, -1);
+			partners[r] = r; // reserve while searching
+			r2 = unpaired_on_switch(sw2, partners, r);
+			if (r2 < 0) {
+				partners[r] = -1;
+				continue;
+			}
+			set_partners(partners, r, r2, i);
+			pairs++;
+			progress = 1;
+		}
+	} while (progress);
+	return pairs;
+}
+
+// allocate a message buffer in huge pages, falling back to page aligned memory
+static char *
+alloc_buffer(size_t size)
+{
+	void *buf = NULL;
+
+#ifdef MAP_HUGETLB
+	size_t len = (size + HUGEPAGE_SIZE - 1) / HUGEPAGE_SIZE * HUGEPAGE_SIZE;
+
+	buf = mmap(NULL, len, PROT_READ|PROT_WRITE,
+			MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+	if (buf != MAP_FAILED)
+		return buf;
+	RANK0("Huge pages unavailable, using page aligned buffers.\n");
+#endif
+	if (posix_memalign(&buf, getpagesize(), size) != 0)
+		return NULL;
+	return buf;
+}
+
+// describe the switch ports and targeted ISL of a rank's pair
+static void
+print_pair_path(FILE *f, int r)
+{
+	int p = partners[r];
+
+	fprintf(f, "%s (%d) <-> %s (%d)", hostnames[r], r, hostnames[p], p);
+	if (switch_of[r] >= 0 && switch_of[p] >= 0)
+		fprintf(f, "  %s:%d <-> %s:%d", switch_names[switch_of[r]], port_of[r],
+				switch_names[switch_of[p]], port_of[p]);
+	if (pair_isl[r] >= 0)
+		fprintf(f, "  ISL %s:%d <-> %s:%d",
+				switch_names[isls[pair_isl[r]].sw1], isls[pair_isl[r]].port1,
+				switch_names[isls[pair_isl[r]].sw2], isls[pair_isl[r]].port2);
+	fprintf(f, "\n");
+}
+
+// point out the slowest pair at this message size so a weak link can be found
+static void
+report_slowest_pair(void)
+{
+	double *all_bw = NULL;
+	double my_bw = (partnerid >= 0 && myid < partnerid) ? pair_bw : -1.0;
+	int r, slowest = -1;
+
+	if (myid == 0) {
+		all_bw = malloc(sizeof(double) * num_procs);
+		if (!all_bw) {
+			fprintf(stderr, "Out of memory.\n");
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+	}
+	MPI_Gather(&my_bw, 1, MPI_DOUBLE, all_bw, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	if (myid != 0)
+		return;
+	for (r = 0; r < num_procs; r++) {
+		if (all_bw[r] >= 0 && (slowest < 0 || all_bw[r] < all_bw[slowest]))
+			slowest = r;
+	}
+	if (slowest >= 0) {
+		printf("#\tSlowest pair %8.2f MB/s: ", all_bw[slowest]);
+		print_pair_path(stdout, slowest);
+	}
+	free(all_bw);
+}
+
+static char *short_options = "g:vl:u:t:m:p:w:P:RHh";
 static struct option long_options[] = {
 	{ .name = "verbose", .has_arg = 0, .val = 'v' },
 	{ .name = "group", .has_arg = 1, .val = 'g' },
 	{ .name = "min", .has_arg = 1, .val = 'l' },
 	{ .name = "max", .has_arg = 1, .val = 'u' },
     { .name = "time", .has_arg = 1, .val = 't' },
+	{ .name = "map", .has_arg = 1, .val = 'm' },
+	{ .name = "pairing", .has_arg = 1, .val = 'p' },
+	{ .name = "window", .has_arg = 1, .val = 'w' },
+	{ .name = "partners", .has_arg = 1, .val = 'P' },
+	{ .name = "persistent", .has_arg = 0, .val = 'R' },
+	{ .name = "hugepages", .has_arg = 0, .val = 'H' },
 	{ .name = "help", .has_arg = 0, .val = 'h' },
 	{ 0 }
 };
@@ -359,6 +786,12 @@ static char *usage_text[] = {
 	"Minimum Message Size. Should be between " add_quotes(MIN_MSG_SIZE) " and " add_quotes(MAX_MSG_SIZE),
 	"Maximum Message Size. Should be between " add_quotes(MIN_MSG_SIZE) " and " add_quotes(MAX_MSG_SIZE),
     "The duration of the test, in minutes. Defaults to 60 minutes. -1 to run forever.",
+	"Host to switch map, as output by \"ethreport -o hostmap\". Used with --pairing.",
+	"Pair ranks using the map: local (same switch) or isl (across every ISL).",
+	"Messages in flight to each partner. Should be between 1 and " add_quotes(MAX_REQ_NUM),
+	"Partners each rank exchanges with at once. At most half the group size.",
+	"Use persistent requests (MPI_Send_init/MPI_Recv_init).",
+	"Allocate message buffers in huge pages, if available.",
 	"Provides this help text.",
 	0
 };
@@ -452,6 +885,48 @@ main(int argc, char *argv[])
 				}
 				break;
 
+			case 'm':
+				map_file = optarg;
+				break;
+
+			case 'p':
+				if (strcmp(optarg, "local") == 0)
+					pairing = PAIRING_LOCAL;
+				else if (strcmp(optarg, "isl") == 0)
+					pairing = PAIRING_ISL;
+				else {
+					usage();
+					err = -1;
+					goto exit;
+				}
+				break;
+
+			case 'w':
+				window_depth = strtol(optarg, NULL, 0);
+				if (window_depth < 1 || window_depth > MAX_REQ_NUM) {
+					usage();
+					err = -1;
+					goto exit;
+				}
+				break;
+
+			case 'P':
+				num_partners = strtol(optarg, NULL, 0);
+				if (num_partners < 1 || num_partners > MAX_PARTNERS) {
+					usage();
+					err = -1;
+					goto exit;
+				}
+				break;
+
+			case 'R':
+				persistent = 1;
+				break;
+
+			case 'H':
+				hugepages = 1;
+				break;
+
 			case 'h':
 			default:
 				usage();
@@ -460,12 +935,85 @@ main(int argc, char *argv[])
 		}
 	}
 
+	if ((map_file == NULL) != (pairing == PAIRING_GROUP)) {
+		if (myid == 0)
+			fprintf(stderr, "--map and --pairing must be used together.\n");
+		usage();
+		err = -1;
+		goto exit;
+	}
+
+	if (num_partners > group_size / 2 || (map_file && num_partners > 1)) {
+		if (myid == 0)
+			fprintf(stderr, "--partners must be at most half the group size"
+					" and 1 with --map.\n");
+		usage();
+		err = -1;
+		goto exit;
+	}
+	if (window_depth) {
+		window_size_small = window_size_large = window_depth;
+	}
+	if (window_size_large * num_partners > MAX_REQ_NUM) {
+		if (myid == 0)
+			fprintf(stderr, "--window times --partners must be at most "
+					add_quotes(MAX_REQ_NUM) ".\n");
+		usage();
+		err = -1;
+		goto exit;
+	}
+
+	if (hugepages) {
+		s_buf = alloc_buffer(MAX_MSG_SIZE);
+		r_buf = alloc_buffer(MAX_MSG_SIZE);
+		if (!s_buf || !r_buf) {
+			fprintf(stderr, "%d: Unable to allocate message buffers.\n", myid);
+			err = -1;
+			goto exit;
+		}
+		memset(r_buf,'a',MAX_MSG_SIZE);
+		for(c=0;c<(MAX_MSG_SIZE-PATTERN_SIZE);c+=PATTERN_SIZE)
+			memcpy(s_buf+c,pattern,PATTERN_SIZE);
+	}
+
 	num_groups = num_procs / group_size;
 
 	MPI_Barrier(MPI_COMM_WORLD);
 
-	/* Calculate my partner's rank. */
-	{
+	if (map_file) {
+		/* Calculate partners from the host map on rank 0. */
+		char myname[HOSTNAME_MAXLEN];
+
+		memset(myname, 0, sizeof(myname));
+		gethostname(myname, sizeof(myname) - 1);
+		if (myid == 0) {
+			hostnames = calloc(num_procs, sizeof(*hostnames));
+			partners = malloc(sizeof(int) * num_procs);
+			pair_isl = malloc(sizeof(int) * num_procs);
+			if (!hostnames || !partners || !pair_isl) {
+				fprintf(stderr, "Out of memory.\n");
+				MPI_Abort(MPI_COMM_WORLD, 1);
+			}
+		}
+		MPI_Gather(myname, HOSTNAME_MAXLEN, MPI_CHAR, hostnames,
+				HOSTNAME_MAXLEN, MPI_CHAR, 0, MPI_COMM_WORLD);
+		if (myid == 0) {
+			if (load_map() != 0)
+				err = -1;
+			else if ((num_groups = map_partners(partners)) == 0) {
+				fprintf(stderr, "No %s pairs found using %s.\n",
+					(pairing == PAIRING_LOCAL) ? "local" : "isl", map_file);
+				err = -1;
+			}
+		}
+		MPI_Bcast(&err, 1, MPI_INT, 0, MPI_COMM_WORLD);
+		if (err)
+			goto exit;
+		MPI_Bcast(&num_groups, 1, MPI_INT, 0, MPI_COMM_WORLD);
+		MPI_Scatter(partners, 1, MPI_INT, &partnerid, 1, MPI_INT, 0,
+				MPI_COMM_WORLD);
+	} else {
+		/* Calculate my partner's rank. */
 		int g; // group #
 		int q; // rank within group.
 
@@ -477,6 +1025,26 @@ main(int argc, char *argv[])
 		if (partnerid >= num_procs) partnerid = -1;
 	}
 
+	/* Additional partners are the following ranks in the other half of
+	 * the group, wrapping within the half. */
+	if (partnerid >= 0 || !map_file) {
+		int half = group_size / 2;
+		int g = myid / group_size;
+		int q = myid % group_size;
+		int k, t;
+
+		for (k = 0; k < num_partners; k++) {
+			if (map_file)
+				t = partnerid;
+			else if (q < half)
+				t = g * group_size + half + (q + k) % half;
+			else
+				t = g * group_size + (q - half - k + half) % half;
+			if (t < num_procs)
+				partner_list[partner_count++] = t;
+		}
+	}
+
 	if (partnerid >= 0) 
 	{
 		VERBOSE("%d is partnered with %d.\n", myid, partnerid);
@@ -486,11 +1054,31 @@ main(int argc, char *argv[])
 		VERBOSE("%d has no partner.\n", myid);
 	}
 	
-	MPI_Comm_split(MPI_COMM_WORLD, (myid<partnerid), myid, &mpi_comm_sender);
+	/* rank 0 reports the results so it must be in the sender group even when
+	 * the map left it without a partner. */
+	MPI_Comm_split(MPI_COMM_WORLD, (myid<partnerid) || myid == 0, myid,
+			&mpi_comm_sender);
 	
 	if (myid == 0) {
 		printf("\n\nMPI_GroupStress BIBW Cable Stress Test\n");
-		if (minutes > 0)  {
+		if (map_file)  {
+			printf("%d %s pairs from %s, ", num_groups,
+					(pairing == PAIRING_LOCAL) ? "switch local" : "inter-switch",
+					map_file);
+			if (minutes > 0) {
+				printf("running for %d minutes.\n", minutes);
+				done_time = time(NULL) + minutes*60;
+			} else {
+				printf("running till interrupted.\n");
+				done_time=(time_t)-1;
+			}
+			if (verbose) {
+				int r;
+				for (r = 0; r < num_procs; r++)
+					if (partners[r] > r)
+						print_pair_path(stderr, r);
+			}
+		} else if (minutes > 0)  {
 			printf("%d groups of %d, running for %d minutes.\n", 
 					num_groups, group_size, minutes);
 			done_time = time(NULL) + minutes*60;
@@ -499,6 +1087,11 @@ main(int argc, char *argv[])
 					num_groups, group_size);
 			done_time=(time_t)-1;
 		}
+		if (num_partners > 1 || persistent) {
+			printf("%d partners per rank, window of %d%s.\n", num_partners,
+					window_size_large,
+					persistent ? ", persistent requests" : "");
+		}
 
 		printf("\n# Size\t\tGroup Agg Bandwidth (MB/s)\tMessages/s\tTime Left\n");
 	}
@@ -506,7 +1099,10 @@ main(int argc, char *argv[])
 	do {
 		for (size = min_msg_size; size <= max_msg_size; size *= 2) 
 		{
-			bw = find_bibw(myid, partnerid, size, s_buf, r_buf);
+			if (num_partners > 1 || persistent)
+				bw = find_bibw_windowed(size, s_buf, r_buf);
+			else
+				bw = find_bibw(myid, partnerid, size, s_buf, r_buf);
 			if (myid == 0) 
 			{
 				double rate = 1000*1000*bw/size;
@@ -530,6 +1126,8 @@ main(int argc, char *argv[])
 					fflush(stdout);
 				}
 			}
+			if (map_file)
+				report_slowest_pair();
 		}
 		if (myid == 0) {
 			if (min_msg_size != max_msg_size) {
@@ -85,6 +85,7 @@ are performing, it is not intended as a benchmark.
 #include <math.h>
 #include <time.h>
 #include <assert.h>
+#include <sys/mman.h>
 
 #define	 stringize(x) #x
 #define	 add_quotes(x) stringize(x)
@@ -111,6 +112,10 @@ static	 int minutes = DEFAULT_MINUTES; // how long the test should run.
 static	 int verbose = 0; // noisy output
 static	 int size = MIN_MSG_SIZE;
 static   int csv = 0; // generate CSV file
+static   int persistent = 0; // use persistent requests
+static   int hugepages = 0; // allocate buffers in huge pages
+static   int histogram = 0; // time every iteration
+static   int tail_pct = 50; // p99 growth flagged as a regression
 
 static	 int num_procs;	 // how many processes in the job?
 static	 int my_id;	   // my rank.
@@ -158,6 +163,134 @@ static	 double *latency;
 static	 unsigned long psize;
 static	 unsigned long csize;
 
+/*
+ * Per iteration latency histogram, in nanoseconds one way. Buckets are
+ * log linear: four per power of two, so any value is within 25% of its
+ * bucket's lower bound. Only senders record, rank 0 keeps the totals for
+ * the current pass through all pairs and the first p99 of every pair,
+ * against which later passes are compared.
+ */
+#define  HIST_SUB_BITS 2
+#define  HIST_SUB (1<<HIST_SUB_BITS)
+#define  HIST_BUCKETS (64*HIST_SUB)
+#define  HUGEPAGE_SIZE (2*1024*1024)
+
+static	 unsigned long hist[HIST_BUCKETS];
+static	 unsigned long pass_hist[HIST_BUCKETS]; // rank 0 only
+static	 double *tail;		// per rank p99 this iteration, rank 0 only
+static	 float *tail_base;	// per pair first p99, rank 0 only
+static	 int regressions;
+
+static int
+hist_bucket(unsigned long long ns)
+{
+	int msb;
+
+	if (ns < HIST_SUB)
+		return ns;
+	msb = 63 - __builtin_clzll(ns);
+	return (msb - HIST_SUB_BITS + 1) * HIST_SUB +
+		((ns >> (msb - HIST_SUB_BITS)) & (HIST_SUB - 1));
+}
+
+// lowest value, in nanoseconds, which falls in bucket b
+static double
+hist_value(int b)
+{
+	int shift;
+
+	if (b < HIST_SUB)
+		return b;
+	shift = b / HIST_SUB - 1;
+	return (double)((unsigned long long)(HIST_SUB + b % HIST_SUB) << shift);
+}
+
+// upper bound of the bucket holding the given fraction of samples, in usec
+static double
+hist_percentile(unsigned long *h, double fraction)
+{
+	unsigned long total = 0, count = 0;
+	int b;
+
+	for (b = 0; b < HIST_BUCKETS; b++)
+		total += h[b];
+	if (!total)
+		return 0.0;
+	for (b = 0; b < HIST_BUCKETS - 1; b++) {
+		count += h[b];
+		if (count >= fraction * total)
+			break;
+	}
+	return hist_value(b + 1) / 1000.0;
+}
+
+static void
+show_histogram(unsigned long *h)
+{
+	unsigned long total = 0;
+	int b;
+
+	for (b = 0; b < HIST_BUCKETS; b++)
+		total += h[b];
+	if (!total)
+		return;
+	printf("Latency Histogram (usec, one way):\n");
+	for (b = 0; b < HIST_BUCKETS; b++) {
+		if (h[b])
+			printf("%10.3f - %10.3f\t%10lu\t%6.2f%%\n",
+				hist_value(b) / 1000.0, hist_value(b + 1) / 1000.0,
+				h[b], 100.0 * h[b] / total);
+	}
+	printf("P50/P99/P99.9:\t%0.2f\t%0.2f\t%0.2f\n",
+		hist_percentile(h, 0.50), hist_percentile(h, 0.99),
+		hist_percentile(h, 0.999));
+}
+
+// compare each pair's p99 this iteration against its first pass
+static void
+check_tail(int ranks)
+{
+	int i;
+
+	for (i = 0; i < ranks; i++) {
+		int s = pair_list[i].sender;
+		int r = pair_list[i].receiver;
+		float *base;
+
+		if (s != i || tail[i] <= 0.0)
+			continue;
+		base = &tail_base[(s < r) ? (s * ranks + r) : (r * ranks + s)];
+		if (*base == 0.0) {
+			*base = tail[i];
+		} else if (tail[i] > *base * (1.0 + tail_pct / 100.0)) {
+			regressions++;
+			printf("Tail Regression:\n%"add_quotes(MAX_HOST_LEN)"s -> %"add_quotes(MAX_HOST_LEN)"s\tp99 %0.2f (was %0.2f)\n",
+				host_list[s].name, host_list[r].name, tail[i], *base);
+			fflush(stdout);
+		}
+	}
+}
+
+// allocate a message buffer in huge pages, falling back to aligned memory
+static char *
+alloc_buffer(size_t size)
+{
+	void *buf = NULL;
+
+#ifdef MAP_HUGETLB
+	size_t len = (size + HUGEPAGE_SIZE - 1) / HUGEPAGE_SIZE * HUGEPAGE_SIZE;
+
+	buf = mmap(NULL, len, PROT_READ|PROT_WRITE,
+			MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+	if (buf != MAP_FAILED)
+		return buf;
+	RANK0("Huge pages unavailable, using aligned buffers.\n");
+#endif
+	if (posix_memalign(&buf, getpagesize(), size) != 0)
+		return NULL;
+	return buf;
+}
+
 static void
 dump_checked(int ranks)
 {
@@ -250,13 +383,14 @@ find_latency(int ranks, int size, char *s_buf, char *r_buf,
 	MPI_Status reqstat;
 	MPI_Comm mpi_comm_sender;
 	MPI_Request request1, request2;
+	MPI_Request send_req, recv_req;
 	int partner;
 	double lat;
 	double summary_f[3];
 	int	   summary_i[2];
 	int sender_id;
 
-	double t_start = 0.0, t_end = 0.0;
+	double t_start = 0.0, t_end = 0.0, t_iter = 0.0;
 
 	//VERBOSE("%d @ find_latency(%d, %d, %p, %p)\n",
 	//		my_id, ranks, size, s_buf, r_buf);
@@ -280,14 +414,52 @@ find_latency(int ranks, int size, char *s_buf, char *r_buf,
 	}
 	
 //	VERBOSE("%d @ barrier.\n", my_id);
+	memset(hist, 0, sizeof(hist));
+	if (persistent && partner >= 0) {
+		MPI_Send_init(s_buf, size, MPI_CHAR, partner, TAG_BASIC,
+					  MPI_COMM_WORLD, &send_req);
+		MPI_Recv_init(r_buf, size, MPI_CHAR, partner, TAG_BASIC,
+					  MPI_COMM_WORLD, &recv_req);
+	}
+
 	MPI_Barrier(MPI_COMM_WORLD);
 	
-	if (pair_list[my_id].sender == my_id) {
+	if (pair_list[my_id].sender == my_id && persistent) {
+		MPI_Comm_split(MPI_COMM_WORLD, 1, my_id, &mpi_comm_sender);
+		for (i = 0; i < loop + skip; i++) {
+			if (i == skip)
+				t_start = MPI_Wtime();
+			if (histogram)
+				t_iter = MPI_Wtime();
+			MPI_Start(&recv_req);
+			MPI_Start(&send_req);
+			MPI_Wait(&send_req, MPI_STATUS_IGNORE);
+			MPI_Wait(&recv_req, &reqstat);
+			if (histogram && i >= skip)
+				hist[hist_bucket((MPI_Wtime() - t_iter) * 0.5e9)]++;
+		}
+		t_end = MPI_Wtime();
+
+	} else if (pair_list[my_id].receiver == my_id && persistent) {
+		MPI_Comm_split(MPI_COMM_WORLD, 2, my_id, &mpi_comm_sender);
+		MPI_Start(&recv_req);
+		for (i = 0; i < loop + skip; i++) {
+			MPI_Wait(&recv_req, &reqstat);
+			MPI_Start(&send_req);
+			MPI_Wait(&send_req, MPI_STATUS_IGNORE);
+			// post the next receive before our partner can send it
+			if (i + 1 < loop + skip)
+				MPI_Start(&recv_req);
+		}
+
+	} else if (pair_list[my_id].sender == my_id) {
 //		VERBOSE("%d @ sending.\n", my_id);
 		MPI_Comm_split(MPI_COMM_WORLD, 1, my_id, &mpi_comm_sender);
 		for (i = 0; i < loop + skip; i++) {
 			if (i == skip)
 				t_start = MPI_Wtime();
+			if (histogram)
+				t_iter = MPI_Wtime();
 			MPI_Send(s_buf, 
 					 size, 
 					 MPI_CHAR, 
@@ -301,6 +473,8 @@ find_latency(int ranks, int size, char *s_buf, char *r_buf,
 					 TAG_BASIC, 
 					 MPI_COMM_WORLD,
 					 &reqstat);
+			if (histogram && i >= skip)
+				hist[hist_bucket((MPI_Wtime() - t_iter) * 0.5e9)]++;
 		}
 		t_end = MPI_Wtime();
 	
@@ -326,6 +500,11 @@ find_latency(int ranks, int size, char *s_buf, char *r_buf,
 		MPI_Comm_split(MPI_COMM_WORLD, 3, my_id, &mpi_comm_sender);
 	}
 
+	if (persistent && partner >= 0) {
+		MPI_Request_free(&send_req);
+		MPI_Request_free(&recv_req);
+	}
+
 //	VERBOSE("%d @ collectives.\n", my_id);
 	
 	if (pair_list[my_id].sender == my_id) {
@@ -420,18 +599,37 @@ find_latency(int ranks, int size, char *s_buf, char *r_buf,
 		*max_rank = summary_i[1];
 	}
 
+	if (histogram) {
+		double p99 = (pair_list[my_id].sender == my_id) ?
+						hist_percentile(hist, 0.99) : -1.0;
+		unsigned long iter_hist[HIST_BUCKETS];
+
+		MPI_Gather(&p99, 1, MPI_DOUBLE, tail, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+		MPI_Reduce(hist, iter_hist, HIST_BUCKETS, MPI_UNSIGNED_LONG, MPI_SUM,
+				0, MPI_COMM_WORLD);
+		if (my_id == 0) {
+			for (i = 0; i < HIST_BUCKETS; i++)
+				pass_hist[i] += iter_hist[i];
+			check_tail(ranks);
+		}
+	}
+
 	MPI_Barrier(MPI_COMM_WORLD);
 	MPI_Comm_free(&mpi_comm_sender);
 
 	//VERBOSE("%d @ done.\n", my_id);
 }
 
-static char *short_options = "s:vt:ch";
+static char *short_options = "s:vt:cpHgT:h";
 static struct option long_options[] = {
 	{ .name = "verbose", .has_arg = 0, .val = 'v' },
 	{ .name = "size", .has_arg = 0, .val = 's' },
 	{ .name = "time", .has_arg = 1, .val = 't' },
 	{ .name = "csv", . has_arg = 0, .val = 'c' },
+	{ .name = "persistent", .has_arg = 0, .val = 'p' },
+	{ .name = "hugepages", .has_arg = 0, .val = 'H' },
+	{ .name = "histogram", .has_arg = 0, .val = 'g' },
+	{ .name = "tail", .has_arg = 1, .val = 'T' },
 	{ .name = "help", .has_arg = 0, .val = 'h' },
 	{ 0 }
 };
@@ -442,6 +640,10 @@ static char *usage_text[] = {
 	"The duration of the test, in minutes. Defaults to "
 		add_quotes(DEFAULT_MINUTES) " minutes or use -1 to run forever.",
 	"Outputs raw data in a CSV file format, suitable for use in Excel.",
+	"Use persistent requests (MPI_Send_init/MPI_Recv_init).",
+	"Allocate message buffers in huge pages, if available.",
+	"Time every iteration, report a latency histogram and flag tail regressions.",
+	"Percent p99 growth over a pair's first pass flagged as a tail regression. Defaults to 50.",
 	"Provides this help text.",
 	0
 };
@@ -538,6 +740,28 @@ main(int argc, char *argv[])
 			case 'c': 
 				csv = 1;
 				break;
+
+			case 'p':
+				persistent = 1;
+				break;
+
+			case 'H':
+				hugepages = 1;
+				break;
+
+			case 'g':
+				histogram = 1;
+				break;
+
+			case 'T':
+				tail_pct = strtol(optarg, NULL, 0);
+				if (tail_pct <= 0) {
+					usage();
+					err = -1;
+					goto exit;
+				}
+				break;
+
 			case 'h':
 			default:
 				usage();
@@ -561,6 +785,27 @@ main(int argc, char *argv[])
 		err = -1;
 		goto exit;
 	}
+
+	if (histogram && my_id == 0) {
+		tail = malloc(sizeof(double)*num_procs);
+		tail_base = calloc((size_t)num_procs*num_procs, sizeof(float));
+		if (!tail || !tail_base) {
+			fprintf(stderr,"malloc failed.\n");
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+	}
+
+	if (hugepages) {
+		s_buf = alloc_buffer(MY_BUF_SIZE);
+		r_buf = alloc_buffer(MY_BUF_SIZE);
+		if (!s_buf || !r_buf) {
+			fprintf(stderr,"%d: buffer allocation failed.\n", my_id);
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+		memset(r_buf,'a',MY_BUF_SIZE);
+		for(c=0;c<(MAX_MSG_SIZE-PATTERN_SIZE);c+=PATTERN_SIZE)
+			memcpy(s_buf+c,pattern,PATTERN_SIZE);
+	}
 	
 	// Broadcast the hostnames.
 	{
@@ -605,6 +850,7 @@ main(int argc, char *argv[])
 		round_max = 0.0;
 		round_min = 99999999.0;
 		num_pairs = 1;
+		memset(pass_hist, 0, sizeof(pass_hist));
 
 		for (i=1; num_pairs > 0; i++) {
 			if (my_id == 0) {
@@ -682,6 +928,8 @@ main(int argc, char *argv[])
 						host_list[round_slowest.receiver].name,
 						round_max);
 				}
+				if (histogram)
+					show_histogram(pass_hist);
 			} 
 			done = (minutes > 0) && (done_time < time(NULL));
 		}
@@ -693,6 +941,8 @@ main(int argc, char *argv[])
 		fprintf(stderr,"Msg Size:\t%d\n",size);
 		fprintf(stderr,"Final Min:\t%0.2f\n",final_min);
 		fprintf(stderr,"Final Max:\t%0.2f\n",final_max);
+		if (histogram)
+			fprintf(stderr,"Tail Regressions:\t%d\n",regressions);
 	}
 
 exit:
@@ -36,6 +36,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *
  * The code is deliberately written to be inefficient; in order to (hopefully)
  * expose communication errors and memory corruption issues.
+ *
+ * The buffer handling itself, however, is kept fast (word at a time pattern
+ * fill and compare, optional CRC32C verification) so that large messages can
+ * be checked at close to line rate when used as a data integrity soak test.
  */
 
 #include <stdio.h>
@@ -45,6 +49,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <getopt.h>
 #include <mpi.h>
 #include <time.h>
+#include <stdint.h>
 
 /* 
  * Defines used by randomize test.
@@ -91,6 +96,7 @@ unsigned int rawBufferCount = 1;
 unsigned int barrierSize = 4096;	/* Default - 4k protection areas. */
 
 int verboseMode = 0;
+int useChecksum = 0;	/* Default - compare against a model buffer. */
 int doFast = 0;
 int doSlow = 1;
 int doRandom = 1;
@@ -110,6 +116,7 @@ struct option options[] = {
 	{"norandom", no_argument, &doRandom, 0},
 	{"seed", required_argument, NULL, 's'},
 	{"sendoffset", no_argument, &useSendOffset, 1},
+	{"checksum", no_argument, &useChecksum, 1},
 	{"help", no_argument, NULL, 'h'},
 	{NULL, 0, NULL, 0}
 };
@@ -157,6 +164,217 @@ dumpbuffer( int myid, char *name, char *buffer, int size )
 	fclose( f );
 }
 
+/* 
+ * Fills a buffer with the ring test pattern; byte i holds i % 256.
+ * The first 256 bytes are built directly and then repeatedly doubled
+ * with memcpy, which keeps the pattern aligned and lets the C library
+ * use its widest copy loops.
+ */
+void
+fillPattern( char *buffer, size_t size )
+{
+	size_t i, n;
+
+	for ( i = 0; i < size && i < 256; i++ )
+		buffer[i] = ( unsigned char ) i;
+
+	for ( n = i; n < size; n *= 2 )
+		memcpy( buffer + n, buffer, MIN( n, size - n ) );
+}
+
+/* 
+ * Returns true if every byte of the area holds value.
+ */
+int
+guardIntact( const char *buffer, size_t size, int value )
+{
+	uint64_t word, expected;
+	size_t i = 0;
+
+	memset( &expected, value, sizeof( expected ) );
+	for ( ; i + sizeof( word ) <= size; i += sizeof( word ) ) {
+		memcpy( &word, buffer + i, sizeof( word ) );
+		if ( word != expected )
+			return 0;
+	}
+	for ( ; i < size; i++ ) {
+		if ( buffer[i] != ( char ) value )
+			return 0;
+	}
+	return 1;
+}
+
+/* 
+ * Second pass over a buffer known to be bad. Compares 64 bits at a time
+ * from each end to find the first and last corrupted bytes.
+ */
+void
+findCorruption( const char *expected, const char *actual, size_t size,
+				size_t * first, size_t * last )
+{
+	uint64_t a, b;
+	size_t i = 0, j = size;
+
+	while ( i + sizeof( a ) <= size ) {
+		memcpy( &a, expected + i, sizeof( a ) );
+		memcpy( &b, actual + i, sizeof( b ) );
+		if ( a != b )
+			break;
+		i += sizeof( a );
+	}
+	while ( i < size && expected[i] == actual[i] )
+		i++;
+
+	while ( j >= i + sizeof( a ) ) {
+		memcpy( &a, expected + j - sizeof( a ), sizeof( a ) );
+		memcpy( &b, actual + j - sizeof( b ), sizeof( b ) );
+		if ( a != b )
+			break;
+		j -= sizeof( a );
+	}
+	while ( j > i && expected[j - 1] == actual[j - 1] )
+		j--;
+
+	*first = i;
+	*last = j ? j - 1 : 0;
+}
+
+/* 
+ * CRC32C (Castagnoli), used by --checksum so that received messages can be
+ * validated without building a model buffer on every rank. The SSE4.2
+ * crc32 instruction is used when the CPU has it, otherwise a slicing by 8
+ * table lookup.
+ */
+#define CRC32C_POLY 0x82F63B78
+
+static uint32_t crc32cTable[8][256];
+static uint32_t ( *crc32cUpdate ) ( uint32_t crc, const unsigned char *buf,
+									size_t len );
+
+static uint32_t
+crc32cSoft( uint32_t crc, const unsigned char *buf, size_t len )
+{
+	uint64_t word;
+
+	while ( len && ( ( uintptr_t ) buf & 7 ) ) {
+		crc = crc32cTable[0][( crc ^ *buf++ ) & 0xff] ^ ( crc >> 8 );
+		len--;
+	}
+	while ( len >= 8 ) {
+		memcpy( &word, buf, sizeof( word ) );
+		word ^= crc;
+		crc = crc32cTable[7][word & 0xff] ^
+			crc32cTable[6][( word >> 8 ) & 0xff] ^
+			crc32cTable[5][( word >> 16 ) & 0xff] ^
+			crc32cTable[4][( word >> 24 ) & 0xff] ^
+			crc32cTable[3][( word >> 32 ) & 0xff] ^
+			crc32cTable[2][( word >> 40 ) & 0xff] ^
+			crc32cTable[1][( word >> 48 ) & 0xff] ^
+			crc32cTable[0][word >> 56];
+		buf += 8;
+		len -= 8;
+	}
+	while ( len-- )
+		crc = crc32cTable[0][( crc ^ *buf++ ) & 0xff] ^ ( crc >> 8 );
+	return crc;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+__attribute__ ( ( target( "sse4.2" ) ) )
+static uint32_t
+crc32cHw( uint32_t crc, const unsigned char *buf, size_t len )
+{
+	uint64_t crc64, word;
+
+	while ( len && ( ( uintptr_t ) buf & 7 ) ) {
+		crc = __builtin_ia32_crc32qi( crc, *buf++ );
+		len--;
+	}
+	crc64 = crc;
+	while ( len >= 8 ) {
+		memcpy( &word, buf, sizeof( word ) );
+		crc64 = __builtin_ia32_crc32di( crc64, word );
+		buf += 8;
+		len -= 8;
+	}
+	crc = ( uint32_t ) crc64;
+	while ( len-- )
+		crc = __builtin_ia32_crc32qi( crc, *buf++ );
+	return crc;
+}
+#endif
+
+void
+crc32cInit( void )
+{
+	uint32_t crc;
+	int i, j;
+
+	for ( i = 0; i < 256; i++ ) {
+		crc = i;
+		for ( j = 0; j < 8; j++ )
+			crc = ( crc >> 1 ) ^ ( ( crc & 1 ) ? CRC32C_POLY : 0 );
+		crc32cTable[0][i] = crc;
+	}
+	for ( i = 0; i < 256; i++ ) {
+		for ( j = 1; j < 8; j++ )
+			crc32cTable[j][i] = crc32cTable[0][crc32cTable[j - 1][i] & 0xff] ^
+				( crc32cTable[j - 1][i] >> 8 );
+	}
+
+	crc32cUpdate = crc32cSoft;
+#if defined(__x86_64__) && defined(__GNUC__)
+	if ( __builtin_cpu_supports( "sse4.2" ) )
+		crc32cUpdate = crc32cHw;
+#endif
+}
+
+uint32_t
+crc32c( const char *buffer, size_t size )
+{
+	return ~crc32cUpdate( ~0U, ( const unsigned char * ) buffer, size );
+}
+
+/* 
+ * Validates a received ring buffer, including its guard areas. The data
+ * starts dataOffset bytes into the raw buffers. By default the received
+ * raw buffer is compared against the model in rawSendBuffer; in checksum
+ * mode only the CRC32C of the data and the guard areas are checked, and
+ * the model is built only if that fails so the bad range can be located.
+ */
+int
+verifyBuffer( int myid, int size, char *rawSendBuffer, char *rawRecvBuffer,
+			  size_t rawBufferSize, size_t dataOffset, uint32_t expectedCrc )
+{
+	size_t first, last;
+
+	if ( useChecksum ) {
+		if ( crc32c( rawRecvBuffer + dataOffset, size ) == expectedCrc
+			 && guardIntact( rawRecvBuffer, dataOffset, myid )
+			 && guardIntact( rawRecvBuffer + dataOffset + size,
+							 rawBufferSize - dataOffset - size, myid ) )
+			return MPI_SUCCESS;
+
+		memset( rawSendBuffer, myid, rawBufferSize );
+		fillPattern( rawSendBuffer + dataOffset, size );
+	} else if ( !memcmp( rawSendBuffer, rawRecvBuffer, rawBufferSize ) ) {
+		return MPI_SUCCESS;
+	}
+
+	ERRPRINT( "%d byte messages do not match!\n", size );
+	findCorruption( rawSendBuffer, rawRecvBuffer, rawBufferSize, &first,
+					&last );
+	ERRPRINT( "Corrupted bytes %ld to %ld of the message (%lu bytes)%s\n",
+			  ( long ) first - ( long ) dataOffset,
+			  ( long ) last - ( long ) dataOffset,
+			  ( unsigned long ) ( last - first + 1 ),
+			  ( first < dataOffset || last >= dataOffset + size ) ?
+			  ", including guard area" : "" );
+	dumpbuffer( myid, "rawSendBuffer", rawSendBuffer, rawBufferSize );
+	dumpbuffer( myid, "rawRecvBuffer", rawRecvBuffer, rawBufferSize );
+	return ~MPI_SUCCESS;
+}
+
 typedef struct {
 	unsigned int start;
 	unsigned int length;
@@ -220,10 +438,17 @@ randomize( int myid, int numProcs, int minSize, int maxSize, int maxIters, unsig
 			if ( sendMode ) {
 				/* Initialize the buffer with some random data. */
 				/* Every 4th byte is a check sum of the previous 3. */
+				/* rand() only seeds a xorshift generator per buffer,
+				 * one call per byte was the bulk of the run time. */
+				uint64_t x = ( ( uint64_t ) rand(  ) << 32 ) | rand(  ) | 1;
+
 				for ( i = 0; i < ( size - 3 ); i += 4 ) {
-					buffer[i] = rand(  ) % 256;
-					buffer[i + 1] = rand(  ) % 256;
-					buffer[i + 2] = rand(  ) % 256;
+					x ^= x << 13;
+					x ^= x >> 7;
+					x ^= x << 17;
+					buffer[i] = x;
+					buffer[i + 1] = x >> 8;
+					buffer[i + 2] = x >> 16;
 					buffer[i + 3] =
 						( buffer[i] + buffer[i + 1] + buffer[i + 2] ) % 256;
 				}
@@ -321,17 +546,34 @@ randomize( int myid, int numProcs, int minSize, int maxSize, int maxIters, unsig
 			}
 
 			/* Check for corruption. */
+			/* The first pass has no early exit so it vectorizes, only a
+			 * bad buffer is scanned again to find the corrupted range. */
 			if ( !sendMode ) {
+				unsigned char bad = 0;
+
 				for ( i = 0; i < ( size - 3 ); i += 4 ) {
-					unsigned char c =
-						( buffer[i] + buffer[i + 1] + buffer[i + 2] ) % 256;
-					if ( c != buffer[i + 3] ) {
-						ERRPRINT( "Corruption in the buffer @ %d\n", i );
-						dumpbuffer( myid, "rawBuffer", (char*)rawBuffer,
-									size + 2 * BARRIERSIZE );
-						retCode = ~MPI_SUCCESS;
-						goto done;
+					bad |= ( unsigned char ) ( buffer[i] + buffer[i + 1] +
+											   buffer[i + 2] - buffer[i + 3] );
+				}
+				if ( bad ) {
+					int first = -1, last = -1;
+
+					for ( i = 0; i < ( size - 3 ); i += 4 ) {
+						unsigned char c =
+							( buffer[i] + buffer[i + 1] + buffer[i + 2] ) % 256;
+						if ( c != buffer[i + 3] ) {
+							if ( first < 0 )
+								first = i;
+							last = i + 3;
+						}
 					}
+					ERRPRINT( "Corruption in the buffer @ %d\n", first );
+					ERRPRINT( "Corrupted range is bytes %d to %d\n", first,
+							  last );
+					dumpbuffer( myid, "rawBuffer", (char*)rawBuffer,
+								size + 2 * BARRIERSIZE );
+					retCode = ~MPI_SUCCESS;
+					goto done;
 				}
 			}
 
@@ -449,6 +691,7 @@ slowRing( int myid, int numProcs, int minSize, int maxSize, int maxIters )
 {
 	unsigned int i, size, iters, round;
 	int retCode = MPI_SUCCESS;
+	uint32_t expectedCrc = 0;
 
 	MPI_Request *request = NULL;
 	MPI_Status *status = NULL;
@@ -533,8 +776,18 @@ slowRing( int myid, int numProcs, int minSize, int maxSize, int maxIters )
 			memset( currentRawRecvBuffer, myid, rawBufferSize );
 
 			/* Create some data to send and validate against. */
-			for ( i = 0; i < size; i++ )
-				sendBuffer[i] = ( unsigned char ) ( i % 256 );
+			/* With --checksum, only the root needs the data. */
+			if ( myid == 0 || !useChecksum )
+				fillPattern( sendBuffer, size );
+
+			/* The root shares the checksum of what it sends. */
+			if ( useChecksum && round == 0 ) {
+				if ( myid == 0 )
+					expectedCrc = crc32c( sendBuffer, size );
+				retCode = MPI_Bcast( &expectedCrc, 1, MPI_UNSIGNED, 0,
+									 MPI_COMM_WORLD );
+				ERRABORT( retCode );
+			}
 
 			if ( myid == 0 ) {
 				/* Root initiates the loop and vets the results. */
@@ -554,16 +807,12 @@ slowRing( int myid, int numProcs, int minSize, int maxSize, int maxIters )
 									round, MPI_COMM_WORLD, status );
 				ERRABORT( retCode );
 
-				if ( memcmp( currentRawSendBuffer,
-							 currentRawRecvBuffer, rawBufferSize ) ) {
-					ERRPRINT( "%d byte messages do not match!\n", size );
-					dumpbuffer( myid, "rawSendBuffer", currentRawSendBuffer,
-								rawBufferSize );
-					dumpbuffer( myid, "rawRecvBuffer", currentRawRecvBuffer,
-								rawBufferSize );
-					retCode = ~MPI_SUCCESS;
+				retCode = verifyBuffer( myid, size, currentRawSendBuffer,
+										currentRawRecvBuffer, rawBufferSize,
+										recvBuffer - currentRawRecvBuffer,
+										expectedCrc );
+				if ( retCode != MPI_SUCCESS )
 					goto done;
-				}
 			} else {
 				/* Everyone else waits for a message and then repeats it to
 				 * their neighbor. */
@@ -586,16 +835,12 @@ slowRing( int myid, int numProcs, int minSize, int maxSize, int maxIters )
 				 * be a correct model of what we actually received then 
 				 * sent.
 				 */
-				if ( memcmp( currentRawSendBuffer,
-							 currentRawRecvBuffer, rawBufferSize ) ) {
-					ERRPRINT( "%d byte messages do not match!\n", size );
-					dumpbuffer( myid, "rawSendBuffer", currentRawSendBuffer,
-								rawBufferSize );
-					dumpbuffer( myid, "rawRecvBuffer", currentRawRecvBuffer,
-								rawBufferSize );
-					retCode = ~MPI_SUCCESS;
+				retCode = verifyBuffer( myid, size, currentRawSendBuffer,
+										currentRawRecvBuffer, rawBufferSize,
+										recvBuffer - currentRawRecvBuffer,
+										expectedCrc );
+				if ( retCode != MPI_SUCCESS )
 					goto done;
-				}
 			}
 
 			if ( !verboseMode && ( round % 100 ) == 0 )
@@ -647,6 +892,7 @@ fastRing( int myid, int numProcs, int minSize, int maxSize, int maxIters )
 {
 	unsigned int i, j, size, iters, round;
 	int retCode = MPI_SUCCESS;
+	uint32_t expectedCrc = 0;
 
 	MPI_Request *request = NULL;
 	MPI_Status *status = NULL;
@@ -711,8 +957,14 @@ fastRing( int myid, int numProcs, int minSize, int maxSize, int maxIters )
 				sendBuffer = currentRawSendBuffer + barrierSize;
 
 				/* Create some data to send and validate against. */
-				for ( i = 0; i < size; i++ )
-					sendBuffer[i] = ( unsigned char ) ( i % 256 );
+				fillPattern( sendBuffer, size );
+			}
+
+			if ( useChecksum ) {
+				expectedCrc = crc32c( rawSendBuffer[0] + barrierSize, size );
+				retCode = MPI_Bcast( &expectedCrc, 1, MPI_UNSIGNED, 0,
+									 MPI_COMM_WORLD );
+				ERRABORT( retCode );
 			}
 
 			for ( round = 0; round < iters; round+= rawBufferCount ) {
@@ -752,16 +1004,12 @@ fastRing( int myid, int numProcs, int minSize, int maxSize, int maxIters )
 										&(status[round+j]) );
 					ERRABORT( retCode );
 
-					if ( memcmp( currentRawSendBuffer, currentRawRecvBuffer,
-							 rawBufferSize ) ) {
-						ERRPRINT( "%d byte messages do not match!\n", size );
-						dumpbuffer( myid, "rawSendBuffer", currentRawSendBuffer,
-									rawBufferSize );
-						dumpbuffer( myid, "rawRecvBuffer", currentRawRecvBuffer,
-									rawBufferSize );
-						retCode = ~MPI_SUCCESS;
+					retCode = verifyBuffer( myid, size, currentRawSendBuffer,
+											currentRawRecvBuffer, rawBufferSize,
+											recvBuffer - currentRawRecvBuffer,
+											expectedCrc );
+					if ( retCode != MPI_SUCCESS )
 						goto done;
-					}
 
 					if ( !verboseMode && ( (round+j) % 100 ) == 0 )
 							ROOTPRINT( "." );
@@ -774,6 +1022,12 @@ fastRing( int myid, int numProcs, int minSize, int maxSize, int maxIters )
 			if ((iters % rawBufferCount) != 0) 
 				iters2 += (rawBufferCount - (iters % rawBufferCount));
 
+			if ( useChecksum ) {
+				retCode = MPI_Bcast( &expectedCrc, 1, MPI_UNSIGNED, 0,
+									 MPI_COMM_WORLD );
+				ERRABORT( retCode );
+			}
+
 			/* Everyone else waits for a message and then repeats it to their
 			 * neighbor. */
 			for ( round = 0; round < iters2; round++ ) {
@@ -792,8 +1046,8 @@ fastRing( int myid, int numProcs, int minSize, int maxSize, int maxIters )
 				memset( currentRawRecvBuffer, myid, rawBufferSize );
 
 				/* Create some data to send and validate against. */
-				for ( i = 0; i < size; i++ )
-					sendBuffer[i] = ( unsigned char ) ( i % 256 );
+				if ( !useChecksum )
+					fillPattern( sendBuffer, size );
 
 				NODEPRINT( "W node %d\n", myid - 1 );
 				retCode = MPI_Recv( recvBuffer,
@@ -814,16 +1068,12 @@ fastRing( int myid, int numProcs, int minSize, int maxSize, int maxIters )
 				 * be a correct model of what we actually received then 
 				 * sent.
 				 */
-				if ( memcmp( currentRawSendBuffer,
-							 currentRawRecvBuffer, rawBufferSize ) ) {
-					ERRPRINT( "%d byte messages do not match!\n", size );
-					dumpbuffer( myid, "rawSendBuffer", currentRawSendBuffer,
-								rawBufferSize );
-					dumpbuffer( myid, "rawRecvBuffer", currentRawRecvBuffer,
-								rawBufferSize );
-					retCode = ~MPI_SUCCESS;
+				retCode = verifyBuffer( myid, size, currentRawSendBuffer,
+										currentRawRecvBuffer, rawBufferSize,
+										recvBuffer - currentRawRecvBuffer,
+										expectedCrc );
+				if ( retCode != MPI_SUCCESS )
 					goto done;
-				}
 			}
 		}
 		ROOTPRINT( "\t%8d\n", size );
@@ -923,7 +1173,10 @@ main( int argc, char *argv[] )
 	ROOTPRINT( "Maximum # of rounds  = %d\n\n", maxIters );
 	ROOTPRINT( "Use Message Send Offset = %s\n", useSendOffset ? "ON" : "OFF" );
 	ROOTPRINT( "Message Buffer Count    = %d\n", rawBufferCount );
-	ROOTPRINT( "Message Barrier Size    = %d\n\n", barrierSize );
+	ROOTPRINT( "Message Barrier Size    = %d\n", barrierSize );
+	ROOTPRINT( "Verify by Checksum      = %s\n\n", useChecksum ? "ON" : "OFF" );
+
+	crc32cInit(  );
 
 	if ( doSlow ) {
 		MPI_Barrier( MPI_COMM_WORLD );
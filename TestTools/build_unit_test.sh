@@ -0,0 +1,68 @@
+#!/bin/bash
+# BEGIN_ICS_COPYRIGHT8 ****************************************
+#
+# Copyright (c) 2023, Intel Corporation
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+#     * Redistributions of source code must retain the above copyright notice,
+#       this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#     * Neither the name of Intel Corporation nor the names of its contributors
+#       may be used to endorse or promote products derived from this software
+#       without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# END_ICS_COPYRIGHT8   ****************************************
+
+#[ICS VERSION STRING: unknown]
+
+# Build a unit test against the IbAccess headers, staged the way they are
+# installed as iba/ and iba/public/.
+# Usage: build_unit_test.sh binary test.c [source.c|-Idir]...
+# Additional sources and -I options are passed to the compiler.
+# CC and CFLAGS may be set in the environment, e.g.
+#	CFLAGS="-O1 -g -fsanitize=address,undefined"
+
+if [ $# -lt 2 ]
+then
+	echo "Usage: build_unit_test.sh binary test.c [source.c|-Idir]..." >&2
+	exit 2
+fi
+
+TESTDIR=$(cd $(dirname $0) && pwd)
+TOPDIR=$(cd $TESTDIR/.. && pwd)
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:--O2 -g}
+
+tempdir=$(mktemp -d /tmp/build_unit_test.XXXXXX) || exit 1
+trap "rm -rf $tempdir" EXIT
+
+mkdir -p $tempdir/iba/public
+# later directories override earlier ones
+for dir in Common/Inc UserCommon/Inc UserLinux/Inc
+do
+	cp $TOPDIR/IbAccess/$dir/*.h $tempdir/iba/
+done
+for dir in Common/Public UserLinux/Public
+do
+	cp $TOPDIR/IbAccess/$dir/*.h $tempdir/iba/public/
+done
+
+$CC $CFLAGS -Wall -DLINUX -Dlinux -D__LINUX__ \
+	-D_UNUSED_="__attribute__((unused))" -D_FALLTHRU_="__attribute__((fallthrough))" \
+	-I$tempdir -I$tempdir/iba -I$tempdir/iba/public \
+	-o "$@"
@@ -0,0 +1,193 @@
+/* BEGIN_ICS_COPYRIGHT7 ****************************************
+
+Copyright (c) 2023, Intel Corporation
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+** END_ICS_COPYRIGHT7   ****************************************/
+
+/* [ICS VERSION STRING: unknown] */
+
+// Checks the PL_MEMORY PrintDest_t from IbPrint/ibprint.c
+// Built and run by test_print_dest.sh.
+//
+// The same lines are printed to a PL_FILE dest and to PL_MEMORY dests with
+// a small initial buffer, so the buffer has to grow several times, including
+// for a single line longer than twice the buffer.  The flushed output must
+// be byte identical to the PL_FILE output.  A flushed buffer is reused, and
+// a dest without a FILE keeps its output for the caller.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <iba/ibt.h>
+#include "ibprint.h"
+
+static unsigned failures;
+
+#define FAIL(fmt, ...) do { \
+		failures++; \
+		fprintf(stderr, "FAIL: " fmt "\n", __VA_ARGS__); \
+	} while (0)
+
+// print a mix of short lines, formatted numbers and one long line
+static void printLines(PrintDest_t *dest, int first, int count)
+{
+	static char longLine[10000];
+	int i;
+
+	if (! longLine[0])
+		memset(longLine, 'x', sizeof(longLine) - 1);
+	for (i = first; i < first + count; i++) {
+		if (i % 500 == 3)
+			PrintFunc(dest, "%d %s\n", i, longLine);
+		else
+			PrintFunc(dest, "%*sLine %d: 0x%016llx %s\n", i % 8, "", i,
+				(unsigned long long)i * 0x9e3779b97f4a7c15ULL,
+				(i % 3) ? "Port" : "Node");
+	}
+}
+
+// read back all of file
+static char *readFile(FILE *file, long *size)
+{
+	char *data;
+
+	fflush(file);
+	*size = ftell(file);
+	data = malloc(*size + 1);
+	if (! data)
+		return NULL;
+	rewind(file);
+	if (fread(data, 1, *size, file) != (size_t)*size) {
+		free(data);
+		return NULL;
+	}
+	return data;
+}
+
+static void compareFiles(const char *test, FILE *expected, FILE *actual)
+{
+	long expectedSize, actualSize;
+	char *expectedData = readFile(expected, &expectedSize);
+	char *actualData = readFile(actual, &actualSize);
+
+	if (! expectedData || ! actualData)
+		FAIL("%s: unable to read output", test);
+	else if (expectedSize != actualSize)
+		FAIL("%s: %ld bytes output, expected %ld", test, actualSize, expectedSize);
+	else if (memcmp(expectedData, actualData, expectedSize))
+		FAIL("%s: output differs from PL_FILE output", test);
+	free(expectedData);
+	free(actualData);
+}
+
+int main(void)
+{
+	PrintDest_t fileDest, memDest;
+	FILE *expected = tmpfile();
+	FILE *actual = tmpfile();
+	size_t length;
+
+	if (! expected || ! actual) {
+		perror("tmpfile");
+		return 2;
+	}
+
+#ifdef LINUX
+	// PL_MEMORY was added after the existing types
+	if (PL_SYSLOG != 4)
+		FAIL("PL_SYSLOG is %d, expected 4", PL_SYSLOG);
+#endif
+
+	// grow from 16 bytes, flush once at the end
+	PrintDestInitFile(&fileDest, expected);
+	PrintDestInitMemory(&memDest, actual, 16);
+	printLines(&fileDest, 0, 2000);
+	printLines(&memDest, 0, 2000);
+	if (memDest.u.mem.length <= 16)
+		FAIL("buffer did not grow, length %zu", memDest.u.mem.length);
+	if (memDest.u.mem.offset == 0)
+		FAIL("%s", "nothing buffered before PrintDestFlush");
+	if (PrintDestFlush(&memDest) != 0)
+		FAIL("%s", "PrintDestFlush failed");
+	if (memDest.u.mem.offset != 0)
+		FAIL("buffer not empty after flush, offset %zu", memDest.u.mem.offset);
+	if (PrintDestFlush(&memDest) != 0)
+		FAIL("%s", "PrintDestFlush of an empty buffer failed");
+	if (memDest.u.mem.overflow)
+		FAIL("%s", "overflow set");
+
+	// reuse the flushed buffer, which must not need to grow again
+	length = memDest.u.mem.length;
+	printLines(&fileDest, 2000, 100);
+	printLines(&memDest, 2000, 100);
+	if (PrintDestFlush(&memDest) != 0)
+		FAIL("%s", "PrintDestFlush after reuse failed");
+	if (memDest.u.mem.length != length)
+		FAIL("reused buffer grew from %zu to %zu", length, memDest.u.mem.length);
+	PrintDestFree(&memDest);
+	if (memDest.u.mem.buffer || memDest.u.mem.length || memDest.u.mem.offset)
+		FAIL("%s", "PrintDestFree left a buffer");
+	compareFiles("grow and flush", expected, actual);
+
+	// default initial size, flush after every few lines
+	rewind(actual);
+	if (ftruncate(fileno(actual), 0))
+		perror("ftruncate");
+	PrintDestInitMemory(&memDest, actual, 0);
+	if (memDest.u.mem.length != 4096)
+		FAIL("default length %zu, expected 4096", memDest.u.mem.length);
+	{
+		int i;
+
+		for (i = 0; i < 2100; i += 7) {
+			printLines(&memDest, i, i + 7 <= 2100 ? 7 : 2100 - i);
+			if (PrintDestFlush(&memDest) != 0)
+				FAIL("%s", "PrintDestFlush failed");
+		}
+	}
+	PrintDestFree(&memDest);
+	compareFiles("periodic flush", expected, actual);
+
+	// without a FILE the output stays in the buffer, NUL terminated
+	PrintDestInitMemory(&memDest, NULL, 8);
+	PrintFunc(&memDest, "%s %d\n", "Port", 1);
+	PrintFunc(&memDest, "%s %d\n", "Port", 22);
+	if (PrintDestFlush(&memDest) != 0)
+		FAIL("%s", "PrintDestFlush without a FILE failed");
+	if (memDest.u.mem.offset != 15 || strcmp(memDest.u.mem.buffer, "Port 1\nPort 22\n"))
+		FAIL("%s", "output not kept in buffer without a FILE");
+	PrintDestFree(&memDest);
+
+	// PrintDestFlush of a PL_FILE dest flushes the FILE
+	if (PrintDestFlush(&fileDest) != 0)
+		FAIL("%s", "PrintDestFlush of PL_FILE failed");
+
+	fclose(expected);
+	fclose(actual);
+	printf("%u failures\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,451 @@
+/* BEGIN_ICS_COPYRIGHT7 ****************************************
+
+Copyright (c) 2023, Intel Corporation
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+     documentation and/or other materials provided with the distribution.
+    * Neither the name of Intel Corporation nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+** END_ICS_COPYRIGHT7   ****************************************/
+
+/* [ICS VERSION STRING: unknown] */
+
+// Checks StringToUint64 and StringToInt64 from IbAccess/Common/Public/imemory.c
+// Built and run by test_string_to_int.sh.
+//
+// Fixed cases cover the overflow boundaries, leading whitespace and signs,
+// base prefixes, trailing characters and *endptr.  Every fixed case, plus a
+// set of random strings, is also compared against RefStringToUint64 and
+// RefStringToInt64, which are the strtoull/strtoll based conversions used
+// before the digit table fast path was added.  With -b a microbenchmark
+// compares the two on typical snapshot values.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include "datatypes.h"
+#include "imemory.h"
+
+// imemory.c dependencies, not used by the conversions
+void *MemoryAllocatePriv(uint32 Bytes, uint32 flags, uint32 tag)
+{
+	return malloc(Bytes);
+}
+
+void MemoryDeallocatePriv(void *pMemory)
+{
+	free(pMemory);
+}
+
+void MemoryFill(void *pMemory, uchar Fill, uint32 Bytes)
+{
+	memset(pMemory, Fill, Bytes);
+}
+
+void BackTrace(FILE *file)
+{
+}
+
+// reference conversions, StringToUint64 and StringToInt64 without the
+// fast path
+static FSTATUS RefStringToUint64(uint64 *value, const char* str, char **endptr, int base, boolean skip_trail_whitespace)
+{
+	char *end = NULL;
+	uint64 temp;
+
+	if (! str || ! value)
+		return FINVALID_PARAMETER;
+	errno = 0;
+	temp = strtoull(str, &end, base?base:10);
+	if ( ! base && ! (temp == IB_UINT64_MAX && errno)
+		&& (end && temp == 0 && *end == 'x' && end != str)) {
+		// try again as base 16
+		temp = strtoull(str, &end, 16);
+	}
+	if ((temp == IB_UINT64_MAX && errno)
+		|| (end && end == str)) {
+		if (errno == ERANGE)
+			return FINVALID_SETTING;
+		else
+			return FERROR;
+	}
+	// skip whitespace
+	if (end && skip_trail_whitespace) {
+		while (isspace(*end)) {
+			end++;
+		}
+	}
+	if (endptr)
+		*endptr = end;
+	else if (end && *end != '\0')
+		return FERROR;
+	*value = temp;
+	return FSUCCESS;
+}
+
+static FSTATUS RefStringToInt64(int64 *value, const char* str, char **endptr, int base, boolean skip_trail_whitespace)
+{
+	char *end = NULL;
+	int64 temp;
+
+	if (! str || ! value)
+		return FINVALID_PARAMETER;
+	errno = 0;
+	temp = strtoll(str, &end, base?base:10);
+	if ( ! base && ! ((temp == IB_INT64_MAX || temp == IB_INT64_MIN) && errno)
+		&& (end && temp == 0 && *end == 'x' && end != str)) {
+		// try again as base 16
+		temp = strtoll(str, &end, 16);
+	}
+	if (((temp == IB_INT64_MAX || temp == IB_INT64_MIN) && errno)
+		|| (end && end == str)) {
+		if (errno == ERANGE)
+			return FINVALID_SETTING;
+		else
+			return FERROR;
+	}
+	// skip whitespace
+	if (end && skip_trail_whitespace) {
+		while (isspace(*end)) {
+			end++;
+		}
+	}
+	if (endptr)
+		*endptr = end;
+	else if (end && *end != '\0')
+		return FERROR;
+	*value = temp;
+	return FSUCCESS;
+}
+
+#define NO_END	(-1)	// call with a NULL endptr
+
+typedef struct {
+	const char *str;
+	int base;
+	boolean skip_ws;
+	int end;			// expected *endptr offset, or NO_END
+	FSTATUS status;
+	uint64 value;		// checked when status is FSUCCESS
+} Uint64Case;
+
+typedef struct {
+	const char *str;
+	int base;
+	boolean skip_ws;
+	int end;
+	FSTATUS status;
+	int64 value;
+} Int64Case;
+
+static const Uint64Case uint64Cases[] = {
+	// overflow at UINT64_MAX, decimal and hex, fast and strtoull digit counts
+	{ "18446744073709551615", 0, FALSE, NO_END, FSUCCESS, IB_UINT64_MAX },
+	{ "18446744073709551615", 10, FALSE, NO_END, FSUCCESS, IB_UINT64_MAX },
+	{ "18446744073709551616", 0, FALSE, NO_END, FINVALID_SETTING, 0 },
+	{ "99999999999999999999", 10, FALSE, NO_END, FINVALID_SETTING, 0 },
+	{ "9999999999999999999", 0, FALSE, NO_END, FSUCCESS, 9999999999999999999ULL },
+	{ "00000000000000000000000000042", 0, FALSE, NO_END, FSUCCESS, 42 },
+	{ "0xffffffffffffffff", 0, FALSE, NO_END, FSUCCESS, IB_UINT64_MAX },
+	{ "ffffffffffffffff", 16, FALSE, NO_END, FSUCCESS, IB_UINT64_MAX },
+	{ "0x10000000000000000", 0, FALSE, NO_END, FINVALID_SETTING, 0 },
+	{ "0xfffffffffffffff", 16, FALSE, NO_END, FSUCCESS, 0xfffffffffffffffULL },
+	{ "0x0000000000000000001", 16, FALSE, NO_END, FSUCCESS, 1 },
+	// leading whitespace and signs
+	{ " 42", 0, FALSE, NO_END, FSUCCESS, 42 },
+	{ "\t0x2a", 0, FALSE, NO_END, FSUCCESS, 42 },
+	{ "+42", 10, FALSE, NO_END, FSUCCESS, 42 },
+	{ "+0x2a", 0, FALSE, NO_END, FSUCCESS, 42 },
+	{ "-1", 0, FALSE, NO_END, FSUCCESS, IB_UINT64_MAX },
+	{ " ", 0, FALSE, NO_END, FERROR, 0 },
+	{ "+", 0, FALSE, NO_END, FERROR, 0 },
+	// base prefixes, base 0 is decimal or hex but never octal
+	{ "0x1F", 0, FALSE, NO_END, FSUCCESS, 31 },
+	{ "0X1f", 16, FALSE, NO_END, FSUCCESS, 31 },
+	{ "1f", 16, FALSE, NO_END, FSUCCESS, 31 },
+	{ "010", 0, FALSE, NO_END, FSUCCESS, 10 },
+	{ "010", 8, FALSE, NO_END, FSUCCESS, 8 },
+	{ "0x1f", 10, FALSE, NO_END, FERROR, 0 },
+	{ "0x1f", 10, FALSE, 1, FSUCCESS, 0 },
+	{ "0x", 0, FALSE, 1, FSUCCESS, 0 },
+	{ "0x", 16, FALSE, 1, FSUCCESS, 0 },
+	{ "0xg", 0, FALSE, 1, FSUCCESS, 0 },
+	{ "00x5", 0, FALSE, 2, FSUCCESS, 0 },
+	{ "1x5", 0, FALSE, 1, FSUCCESS, 1 },
+	{ "z", 36, FALSE, NO_END, FSUCCESS, 35 },
+	// trailing characters and *endptr
+	{ "12ab", 10, FALSE, 2, FSUCCESS, 12 },
+	{ "12ab", 10, FALSE, NO_END, FERROR, 0 },
+	{ "12ab", 0, FALSE, 2, FSUCCESS, 12 },
+	{ "12ab", 16, FALSE, 4, FSUCCESS, 0x12ab },
+	{ "12  ", 0, TRUE, NO_END, FSUCCESS, 12 },
+	{ "12  ", 0, FALSE, NO_END, FERROR, 0 },
+	{ "12  ", 0, FALSE, 2, FSUCCESS, 12 },
+	{ "12  ", 0, TRUE, 4, FSUCCESS, 12 },
+	{ "12 \t z", 0, TRUE, 5, FSUCCESS, 12 },
+	{ "0x11:0x22", 0, FALSE, 4, FSUCCESS, 0x11 },
+	{ "", 0, FALSE, NO_END, FERROR, 0 },
+	{ "abc", 10, FALSE, NO_END, FERROR, 0 },
+	{ "abc", 10, FALSE, 0, FERROR, 0 },
+};
+
+static const Int64Case int64Cases[] = {
+	// overflow at INT64_MAX and INT64_MIN
+	{ "9223372036854775807", 0, FALSE, NO_END, FSUCCESS, IB_INT64_MAX },
+	{ "9223372036854775808", 0, FALSE, NO_END, FINVALID_SETTING, 0 },
+	{ "-9223372036854775808", 0, FALSE, NO_END, FSUCCESS, IB_INT64_MIN },
+	{ "-9223372036854775809", 10, FALSE, NO_END, FINVALID_SETTING, 0 },
+	{ "999999999999999999", 0, FALSE, NO_END, FSUCCESS, 999999999999999999LL },
+	{ "0x7fffffffffffffff", 0, FALSE, NO_END, FSUCCESS, IB_INT64_MAX },
+	{ "0x8000000000000000", 0, FALSE, NO_END, FINVALID_SETTING, 0 },
+	{ "-0x8000000000000000", 0, FALSE, NO_END, FSUCCESS, IB_INT64_MIN },
+	{ "-0x8000000000000001", 16, FALSE, NO_END, FINVALID_SETTING, 0 },
+	{ "fffffffffffffff", 16, FALSE, NO_END, FSUCCESS, 0xfffffffffffffffLL },
+	// leading whitespace and signs
+	{ " -42", 0, FALSE, NO_END, FSUCCESS, -42 },
+	{ "-0x2a", 0, FALSE, NO_END, FSUCCESS, -42 },
+	{ "+42", 0, FALSE, NO_END, FSUCCESS, 42 },
+	{ "--42", 0, FALSE, NO_END, FERROR, 0 },
+	{ "-", 10, FALSE, NO_END, FERROR, 0 },
+	// base prefixes
+	{ "0x1F", 0, FALSE, NO_END, FSUCCESS, 31 },
+	{ "010", 0, FALSE, NO_END, FSUCCESS, 10 },
+	{ "-010", 8, FALSE, NO_END, FSUCCESS, -8 },
+	{ "0x1f", 10, FALSE, 1, FSUCCESS, 0 },
+	{ "0xg", 0, FALSE, 1, FSUCCESS, 0 },
+	// trailing characters and *endptr
+	{ "-12ab", 10, FALSE, 3, FSUCCESS, -12 },
+	{ "-12ab", 10, FALSE, NO_END, FERROR, 0 },
+	{ "12 \n", 0, TRUE, NO_END, FSUCCESS, 12 },
+	{ "12 \n", 0, FALSE, NO_END, FERROR, 0 },
+	{ "12 x", 0, TRUE, 3, FSUCCESS, 12 },
+	{ "", 0, FALSE, NO_END, FERROR, 0 },
+};
+
+static unsigned failures;
+
+#define FAIL(fmt, ...) do { \
+		if (failures++ < 50) \
+			fprintf(stderr, "FAIL: " fmt "\n", __VA_ARGS__); \
+	} while (0)
+
+static void checkUint64Case(const Uint64Case *c)
+{
+	uint64 value = 0x5a5a5a5a5a5a5a5aULL;
+	char *end = NULL;
+	FSTATUS status;
+
+	status = StringToUint64(&value, c->str, c->end == NO_END ? NULL : &end,
+						c->base, c->skip_ws);
+	if (status != c->status)
+		FAIL("StringToUint64(\"%s\", %d) status %d, expected %d",
+			c->str, c->base, status, c->status);
+	else if (status == FSUCCESS && value != c->value)
+		FAIL("StringToUint64(\"%s\", %d) value %llu, expected %llu",
+			c->str, c->base, (unsigned long long)value,
+			(unsigned long long)c->value);
+	else if (status == FSUCCESS && c->end != NO_END && end != c->str + c->end)
+		FAIL("StringToUint64(\"%s\", %d) end offset %d, expected %d",
+			c->str, c->base, (int)(end - c->str), c->end);
+}
+
+static void checkInt64Case(const Int64Case *c)
+{
+	int64 value = 0x5a5a5a5a5a5a5a5aLL;
+	char *end = NULL;
+	FSTATUS status;
+
+	status = StringToInt64(&value, c->str, c->end == NO_END ? NULL : &end,
+						c->base, c->skip_ws);
+	if (status != c->status)
+		FAIL("StringToInt64(\"%s\", %d) status %d, expected %d",
+			c->str, c->base, status, c->status);
+	else if (status == FSUCCESS && value != c->value)
+		FAIL("StringToInt64(\"%s\", %d) value %lld, expected %lld",
+			c->str, c->base, (long long)value, (long long)c->value);
+	else if (status == FSUCCESS && c->end != NO_END && end != c->str + c->end)
+		FAIL("StringToInt64(\"%s\", %d) end offset %d, expected %d",
+			c->str, c->base, (int)(end - c->str), c->end);
+}
+
+// compare status, *value and *endptr of the conversions with the reference
+// for every base, trailing whitespace mode and with or without endptr
+static void checkEquivalence(const char *str)
+{
+	static const int bases[] = { 0, 8, 10, 16 };
+	unsigned b;
+	int ws, useEnd;
+
+	for (b = 0; b < sizeof(bases)/sizeof(bases[0]); b++) {
+		for (ws = 0; ws < 2; ws++) {
+			for (useEnd = 0; useEnd < 2; useEnd++) {
+				uint64 u = 1, uRef = 1;
+				int64 i = 1, iRef = 1;
+				char *end = NULL, *endRef = NULL;
+				FSTATUS status, statusRef;
+
+				status = StringToUint64(&u, str, useEnd ? &end : NULL, bases[b], ws);
+				statusRef = RefStringToUint64(&uRef, str, useEnd ? &endRef : NULL, bases[b], ws);
+				if (status != statusRef || u != uRef || end != endRef)
+					FAIL("StringToUint64(\"%s\", %d, %d, %s) differs from reference",
+						str, bases[b], ws, useEnd ? "endptr" : "NULL");
+
+				end = endRef = NULL;
+				status = StringToInt64(&i, str, useEnd ? &end : NULL, bases[b], ws);
+				statusRef = RefStringToInt64(&iRef, str, useEnd ? &endRef : NULL, bases[b], ws);
+				if (status != statusRef || i != iRef || end != endRef)
+					FAIL("StringToInt64(\"%s\", %d, %d, %s) differs from reference",
+						str, bases[b], ws, useEnd ? "endptr" : "NULL");
+			}
+		}
+	}
+}
+
+// random strings mostly of digits, with prefixes, signs and whitespace mixed in
+static void randomString(char *str, int maxLen)
+{
+	static const char digits[] = "0123456789";
+	static const char other[] = "abcdefABCDEFxX+- \t\n:g";
+	int len = rand() % maxLen;
+	int i;
+
+	for (i = 0; i < len; i++) {
+		if (rand() % 3)
+			str[i] = digits[rand() % (sizeof(digits) - 1)];
+		else
+			str[i] = other[rand() % (sizeof(other) - 1)];
+	}
+	str[len] = '\0';
+	if (len > 2 && rand() % 4 == 0) {
+		str[0] = '0';
+		str[1] = 'x';
+	}
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// ns per call of StringToUint64 and RefStringToUint64 for values like those
+// found in snapshot and topology XML
+static void benchmark(unsigned iterations)
+{
+	static const char *values[] = {
+		"0x00117501016a0001", "0x0001", "123456789012", "7", "0x1f", NULL
+	};
+	volatile uint64 sum = 0;
+	uint64 value;
+	unsigned i, v;
+	double start, ns, nsRef;
+
+	printf("%-20s %12s %12s\n", "value", "ns/call", "reference");
+	for (v = 0; values[v]; v++) {
+		start = now();
+		for (i = 0; i < iterations; i++) {
+			StringToUint64(&value, values[v], NULL, 0, TRUE);
+			sum += value;
+		}
+		ns = (now() - start) * 1e9 / iterations;
+		start = now();
+		for (i = 0; i < iterations; i++) {
+			RefStringToUint64(&value, values[v], NULL, 0, TRUE);
+			sum += value;
+		}
+		nsRef = (now() - start) * 1e9 / iterations;
+		printf("%-20s %12.1f %12.1f\n", values[v], ns, nsRef);
+	}
+}
+
+static void Usage(void)
+{
+	fprintf(stderr, "Usage: test_string_to_int [-n count] [-s seed] [-b iterations]\n");
+	fprintf(stderr, "   -n count      - number of random strings compared with the\n");
+	fprintf(stderr, "                   reference conversions, default is 1000000\n");
+	fprintf(stderr, "   -s seed       - seed for the random strings, default is 1\n");
+	fprintf(stderr, "   -b iterations - also run the microbenchmark\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long count = 1000000;
+	unsigned seed = 1;
+	unsigned iterations = 0;
+	unsigned long n;
+	unsigned i;
+	char str[32];
+	int c;
+
+	while ((c = getopt(argc, argv, "n:s:b:")) != -1) {
+		switch (c) {
+		case 'n':
+			count = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			seed = (unsigned)strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			iterations = (unsigned)strtoul(optarg, NULL, 0);
+			break;
+		default:
+			Usage();
+		}
+	}
+	if (optind < argc)
+		Usage();
+
+	for (i = 0; i < sizeof(uint64Cases)/sizeof(uint64Cases[0]); i++) {
+		checkUint64Case(&uint64Cases[i]);
+		checkEquivalence(uint64Cases[i].str);
+	}
+	for (i = 0; i < sizeof(int64Cases)/sizeof(int64Cases[0]); i++) {
+		checkInt64Case(&int64Cases[i]);
+		checkEquivalence(int64Cases[i].str);
+	}
+	if (StringToUint64(NULL, "1", NULL, 0, FALSE) != FINVALID_PARAMETER)
+		FAIL("%s", "StringToUint64 with NULL value did not fail");
+	if (StringToInt64(NULL, "1", NULL, 0, FALSE) != FINVALID_PARAMETER)
+		FAIL("%s", "StringToInt64 with NULL value did not fail");
+
+	srand(seed);
+	for (n = 0; n < count; n++) {
+		randomString(str, sizeof(str) - 1);
+		checkEquivalence(str);
+	}
+
+	if (iterations)
+		benchmark(iterations);
+
+	printf("%u fixed cases, %lu random strings, %u failures\n",
+		(unsigned)(sizeof(uint64Cases)/sizeof(uint64Cases[0])
+			+ sizeof(int64Cases)/sizeof(int64Cases[0])),
+		count, failures);
+	return failures ? 1 : 0;
+}
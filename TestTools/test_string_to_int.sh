@@ -0,0 +1,48 @@
+#!/bin/bash
+# BEGIN_ICS_COPYRIGHT8 ****************************************
+#
+# Copyright (c) 2023, Intel Corporation
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+#     * Redistributions of source code must retain the above copyright notice,
+#       this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#     * Neither the name of Intel Corporation nor the names of its contributors
+#       may be used to endorse or promote products derived from this software
+#       without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# END_ICS_COPYRIGHT8   ****************************************
+
+#[ICS VERSION STRING: unknown]
+
+# Build test_string_to_int.c against IbAccess/Common/Public/imemory.c and run
+# it.  Arguments are passed to the test, for example:
+#	test_string_to_int.sh -n 100000 -b 2000000
+# runs 100000 random strings and the microbenchmark.
+# CC and CFLAGS may be set in the environment, see build_unit_test.sh.
+
+TESTDIR=$(cd $(dirname $0) && pwd)
+TOPDIR=$(cd $TESTDIR/.. && pwd)
+
+tempdir=$(mktemp -d /tmp/test_string_to_int.XXXXXX) || exit 1
+trap "rm -rf $tempdir" EXIT
+
+$TESTDIR/build_unit_test.sh $tempdir/test_string_to_int \
+	$TESTDIR/test_string_to_int.c $TOPDIR/IbAccess/Common/Public/imemory.c || exit 2
+
+$tempdir/test_string_to_int "$@"
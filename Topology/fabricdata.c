@@ -1803,6 +1803,9 @@ void DestroyFabricData(FabricData_t *fabricp)
 	if (fabricp->flags & FF_LIDARRAY)
 		FreeLidMap(fabricp);
 
+	if (fabricp->SnmpStats)
+		MemoryDeallocate(fabricp->SnmpStats);
+
 	// make sure no stale pointers in lists, etc
 	// also clear counters and flags
 	MemoryClear(fabricp, sizeof(*fabricp));
@@ -84,6 +84,13 @@ void hmgt_set_retry_count(struct hmgt_port *port, int retry_count)
 	}
 }
 /** ========================================================================= */
+void hmgt_set_dead_hosts_file(struct hmgt_port *port, const char *file)
+{
+	if (port) {
+		port->dead_hosts_file = file;
+	}
+}
+/** ========================================================================= */
 const char* hmgt_status_totext(HMGT_STATUS_T status)
 {
 	switch (status) {
@@ -318,6 +325,7 @@ static HMGT_STATUS_T open_port_internal(struct hmgt_port *port, char *hfi_name _
 	/* Set Timeout and retry to default values */
 	port->ms_timeout = HMGT_DEF_TIMEOUT_MS;
 	port->retry_count = HMGT_DEF_RETRY_CNT;
+	port->dead_hosts_file = NULL;
 
 free_port:
 	return (err);
@@ -84,6 +84,7 @@ struct hmgt_port;
 #define HMGT_DBG_FILE_SYSLOG ((FILE *)-1)
 #define HMGT_DEF_TIMEOUT_MS 1000
 #define HMGT_DEF_RETRY_CNT 3
+#define HMGT_DEF_DEAD_HOSTS_DIR "/var/usr/lib/eth-tools"
 
 #define HMGT_SHORT_STRING_SIZE 64
 #define HMGT_MAX_STRING_SIZE 256
@@ -251,6 +252,22 @@ void hmgt_set_timeout(struct hmgt_port *port, int ms_timeout);
  */
 void hmgt_set_retry_count(struct hmgt_port *port, int retry_count);
 
+/**
+ * @brief Set the file recording hosts that recently did not respond
+ *
+ * Hosts whose first query timed out are recorded in this file. In later
+ * queries they are probed once, without retries, before being queried in
+ * full. By default the file is snmp_dead_hosts.<plane> in
+ * HMGT_DEF_DEAD_HOSTS_DIR, and is not used if that directory doesn't exist.
+ *
+ * @param port        port instance to modify configuration.
+ * @param file        name of the file. NULL selects the default file, an
+ *  				  empty string disables the list.
+ *
+ * @see HMGT_DEF_DEAD_HOSTS_DIR
+ */
+void hmgt_set_dead_hosts_file(struct hmgt_port *port, const char *file);
+
 
 /* OMGT Service State Values */
 #define HMGT_SERVICE_STATE_UNKNOWN         0
@@ -129,6 +129,7 @@ struct hmgt_port {
 	/* Timeout & Retries */
 	int ms_timeout;
 	int retry_count;
+	const char *dead_hosts_file;	/* NULL for default, "" for none */
 
 //	/* SA interaction for userspace Notice registration */
 //	struct ibv_comp_channel *sa_qp_comp_channel;
@@ -31,6 +31,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "topology.h"
 #include <stdarg.h>
+#include <fnmatch.h>
+#include <errno.h>
+#include <sys/stat.h>
 #include "iba/stl_sa_types.h"
 #include "iba/stl_sd.h"
 #include "hpnmgt_snmp_priv.h"
@@ -61,6 +64,7 @@ typedef struct {
 boolean TRACE = FALSE;
 uint8 verbose_level = 0;
 FILE *verbose_file = NULL;	// file for verbose output
+FILE *capture_file = NULL;	// file for SNMP capture
 
 #define DBGPRINT(format, args...) if (verbose_file) { fprintf(verbose_file, format, ##args); }
 #define TRACEPRINT(format, args...) if (TRACE) { fprintf(verbose_file?verbose_file:stderr, format, ##args); }
@@ -77,6 +81,12 @@ void setTopologySnmpVerbose(FILE* file, uint8 level) {
 	}
 }
 
+void setTopologySnmpCapture(FILE* file) {
+	capture_file = file;
+	if (capture_file)
+		fprintf(capture_file, "# hpnmgt SNMP capture 1\n");
+}
+
 //--------- utility functions ------------------//
 
 void print_timestamp(FILE *out) {
@@ -888,6 +898,35 @@ next_loop:
 	return fstatus;
 }
 
+/*
+ * @brief format the NodeDesc of a NIC, sysName-ifName. When it doesn't fit
+ *        the sysName is shortened to make room for the ifName, keeping at
+ *        least 4 characters, then the start of the ifName is dropped.
+ * @param desc	STL_NODE_DESCRIPTION_ARRAY_SIZE buffer to fill in
+ * @param sysNameRes	sysName result, NULL if the host didn't report it
+ * @param ifNameRes	ifName result of the interface
+ */
+static void format_nic_desc(char *desc, const SNMPResult *sysNameRes,
+		const SNMPResult *ifNameRes)
+{
+	// val.string doesn't guarantee it's null terminated
+	const char *sys = sysNameRes ? (const char *)sysNameRes->val.string : "Unknown";
+	size_t sysLen = sysNameRes ? sysNameRes->valLen : strlen(sys);
+	const char *ifn = (const char *)ifNameRes->val.string;
+	size_t ifLen = ifNameRes->valLen;
+	const size_t max = STL_NODE_DESCRIPTION_ARRAY_SIZE - 1;
+
+	if (sysLen + 1 + ifLen > max)
+		sysLen = MIN(sysLen, (ifLen + 1 + 4 < max) ? max - 1 - ifLen : 4);
+	if (sysLen + 1 + ifLen > max) {
+		size_t delta = sysLen + 1 + ifLen - max;
+		ifn += delta;
+		ifLen -= delta;
+	}
+	snprintf(desc, STL_NODE_DESCRIPTION_ARRAY_SIZE, "%.*s-%.*s",
+			(int)sysLen, sys, (int)ifLen, ifn);
+}
+
 HMGT_STATUS_T populate_host_node_record(SNMPHost *host, SNMPResult *res,
 		QUICK_LIST *nodeList) {
 	HMGT_STATUS_T fstatus = HMGT_STATUS_SUCCESS;
@@ -937,29 +976,7 @@ HMGT_STATUS_T populate_host_node_record(SNMPHost *host, SNMPResult *res,
 					break;
 				}
 
-				// rp->val.string doesn't guarantee it's null terminated
-				size_t len = 0;
-				if (sysNameRes) {
-					len =
-							sysNameRes->valLen + 1 < STL_NODE_DESCRIPTION_ARRAY_SIZE ?
-									sysNameRes->valLen + 1 : STL_NODE_DESCRIPTION_ARRAY_SIZE;
-					if (len + rp->valLen + 1 > STL_NODE_DESCRIPTION_ARRAY_SIZE) {
-						len = STL_NODE_DESCRIPTION_ARRAY_SIZE - rp->valLen - 1;
-						if (len < 5) {
-							len = 5;
-						}
-					}
-					snprintf((char*) node->NodeDesc.NodeString, len, "%s",
-							sysNameRes->val.string);
-				} else {
-					len = snprintf((char*) node->NodeDesc.NodeString, 8, "%s",
-							"Unknown");
-				}
-				char *pos = (char*) (node->NodeDesc.NodeString) + len - 1;
-				len = rp->valLen + 2 < STL_NODE_DESCRIPTION_ARRAY_SIZE - len + 1 ?
-						rp->valLen + 2 : STL_NODE_DESCRIPTION_ARRAY_SIZE - len + 1;
-				size_t delta = rp->valLen + 2 - len;
-				snprintf(pos, len, "-%s", rp->val.string + delta);
+				format_nic_desc((char*) node->NodeDesc.NodeString, sysNameRes, rp);
 			}
 		} else if (is_oid(rp, &ifType)) {
 			TRACEPRINT("..ifType\n");
@@ -1009,6 +1026,8 @@ next_loop:
 	return fstatus;
 }
 
+static void format_oid(char *buf, size_t size, const oid *name, size_t len);
+
 /*
  * @brief create port records for each switch node and put port list back to RAW_NODE
  */
@@ -1229,6 +1248,11 @@ HMGT_STATUS_T populate_switch_node_port_records(SNMPResult *res,
 				copy_snmp_string(rp, (char*) portRec->PortInfo.LocalPortId,
 						TINY_STR_ARRAY_SIZE, FALSE);
 			}
+		} else if (is_oid(rp, &sysObjectID)) {
+			TRACEPRINT("..sysObjectID\n");
+			// switches of the same model share their port numbering
+			format_oid(buf, sizeof(buf), rp->val.objid, rp->valLen / sizeof(oid));
+			pn_gen_set_profile(&png_model, buf);
 		} else if (is_oid(rp, &ifName)) {
 			TRACEPRINT("..ifName\n");
 			// transfer from port number map to interface index map
@@ -1959,6 +1983,407 @@ int print_result(FILE *out, int status, struct snmp_session *session,
 	return 0;
 }
 
+/*
+ * SNMP capture.
+ * Every request and response PDU of a sweep is written as one line per PDU
+ * and one line per variable, so a sweep can be replayed by ethsnmpsim:
+ *   > time peer reqid command non_repeaters max_repetitions oid...
+ *   < time peer reqid errstat errindex
+ *   = peer oid type value
+ *   ! time peer reqid timeout
+ * oids are numeric, integer values are decimal, strings are hex ('-' when
+ * empty).
+ */
+static void capture_oid(const oid *name, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		fprintf(capture_file, ".%lu", (unsigned long)name[i]);
+}
+
+static void capture_time(char type, struct snmp_session *sess)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	fprintf(capture_file, "%c %ld.%06ld %s", type, (long)now.tv_sec,
+			(long)now.tv_usec, sess->peername);
+}
+
+static void capture_request(struct snmp_session *sess, struct snmp_pdu *pdu, int reqid)
+{
+	struct variable_list *vars;
+
+	if (!capture_file)
+		return;
+	capture_time('>', sess);
+	fprintf(capture_file, " %d %s %ld %ld", reqid,
+			pdu->command == SNMP_MSG_GETBULK ? "GETBULK" :
+			pdu->command == SNMP_MSG_GETNEXT ? "GETNEXT" : "GET",
+			pdu->non_repeaters, pdu->max_repetitions);
+	for (vars = pdu->variables; vars; vars = vars->next_variable) {
+		fputc(' ', capture_file);
+		capture_oid(vars->name, vars->name_length);
+	}
+	fputc('\n', capture_file);
+}
+
+static void capture_response(struct snmp_session *sess, int operation, int reqid,
+		struct snmp_pdu *pdu)
+{
+	struct variable_list *vars;
+	size_t i;
+
+	if (!capture_file)
+		return;
+	if (operation != NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE) {
+		capture_time('!', sess);
+		fprintf(capture_file, " %d timeout\n", reqid);
+		return;
+	}
+	capture_time('<', sess);
+	fprintf(capture_file, " %d %ld %ld\n", reqid, pdu->errstat, pdu->errindex);
+	for (vars = pdu->variables; vars; vars = vars->next_variable) {
+		fprintf(capture_file, "= %s ", sess->peername);
+		capture_oid(vars->name, vars->name_length);
+		fprintf(capture_file, " %u ", vars->type);
+		switch (vars->type) {
+		case ASN_INTEGER:
+			fprintf(capture_file, "%ld", *vars->val.integer);
+			break;
+		case ASN_COUNTER:
+		case ASN_GAUGE:
+		case ASN_TIMETICKS:
+			fprintf(capture_file, "%lu", *(u_long *)vars->val.integer);
+			break;
+		case ASN_COUNTER64:
+			fprintf(capture_file, "%"PRIu64, COUNTER64_TO_UINT64(vars->val.counter64));
+			break;
+		case ASN_OBJECT_ID:
+			capture_oid(vars->val.objid, vars->val_len / sizeof(oid));
+			break;
+		default:
+			if (!vars->val_len || !vars->val.string)
+				fputc('-', capture_file);
+			for (i = 0; i < vars->val_len && vars->val.string; i++)
+				fprintf(capture_file, "%02x", vars->val.string[i]);
+			break;
+		}
+		fputc('\n', capture_file);
+	}
+}
+
+/*
+ * Adaptive timeouts.
+ * A host is first queried with the configured timeout and retries. Once it
+ * responded, its requests use a timeout derived from its measured response
+ * times (Jacobson/Karels, srtt + 4 * rttvar) bounded by SNMP_MIN_RTO_MS and
+ * the configured timeout. A host whose first request times out is marked dead
+ * and skipped by the following collect_data() calls of the same query.
+ */
+#define SNMP_MIN_RTO_MS 200
+
+static long snmp_timeout_us = HMGT_DEF_TIMEOUT_MS * 1000L;
+static int snmp_retries = HMGT_DEF_RETRY_CNT;
+
+static uint32 usec_since(const struct timeval *start)
+{
+	struct timeval now;
+	int64_t usec;
+
+	gettimeofday(&now, NULL);
+	usec = (int64_t)(now.tv_sec - start->tv_sec) * 1000000
+			+ (now.tv_usec - start->tv_usec);
+	if (usec < 0)
+		return 0;
+	return usec > IB_UINT32_MAX ? IB_UINT32_MAX : (uint32)usec;
+}
+
+static SnmpColumnStats_t *stats_column(SnmpHostStats_t *stats, const char *name)
+{
+	uint32 i;
+
+	// OID lists are copies of the same SNMPOid globals, so the name pointer
+	// identifies the column
+	for (i = 0; i < stats->numColumns; i++) {
+		if (stats->columns[i].oid == name)
+			return &stats->columns[i];
+	}
+	if (stats->numColumns >= SNMP_STATS_MAX_COLUMNS)
+		return NULL;
+	stats->columns[stats->numColumns].oid = name;
+	return &stats->columns[stats->numColumns++];
+}
+
+static int send_query(struct context_s *context, struct snmp_pdu *req)
+{
+	SNMPHost *host = context->host;
+	int reqid;
+
+	if (host->stats) {
+		host->stats->requests++;
+		context->sentColumn = stats_column(host->stats, context->current_oid->name);
+		if (context->sentColumn)
+			context->sentColumn->requests++;
+	}
+	context->sess->timeout = host->state == HOST_ALIVE ? (long)host->rto : snmp_timeout_us;
+	context->sess->retries = host->state == HOST_PROBE ? 0 : snmp_retries;
+	context->sentTimeout = context->sess->timeout;
+	gettimeofday(&context->sent, NULL);
+	if ((reqid = snmp_send(context->sess, req)))
+		capture_request(context->sess, req, reqid);
+	return reqid;
+}
+
+static void update_host_timing(struct context_s *context, int operation)
+{
+	SNMPHost *host = context->host;
+	int64_t sample, srtt, rttvar, rto;
+
+	if (operation != NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE) {
+		if (host->state != HOST_ALIVE) {
+			DBGPRINT("%s did not respond, skip it for the rest of the query\n", host->name);
+			host->state = HOST_DEAD;
+		}
+		return;
+	}
+	if (host->state != HOST_ALIVE) {
+		host->state = HOST_ALIVE;
+		host->rto = snmp_timeout_us;
+	}
+
+	sample = usec_since(&context->sent);
+	if (sample >= context->sentTimeout) {
+		// a retry was answered, the sample is ambiguous (Karn), back off
+		rto = (int64_t)host->rto * 2;
+	} else {
+		if (sample < 1)
+			sample = 1;
+		if (!host->srtt) {
+			srtt = sample;
+			rttvar = sample / 2;
+		} else {
+			srtt = host->srtt;
+			rttvar = (3 * (int64_t)host->rttvar + (srtt > sample ? srtt - sample : sample - srtt)) / 4;
+			srtt = (7 * srtt + sample) / 8;
+		}
+		host->srtt = (uint32)srtt;
+		host->rttvar = (uint32)rttvar;
+		rto = srtt + 4 * rttvar;
+	}
+	if (rto < SNMP_MIN_RTO_MS * 1000)
+		rto = SNMP_MIN_RTO_MS * 1000;
+	if (rto > snmp_timeout_us)
+		rto = snmp_timeout_us;
+	host->rto = (uint32)rto;
+}
+
+/*
+ * Sweep telemetry.
+ * Every host of a query gets a SnmpHostStats_t in FabricData_t.SnmpStats,
+ * accumulated over all collect_data() calls of the query. A response is
+ * charged to the OID column its request was sent for, so GETBULK
+ * continuations of a table add up in that table's first column.
+ */
+static void format_oid(char *buf, size_t size, const oid *name, size_t len)
+{
+	size_t i;
+	int n;
+
+	buf[0] = '\0';
+	for (i = 0; i < len && size > 1; i++) {
+		n = snprintf(buf, size, ".%lu", (unsigned long)name[i]);
+		if (n < 0 || (size_t)n >= size)
+			break;
+		buf += n;
+		size -= n;
+	}
+}
+
+static void record_response(struct context_s *context, int operation,
+		struct snmp_pdu *pdu)
+{
+	SnmpHostStats_t *stats = context->host->stats;
+	SnmpColumnStats_t *column = context->sentColumn;
+	struct variable_list *vars;
+	uint32 sample;
+
+	if (!stats)
+		return;
+	if (operation != NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE) {
+		stats->timeouts++;
+		stats->retries += context->sess->retries;
+		return;
+	}
+	sample = usec_since(&context->sent);
+	if (sample >= context->sentTimeout)
+		stats->retries++;
+	stats->responses++;
+	if (column) {
+		column->latency += sample;
+		if (sample > column->maxLatency)
+			column->maxLatency = sample;
+	}
+	for (vars = pdu->variables; vars; vars = vars->next_variable) {
+		stats->vars++;
+		stats->bytes += vars->val_len;
+		if (column)
+			column->vars++;
+		if (vars->type == ASN_OBJECT_ID &&
+		    match_oid(sysObjectID.oid, sysObjectID.oidLen, vars->name, vars->name_length))
+			format_oid(stats->sysObjectID, sizeof(stats->sysObjectID),
+					vars->val.objid, vars->val_len / sizeof(oid));
+	}
+}
+
+static void init_stats(FabricData_t *pFabric, SNMPHost *hosts, uint32_t numHosts)
+{
+	uint32_t i;
+
+	if (pFabric->SnmpStats)
+		MemoryDeallocate(pFabric->SnmpStats);
+	pFabric->SnmpStatsCount = 0;
+	pFabric->SnmpStats = MemoryAllocate2AndClear(numHosts * sizeof(SnmpHostStats_t),
+			IBA_MEM_FLAG_PREMPTABLE, SNMPTAG);
+	if (!pFabric->SnmpStats) {
+		// telemetry is optional, sweep without it
+		fprintf(stderr, "WARNING - failed to allocate memory for sweep statistics.\n");
+		return;
+	}
+	for (i = 0; i < numHosts; i++) {
+		hosts[i].stats = &pFabric->SnmpStats[i];
+		snprintf(hosts[i].stats->name, sizeof(hosts[i].stats->name), "%s",
+				hosts[i].name ? hosts[i].name : "");
+		hosts[i].stats->nodeType = hosts[i].type;
+	}
+	pFabric->SnmpStatsCount = numHosts;
+}
+
+static void write_csv_string(FILE *file, const char *str)
+{
+	if (!strpbrk(str, ",\"\n")) {
+		fputs(str, file);
+		return;
+	}
+	fputc('"', file);
+	for (; *str; str++) {
+		if (*str == '"')
+			fputc('"', file);
+		fputc(*str, file);
+	}
+	fputc('"', file);
+}
+
+static void write_json_string(FILE *file, const char *str)
+{
+	fputc('"', file);
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			fprintf(file, "\\%c", *str);
+		else if ((unsigned char)*str < 0x20)
+			fprintf(file, "\\u%04x", (unsigned char)*str);
+		else
+			fputc(*str, file);
+	}
+	fputc('"', file);
+}
+
+static void write_stats_csv(FILE *file, FabricData_t *fabricp)
+{
+	uint32 i, j;
+
+	// one row per host and column, hosts without columns get a single row
+	fprintf(file, "Host,Type,SysObjectID,ConnectUsec,TotalUsec,ProcessUsec,"
+			"Requests,Responses,Vars,Bytes,Timeouts,Retries,"
+			"Oid,OidRequests,OidVars,OidLatencyUsec,OidMaxLatencyUsec\n");
+	for (i = 0; i < fabricp->SnmpStatsCount; i++) {
+		SnmpHostStats_t *stats = &fabricp->SnmpStats[i];
+
+		if (!stats->requests)
+			continue;
+		for (j = 0; j == 0 || j < stats->numColumns; j++) {
+			write_csv_string(file, stats->name);
+			fprintf(file, ",%s,%s,%u,%u,%u,%u,%u,%u,%"PRIu64",%u,%u,",
+					StlNodeTypeToText(stats->nodeType), stats->sysObjectID,
+					stats->connectTime, stats->totalTime, stats->processTime,
+					stats->requests, stats->responses, stats->vars,
+					stats->bytes, stats->timeouts, stats->retries);
+			if (j < stats->numColumns) {
+				SnmpColumnStats_t *column = &stats->columns[j];
+
+				fprintf(file, "%s,%u,%u,%"PRIu64",%u\n", column->oid,
+						column->requests, column->vars, column->latency,
+						column->maxLatency);
+			} else {
+				fprintf(file, ",,,,\n");
+			}
+		}
+	}
+}
+
+static void write_stats_json(FILE *file, FabricData_t *fabricp)
+{
+	uint32 i, j;
+	int first = 1;
+
+	fprintf(file, "{\n  \"plane\": ");
+	write_json_string(file, fabricp->name);
+	fprintf(file, ",\n  \"unixtime\": %ld,\n  \"hosts\": [", (long)fabricp->time);
+	for (i = 0; i < fabricp->SnmpStatsCount; i++) {
+		SnmpHostStats_t *stats = &fabricp->SnmpStats[i];
+
+		if (!stats->requests)
+			continue;
+		fprintf(file, "%s\n    { \"name\": ", first ? "" : ",");
+		first = 0;
+		write_json_string(file, stats->name);
+		fprintf(file, ", \"type\": \"%s\", \"sysObjectID\": \"%s\",\n",
+				StlNodeTypeToText(stats->nodeType), stats->sysObjectID);
+		fprintf(file, "      \"connectUsec\": %u, \"totalUsec\": %u, \"processUsec\": %u,\n",
+				stats->connectTime, stats->totalTime, stats->processTime);
+		fprintf(file, "      \"requests\": %u, \"responses\": %u, \"vars\": %u, \"bytes\": %"PRIu64",\n",
+				stats->requests, stats->responses, stats->vars, stats->bytes);
+		fprintf(file, "      \"timeouts\": %u, \"retries\": %u,\n      \"columns\": [",
+				stats->timeouts, stats->retries);
+		for (j = 0; j < stats->numColumns; j++) {
+			SnmpColumnStats_t *column = &stats->columns[j];
+
+			fprintf(file, "%s\n        { \"oid\": \"%s\", \"requests\": %u, \"vars\": %u,"
+					" \"latencyUsec\": %"PRIu64", \"maxLatencyUsec\": %u }",
+					j ? "," : "", column->oid, column->requests, column->vars,
+					column->latency, column->maxLatency);
+		}
+		fprintf(file, "%s] }", stats->numColumns ? "\n      " : "");
+	}
+	fprintf(file, "%s]\n}\n", first ? "" : "\n  ");
+}
+
+FSTATUS WriteSnmpSweepStats(FabricData_t *fabricp, const char *file)
+{
+	FILE *out;
+	size_t len = strlen(file);
+
+	if (!fabricp->SnmpStats) {
+		fprintf(stderr, "ERROR - no SNMP sweep statistics available.\n");
+		return FNOT_FOUND;
+	}
+	out = fopen(file, "w");
+	if (!out) {
+		fprintf(stderr, "ERROR - couldn't open %s: %s\n", file, strerror(errno));
+		return FERROR;
+	}
+	if (len >= 4 && strcasecmp(file + len - 4, ".csv") == 0)
+		write_stats_csv(out, fabricp);
+	else
+		write_stats_json(out, fabricp);
+	if (fclose(out) != 0) {
+		fprintf(stderr, "ERROR - couldn't write %s: %s\n", file, strerror(errno));
+		return FERROR;
+	}
+	return FSUCCESS;
+}
+
 /*
  * prepare next SNMP query based on OID type
  */
@@ -1994,13 +2419,18 @@ struct snmp_pdu * prepare_snmp_query(struct context_s *context) {
 /*
  * response handler
  */
-int asynch_mixed_response(int operation, struct snmp_session *sp, int reqid _UNUSED_,
+int asynch_mixed_response(int operation, struct snmp_session *sp, int reqid,
 		struct snmp_pdu *pdu, void *magic) {
 	struct context_s *context = (struct context_s *) magic;
 	struct snmp_pdu *req = NULL;
 	struct variable_list *vars;
 	QueryState state = Q_NONE;
 	SNMPOid *next_oid;
+	int newReqid;
+
+	capture_response(sp, operation, reqid, pdu);
+	record_response(context, operation, pdu);
+	update_host_timing(context, operation);
 
 	TRACEPRINT("Get response for %s, magic=%p from %s\n",
 			context->current_oid->name, magic, sp->peername);
@@ -2085,7 +2515,7 @@ int asynch_mixed_response(int operation, struct snmp_session *sp, int reqid _UNU
 			}
 
 			if (req) {
-				if (snmp_send(context->sess, req)) {
+				if ((newReqid = send_query(context, req))) {
 					if (TRACE) {
 						print_timestamp(verbose_file?verbose_file:stderr);
 					}
@@ -2109,11 +2539,18 @@ int asynch_mixed_response(int operation, struct snmp_session *sp, int reqid _UNU
 	/* something went wrong or end of variables
 	 * this host not active any more
 	 */
+	if (context->host->stats)
+		context->host->stats->totalTime += usec_since(&context->started);
 	if (state != Q_ERROR) {
+		struct timeval start;
+
 		TRACEPRINT("Process data\n");
 		time_print("[%s] Data collected\n", context->host->name);
+		gettimeofday(&start, NULL);
 		context->populated_data = context->processor(context->host,
 				context->result, context->fabric);
+		if (context->host->stats)
+			context->host->stats->processTime += usec_since(&start);
 	}
 
 	free_snmp_result(context->result);
@@ -2154,6 +2591,9 @@ HMGT_STATUS_T collect_data(SNMPHost *hosts, SNMPOid *sw_oids, SNMPOid *nic_oids,
 	struct context_s contexts[numHosts];
 	struct context_s *cs;
 
+	// hosts that are skipped below must not leave a stale session behind
+	memset(contexts, 0, sizeof(contexts));
+
 	//Convert user specified SNMP security parameters
 	int version = 0;
 	int secLevel = 0;
@@ -2239,14 +2679,22 @@ HMGT_STATUS_T collect_data(SNMPHost *hosts, SNMPOid *sw_oids, SNMPOid *nic_oids,
 
 		struct snmp_pdu *req;
 		struct snmp_session sess = {0};
+		struct timeval opened;
+		int reqid;
 
 		if (!hosts[count].name) {
 			fprintf(stderr, "WARNING - no host name defined. Skip.\n");
 			continue;
 		}
+		if (hosts[count].state == HOST_DEAD) {
+			DBGPRINT("Skip %s, it did not respond\n", hosts[count].name);
+			continue;
+		}
 
 		cs->host = &hosts[count];
-		if (hosts[count].type == STL_NODE_FI) {
+		if (hosts[count].oids) {
+			cs->current_oid = hosts[count].oids;
+		} else if (hosts[count].type == STL_NODE_FI) {
 			cs->current_oid = nic_oids;
 		} else {
                 	cs->current_oid = sw_oids;
@@ -2335,7 +2783,10 @@ HMGT_STATUS_T collect_data(SNMPHost *hosts, SNMPOid *sw_oids, SNMPOid *nic_oids,
 
 		sess.callback = asynch_mixed_response; /* default callback */
 		sess.callback_magic = cs;
+		gettimeofday(&opened, NULL);
 		cs->sess = snmp_open(&sess);
+		if (hosts[count].stats)
+			hosts[count].stats->connectTime += usec_since(&opened);
 		if (sess.peername) {
 			MemoryDeallocate(sess.peername);
 		}
@@ -2354,7 +2805,8 @@ HMGT_STATUS_T collect_data(SNMPHost *hosts, SNMPOid *sw_oids, SNMPOid *nic_oids,
 
 		req = prepare_snmp_query(cs);
 
-		if (snmp_send(cs->sess, req)) {
+		gettimeofday(&cs->started, NULL);
+		if ((reqid = send_query(cs, req))) {
 			active_hosts++;
 			if (TRACE) {
 				print_timestamp(verbose_file?verbose_file:stderr);
@@ -2764,21 +3216,695 @@ HMGT_STATUS_T cleanup_dev_data(QUICK_LIST *nodeList) {
 	return HMGT_STATUS_SUCCESS;
 }
 
-HMGT_STATUS_T hmgt_snmp_get_fabric_data(struct hmgt_port *port _UNUSED_,
+/*
+ * @brief copy the response state and timing learned while querying copies of
+ *        hosts back to the hosts, so later passes skip hosts that timed out
+ *        and the dead hosts file sees them
+ * @param queried	host copies passed to collect_data
+ * @param queriedIndex	index in hosts of each entry in queried
+ * @param count	number of entries in queried
+ */
+static void copy_host_timing(SNMPHost *hosts, const SNMPHost *queried,
+		const int *queriedIndex, uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		SNMPHost *host = &hosts[queriedIndex[i]];
+
+		host->state = queried[i].state;
+		host->srtt = queried[i].srtt;
+		host->rttvar = queried[i].rttvar;
+		host->rto = queried[i].rto;
+	}
+}
+
+/*
+ * Focus scoped sweeps.
+ * When only a few nodes are of interest (ethreport -F node:/nodepat:) there is
+ * no need to walk every table on every device. A pre-pass that only queries
+ * lldpRemSysName finds the one hop neighbors of the focused hosts, then the
+ * full query runs against the focused hosts plus those neighbors.
+ */
+#define FOCUS_MATCH		0x1	/* host matches the focus */
+#define FOCUS_NEIGHBOR	0x2	/* host is a neighbor of a focused host */
+
+typedef struct {
+	SNMPHost *hosts;	/* all configured hosts */
+	uint8 *marks;		/* FOCUS_* flags per entry in hosts */
+	int numHosts;
+	SNMPHost *queried;	/* hosts queried in the pre-pass */
+	int *queriedIndex;	/* index in hosts of each entry in queried */
+} FocusScope;
+
+static FocusScope focus_scope;
+
+/*
+ * @brief compare host names ignoring any domain suffix, since LLDP system
+ *        names and configured host names often differ in that
+ * @param name1	NUL terminated name
+ * @param name2	name that need not be NUL terminated
+ * @param len2	length of name2
+ * @return TRUE if the names refer to the same host
+ */
+static boolean host_name_match(const char *name1, const char *name2, size_t len2)
+{
+	size_t len1 = strlen(name1);
+	const char *dot;
+
+	if ((dot = memchr(name1, '.', len1)))
+		len1 = dot - name1;
+	if ((dot = memchr(name2, '.', len2)))
+		len2 = dot - name2;
+	return len1 == len2 && strncasecmp(name1, name2, len1) == 0;
+}
+
+/*
+ * @brief check if a host is selected by a node: or nodepat: focus
+ * @param focus	focus argument after the prefix, may be followed by ":port:#"
+ * @param pattern	TRUE if focus is a nodepat: pattern
+ * @return TRUE if the host is selected
+ */
+static boolean host_in_focus(const SNMPHost *host, const char *focus, boolean pattern)
+{
+	char name[STL_NODE_DESCRIPTION_ARRAY_SIZE+1];
+	const char *p = strchr(focus, ':');
+	int len = p ? (int)(p - focus) : (int)strlen(focus);
+
+	snprintf(name, sizeof(name), "%.*s", len, focus);
+	if (pattern)
+		return fnmatch(name, host->name, 0) == 0;
+	return host_name_match(name, host->name, strlen(host->name));
+}
+
+/*
+ * @brief phase 1 processor for the focus pre-pass. All LLDP neighbors of a
+ *        focused switch are marked. An unfocused switch is marked if it has a
+ *        focused neighbor, NICs don't run LLDP so the switch a focused NIC is
+ *        cabled to can only be found from the switch side.
+ */
+static void* process_focus_data(SNMPHost *host, SNMPResult *res,
+		FabricData_t *fabric _UNUSED_)
+{
+	int index = focus_scope.queriedIndex[host - focus_scope.queried];
+	boolean focused = (focus_scope.marks[index] & FOCUS_MATCH) != 0;
+	SNMPResult *rp;
+	int i;
+
+	for (rp = res; rp; rp = rp->next) {
+		if (!is_oid(rp, &lldpRemSysName) || !rp->valLen)
+			continue;
+		for (i = 0; i < focus_scope.numHosts; i++) {
+			if (!focused && !(focus_scope.marks[i] & FOCUS_MATCH))
+				continue;
+			if (!host_name_match(focus_scope.hosts[i].name,
+					(char *)rp->val.string, rp->valLen))
+				continue;
+			if (focused) {
+				focus_scope.marks[i] |= FOCUS_NEIGHBOR;
+			} else {
+				focus_scope.marks[index] |= FOCUS_NEIGHBOR;
+				break;
+			}
+		}
+	}
+	return NULL;
+}
+
+static HMGT_STATUS_T process_focus_fab_data(void **data _UNUSED_,
+		int numHosts _UNUSED_, FabricData_t *fabric _UNUSED_)
+{
+	return HMGT_STATUS_SUCCESS;
+}
+
+static HMGT_STATUS_T cleanup_focus_data(void *data _UNUSED_)
+{
+	return HMGT_STATUS_SUCCESS;
+}
+
+/*
+ * @brief reduce the hosts array to the hosts selected by pFabric->SnmpFocus
+ *        plus their one hop neighbors. Other focus formats, or a focus that
+ *        matches no configured host, leave the hosts array unchanged.
+ * @param sw_oids	OIDs for neighbor only switches when
+ *               	pFabric->SnmpFocusLimitStats is set
+ * @param nic_oids	OIDs for neighbor only NICs, same as above
+ */
+static HMGT_STATUS_T scope_hosts_to_focus(FabricData_t *pFabric, SNMPHost **hosts,
+		uint32_t *entries, SNMPOid *sw_oids, SNMPOid *nic_oids)
+{
+	SNMPOid lldp_oids[] = { ifNumber, lldpRemSysName, { NULL } };
+	SNMPHost *pHosts = *hosts;
+	SNMPHost *scoped = NULL;
+	const char *param;
+	boolean pattern;
+	boolean focusNic = FALSE;
+	uint32_t i, count, matched = 0;
+	HMGT_STATUS_T status = HMGT_STATUS_SUCCESS;
+
+	if (NULL != (param = ComparePrefix((char *)pFabric->SnmpFocus, "node:")))
+		pattern = FALSE;
+	else if (NULL != (param = ComparePrefix((char *)pFabric->SnmpFocus, "nodepat:")))
+		pattern = TRUE;
+	else
+		return HMGT_STATUS_SUCCESS;
+
+	memset(&focus_scope, 0, sizeof(focus_scope));
+	focus_scope.hosts = pHosts;
+	focus_scope.numHosts = *entries;
+	focus_scope.marks = MemoryAllocate2AndClear(*entries, IBA_MEM_FLAG_PREMPTABLE, SNMPTAG);
+	focus_scope.queried = MemoryAllocate2AndClear(*entries * sizeof(SNMPHost),
+			IBA_MEM_FLAG_PREMPTABLE, SNMPTAG);
+	focus_scope.queriedIndex = MemoryAllocate2AndClear(*entries * sizeof(int),
+			IBA_MEM_FLAG_PREMPTABLE, SNMPTAG);
+	if (!focus_scope.marks || !focus_scope.queried || !focus_scope.queriedIndex) {
+		fprintf(stderr, "ERROR - failed to allocate memory for focus.\n");
+		status = HMGT_STATUS_INSUFFICIENT_MEMORY;
+		goto done;
+	}
+
+	for (i = 0; i < *entries; i++) {
+		if (host_in_focus(&pHosts[i], param, pattern)) {
+			focus_scope.marks[i] = FOCUS_MATCH;
+			matched++;
+			if (pHosts[i].type == STL_NODE_FI)
+				focusNic = TRUE;
+		}
+	}
+	if (!matched) {
+		DBGPRINT("No SNMP host matches focus %s, sweep all hosts\n",
+				pFabric->SnmpFocus);
+		goto done;
+	}
+
+	// LLDP pre-pass against the focused switches, or against all switches
+	// when the switch of a focused NIC has to be found
+	for (i = 0, count = 0; i < *entries; i++) {
+		if (pHosts[i].type != STL_NODE_SW)
+			continue;
+		if (!focusNic && !(focus_scope.marks[i] & FOCUS_MATCH))
+			continue;
+		focus_scope.queried[count] = pHosts[i];
+		focus_scope.queried[count].oids = lldp_oids;
+		focus_scope.queriedIndex[count++] = i;
+	}
+	if (count) {
+		time_print("Start focus neighbor discovery on %u switches...\n", count);
+		status = collect_data(focus_scope.queried, lldp_oids, lldp_oids, count,
+				process_focus_data, process_focus_fab_data, cleanup_focus_data,
+				pFabric);
+		copy_host_timing(pHosts, focus_scope.queried, focus_scope.queriedIndex,
+				count);
+		if (status != HMGT_STATUS_SUCCESS)
+			goto done;
+	}
+
+	for (i = 0, count = 0; i < *entries; i++) {
+		if (focus_scope.marks[i])
+			count++;
+	}
+	scoped = MemoryAllocate2AndClear(count * sizeof(SNMPHost), IBA_MEM_FLAG_PREMPTABLE, SNMPTAG);
+	if (!scoped) {
+		fprintf(stderr, "ERROR - failed to allocate memory for hosts.\n");
+		status = HMGT_STATUS_INSUFFICIENT_MEMORY;
+		goto done;
+	}
+	for (i = 0, count = 0; i < *entries; i++) {
+		if (!focus_scope.marks[i]) {
+			if (pHosts[i].interfaces)
+				MemoryDeallocate(pHosts[i].interfaces);
+			continue;
+		}
+		scoped[count] = pHosts[i];
+		if (pFabric->SnmpFocusLimitStats && !(focus_scope.marks[i] & FOCUS_MATCH))
+			scoped[count].oids = (pHosts[i].type == STL_NODE_FI) ? nic_oids : sw_oids;
+		count++;
+	}
+	DBGPRINT("Focus %s selects %u of %u SNMP hosts\n", pFabric->SnmpFocus,
+			count, *entries);
+	MemoryDeallocate(pHosts);
+	*hosts = scoped;
+	*entries = count;
+
+done:
+	if (focus_scope.marks)
+		MemoryDeallocate(focus_scope.marks);
+	if (focus_scope.queried)
+		MemoryDeallocate(focus_scope.queried);
+	if (focus_scope.queriedIndex)
+		MemoryDeallocate(focus_scope.queriedIndex);
+	memset(&focus_scope, 0, sizeof(focus_scope));
+	return status;
+}
+
+/*
+ * Counters only re-sweep.
+ * Between sweeps of a stable fabric only the port counters change. With a
+ * cached topology in the fabric data (e.g. from a snapshot) each host is
+ * checked with a few scalar GETs and then only the counter columns are
+ * walked. If any host no longer matches the cache pFabric->SnmpCountersOnly
+ * is cleared so the caller can fall back to a full sweep.
+ */
+#define CACHE_UNKNOWN	0	/* host did not respond */
+#define CACHE_VALID		1	/* host matches the cached topology */
+#define CACHE_STALE		2	/* host changed since the cache was taken */
+
+typedef struct {
+	SNMPHost *queried;		/* hosts queried in the current pass */
+	int *queriedIndex;		/* index in the hosts array of each queried host */
+	uint8 *state;			/* CACHE_* per host */
+	cl_qmap_t *ifIndexMaps;	/* cached ifIndex to PortData map per host */
+} CounterCache;
+
+static CounterCache counter_cache;
+
+/*
+ * @brief add the ports of a cached node to the ifIndex map of its host, the
+ *        same ports process_dev_data maps for a full sweep
+ */
+static HMGT_STATUS_T map_cached_ports(NodeData *nodep, cl_qmap_t *ifIndexMap)
+{
+	cl_map_item_t *q;
+
+	for (q = cl_qmap_head(&nodep->Ports); q != cl_qmap_end(&nodep->Ports);
+			q = cl_qmap_next(q)) {
+		PortData *portp = PARENT_STRUCT(q, PortData, NodePortsEntry);
+
+		if (nodep->NodeInfo.NodeType == STL_NODE_SW && portp->PortNum == 0)
+			continue;
+		cl_map_obj_t *mapObj = create_map_obj(portp);
+		if (!mapObj)
+			return HMGT_STATUS_INSUFFICIENT_MEMORY;
+		if (cl_qmap_insert(ifIndexMap, portp->PortInfo.LID, &mapObj->item)
+				!= &mapObj->item)
+			MemoryDeallocate(mapObj);
+	}
+	return HMGT_STATUS_SUCCESS;
+}
+
+/*
+ * @brief find the ifName a cached NIC node was named after in a sweep
+ * @return the ifName result, NULL if no interface of the host matches desc
+ */
+static SNMPResult *find_nic_ifname(SNMPHost *host, SNMPResult *res,
+		const SNMPResult *sysNameRes, const char *desc)
+{
+	char expected[STL_NODE_DESCRIPTION_ARRAY_SIZE];
+	SNMPResult *rp;
+
+	for (rp = res; rp; rp = rp->next) {
+		if (!is_oid(rp, &ifName)
+				|| !is_supported_interface(host, (char*)rp->val.string, rp->valLen))
+			continue;
+		format_nic_desc(expected, sysNameRes, rp);
+		if (strncmp(desc, expected, STL_NODE_DESCRIPTION_ARRAY_SIZE) == 0)
+			return rp;
+	}
+	return NULL;
+}
+
+/*
+ * @brief phase 1 processor for the cache check. A host matches the cache
+ *        when it has not restarted since the cache was taken (a restart may
+ *        renumber ifIndex), its nodes are found by sysName and a switch still
+ *        reports the same ifNumber. A NIC node must be named after one of the
+ *        host's interfaces and still have its ifIndex.
+ */
+static void* process_cache_check(SNMPHost *host, SNMPResult *res,
+		FabricData_t *pFabric)
+{
+	int index = counter_cache.queriedIndex[host - counter_cache.queried];
+	char name[STL_NODE_DESCRIPTION_ARRAY_SIZE+1] = "";
+	SNMPResult *sysNameRes = NULL;
+	long uptime = -1;	/* in seconds */
+	long engineTime = -1;	/* in seconds */
+	int numIf = -1;
+	int found = 0;
+	SNMPResult *rp;
+	cl_map_item_t *p;
+
+	counter_cache.state[index] = CACHE_STALE;
+	for (rp = res; rp; rp = rp->next) {
+		if (is_oid(rp, &sysName)) {
+			snprintf(name, sizeof(name), "%.*s", (int)rp->valLen, rp->val.string);
+			sysNameRes = rp;
+		} else if (is_oid(rp, &snmpEngineTime)) {
+			engineTime = *(rp->val.integer);
+		} else if (is_oid(rp, &sysUpTime)) {
+			uptime = (long)(*(u_long *)rp->val.integer / 100);
+		} else if (is_oid(rp, &ifNumber)) {
+			numIf = (int) *(rp->val.integer);
+		}
+	}
+	// sysUpTime wraps after 497 days, snmpEngineTime counts seconds since the
+	// agent last (re)started and doesn't, so prefer it when the agent has it
+	if (engineTime >= 0)
+		uptime = engineTime;
+	if (!name[0] || uptime < 0) {
+		DBGPRINT("[%s] no sysName or uptime, cache not usable\n", host->name);
+		return NULL;
+	}
+	if (uptime < time(NULL) - pFabric->time) {
+		DBGPRINT("[%s] restarted since cached topology was taken\n", host->name);
+		return NULL;
+	}
+
+	for (p = cl_qmap_head(&pFabric->AllNodes); p != cl_qmap_end(&pFabric->AllNodes);
+			p = cl_qmap_next(p)) {
+		NodeData *nodep = PARENT_STRUCT(p, NodeData, AllNodesEntry);
+		const char *desc = (const char *)nodep->NodeDesc.NodeString;
+
+		if (nodep->NodeInfo.NodeType != host->type)
+			continue;
+		if (host->type == STL_NODE_SW) {
+			if (strncmp(desc, name, STL_NODE_DESCRIPTION_ARRAY_SIZE) != 0)
+				continue;
+			if (nodep->NodeInfo.NumPorts != numIf) {
+				DBGPRINT("[%s] ifNumber %d differs from cached %u\n", host->name,
+						numIf, nodep->NodeInfo.NumPorts);
+				return NULL;
+			}
+		} else {
+			rp = find_nic_ifname(host, res, sysNameRes, desc);
+			if (!rp)
+				continue;
+			PortData *portp = FindNodePort(nodep, 1);
+			if (!portp || portp->PortInfo.LID != (uint32)get_oid_num(rp, ifName.oidLen)) {
+				DBGPRINT("[%s] ifIndex of %s differs from cache\n", host->name, desc);
+				return NULL;
+			}
+		}
+		if (map_cached_ports(nodep, &counter_cache.ifIndexMaps[index])
+				!= HMGT_STATUS_SUCCESS)
+			return NULL;
+		found++;
+	}
+	if (!found) {
+		DBGPRINT("[%s] %s not in cached topology\n", host->name, name);
+		return NULL;
+	}
+	counter_cache.state[index] = CACHE_VALID;
+	return NULL;
+}
+
+/*
+ * @brief phase 1 processor for the counters pass. Fills in fresh counters for
+ *        every cached port of the host.
+ */
+static void* process_cache_counters(SNMPHost *host, SNMPResult *res,
+		FabricData_t *pFabric _UNUSED_)
+{
+	int index = counter_cache.queriedIndex[host - counter_cache.queried];
+	cl_qmap_t *ifIndexMap = &counter_cache.ifIndexMaps[index];
+	cl_map_item_t *p;
+
+	for (p = cl_qmap_head(ifIndexMap); p != cl_qmap_end(ifIndexMap);
+			p = cl_qmap_next(p)) {
+		PortData *portp = cl_qmap_obj(PARENT_STRUCT(p, cl_map_obj_t, item));
+
+		if (!portp->pPortCounters) {
+			portp->pPortCounters = MemoryAllocate2AndClear(
+					sizeof(STL_PORT_COUNTERS_DATA), IBA_MEM_FLAG_PREMPTABLE, SNMPTAG);
+			if (!portp->pPortCounters) {
+				fprintf(stderr, "ERROR - Couldn't allocate memory for port counters\n");
+				return NULL;
+			}
+		}
+	}
+	populate_port_counters(res, ifIndexMap);
+	return NULL;
+}
+
+static HMGT_STATUS_T process_cache_fab_data(void **data _UNUSED_,
+		int numHosts _UNUSED_, FabricData_t *fabric _UNUSED_)
+{
+	return HMGT_STATUS_SUCCESS;
+}
+
+static HMGT_STATUS_T cleanup_cache_data(void *data _UNUSED_)
+{
+	return HMGT_STATUS_SUCCESS;
+}
+
+/*
+ * @brief refresh port counters of the cached topology in pFabric
+ * @param sw_oids	counter columns to walk on switches
+ * @param nic_oids	counter columns to walk on NICs
+ */
+static HMGT_STATUS_T refresh_cached_counters(FabricData_t *pFabric, SNMPHost *hosts,
+		uint32_t entries, SNMPOid *sw_oids, SNMPOid *nic_oids)
+{
+	SNMPOid sw_check_oids[] = { sysName, snmpEngineTime, sysUpTime, ifNumber,
+		{ NULL } };
+	SNMPOid nic_check_oids[] = { sysName, snmpEngineTime, sysUpTime, ifName,
+		{ NULL } };
+	uint32_t i, count, stale = 0;
+	LIST_ITEM *lp;
+	HMGT_STATUS_T status = HMGT_STATUS_SUCCESS;
+
+	memset(&counter_cache, 0, sizeof(counter_cache));
+	counter_cache.queried = MemoryAllocate2AndClear(entries * sizeof(SNMPHost),
+			IBA_MEM_FLAG_PREMPTABLE, SNMPTAG);
+	counter_cache.queriedIndex = MemoryAllocate2AndClear(entries * sizeof(int),
+			IBA_MEM_FLAG_PREMPTABLE, SNMPTAG);
+	counter_cache.state = MemoryAllocate2AndClear(entries, IBA_MEM_FLAG_PREMPTABLE, SNMPTAG);
+	counter_cache.ifIndexMaps = MemoryAllocate2AndClear(entries * sizeof(cl_qmap_t),
+			IBA_MEM_FLAG_PREMPTABLE, SNMPTAG);
+	if (!counter_cache.queried || !counter_cache.queriedIndex
+			|| !counter_cache.state || !counter_cache.ifIndexMaps) {
+		fprintf(stderr, "ERROR - failed to allocate memory for counters refresh.\n");
+		status = HMGT_STATUS_INSUFFICIENT_MEMORY;
+		goto done;
+	}
+	for (i = 0; i < entries; i++) {
+		cl_qmap_init(&counter_cache.ifIndexMaps[i], NULL);
+		counter_cache.queried[i] = hosts[i];
+		counter_cache.queried[i].oids =
+				(hosts[i].type == STL_NODE_FI) ? nic_check_oids : sw_check_oids;
+		counter_cache.queriedIndex[i] = i;
+	}
+
+	time_print("Start cached topology check...\n");
+	status = collect_data(counter_cache.queried, sw_check_oids, nic_check_oids, entries,
+			process_cache_check, process_cache_fab_data, cleanup_cache_data, pFabric);
+	copy_host_timing(hosts, counter_cache.queried, counter_cache.queriedIndex,
+			entries);
+	if (status != HMGT_STATUS_SUCCESS)
+		goto done;
+	for (i = 0; i < entries; i++) {
+		if (counter_cache.state[i] == CACHE_STALE)
+			stale++;
+	}
+	if (stale) {
+		DBGPRINT("%u hosts changed since cached topology was taken\n", stale);
+		pFabric->SnmpCountersOnly = FALSE;
+		goto done;
+	}
+
+	// counters of hosts that don't respond must not look current
+	for (lp = QListHead(&pFabric->AllPorts); lp != NULL;
+			lp = QListNext(&pFabric->AllPorts, lp)) {
+		PortData *portp = (PortData *)QListObj(lp);
+
+		if (portp->pPortCounters) {
+			MemoryDeallocate(portp->pPortCounters);
+			portp->pPortCounters = NULL;
+		}
+	}
+
+	for (i = 0, count = 0; i < entries; i++) {
+		if (counter_cache.state[i] != CACHE_VALID)
+			continue;
+		counter_cache.queried[count] = hosts[i];
+		counter_cache.queried[count].oids =
+				(hosts[i].type == STL_NODE_FI) ? nic_oids : sw_oids;
+		counter_cache.queriedIndex[count++] = i;
+	}
+	time_print("Start counters refresh on %u hosts...\n", count);
+	if (count) {
+		status = collect_data(counter_cache.queried, sw_oids, nic_oids, count,
+				process_cache_counters, process_cache_fab_data, cleanup_cache_data,
+				pFabric);
+		copy_host_timing(hosts, counter_cache.queried, counter_cache.queriedIndex,
+				count);
+	}
+
+done:
+	if (counter_cache.ifIndexMaps) {
+		for (i = 0; i < entries; i++)
+			cleanup_map(&counter_cache.ifIndexMaps[i]);
+		MemoryDeallocate(counter_cache.ifIndexMaps);
+	}
+	if (counter_cache.state)
+		MemoryDeallocate(counter_cache.state);
+	if (counter_cache.queriedIndex)
+		MemoryDeallocate(counter_cache.queriedIndex);
+	if (counter_cache.queried)
+		MemoryDeallocate(counter_cache.queried);
+	memset(&counter_cache, 0, sizeof(counter_cache));
+	return status;
+}
+
+/*
+ * Recently dead hosts.
+ * Hosts whose first request timed out are kept in a file as "name time"
+ * lines for SNMP_DEAD_HOST_AGE seconds. Listed hosts are probed with a
+ * single request before they are queried in full.
+ */
+#define SNMP_DEAD_HOST_AGE (24*60*60)
+#define SNMP_DEAD_HOSTS_HEADER "# hpnmgt SNMP dead hosts"
+
+typedef struct {
+	char name[STL_NODE_DESCRIPTION_ARRAY_SIZE];
+	time_t time;
+} DeadHost;
+
+static const char *dead_hosts_path(struct hmgt_port *port, FabricData_t *pFabric,
+		char *path, size_t size)
+{
+	struct stat st;
+
+	if (port && port->dead_hosts_file) {
+		if (!port->dead_hosts_file[0])
+			return NULL;
+		snprintf(path, size, "%s", port->dead_hosts_file);
+	} else {
+		if (stat(HMGT_DEF_DEAD_HOSTS_DIR, &st) || !S_ISDIR(st.st_mode))
+			return NULL;
+		snprintf(path, size, "%s/snmp_dead_hosts.%s", HMGT_DEF_DEAD_HOSTS_DIR,
+				pFabric->name[0] ? pFabric->name : "default");
+	}
+	return path;
+}
+
+static SNMPHost *find_host(SNMPHost *hosts, uint32_t numHosts, const char *name)
+{
+	uint32_t i;
+
+	for (i = 0; i < numHosts; i++) {
+		if (hosts[i].name && !strcmp(hosts[i].name, name))
+			return &hosts[i];
+	}
+	return NULL;
+}
+
+/*
+ * @brief read the dead hosts list and mark the listed hosts for probing
+ * @return the number of entries returned in *list, which the caller frees
+ */
+static int load_dead_hosts(const char *path, SNMPHost *hosts, uint32_t numHosts,
+		DeadHost **list)
+{
+	FILE *fp;
+	char buffer[STL_NODE_DESCRIPTION_ARRAY_SIZE + 32];
+	time_t now = time(NULL);
+	int count = 0, size = 0;
+
+	*list = NULL;
+	if (!(fp = fopen(path, "r")))
+		return 0;
+	while (fgets(buffer, sizeof(buffer), fp)) {
+		DeadHost entry;
+		long long when;
+		SNMPHost *host;
+
+		if (buffer[0] == '#' || sscanf(buffer, "%63s %lld", entry.name, &when) != 2)
+			continue;
+		entry.time = (time_t)when;
+		if (now - entry.time > SNMP_DEAD_HOST_AGE)
+			continue;
+		if (count == size) {
+			DeadHost *tmp = realloc(*list, (size ? size * 2 : 16) * sizeof(DeadHost));
+			if (!tmp)
+				break;
+			*list = tmp;
+			size = size ? size * 2 : 16;
+		}
+		(*list)[count++] = entry;
+		if ((host = find_host(hosts, numHosts, entry.name)) && host->state == HOST_UNKNOWN) {
+			DBGPRINT("%s recently did not respond, probe it first\n", host->name);
+			host->state = HOST_PROBE;
+		}
+	}
+	fclose(fp);
+	return count;
+}
+
+/*
+ * @brief write back the dead hosts list. Hosts that responded are removed,
+ * hosts that did not are (re)added, entries of hosts not queried are kept.
+ */
+static void save_dead_hosts(const char *path, SNMPHost *hosts, uint32_t numHosts,
+		DeadHost *list, int count)
+{
+	FILE *fp;
+	char tmpPath[HMGT_CONFIG_PARAMS_PATH_SIZE + 8];
+	time_t now = time(NULL);
+	int i, written = 0;
+	uint32_t j;
+
+	snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+	if (!(fp = fopen(tmpPath, "w"))) {
+		DBGPRINT("Unable to write dead hosts file %s: %s\n", tmpPath, strerror(errno));
+		return;
+	}
+	fprintf(fp, "%s\n", SNMP_DEAD_HOSTS_HEADER);
+	for (i = 0; i < count; i++) {
+		SNMPHost *host = find_host(hosts, numHosts, list[i].name);
+
+		if (host && (host->state == HOST_ALIVE || host->state == HOST_DEAD))
+			continue;
+		fprintf(fp, "%s %lld\n", list[i].name, (long long)list[i].time);
+		written++;
+	}
+	for (j = 0; j < numHosts; j++) {
+		if (hosts[j].name && hosts[j].state == HOST_DEAD) {
+			fprintf(fp, "%s %lld\n", hosts[j].name, (long long)now);
+			written++;
+		}
+	}
+	if (fclose(fp)) {
+		DBGPRINT("Unable to write dead hosts file %s: %s\n", tmpPath, strerror(errno));
+		unlink(tmpPath);
+	} else if (!written) {
+		// nothing is dead, don't leave an empty list behind
+		unlink(tmpPath);
+		unlink(path);
+	} else if (rename(tmpPath, path)) {
+		DBGPRINT("Unable to update dead hosts file %s: %s\n", path, strerror(errno));
+		unlink(tmpPath);
+	}
+}
+
+HMGT_STATUS_T hmgt_snmp_get_fabric_data(struct hmgt_port *port,
 		HMGT_QUERY *pQuery, struct _HQUERY_RESULT_VALUES **ppQR)
 {
 	HMGT_STATUS_T status = HMGT_STATUS_SUCCESS;
 	uint32_t memSize, recSize, hostEntries;
 	FabricData_t *pFabric = pQuery->InputValue.FabricDataRecord.FabricDataPtr;
+	char deadPathBuf[HMGT_CONFIG_PARAMS_PATH_SIZE];
+	const char *deadPath;
+	DeadHost *deadHosts = NULL;
+	int numDeadHosts = 0;
 
 	if (!pFabric)
 		return HMGT_STATUS_INVALID_PARAMETER;
 
+	if (port) {
+		snmp_timeout_us = port->ms_timeout * 1000L;
+		snmp_retries = port->retry_count;
+	}
+
 	// Populate the hosts array with nodes specified in the hosts and switches configuration
 	// files.
 	SNMPHost *hosts = NULL;
 	if ((status = init_hosts(pFabric, &hosts, &hostEntries)))
 		goto done;
+	init_stats(pFabric, hosts, hostEntries);
+
+	deadPath = dead_hosts_path(port, pFabric, deadPathBuf, sizeof(deadPathBuf));
+	if (deadPath)
+		numDeadHosts = load_dead_hosts(deadPath, hosts, hostEntries, &deadHosts);
 
 	// Note: the order of the OIDs matters. How to process data of a later OID
 	// may depend on the data processing of a previous OID. E.g. we figure out
@@ -2868,7 +3994,35 @@ HMGT_STATUS_T hmgt_snmp_get_fabric_data(struct hmgt_port *port _UNUSED_,
 //			entPhysicalHardwareRev, entPhysicalFirmwareRev,
 //			entPhysicalSerialNum, entPhysicalMfgName, entPhysicalModelName,
 			{ NULL } };
-	if (pFabric->flags & FF_STATS) {
+	// only the counter columns, for refreshing a cached topology
+	SNMPOid sw_oids_counters[] = { ifNumber,
+			ifInDiscards, ifInErrors, ifInUnknownProtos, ifOutDiscards, ifOutErrors,
+			dot3StatsSingleCollisionFrames, dot3StatsMultipleCollisionFrames,
+			dot3StatsSQETestErrors, dot3StatsDeferredTransmissions,
+			dot3StatsLateCollisions, dot3StatsExcessiveCollisions,
+			dot3StatsCarrierSenseErrors, dot3HCStatsAlignmentErrors,
+			dot3HCStatsFCSErrors, dot3HCStatsInternalMacTransmitErrors,
+			dot3HCStatsFrameTooLongs, dot3HCStatsInternalMacReceiveErrors,
+			dot3HCStatsSymbolErrors,
+			ifHCInOctets, ifHCInUcastPkts, ifHCInMulticastPkts, ifHCOutOctets,
+			ifHCOutUcastPkts, ifHCOutMulticastPkts,
+			{ NULL } };
+	SNMPOid nic_oids_counters[] = { ifNumber,
+			ifInDiscards, ifInErrors, ifInUnknownProtos, ifOutDiscards, ifOutErrors,
+			dot3StatsDeferredTransmissions, dot3StatsCarrierSenseErrors,
+			ifHCInOctets, ifHCInUcastPkts, ifHCInMulticastPkts, ifHCOutOctets,
+			ifHCOutUcastPkts, ifHCOutMulticastPkts,
+			{ NULL } };
+	if (pFabric->SnmpFocus) {
+		status = scope_hosts_to_focus(pFabric, &hosts, &hostEntries,
+				sw_oids_basic, nic_oids_basic);
+		if (status != HMGT_STATUS_SUCCESS)
+			goto done;
+	}
+	if (pFabric->SnmpCountersOnly) {
+		status = refresh_cached_counters(pFabric, hosts, hostEntries,
+				sw_oids_counters, nic_oids_counters);
+	} else if (pFabric->flags & FF_STATS) {
 		status = collect_data(hosts, sw_oids_full, nic_oids_full, hostEntries,
 				(void* (*)(SNMPHost*, SNMPResult*, FabricData_t*)) process_dev_data,
 				(HMGT_STATUS_T (*)(void**, int, FabricData_t*)) process_fab_data,
@@ -2882,6 +4036,9 @@ HMGT_STATUS_T hmgt_snmp_get_fabric_data(struct hmgt_port *port _UNUSED_,
 				pFabric);
 	}
 
+	if (deadPath)
+		save_dead_hosts(deadPath, hosts, hostEntries, deadHosts, numDeadHosts);
+
 	recSize = sizeof(HPN_FABRICDATA_RECORD);
 	memSize = recSize;
 	memSize += sizeof (uint32_t); 
@@ -2904,5 +4061,8 @@ HMGT_STATUS_T hmgt_snmp_get_fabric_data(struct hmgt_port *port _UNUSED_,
 	pFDR->FabricDataRecord.FabricData = pFabric;
 
 done:
+	// port numbering profiles are only shared by the switches of one query
+	pn_gen_cache_cleanup();
+	free(deadHosts);
 	return status;
 }
@@ -50,6 +50,10 @@ struct context_s {
 	snmp_device_data_process processor; /* function that processors the SNMPResult data */
 	void *populated_data; /* data generated from processor */
 	FabricData_t *fabric; /* the fabric data */
+	struct timeval sent; /* when the outstanding request was sent */
+	long sentTimeout; /* timeout in us of the outstanding request */
+	SnmpColumnStats_t *sentColumn; /* telemetry of the outstanding request's column */
+	struct timeval started; /* when the first request was sent */
 };
 int active_hosts; /* hosts that we have not completed */
 typedef enum {
@@ -79,8 +83,10 @@ SNMPOid lldpRemSysName = { ".1.0.8802.1.1.2.1.4.1.1.9", SNMP_MSG_GETNEXT, {0}, 0
 SNMPOid lldpRemSysCapEnabled = { ".1.0.8802.1.1.2.1.4.1.1.12", SNMP_MSG_GETNEXT, {0}, 0 };
 
 SNMPOid sysObjectID = { ".1.3.6.1.2.1.1.2.0", SNMP_MSG_GET, {0}, 0 };
+SNMPOid sysUpTime = { ".1.3.6.1.2.1.1.3.0", SNMP_MSG_GET, {0}, 0 };
 SNMPOid sysName = { ".1.3.6.1.2.1.1.5.0", SNMP_MSG_GET, {0}, 0 };
 SNMPOid ifNumber = { ".1.3.6.1.2.1.2.1.0", SNMP_MSG_GET, {0}, 0 };
+SNMPOid snmpEngineTime = { ".1.3.6.1.6.3.10.2.1.3.0", SNMP_MSG_GET, {0}, 0 };
 SNMPOid ifIndex = { ".1.3.6.1.2.1.2.2.1.1", SNMP_MSG_GETNEXT, {0}, 0 };
 SNMPOid ifDescr = { ".1.3.6.1.2.1.2.2.1.2", SNMP_MSG_GETNEXT, {0}, 0 };
 SNMPOid ifType = { ".1.3.6.1.2.1.2.2.1.3", SNMP_MSG_GETNEXT, {0}, 0 };
@@ -147,7 +153,7 @@ SNMPOid *LLDPOids[] = { &lldpLocChassisId, &lldpLocSysName,
 	&lldpLocPortEntry, &lldpLocPortIdSubtype,
 	&lldpLocPortId, &lldpLocPortDesc, &lldpLocManAddrIfId, &lldpRemEntry,
 	&lldpRemChassisId, &lldpRemPortIdSubtype, &lldpRemPortId, &lldpRemSysName,
-	&lldpRemSysCapEnabled, &sysObjectID, &sysName, &ifNumber, &ifIndex, &ifDescr, &ifType,
+	&lldpRemSysCapEnabled, &sysObjectID, &sysUpTime, &sysName, &ifNumber, &snmpEngineTime, &ifIndex, &ifDescr, &ifType,
 	&ifMTU, &ifSpeed, &ifPhysAddress, &ifOperStatus, &ifInDiscards, &ifInErrors,
 	&ifInUnknownProtos, &ifOutDiscards, &ifOutErrors, &ipAdEntIfIndex,
 	&dot3StatsSingleCollisionFrames, &dot3StatsMultipleCollisionFrames,
@@ -46,12 +46,25 @@ extern "C" {
 #define FF_MAX_OID_LEN 24
 #define FF_SNMP_VAL_LEN 64
 
+typedef enum {
+	HOST_UNKNOWN,	/* no response yet */
+	HOST_PROBE,	/* recently dead, first request is sent without retries */
+	HOST_ALIVE,	/* responded during this query */
+	HOST_DEAD	/* first request timed out, skipped for the rest of the query */
+} SNMPHostState;
+
 typedef struct SNMPHost_s {
 	uint8 type;
 	char *name;
 	char *community;
 	int numInterface;
 	char **interfaces;
+	struct SNMPOid_s *oids; /* overrides the per type OIDs queried, if set */
+	SNMPHostState state;
+	uint32 srtt;	/* smoothed response time in us, 0 until first sample */
+	uint32 rttvar;	/* response time variation in us */
+	uint32 rto;	/* timeout in us for requests once the host responded */
+	SnmpHostStats_t *stats;	/* sweep telemetry, NULL if not recorded */
 } SNMPHost;
 
 typedef struct SNMPOid_s {
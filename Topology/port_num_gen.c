@@ -32,6 +32,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "port_num_gen.h"
 #include <ctype.h>
 #include <inttypes.h>
+#include <string.h>
 
 #define DEBUG 0
 #define DBGPRINT(format, args...) if (DEBUG) { fprintf(stderr, format, ##args); }
@@ -42,8 +43,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 // segment data structure
 typedef struct {
-	// segment key calculated from seg index and contents
+	// segment key from seg index and interned contents
 	uint64 key;
+	// hash of seg index and contents. Only used to order groups
+	uint64 order;
 	// value of the segment. For alphabet seg, it doesn't apply and
 	//  the value is always -1
 	int num;
@@ -51,6 +54,12 @@ typedef struct {
 
 // port data structure
 typedef struct {
+	// interned port name
+	char* name;
+	// number of registrations of the name
+	int reg_count;
+	// whether the name may have a port number
+	boolean valid;
 	// segments in a port name
 	pn_seg segments[MAX_SEGS];
 	// number of segments
@@ -65,8 +74,12 @@ typedef struct {
 
 // double linked group data structure
 typedef struct pn_group_s {
+	// item in the group map, keyed by group key
+	cl_map_item_t item;
 	// group key
 	uint64 key;
+	// hash of the group segments. Only used to order groups
+	uint64 order;
 	// the min port number in a group
 	uint16 min;
 	// the max port number in a group
@@ -81,6 +94,53 @@ typedef struct pn_group_s {
 	struct pn_group_s* next;
 } pn_group_item;
 
+// interned name. Names with the same hash are chained on the one in the map
+typedef struct pn_name_s {
+	// item in the name map, keyed by name hash
+	cl_map_item_t item;
+	// next name with the same hash
+	struct pn_name_s* next;
+	// unique id, never ZERO
+	uint64 id;
+	// length of the name
+	size_t len;
+	// the name, NUL terminated
+	char str[1];
+} pn_name;
+
+// port number of a port in a cached profile
+typedef struct {
+	// interned port name
+	uint64 name_id;
+	// port number
+	uint16 port_num;
+	// port number adjustment
+	int offset;
+} pn_profile_port;
+
+// cached port numbering of a switch model. Profiles with the same set key
+// are chained on the one in the map
+typedef struct pn_profile_s {
+	// item in the profile map, keyed by set key
+	cl_map_item_t item;
+	// next profile with the same set key
+	struct pn_profile_s* next;
+	// interned profile name, i.e. sysObjectID
+	uint64 profile_id;
+	// number of registrations, including repeated names
+	int reg_count;
+	// number of ports
+	int port_count;
+	// ports in ascending name id order
+	pn_profile_port ports[1];
+} pn_profile;
+
+// interned names and cached profiles shared by all pn_gen_t
+static cl_qmap_t pn_name_map;
+static cl_qmap_t pn_profile_map;
+static uint64 pn_name_count = 0;
+static boolean pn_cache_inited = FALSE;
+
 cl_map_obj_t *create_port_obj() {
 	pn_port_item* port = MemoryAllocate2AndClear(sizeof(pn_port_item), IBA_MEM_FLAG_PREMPTABLE, PNGTAG);
 	if (port == NULL) {
@@ -158,6 +218,16 @@ void pn_gen_init(pn_gen_t* const model) {
 	cl_qmap_init(&(model->seg_map), NULL);
 	cl_qmap_init(&(model->port_map), NULL);
 	model->processed = FALSE;
+	model->profile_id = 0;
+	model->reg_count = 0;
+}
+
+void pn_cache_init(void) {
+	if (!pn_cache_inited) {
+		cl_qmap_init(&pn_name_map, NULL);
+		cl_qmap_init(&pn_profile_map, NULL);
+		pn_cache_inited = TRUE;
+	}
 }
 
 uint64 cal_str_key(int index, char* const start, char* const end) {
@@ -169,6 +239,62 @@ uint64 cal_str_key(int index, char* const start, char* const end) {
 	return res;
 }
 
+/**
+ * FNV-1a hash of len bytes at data
+ */
+uint64 cal_data_hash(const void* data, size_t len) {
+	const uint8* p = (const uint8*)data;
+	uint64 res = 14695981039346656037ULL;
+	size_t i;
+	for (i = 0; i < len; i++) {
+		res ^= p[i];
+		res *= 1099511628211ULL;
+	}
+	return res;
+}
+
+/**
+ * Return the interned name described by len bytes at data. A name not seen
+ * before is interned with a new id when create is TRUE, otherwise NULL is
+ * returned. The name is found by its hash and then compared byte by byte,
+ * so two names never share an id even if their hashes collide. NULL is also
+ * returned if we run out of memory.
+ */
+pn_name* intern_name(const void* data, size_t len, boolean create) {
+	pn_cache_init();
+	uint64 hash = cal_data_hash(data, len);
+	pn_name* name = NULL;
+	cl_map_item_t* mItem = cl_qmap_get(&pn_name_map, hash);
+	if (mItem != cl_qmap_end(&pn_name_map)) {
+		for (name = PARENT_STRUCT(mItem, pn_name, item); name; name = name->next) {
+			if (name->len == len && memcmp(name->str, data, len) == 0) {
+				return name;
+			}
+		}
+	}
+	if (!create) {
+		return NULL;
+	}
+
+	pn_name* res = MemoryAllocate2AndClear(sizeof(pn_name) + len, IBA_MEM_FLAG_PREMPTABLE, PNGTAG);
+	if (res == NULL) {
+		fprintf(stderr, "ERROR - couldn't allocate memory for name!\n");
+		return NULL;
+	}
+	memcpy(res->str, data, len);
+	res->len = len;
+	res->id = ++pn_name_count;
+	if (mItem != cl_qmap_end(&pn_name_map)) {
+		// hash collision, chain it after the name in the map
+		name = PARENT_STRUCT(mItem, pn_name, item);
+		res->next = name->next;
+		name->next = res;
+	} else {
+		cl_qmap_insert(&pn_name_map, hash, &(res->item));
+	}
+	return res;
+}
+
 int parse_port_name(char* const port_name, pn_port_item* port_item) {
 	if (port_name == NULL) {
 		fprintf(stderr, "ERROR - port name is NULL!\n");
@@ -186,6 +312,7 @@ int parse_port_name(char* const port_name, pn_port_item* port_item) {
 	boolean is_num = FALSE;
 	boolean to_close_seg = FALSE;
 	int value = 0;
+	pn_name* seg_name;
 	//boolean
 	// state:
 	//  0 - NONE
@@ -227,7 +354,12 @@ int parse_port_name(char* const port_name, pn_port_item* port_item) {
 		if (state == 3 || to_close_seg) {
 			// close a segment
 			pn_seg* seg = &(port_item->segments[index]);
-			seg->key = cal_str_key(index+1, seg_start, p);
+			seg_name = intern_name(seg_start, p - seg_start, TRUE);
+			if (!seg_name) {
+				return PNG_NO_MEMORY;
+			}
+			seg->key = ((uint64)(index + 1) << 32) | seg_name->id;
+			seg->order = cal_str_key(index+1, seg_start, p);
 			seg->num = value;
 			to_close_seg = FALSE;
 			DBGPRINT("  Seg%d: start=%ld end=%ld num=%d\n",
@@ -257,7 +389,12 @@ int parse_port_name(char* const port_name, pn_port_item* port_item) {
 	if (state == 2) {
 		// process last segment
 		pn_seg* seg = &(port_item->segments[index]);
-		seg->key = cal_str_key(index+1, seg_start, p);
+		seg_name = intern_name(seg_start, p - seg_start, TRUE);
+		if (!seg_name) {
+			return PNG_NO_MEMORY;
+		}
+		seg->key = ((uint64)(index + 1) << 32) | seg_name->id;
+		seg->order = cal_str_key(index+1, seg_start, p);
 		seg->num = value;
 		DBGPRINT("  Seg%d: start=%ld end=%ld num=%d\n",
 			index, seg_start - port_name, p - port_name, seg->num);
@@ -284,40 +421,185 @@ uint8 update_count(cl_qmap_t* map, uint64 key) {
 	return *count;
 }
 
+int pn_gen_set_profile(pn_gen_t* const model, const char* const profile) {
+	if (model->processed) {
+		fprintf(stderr, "ERROR - couldn't set profile because model was already processed and locked!\n");
+		return PNG_ALREADY_PROCESSED;
+	}
+
+	if (profile == NULL || ! *profile) {
+		model->profile_id = 0;
+		return PNG_OK;
+	}
+	pn_name* name = intern_name(profile, strlen(profile), TRUE);
+	if (name == NULL) {
+		return PNG_NO_MEMORY;
+	}
+	model->profile_id = name->id;
+	return PNG_OK;
+}
+
 int pn_gen_register(pn_gen_t* const model, char* const port_name) {
 	if (model->processed) {
 		fprintf(stderr, "ERROR - couldn't register because model was already processed and locked!\n");
 		return PNG_ALREADY_PROCESSED;
 	}
+	if (port_name == NULL) {
+		fprintf(stderr, "ERROR - port name is NULL!\n");
+		return PNG_INVALID_PORT_NAME;
+	}
 
-	cl_map_obj_t *mapObj = create_port_obj();
-	if (mapObj == NULL) {
+	pn_name* name = intern_name(port_name, strlen(port_name), TRUE);
+	if (name == NULL) {
 		return PNG_NO_MEMORY;
 	}
-	uint64 key = cal_str_key(0, port_name, NULL);
-	cl_qmap_insert(&(model->port_map), key, &(mapObj->item));
-	DBGPRINT("Added <%s> with key:%"PRIu64"\n", port_name, key);
-	pn_port_item* ppitem = (pn_port_item*)mapObj->p_object;
+	pn_port_item* ppitem = NULL;
+	cl_map_item_t *mItem = cl_qmap_get(&(model->port_map), name->id);
+	if (mItem != cl_qmap_end(&(model->port_map))) {
+		// a repeated name counts its segments again
+		ppitem = cl_qmap_obj(PARENT_STRUCT(mItem, cl_map_obj_t, item));
+	} else {
+		cl_map_obj_t *mapObj = create_port_obj();
+		if (mapObj == NULL) {
+			return PNG_NO_MEMORY;
+		}
+		cl_qmap_insert(&(model->port_map), name->id, &(mapObj->item));
+		DBGPRINT("Added <%s> with key:%"PRIu64"\n", port_name, name->id);
+		ppitem = (pn_port_item*)mapObj->p_object;
+		ppitem->name = name->str;
+		ppitem->valid = TRUE;
+	}
+	ppitem->reg_count += 1;
+	model->reg_count += 1;
 
-	DBGPRINT("Parse <%s>\n", port_name);
-	int ret = parse_port_name(port_name, ppitem);
-	if (ret) {
-		return ret;
+	// the name is parsed when processed, so a switch that reuses a cached
+	// profile never parses it. Only report names we can't number now.
+	if (! *port_name) {
+		fprintf(stderr, "ERROR - empty port name!\n");
+		ppitem->valid = FALSE;
+		return PNG_INVALID_PORT_NAME;
 	}
-	DBGPRINT("  seg_count=%d\n", ppitem->seg_count);
-	int i = 0;
-	for (; i < ppitem->seg_count; i++) {
-		update_count(&(model->seg_map), ppitem->segments[i].key);
+	if (strpbrk(port_name, "0123456789") == NULL) {
+		fprintf(stderr, "ERROR - no number in port name!\n");
+		ppitem->valid = FALSE;
+		return PNG_INVALID_PORT_NAME;
+	}
+	return PNG_OK;
+}
+
+/**
+ * Parse registered port names and count their segments
+ */
+int parse_ports(pn_gen_t* const model) {
+	cl_map_item_t* port_item = cl_qmap_head(&(model->port_map));
+	for (; port_item != cl_qmap_end(&(model->port_map)); port_item = cl_qmap_next(port_item)) {
+		pn_port_item* port = cl_qmap_obj(PARENT_STRUCT(port_item, cl_map_obj_t, item));
+		if (!port->valid) {
+			continue;
+		}
+		DBGPRINT("Parse <%s>\n", port->name);
+		int ret = parse_port_name(port->name, port);
+		if (ret == PNG_NO_MEMORY) {
+			return ret;
+		} else if (ret) {
+			continue;
+		}
+		DBGPRINT("  seg_count=%d\n", port->seg_count);
+		int i, j;
+		for (i = 0; i < port->seg_count; i++) {
+			for (j = 0; j < port->reg_count; j++) {
+				update_count(&(model->seg_map), port->segments[i].key);
+			}
+		}
 	}
 	return PNG_OK;
 }
 
+/**
+ * Key of the registered port name set of a model. Port map is ordered by
+ * interned name id, so the same set always produces the same key.
+ */
+uint64 cal_set_key(pn_gen_t* const model) {
+	uint64 res = cal_data_hash(&(model->profile_id), sizeof(uint64));
+	res = (res ^ (uint64)model->reg_count) * 1099511628211ULL;
+	cl_map_item_t* mItem = cl_qmap_head(&(model->port_map));
+	for (; mItem != cl_qmap_end(&(model->port_map)); mItem = cl_qmap_next(mItem)) {
+		res = (res ^ mItem->key) * 1099511628211ULL;
+	}
+	return res;
+}
+
+/**
+ * Find the cached profile that has exactly the port names registered in a
+ * model. Return NULL if there is no such profile.
+ */
+pn_profile* find_profile(pn_gen_t* const model, uint64 set_key) {
+	int port_count = (int)cl_qmap_count(&(model->port_map));
+	cl_map_item_t* mItem = cl_qmap_get(&pn_profile_map, set_key);
+	if (mItem == cl_qmap_end(&pn_profile_map)) {
+		return NULL;
+	}
+
+	pn_profile* profile = PARENT_STRUCT(mItem, pn_profile, item);
+	for (; profile; profile = profile->next) {
+		if (profile->profile_id != model->profile_id
+				|| profile->reg_count != model->reg_count
+				|| profile->port_count != port_count) {
+			continue;
+		}
+		int i = 0;
+		cl_map_item_t* port_item = cl_qmap_head(&(model->port_map));
+		for (; i < port_count && port_item->key == profile->ports[i].name_id; i++) {
+			port_item = cl_qmap_next(port_item);
+		}
+		if (i == port_count) {
+			return profile;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Cache the port numbers of a processed model under its profile
+ */
+void save_profile(pn_gen_t* const model, uint64 set_key) {
+	int port_count = (int)cl_qmap_count(&(model->port_map));
+	pn_profile* profile = MemoryAllocate2AndClear(
+		sizeof(pn_profile) + sizeof(pn_profile_port) * port_count,
+		IBA_MEM_FLAG_PREMPTABLE, PNGTAG);
+	if (profile == NULL) {
+		// not fatal, the next switch of this model just isn't cached
+		fprintf(stderr, "ERROR - couldn't allocate memory for profile!\n");
+		return;
+	}
+	profile->profile_id = model->profile_id;
+	profile->reg_count = model->reg_count;
+	profile->port_count = port_count;
+
+	int i = 0;
+	cl_map_item_t* port_item = cl_qmap_head(&(model->port_map));
+	for (; i < port_count; i++, port_item = cl_qmap_next(port_item)) {
+		pn_port_item* port = cl_qmap_obj(PARENT_STRUCT(port_item, cl_map_obj_t, item));
+		profile->ports[i].name_id = port_item->key;
+		profile->ports[i].port_num = port->port_num;
+		profile->ports[i].offset = port->offset;
+	}
+
+	cl_map_item_t* mItem = cl_qmap_insert(&pn_profile_map, set_key, &(profile->item));
+	if (mItem != &(profile->item)) {
+		// set key collision, chain it after the profile in the map
+		pn_profile* head = PARENT_STRUCT(mItem, pn_profile, item);
+		profile->next = head->next;
+		head->next = profile;
+	}
+}
+
 /**
  * Compare two groups, g1 and g2.
  *
  * When order groups, if g1 has larger occurrence than g2, g1 will be before
  * g2, i.e. smaller than g2. If they have the same occurrence, g1 is before
- * g2 if it has smaller start port number. Please note the followed key
+ * g2 if it has smaller start port number. Please note the followed hash
  * comparison if g1 and g2 have the same start port number has no any physical
  * meaning. The intention is to ensure repeatable sort order.
  */
@@ -330,6 +612,10 @@ int compare_groups(pn_group_item* g1, pn_group_item* g2) {
 		return -1;
 	} else if (g1->min > g2->min) {
 		return 1;
+	} else if (g1->order < g2->order) {
+		return -1;
+	} else if (g1->order > g2->order) {
+		return 1;
 	} else if (g1->key < g2->key) {
 		return -1;
 	} else if (g1->key > g2->key) {
@@ -402,6 +688,29 @@ int pn_gen_process(pn_gen_t* const model) {
 	cl_map_item_t* seg_item = NULL;
 	const cl_map_item_t* seg_end_item = cl_qmap_end(&(model->seg_map));
 	boolean has_confliction = FALSE;
+	uint64 set_key = 0;
+
+	if (model->profile_id) {
+		// switches of the same model usually have the same port names, so
+		// reuse the port numbers we figured out for a previous one
+		set_key = cal_set_key(model);
+		pn_profile* profile = find_profile(model, set_key);
+		if (profile) {
+			for (i = 0; i < profile->port_count; i++, port_item = cl_qmap_next(port_item)) {
+				port = cl_qmap_obj(PARENT_STRUCT(port_item, cl_map_obj_t, item));
+				port->port_num = profile->ports[i].port_num;
+				port->offset = profile->ports[i].offset;
+			}
+			DBGPRINT("Reused profile %"PRIu64" for %d ports\n", model->profile_id, profile->port_count);
+			model->processed = TRUE;
+			return PNG_OK;
+		}
+	}
+
+	int ret = parse_ports(model);
+	if (ret) {
+		return ret;
+	}
 
 	// Port array stores port items from port number 0 to 65535. We support
 	// up to 65535 ports since we are using unit16 as port number. This array
@@ -415,6 +724,10 @@ int pn_gen_process(pn_gen_t* const model) {
 
 	pn_group_item* group_head = NULL;
 	pn_group_item* group_tail = NULL;
+	// groups by group key
+	cl_qmap_t group_map;
+	cl_qmap_init(&group_map, NULL);
+	cl_map_item_t* group_map_item = NULL;
 
 	for (; port_item != port_end_item; port_item = cl_qmap_next(port_item)) {
 		// check each port
@@ -463,32 +776,42 @@ int pn_gen_process(pn_gen_t* const model) {
 				return PNG_INVALID_PORT_NAME;
 			}
 			DBGPRINT("  port<%"PRIu64">: index=%d portNum=%d\n", port_item->key, pn_index, port->port_num);
-			// calculate group key. Please note the key is based on
-			// seg key that already includes seg index info.
-			uint64 g_key = 0;
+			// calculate group key from the interned seg keys of all
+			// segments but the port number. Please note seg key already
+			// includes seg index info.
+			uint64 g_segs[MAX_SEGS];
+			int g_seg_count = 0;
+			uint64 g_order = 0;
 			for (i = 0; i < port->seg_count; i++) {
 				if (i != pn_index) {
-					g_key = 31 * g_key + port->segments[i].key;
+					g_segs[g_seg_count++] = port->segments[i].key;
+					g_order = 31 * g_order + port->segments[i].order;
+				}
+			}
+			pn_name* g_name = intern_name(g_segs, sizeof(uint64) * g_seg_count, TRUE);
+			if (!g_name) {
+				MemoryDeallocate(full_ports);
+				if (group_head) {
+					free_group_item(group_head);
 				}
+				return PNG_NO_MEMORY;
 			}
+			uint64 g_key = g_name->id;
 			port->group_key = g_key;
 
 			// update group port range if it already exists
-			pn_group_item* pitem = group_head;
-			while (pitem) {
-				if (pitem->key == g_key) {
-					if (port->port_num > pitem->max) {
-						pitem->max = port->port_num;
-					}
-					if (port->port_num < pitem->min) {
-						pitem->min = port->port_num;
-					}
-					pitem->count += 1;
-					break;
+			pn_group_item* pitem = NULL;
+			group_map_item = cl_qmap_get(&group_map, g_key);
+			if (group_map_item != cl_qmap_end(&group_map)) {
+				pitem = PARENT_STRUCT(group_map_item, pn_group_item, item);
+				if (port->port_num > pitem->max) {
+					pitem->max = port->port_num;
 				}
-				pitem = pitem->next;
-			}
-			if (!pitem) {
+				if (port->port_num < pitem->min) {
+					pitem->min = port->port_num;
+				}
+				pitem->count += 1;
+			} else {
 				// new group
 				pn_group_item* g_item = create_group_item();
 				if (!g_item) {
@@ -499,6 +822,7 @@ int pn_gen_process(pn_gen_t* const model) {
 					return PNG_NO_MEMORY;
 				}
 				g_item->key = g_key;
+				g_item->order = g_order;
 				g_item->min = g_item->max = port->port_num;
 				g_item->count = 1;
 				g_item->offset = 0;
@@ -512,6 +836,7 @@ int pn_gen_process(pn_gen_t* const model) {
 				} else {
 					group_head = group_tail = g_item;
 				}
+				cl_qmap_insert(&group_map, g_key, &(g_item->item));
 			}
         	} else {
         		// shouldn't happen
@@ -543,7 +868,9 @@ int pn_gen_process(pn_gen_t* const model) {
 		for (port_item = cl_qmap_head(&(model->port_map)); port_item != port_end_item;
 				port_item = cl_qmap_next(port_item)) {
 			port = cl_qmap_obj(PARENT_STRUCT(port_item, cl_map_obj_t, item));
-			for (item = group_head; item && item->key != port->group_key; item = item->next);
+			group_map_item = cl_qmap_get(&group_map, port->group_key);
+			item = group_map_item != cl_qmap_end(&group_map)
+				? PARENT_STRUCT(group_map_item, pn_group_item, item) : NULL;
 			if (item) {
 				port->offset = item->offset;
 				DBGPRINT("Adjusted port<%"PRIu64">: group=%"PRIu64" port_num=%d offset=%d\n",
@@ -558,6 +885,9 @@ int pn_gen_process(pn_gen_t* const model) {
 	model->processed = TRUE;
 	MemoryDeallocate(full_ports);
 	free_group_item(group_head);
+	if (model->profile_id) {
+		save_profile(model, set_key);
+	}
 	return PNG_OK;
 }
 
@@ -568,9 +898,9 @@ uint16 pn_gen_get_port(pn_gen_t* const model, char* const port_name) {
 	}
 
 	cl_qmap_t* map = &(model->port_map);
-	uint64 key = cal_str_key(0, port_name, NULL);
-	cl_map_item_t *mItem = cl_qmap_get(map, key);
-	if (mItem != cl_qmap_end(map)) {
+	pn_name* name = port_name ? intern_name(port_name, strlen(port_name), FALSE) : NULL;
+	cl_map_item_t *mItem = name ? cl_qmap_get(map, name->id) : NULL;
+	if (mItem && mItem != cl_qmap_end(map)) {
 		pn_port_item* port = cl_qmap_obj(PARENT_STRUCT(mItem, cl_map_obj_t, item));
 		int port_num = port->port_num + port->offset;
 		if (port_num >= MAX_PORT_NUM) {
@@ -598,6 +928,37 @@ void pn_gen_cleanup(pn_gen_t* const model) {
 	cl_qmap_remove_all(map);
 }
 
+void pn_gen_cache_cleanup(void) {
+	if (!pn_cache_inited) {
+		return;
+	}
+
+	cl_map_item_t* mItem = cl_qmap_head(&pn_profile_map);
+	while (mItem != cl_qmap_end(&pn_profile_map)) {
+		pn_profile* profile = PARENT_STRUCT(mItem, pn_profile, item);
+		mItem = cl_qmap_next(mItem);
+		while (profile) {
+			pn_profile* next = profile->next;
+			MemoryDeallocate(profile);
+			profile = next;
+		}
+	}
+	cl_qmap_remove_all(&pn_profile_map);
+
+	mItem = cl_qmap_head(&pn_name_map);
+	while (mItem != cl_qmap_end(&pn_name_map)) {
+		pn_name* name = PARENT_STRUCT(mItem, pn_name, item);
+		mItem = cl_qmap_next(mItem);
+		while (name) {
+			pn_name* next = name->next;
+			MemoryDeallocate(name);
+			name = next;
+		}
+	}
+	cl_qmap_remove_all(&pn_name_map);
+	pn_name_count = 0;
+}
+
 #if 0
 //------- unit test code ---------//
 
@@ -67,6 +67,15 @@ extern "C" {
  * initialize it, then call pn_gen_register to register ALL port names. After
  * that, pn_gen_get_port will return a port name for a given port name. Finally,
  * please call pn_gen_cleanup to release used resources.
+ *
+ * Port names are interned, so maps are keyed by unique name ids rather than
+ * by name hashes. A model may also be given a profile, such as the switch's
+ * sysObjectID, with pn_gen_set_profile. The port numbers figured out for a
+ * profile and port name set are cached and reused by any later model with
+ * the same profile and the same port names, so a fabric with many switches
+ * of the same model only runs the numbering once per model. Interned names
+ * and cached profiles are shared by all models and are not thread safe.
+ * Call pn_gen_cache_cleanup to release them once no model is in use.
  */
 
 #include <iba/ipublic.h>
@@ -86,6 +95,10 @@ typedef struct {
 	cl_qmap_t port_map;
 	// indicate whether the data was processed or not
 	boolean processed;
+	// interned profile name, ZERO if port numbers shall not be cached
+	uint64 profile_id;
+	// number of registrations, including repeated port names
+	int reg_count;
 } pn_gen_t;
 
 /**
@@ -93,6 +106,19 @@ typedef struct {
  */
 void pn_gen_init(pn_gen_t* const model);
 
+/**
+ * Set the profile of a port number generator described by pn_gen_t. Port
+ * numbers are cached by profile and port name set, so a profile shall
+ * identify a switch model, e.g. its sysObjectID. A NULL or empty profile
+ * disables caching. Must be called before pn_gen_get_port.
+ *
+ * Return value indicates states. A value of ZERO means success, otherwise
+ * it's an error code that can be
+ *  PNG_NO_MEMORY - memory allocation failure
+ *  PNG_ALREADY_PROCESSED - data was already processed, so the model is locked.
+ */
+int pn_gen_set_profile(pn_gen_t* const model, const char* const profile);
+
 /**
  * Register a port name into a port number generator described by pn_gen_t
  *
@@ -121,6 +147,12 @@ uint16 pn_gen_get_port(pn_gen_t* const model, char* const port_name);
  */
 void pn_gen_cleanup(pn_gen_t* const model);
 
+/**
+ * Release interned port names and cached profiles shared by all port number
+ * generators. Must not be called while any pn_gen_t is in use.
+ */
+void pn_gen_cache_cleanup(void);
+
 #ifdef __cplusplus
 }
 #endif
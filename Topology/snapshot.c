@@ -34,6 +34,13 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "topology_internal.h"
 #include <stl_helper.h>
 #include "hpnmgt.h"
+#ifndef __VXWORKS__
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 /* this file supports fabric snapshot generation and parsing */
 
@@ -553,17 +560,14 @@ void Snapshot_PortDataFree(PortData * portp, FabricData_t * fabricp);
 void Snapshot_NodeDataFree(NodeData * nodep, FabricData_t * fabricp);
 
 /**
-	Completion handler for PortData inside a snapshot.
+	Node local part of PortData completion: validate the port and add it
+	to its node's Ports.  Nothing shared by the fabric is touched, so the
+	parallel loader also calls this from its worker threads.
 */
-static int Snapshot_PortDataComplete(IXmlParserState_t * state, void * object, void * parent)
+static int Snapshot_PortDataAddToNode(IXmlParserState_t * state, PortData *portp, NodeData *nodep)
 {
 	const IXML_FIELD *p;
 	unsigned int i;
-	PortData *portp = (PortData*)object;
-	NodeData *nodep = portp->nodep;
-	FabricData_t *fabricp = IXmlParserGetContext(state);
-
-	ASSERT(nodep == (NodeData*)parent);
 
 	// technically <Port> could preceed <NodeType> within <Node>
 	if (nodep->NodeInfo.NodeType == STL_NODE_SW) {
@@ -583,20 +587,6 @@ static int Snapshot_PortDataComplete(IXmlParserState_t * state, void * object, v
 		}
 	}
 
-	if (cl_qmap_insert(&nodep->Ports, portp->PortNum, &portp->NodePortsEntry) != &portp->NodePortsEntry)
-	{
-		IXmlParserPrintError(state, "Duplicate PortNum: %u", portp->PortNum);
-		goto failinsert2;
-	}
-	if (FSUCCESS != AllLidsAdd(fabricp, portp, FALSE))
-	{
-		IXmlParserPrintError(state, "Duplicate IfIDs found in portRecords: IfID 0x%x Port %u Node: %.*s\n",
-					portp->EndPortLID,
-					portp->PortNum, STL_NODE_DESCRIPTION_ARRAY_SIZE,
-					(char*)nodep->NodeDesc.NodeString);
-		goto failinsert2;
-	}
-
 	// Handling to deal with fields not defined in STL Gen 1, but required in Gen 2. Allows forward compatability
 	// of snapshots.
 	for (p=state->current.subfields,i=0; p->tag != NULL; ++i,++p) {
@@ -614,28 +604,61 @@ static int Snapshot_PortDataComplete(IXmlParserState_t * state, void * object, v
 		}
 	}
 
+	if (cl_qmap_insert(&nodep->Ports, portp->PortNum, &portp->NodePortsEntry) != &portp->NodePortsEntry)
+	{
+		IXmlParserPrintError(state, "Duplicate PortNum: %u", portp->PortNum);
+		return FERROR;
+	}
 	return FSUCCESS;
-
-failinsert2:
-	cl_qmap_remove_item(&nodep->Ports, &portp->NodePortsEntry);
-	return FERROR;
 }
 
-static void PortDataXmlParserEnd(IXmlParserState_t *state, const IXML_FIELD *field _UNUSED_, void *object, void *parent, XML_Char *content _UNUSED_, unsigned len _UNUSED_, boolean valid)
+/**
+	Completion handler for PortData inside a snapshot.
+*/
+static int Snapshot_PortDataComplete(IXmlParserState_t * state, void * object, void * parent)
 {
 	PortData *portp = (PortData*)object;
+	NodeData *nodep = portp->nodep;
 	FabricData_t *fabricp = IXmlParserGetContext(state);
 
-	ParseCompleteFn parseCompleteFn = GetPortDataComplete();
+	ASSERT(nodep == (NodeData*)parent);
 
-	if (! valid)	// missing mandatory fields
-		goto failvalidate;
+	if (FSUCCESS != Snapshot_PortDataAddToNode(state, portp, nodep))
+		return FERROR;
+	if (FSUCCESS != AllLidsAdd(fabricp, portp, FALSE))
+	{
+		IXmlParserPrintError(state, "Duplicate IfIDs found in portRecords: IfID 0x%x Port %u Node: %.*s\n",
+					portp->EndPortLID,
+					portp->PortNum, STL_NODE_DESCRIPTION_ARRAY_SIZE,
+					(char*)nodep->NodeDesc.NodeString);
+		cl_qmap_remove_item(&nodep->Ports, &portp->NodePortsEntry);
+		return FERROR;
+	}
+
+	return FSUCCESS;
+}
 
+/* fields computed from the parsed PortInfo */
+static void PortDataXmlParserDerive(PortData *portp)
+{
 	portp->rate = EthIfSpeedToStaticRate(portp->PortInfo.IfSpeed);
 
 	if (portp->pPortCounters) {
 		portp->pPortCounters->lq.s.numLanesDown = StlGetNumLanesDown(&portp->PortInfo);
 	}
+}
+
+static void PortDataXmlParserEnd(IXmlParserState_t *state, const IXML_FIELD *field _UNUSED_, void *object, void *parent, XML_Char *content _UNUSED_, unsigned len _UNUSED_, boolean valid)
+{
+	PortData *portp = (PortData*)object;
+	FabricData_t *fabricp = IXmlParserGetContext(state);
+
+	ParseCompleteFn parseCompleteFn = GetPortDataComplete();
+
+	if (! valid)	// missing mandatory fields
+		goto failvalidate;
+
+	PortDataXmlParserDerive(portp);
 
 	if (parseCompleteFn) {
 		if (parseCompleteFn(state, object, parent) != FSUCCESS) {
@@ -887,6 +910,44 @@ static void *LinkXmlParserStart(IXmlParserState_t *state _UNUSED_, void *parent
 	return &link;
 }
 
+/* connect the two ports of a validated <Link> */
+static void SnapshotLinkPorts(FabricData_t *fabricp, PortData *p1, PortData *p2)
+{
+	p1->neighbor = p2;
+	p2->neighbor = p1;
+	p1->from = 1;
+	++(fabricp->LinkCount);
+	if (! isInternalLink(p1))
+		++(fabricp->ExtLinkCount);
+	if (isFILink(p1))
+		++(fabricp->FILinkCount);
+	if (isISLink(p1))
+		++(fabricp->ISLinkCount);
+	if (! isInternalLink(p1)&& isISLink(p1))
+		++(fabricp->ExtISLinkCount);
+}
+
+static void SnapshotLinkCheckRate(PortData *p1, PortData *p2)
+{
+	if (p1->rate != p2->rate) {
+		fprintf(stderr, "%s: Warning: Ignoring Inconsistent Active Speed/Width for link between:\n", g_Top_cmdname);
+		fprintf(stderr, "  %4s 0x%016"PRIx64" %3u %s %.*s\n",
+				StlStaticRateToText(p1->rate),
+				p1->nodep->NodeInfo.NodeGUID,
+				p1->PortNum,
+				StlNodeTypeToText(p1->nodep->NodeInfo.NodeType),
+				STL_NODE_DESCRIPTION_ARRAY_SIZE,
+				(char*)p1->nodep->NodeDesc.NodeString);
+		fprintf(stderr, "  %4s 0x%016"PRIx64" %3u %s %.*s\n",
+				StlStaticRateToText(p2->rate),
+				p2->nodep->NodeInfo.NodeGUID,
+				p2->PortNum,
+				StlNodeTypeToText(p2->nodep->NodeInfo.NodeType),
+				STL_NODE_DESCRIPTION_ARRAY_SIZE,
+				(char*)p2->nodep->NodeDesc.NodeString);
+	}
+}
+
 static void LinkXmlParserEnd(
 	IXmlParserState_t *state,
 	const IXML_FIELD *field _UNUSED_,
@@ -924,35 +985,8 @@ static void LinkXmlParserEnd(
 								link->to.NodeGUID, link->to.PortNum);
 		goto badport;
 	}
-	p1->neighbor = p2;
-	p2->neighbor = p1;
-	p1->from = 1;
-	if (p1->rate != p2->rate) {
-		fprintf(stderr, "%s: Warning: Ignoring Inconsistent Active Speed/Width for link between:\n", g_Top_cmdname);
-		fprintf(stderr, "  %4s 0x%016"PRIx64" %3u %s %.*s\n",
-				StlStaticRateToText(p1->rate),
-				p1->nodep->NodeInfo.NodeGUID,
-				p1->PortNum,
-				StlNodeTypeToText(p1->nodep->NodeInfo.NodeType),
-				STL_NODE_DESCRIPTION_ARRAY_SIZE,
-				(char*)p1->nodep->NodeDesc.NodeString);
-		fprintf(stderr, "  %4s 0x%016"PRIx64" %3u %s %.*s\n",
-				StlStaticRateToText(p2->rate),
-				p2->nodep->NodeInfo.NodeGUID,
-				p2->PortNum,
-				StlNodeTypeToText(p2->nodep->NodeInfo.NodeType),
-				STL_NODE_DESCRIPTION_ARRAY_SIZE,
-				(char*)p2->nodep->NodeDesc.NodeString);
-	}
-	++(fabricp->LinkCount);
-	if (! isInternalLink(p1))
-		++(fabricp->ExtLinkCount);
-	if (isFILink(p1))
-		++(fabricp->FILinkCount);
-	if (isISLink(p1))
-		++(fabricp->ISLinkCount);
-	if (! isInternalLink(p1)&& isISLink(p1))
-		++(fabricp->ExtISLinkCount);
+	SnapshotLinkPorts(fabricp, p1, p2);
+	SnapshotLinkCheckRate(p1, p2);
 
 badport:
 invalid:
@@ -1149,6 +1183,570 @@ fail:
 
 
 #ifndef __VXWORKS__
+/****************************************************************************/
+/* Parallel snapshot parsing
+ *
+ * A multi-GB snapshot keeps a single expat instance busy for a long time.
+ * For a large regular file the snapshot is mmap'ed and the contents of
+ * <Nodes> and <Links> are cut into element aligned chunks, each parsed by
+ * its own expat instance in a worker thread.  Text and attribute values
+ * cannot contain a literal '<', so a "<Node " or "<Link>" match always
+ * starts an element.
+ *
+ * Node workers only build node local state (the NodeData and its Ports)
+ * and Link workers only resolve ports with read only lookups.  The main
+ * thread merges each chunk, in file order, as soon as its worker is done,
+ * so AllPorts order, duplicate detection and warnings match a sequential
+ * parse.  On any failure the partial fabric is discarded and the file is
+ * reparsed sequentially, which reports the problem with line numbers.
+ */
+#define SNAPSHOT_PARALLEL_MIN_SIZE		(32*1024*1024)	/* smaller files parse sequentially */
+#define SNAPSHOT_PARALLEL_MAX_THREADS	16
+
+/* a completed Node or PortInfo within a <Nodes> chunk */
+typedef struct SnapshotChunkItem_s {
+	void *object;
+	boolean isNode;
+} SnapshotChunkItem_t;
+
+/* a <Link> within a <Links> chunk and the ports it resolved to */
+typedef struct SnapshotChunkLink_s {
+	TempLinkData_t link;	/* must be first, it is the parser object */
+	PortData *p1;
+	PortData *p2;
+} SnapshotChunkLink_t;
+
+typedef struct SnapshotChunk_s {
+	FabricData_t *fabricp;		/* only read by the worker */
+	const IXML_FIELD *fields;	/* top level fields for the section */
+	const char *section;		/* "Nodes" or "Links" */
+	const char *start;			/* element aligned slice of the section */
+	size_t len;
+	pthread_t thread;
+	boolean threaded;
+	FSTATUS status;
+	SnapshotChunkItem_t *items;	/* Nodes and Ports in end tag order */
+	unsigned numItems;
+	unsigned maxItems;
+	unsigned merged;			/* items already merged into fabricp */
+	SnapshotChunkLink_t *links;	/* Links in file order */
+	unsigned numLinks;
+	unsigned maxLinks;
+} SnapshotChunk_t;
+
+/* workers fail quietly, the sequential reparse reports the error */
+static void SnapshotQuietMessage(const char *message _UNUSED_)
+{
+}
+
+/* make room for one more entry in a chunk array, returns new array or NULL */
+static void *SnapshotChunkGrow(void *array, unsigned *max, unsigned count, size_t size)
+{
+	unsigned newmax;
+
+	if (count < *max)
+		return array;
+	newmax = *max ? *max * 2 : 1024;
+	array = realloc(array, newmax * size);
+	if (array)
+		*max = newmax;
+	return array;
+}
+
+static boolean SnapshotChunkAddItem(IXmlParserState_t *state, SnapshotChunk_t *chunk, void *object, boolean isNode)
+{
+	SnapshotChunkItem_t *items = SnapshotChunkGrow(chunk->items, &chunk->maxItems, chunk->numItems, sizeof(*items));
+
+	if (! items) {
+		IXmlParserPrintError(state, "Unable to allocate memory");
+		return FALSE;
+	}
+	chunk->items = items;
+	items[chunk->numItems].object = object;
+	items[chunk->numItems].isNode = isNode;
+	chunk->numItems++;
+	return TRUE;
+}
+
+/* free a Node built by a worker which never made it into the fabric */
+static void SnapshotChunkNodeFree(FabricData_t *fabricp, NodeData *nodep)
+{
+	cl_map_item_t *p;
+
+	while ((p = cl_qmap_head(&nodep->Ports)) != cl_qmap_end(&nodep->Ports)) {
+		PortData *portp = PARENT_STRUCT(p, PortData, NodePortsEntry);
+
+		cl_qmap_remove_item(&nodep->Ports, p);
+		Snapshot_PortDataFree(portp, fabricp);
+		MemoryDeallocate(portp);
+	}
+	if (nodep->pSwitchInfo)
+		MemoryDeallocate(nodep->pSwitchInfo);
+	NodeDataFreeSwitchData(fabricp, nodep);
+	MemoryDeallocate(nodep);
+}
+
+static void PortDataChunkXmlParserEnd(IXmlParserState_t *state, const IXML_FIELD *field _UNUSED_, void *object, void *parent, XML_Char *content _UNUSED_, unsigned len _UNUSED_, boolean valid)
+{
+	PortData *portp = (PortData*)object;
+	NodeData *nodep = (NodeData*)parent;
+	SnapshotChunk_t *chunk = IXmlParserGetContext(state);
+
+	if (! valid)	// missing mandatory fields
+		goto failvalidate;
+
+	PortDataXmlParserDerive(portp);
+
+	if (FSUCCESS != Snapshot_PortDataAddToNode(state, portp, nodep))
+		goto failvalidate;
+	if (! SnapshotChunkAddItem(state, chunk, portp, FALSE)) {
+		cl_qmap_remove_item(&nodep->Ports, &portp->NodePortsEntry);
+		goto failvalidate;
+	}
+	return;
+
+failvalidate:
+	Snapshot_PortDataFree(portp, chunk->fabricp);
+	MemoryDeallocate(portp);
+}
+
+static void NodeDataChunkXmlParserEnd(
+	IXmlParserState_t *state,
+	const IXML_FIELD *field _UNUSED_,
+	void *object,
+	void *parent _UNUSED_,
+	XML_Char *content _UNUSED_,
+	unsigned len _UNUSED_,
+	boolean valid)
+{
+	NodeData *nodep = (NodeData*)object;
+	SnapshotChunk_t *chunk = IXmlParserGetContext(state);
+
+	if (! valid || ! SnapshotChunkAddItem(state, chunk, nodep, TRUE))
+		SnapshotChunkNodeFree(chunk->fabricp, nodep);
+}
+
+/* NodeDataFields with the PortInfo end_func replaced by the chunk version */
+static IXML_FIELD NodeDataChunkFields[sizeof(NodeDataFields)/sizeof(NodeDataFields[0])];
+static pthread_once_t NodeDataChunkFieldsOnce = PTHREAD_ONCE_INIT;
+
+static void NodeDataChunkFieldsInit(void)
+{
+	unsigned i;
+
+	MemoryCopy(NodeDataChunkFields, NodeDataFields, sizeof(NodeDataFields));
+	for (i=0; NodeDataChunkFields[i].tag; i++) {
+		if (NodeDataChunkFields[i].end_func == PortDataXmlParserEnd)
+			NodeDataChunkFields[i].end_func = PortDataChunkXmlParserEnd;
+	}
+}
+
+static IXML_FIELD NodesChunkFields[] = {
+	{ tag:"Node", format:'K', subfields:NodeDataChunkFields, start_func:NodeDataXmlParserStart, end_func:NodeDataChunkXmlParserEnd }, // structure
+	{ NULL }
+};
+
+static IXML_FIELD NodesChunkTopFields[] = {
+	{ tag:"Nodes", format:'K', subfields:NodesChunkFields }, // list
+	{ NULL }
+};
+
+static void *LinkChunkXmlParserStart(IXmlParserState_t *state, void *parent _UNUSED_, const char **attr _UNUSED_)
+{
+	SnapshotChunk_t *chunk = IXmlParserGetContext(state);
+	SnapshotChunkLink_t *links = SnapshotChunkGrow(chunk->links, &chunk->maxLinks, chunk->numLinks, sizeof(*links));
+
+	if (! links) {
+		IXmlParserPrintError(state, "Unable to allocate memory");
+		return NULL;
+	}
+	chunk->links = links;
+	MemoryClear(&links[chunk->numLinks], sizeof(links[0]));
+	return &links[chunk->numLinks].link;
+}
+
+static void LinkChunkXmlParserEnd(
+	IXmlParserState_t *state,
+	const IXML_FIELD *field _UNUSED_,
+	void *object,
+	void *parent _UNUSED_,
+	XML_Char *content _UNUSED_,
+	unsigned len _UNUSED_,
+	boolean valid)
+{
+	SnapshotChunkLink_t *link = (SnapshotChunkLink_t*)object;
+	SnapshotChunk_t *chunk = IXmlParserGetContext(state);
+
+	if (! valid)
+		return;
+	// the Nodes are all merged by now, so these lookups are read only
+	link->p1 = FindNodeGuidPort(chunk->fabricp, link->link.from.NodeGUID, link->link.from.PortNum);
+	link->p2 = FindNodeGuidPort(chunk->fabricp, link->link.to.NodeGUID, link->link.to.PortNum);
+	chunk->numLinks++;
+}
+
+static IXML_FIELD LinksChunkFields[] = {
+	{ tag:"Link", format:'K', subfields:LinkFields, start_func:LinkChunkXmlParserStart, end_func:LinkChunkXmlParserEnd }, // structure
+	{ NULL }
+};
+
+static IXML_FIELD LinksChunkTopFields[] = {
+	{ tag:"Links", format:'K', subfields:LinksChunkFields }, // list
+	{ NULL }
+};
+
+/* the main parser sees <Nodes> and <Links> empty, their contents go to
+ * the workers
+ */
+static IXML_FIELD SnapshotParallelSectionFields[] = {
+	{ NULL }
+};
+
+static IXML_FIELD SnapshotParallelFields[] = {
+	{ tag:"Nodes", format:'K', subfields:SnapshotParallelSectionFields }, // list
+	{ tag:"Links", format:'K', subfields:SnapshotParallelSectionFields }, // list
+	{ NULL }
+};
+
+static IXML_FIELD TopLevelParallelFields[] = {
+	{ tag:"Snapshot", format:'K', subfields:SnapshotParallelFields, start_func:SnapshotXmlParserStart, end_func:SnapshotXmlParserEnd }, // structure
+	{ NULL }
+};
+
+/* worker thread, parses one chunk wrapped in its section tags */
+static void *SnapshotChunkParse(void *arg)
+{
+	SnapshotChunk_t *chunk = (SnapshotChunk_t*)arg;
+	IXmlParserState_t state;
+	char open[16];
+	char close[16];
+
+	snprintf(open, sizeof(open), "<%s>", chunk->section);
+	snprintf(close, sizeof(close), "</%s>", chunk->section);
+
+	chunk->status = IXmlParserInit(&state, IXML_PARSER_FLAG_NONE, chunk->fields, NULL, chunk, SnapshotQuietMessage, NULL, NULL);
+	if (FSUCCESS != chunk->status)
+		return NULL;
+	if (FSUCCESS != IXmlParserReadBuffer(&state, open, strlen(open), FALSE)
+		|| FSUCCESS != IXmlParserReadBuffer(&state, chunk->start, chunk->len, FALSE)
+		|| FSUCCESS != IXmlParserReadBuffer(&state, close, strlen(close), TRUE)
+		|| state.error_cnt)
+		chunk->status = FERROR;
+	IXmlParserDestroy(&state);
+	return NULL;
+}
+
+/* find str in [p, end), NULL if not found */
+static const char *SnapshotFindString(const char *p, const char *end, const char *str)
+{
+	size_t len = strlen(str);
+
+	while ((size_t)(end - p) >= len) {
+		p = memchr(p, str[0], end - p - len + 1);
+		if (! p)
+			return NULL;
+		if (memcmp(p, str, len) == 0)
+			return p;
+		p++;
+	}
+	return NULL;
+}
+
+/* find the next start tag for element in [p, end), NULL if not found */
+static const char *SnapshotFindElement(const char *p, const char *end, const char *element)
+{
+	char tag[16];
+	size_t len;
+
+	len = snprintf(tag, sizeof(tag), "<%s", element);
+	while ((p = SnapshotFindString(p, end, tag)) != NULL) {
+		if (p + len < end && strchr(" \t\r\n/>", p[len]) && p[len])
+			return p;
+		p += len;
+	}
+	return NULL;
+}
+
+/* chunks are parsed without the XML declaration, so they can only be
+ * split out of UTF-8 documents (the default, and what Xml2PrintSnapshot
+ * writes)
+ */
+static boolean SnapshotIsUtf8(const char *p, const char *end)
+{
+	const char *decl_end;
+	const char *enc;
+
+	if (end - p < 5 || memcmp(p, "<?xml", 5) != 0)
+		return TRUE;
+	decl_end = memchr(p, '>', end - p);
+	if (! decl_end)
+		return FALSE;
+	enc = SnapshotFindString(p, decl_end, "encoding=");
+	if (! enc)
+		return TRUE;
+	enc += strlen("encoding=") + 1;	// skip the opening quote
+	return (decl_end - enc >= 5 && strncasecmp(enc, "utf-8", 5) == 0);
+}
+
+/* cut [start, end) into up to max chunks at element boundaries */
+static unsigned SnapshotChunksSplit(SnapshotChunk_t *chunks, unsigned max,
+				FabricData_t *fabricp, const char *start, const char *end,
+				const char *element, const char *section, const IXML_FIELD *fields)
+{
+	const char *p = SnapshotFindElement(start, end, element);
+	unsigned count = 0;
+
+	while (p) {
+		const char *next = NULL;
+		const char *target = start + (size_t)((uint64)(end - start) * (count+1) / max);
+
+		if (count+1 < max)
+			next = SnapshotFindElement((target > p) ? target : p+1, end, element);
+		MemoryClear(&chunks[count], sizeof(chunks[count]));
+		chunks[count].fabricp = fabricp;
+		chunks[count].fields = fields;
+		chunks[count].section = section;
+		chunks[count].start = p;
+		chunks[count].len = (next ? next : end) - p;
+		count++;
+		p = next;
+	}
+	return count;
+}
+
+static void SnapshotChunksStart(SnapshotChunk_t *chunks, unsigned count)
+{
+	unsigned i;
+
+	for (i=0; i < count; i++)
+		chunks[i].threaded = (0 == pthread_create(&chunks[i].thread, NULL, SnapshotChunkParse, &chunks[i]));
+}
+
+/* wait for a chunk, parsing it here if its thread could not be created */
+static FSTATUS SnapshotChunkWait(SnapshotChunk_t *chunk)
+{
+	if (chunk->threaded) {
+		pthread_join(chunk->thread, NULL);
+		chunk->threaded = FALSE;
+	} else {
+		(void)SnapshotChunkParse(chunk);
+	}
+	return chunk->status;
+}
+
+/* wait for all chunks and free whatever was not merged into the fabric */
+static void SnapshotChunksFree(SnapshotChunk_t *chunks, unsigned count)
+{
+	unsigned i, j;
+
+	for (i=0; i < count; i++) {
+		SnapshotChunk_t *chunk = &chunks[i];
+
+		if (chunk->threaded) {
+			pthread_join(chunk->thread, NULL);
+			chunk->threaded = FALSE;
+		}
+		for (j=chunk->merged; j < chunk->numItems; j++) {
+			if (chunk->items[j].isNode)
+				SnapshotChunkNodeFree(chunk->fabricp, (NodeData*)chunk->items[j].object);
+		}
+		if (chunk->items)
+			free(chunk->items);
+		if (chunk->links)
+			free(chunk->links);
+		MemoryClear(chunk, sizeof(*chunk));
+	}
+}
+
+/* merge a parsed <Nodes> chunk into the fabric, one Node at a time */
+static FSTATUS SnapshotChunkMergeNodes(SnapshotChunk_t *chunk, FabricData_t *fabricp)
+{
+	unsigned first, i;
+	NodeData *nodep;
+
+	while (chunk->merged < chunk->numItems) {
+		first = chunk->merged;
+		// a Node's ports always end before the Node itself
+		for (i=first; ! chunk->items[i].isNode; i++) {
+			PortData *portp = (PortData*)chunk->items[i].object;
+
+			if (FSUCCESS != AllLidsAdd(fabricp, portp, FALSE))
+				goto fail;
+			QListInsertTail(&fabricp->AllPorts, &portp->AllPortsEntry);
+		}
+		nodep = (NodeData*)chunk->items[i].object;
+		if (cl_qmap_insert(&fabricp->AllNodes, nodep->NodeInfo.NodeGUID, &nodep->AllNodesEntry) != &nodep->AllNodesEntry)
+			goto fail;
+		if (FSUCCESS != AddSystemNode(fabricp, nodep)) {
+			cl_qmap_remove_item(&fabricp->AllNodes, &nodep->AllNodesEntry);
+			goto fail;
+		}
+		chunk->merged = i+1;
+	}
+	return FSUCCESS;
+
+fail:
+	// back out the partially merged Node, SnapshotChunksFree frees it
+	while (i-- > first) {
+		PortData *portp = (PortData*)chunk->items[i].object;
+
+		QListRemoveItem(&fabricp->AllPorts, &portp->AllPortsEntry);
+		AllLidsRemove(fabricp, portp);
+	}
+	return FERROR;
+}
+
+/* apply a parsed <Links> chunk, same checks as LinkXmlParserEnd.
+ * Rate warnings wait for SnapshotChunkCheckRates so a failed parallel
+ * parse does not print them twice
+ */
+static FSTATUS SnapshotChunkApplyLinks(SnapshotChunk_t *chunk, FabricData_t *fabricp)
+{
+	unsigned i;
+
+	for (i=0; i < chunk->numLinks; i++) {
+		PortData *p1 = chunk->links[i].p1;
+		PortData *p2 = chunk->links[i].p2;
+
+		if (! p1 || p1->neighbor || ! p2 || p2->neighbor)
+			return FERROR;
+		SnapshotLinkPorts(fabricp, p1, p2);
+	}
+	return FSUCCESS;
+}
+
+static void SnapshotChunkCheckRates(SnapshotChunk_t *chunk)
+{
+	unsigned i;
+
+	for (i=0; i < chunk->numLinks; i++)
+		SnapshotLinkCheckRate(chunk->links[i].p1, chunk->links[i].p2);
+}
+
+static unsigned SnapshotParseThreads(void)
+{
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (cpus < 1)
+		return 1;
+	if (cpus > SNAPSHOT_PARALLEL_MAX_THREADS)
+		return SNAPSHOT_PARALLEL_MAX_THREADS;
+	return (unsigned)cpus;
+}
+
+/* parse a large snapshot file with one thread per core.
+ * Returns FNOT_DONE when the file is not suitable or the parallel parse
+ * failed, in which case fabricp is left freshly initialized for a
+ * sequential parse.
+ */
+static FSTATUS Xml2ParseSnapshotParallel(const char *input_file, FabricData_t *fabricp,
+				unsigned *tags_found, unsigned *fields_found)
+{
+	FabricFlags_t flags = fabricp->flags;
+	unsigned threads = SnapshotParseThreads();
+	SnapshotChunk_t *chunks = NULL;
+	unsigned count = 0;
+	unsigned i;
+	IXmlParserState_t state;
+	boolean parsing = FALSE;
+	const char *base, *end;
+	const char *nodes, *nodes_end, *links, *links_end;
+	struct stat st;
+	int fd;
+	FSTATUS status = FNOT_DONE;
+
+	// a custom PortData completion may depend on the sequential order
+	if (threads < 2 || GetPortDataComplete() != Snapshot_PortDataComplete)
+		return FNOT_DONE;
+
+	fd = open(input_file, O_RDONLY);
+	if (fd < 0)
+		return FNOT_DONE;	// sequential parse reports the error
+	if (fstat(fd, &st) < 0 || ! S_ISREG(st.st_mode)
+		|| st.st_size < SNAPSHOT_PARALLEL_MIN_SIZE) {
+		close(fd);
+		return FNOT_DONE;
+	}
+	base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+		return FNOT_DONE;
+	end = base + st.st_size;
+
+	nodes = SnapshotFindString(base, end, "<Nodes>");
+	nodes_end = nodes ? SnapshotFindString(nodes, end, "</Nodes>") : NULL;
+	links = nodes_end ? SnapshotFindString(nodes_end, end, "<Links>") : NULL;
+	links_end = links ? SnapshotFindString(links, end, "</Links>") : NULL;
+	if (! links_end || ! SnapshotIsUtf8(base, nodes))
+		goto done;
+	nodes += strlen("<Nodes>");
+	links += strlen("<Links>");
+
+	chunks = (SnapshotChunk_t*)MemoryAllocate2AndClear(sizeof(SnapshotChunk_t)*threads, IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	if (! chunks)
+		goto done;
+	pthread_once(&NodeDataChunkFieldsOnce, NodeDataChunkFieldsInit);
+
+	if (FSUCCESS != IXmlParserInit(&state, IXML_PARSER_FLAG_NONE, TopLevelParallelFields, NULL, fabricp, SnapshotQuietMessage, NULL, NULL))
+		goto done;
+	parsing = TRUE;
+	if (FSUCCESS != IXmlParserReadBuffer(&state, base, nodes - base, FALSE))
+		goto fail;
+
+	// like the sequential parse, <Node> and <Link> are mandatory
+	count = SnapshotChunksSplit(chunks, threads, fabricp, nodes, nodes_end, "Node", "Nodes", NodesChunkTopFields);
+	if (! count)
+		goto fail;
+	SnapshotChunksStart(chunks, count);
+	for (i=0; i < count; i++) {
+		if (FSUCCESS != SnapshotChunkWait(&chunks[i])
+			|| FSUCCESS != SnapshotChunkMergeNodes(&chunks[i], fabricp))
+			goto fail;
+	}
+	SnapshotChunksFree(chunks, count);
+	count = 0;
+
+	if (FSUCCESS != IXmlParserReadBuffer(&state, nodes_end, links - nodes_end, FALSE))
+		goto fail;
+
+	count = SnapshotChunksSplit(chunks, threads, fabricp, links, links_end, "Link", "Links", LinksChunkTopFields);
+	if (! count)
+		goto fail;
+	SnapshotChunksStart(chunks, count);
+	for (i=0; i < count; i++) {
+		if (FSUCCESS != SnapshotChunkWait(&chunks[i])
+			|| FSUCCESS != SnapshotChunkApplyLinks(&chunks[i], fabricp))
+			goto fail;
+	}
+
+	if (FSUCCESS != IXmlParserReadBuffer(&state, links_end, end - links_end, TRUE)
+		|| FSUCCESS != IXmlParserCheckSubfields(&state, tags_found, fields_found)
+		|| state.error_cnt)
+		goto fail;
+	for (i=0; i < count; i++)
+		SnapshotChunkCheckRates(&chunks[i]);
+	SnapshotChunksFree(chunks, count);
+	status = FSUCCESS;
+	goto done;
+
+fail:
+	SnapshotChunksFree(chunks, count);
+	IXmlParserDestroy(&state);
+	parsing = FALSE;
+	DestroyFabricData(fabricp);
+	if (FSUCCESS != InitFabricData(fabricp, flags)) {
+		fprintf(stderr, "%s: Unable to initialize fabric data memory\n", g_Top_cmdname);
+		status = FERROR;
+	}
+done:
+	if (parsing)
+		IXmlParserDestroy(&state);
+	if (chunks)
+		MemoryDeallocate(chunks);
+	munmap((void*)base, st.st_size);
+	return status;
+}
+
 FSTATUS Xml2ParseSnapshot(const char *input_file, int quiet, FabricData_t *fabricp, FabricFlags_t flags, boolean allocFull)
 {
 	unsigned tags_found, fields_found;
@@ -1165,8 +1763,13 @@ FSTATUS Xml2ParseSnapshot(const char *input_file, int quiet, FabricData_t *fabri
 			return FERROR;
 		}
 	} else {
+		FSTATUS status;
+
 		if (! quiet) ProgressPrint(TRUE, "Parsing %s...", Top_truncate_str(input_file));
-		if (FSUCCESS != IXmlParseInputFile(input_file, IXML_PARSER_FLAG_NONE, TopLevelFields, NULL, fabricp, NULL, NULL, &tags_found, &fields_found)) {
+		status = Xml2ParseSnapshotParallel(input_file, fabricp, &tags_found, &fields_found);
+		if (FNOT_DONE == status)
+			status = IXmlParseInputFile(input_file, IXML_PARSER_FLAG_NONE, TopLevelFields, NULL, fabricp, NULL, NULL, &tags_found, &fields_found);
+		if (FSUCCESS != status) {
 			return FERROR;
 		}
 	}
@@ -148,6 +148,7 @@ static FSTATUS SweepInternal(struct hmgt_port *port,
 	HMGT_QUERY query;
 	FSTATUS status = HMGT_STATUS_SUCCESS;
 	PHQUERY_RESULT_VALUES pQueryResults = NULL;
+	boolean refresh = fabricp->SnmpCountersOnly;
 
 	memset(&query, 0, sizeof(query));	// initialize reserved fields
 	query.InputType 	= InputTypeFabricDataPtr;
@@ -175,7 +176,9 @@ static FSTATUS SweepInternal(struct hmgt_port *port,
 		fprintf(stderr, "%*sNo Fabric Record Returned\n", 0, "");
 	}
 	if (! quiet) ProgressPrint(TRUE, "Done Getting All Fabric Records");
-	BuildFabricDataLists(fabricp);
+	// a counters refresh keeps the lists of the cached topology
+	if (! refresh)
+		BuildFabricDataLists(fabricp);
 
 done:
 	// omgt_query_sa will have allocated a result buffer
@@ -197,6 +200,14 @@ FSTATUS InitSweepVerbose(FILE *verbose_file)
 
 // only FF_LIDARRAY fflag is used, others ignored
 FSTATUS Sweep(EUI64 portGuid, FabricData_t *fabricp, FabricFlags_t fflags,  SweepFlags_t flags, int quiet, int ms_timeout, void *cfpp)
+{
+	return SweepFocused(portGuid, fabricp, fflags, flags, quiet, ms_timeout,
+						cfpp, NULL, FALSE);
+}
+
+// focus is only used to scope the SNMP sweep, caller must still parse it
+// against the resulting fabric
+FSTATUS SweepFocused(EUI64 portGuid, FabricData_t *fabricp, FabricFlags_t fflags,  SweepFlags_t flags, int quiet, int ms_timeout, void *cfpp, const char *focus, boolean limitstats)
 {
 	FSTATUS fstatus;
 	struct hmgt_port *hmgt_port_session = NULL;
@@ -209,6 +220,8 @@ FSTATUS Sweep(EUI64 portGuid, FabricData_t *fabricp, FabricFlags_t fflags,  Swee
 	}
 
 	fabricp->ms_timeout = ms_timeout;
+	fabricp->SnmpFocus = focus;
+	fabricp->SnmpFocusLimitStats = limitstats;
 
 	// set port parameters and open the port
 	memset(&port_params, 0, sizeof(port_params));
@@ -230,3 +243,41 @@ FSTATUS Sweep(EUI64 portGuid, FabricData_t *fabricp, FabricFlags_t fflags,  Swee
 done:
 	return fstatus;
 }
+
+FSTATUS SweepCounters(EUI64 portGuid, FabricData_t *fabricp, FabricFlags_t fflags,  SweepFlags_t flags, int quiet, int ms_timeout, void *cfpp)
+{
+	FSTATUS fstatus;
+	struct hmgt_port *hmgt_port_session = NULL;
+	struct hmgt_params port_params;
+
+	fabricp->ms_timeout = ms_timeout;
+	fabricp->SnmpCountersOnly = TRUE;
+
+	// set port parameters and open the port
+	memset(&port_params, 0, sizeof(port_params));
+	port_params.config_file_params = (fabric_config_t *)cfpp;
+
+	if (FSUCCESS != (fstatus = hmgt_open_port_by_guid(&hmgt_port_session, portGuid, &port_params))) {
+		fprintf(stderr, "%s: Unable to open fabric interface.\n",
+			g_Top_cmdname);
+		goto done;
+	}
+	hmgt_set_timeout(hmgt_port_session, fabricp->ms_timeout);
+
+	fstatus = SweepInternal(hmgt_port_session, portGuid, fabricp, flags, quiet);
+	hmgt_close_port(hmgt_port_session);
+
+	if (fstatus == FSUCCESS && ! fabricp->SnmpCountersOnly) {
+		if (! quiet) ProgressPrint(TRUE, "Fabric changed since cached topology, full sweep...");
+		DestroyFabricData(fabricp);
+		return Sweep(portGuid, fabricp, fflags|FF_STATS, flags, quiet, ms_timeout, cfpp);
+	}
+	if (fstatus == FSUCCESS) {
+		fabricp->flags |= FF_STATS;
+		time(&fabricp->time);
+	}
+
+done:
+	fabricp->SnmpCountersOnly = FALSE;
+	return fstatus;
+}
@@ -31,6 +31,13 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "topology.h"
 #include "topology_internal.h"
+#ifndef __VXWORKS__
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 typedef enum {
 	MATCH_NONE=0,	// worst - nothing matched
@@ -169,11 +176,91 @@ static void PortSelectorXmlParserEndPortNum(
 	}
 }
 
+/****************************************************************************/
+/* Fabric NodeDesc index */
+
+// While a topology is resolved against the fabric, each ExpectedNode and
+// PortSelector with only a NodeDesc would otherwise scan all of AllNodes.
+// This index maps a hash of NodeDesc to the 1st node (in AllNodes order)
+// with that NodeDesc.  It is only valid during Xml2ParseTopology.
+typedef struct NodeNameEntry_s {
+	cl_map_item_t	NodeNameMapEntry;	// key is TopologyHash of NodeDesc
+	NodeData		*nodep;
+} NodeNameEntry;
+
+static cl_qmap_t g_NodeNameMap;
+static NodeNameEntry *g_NodeNames = NULL;	// NULL if no index
+
+#define TOPOLOGY_HASH_INIT	14695981039346656037ULL
+
+// 64 bit FNV-1a hash of data, start with hash=TOPOLOGY_HASH_INIT
+static uint64 TopologyHash(const void *data, size_t len, uint64 hash)
+{
+	const uint8 *p = (const uint8 *)data;
+	const uint8 *end = p + len;
+
+	for (; p < end; p++) {
+		hash ^= *p;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static uint64 NodeNameHash(const char *name)
+{
+	return TopologyHash(name, strnlen(name, STL_NODE_DESCRIPTION_ARRAY_SIZE),
+						TOPOLOGY_HASH_INIT);
+}
+
+static void NodeNameIndexBuild(FabricData_t *fabricp)
+{
+	cl_map_item_t *p;
+	uint32 count = cl_qmap_count(&fabricp->AllNodes);
+	uint32 i = 0;
+
+	if (! count)
+		return;
+	g_NodeNames = (NodeNameEntry*)MemoryAllocate2AndClear(sizeof(NodeNameEntry)*count, IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	if (! g_NodeNames)
+		return;	// LookupNodeName will do a linear search
+	cl_qmap_init(&g_NodeNameMap, NULL);
+	for (p=cl_qmap_head(&fabricp->AllNodes); p != cl_qmap_end(&fabricp->AllNodes); p = cl_qmap_next(p)) {
+		NodeData *nodep = PARENT_STRUCT(p, NodeData, AllNodesEntry);
+
+		// if NodeDesc is a duplicate, insert leaves the 1st node in the map
+		g_NodeNames[i].nodep = nodep;
+		cl_qmap_insert(&g_NodeNameMap,
+			NodeNameHash((char*)nodep->NodeDesc.NodeString),
+			&g_NodeNames[i].NodeNameMapEntry);
+		i++;
+	}
+}
+
+static void NodeNameIndexFree(void)
+{
+	if (g_NodeNames) {
+		MemoryDeallocate(g_NodeNames);
+		g_NodeNames = NULL;
+	}
+}
+
 // returns 1st matching node name found
 static NodeData* LookupNodeName(FabricData_t *fabricp, char *name)
 {
 	cl_map_item_t *p;
 
+	if (g_NodeNames) {
+		NodeData *nodep;
+
+		p = cl_qmap_get(&g_NodeNameMap, NodeNameHash(name));
+		if (p == cl_qmap_end(&g_NodeNameMap))
+			return NULL;
+		nodep = PARENT_STRUCT(p, NodeNameEntry, NodeNameMapEntry)->nodep;
+		if (strncmp((char*)nodep->NodeDesc.NodeString,
+					name, STL_NODE_DESCRIPTION_ARRAY_SIZE) == 0)
+			return nodep;
+		// hash collision, fall back to a search
+	}
 	for (p=cl_qmap_head(&fabricp->AllNodes); p != cl_qmap_end(&fabricp->AllNodes); p = cl_qmap_next(p)) {
 		NodeData *nodep = PARENT_STRUCT(p, NodeData, AllNodesEntry);
 		if (strncmp((char*)nodep->NodeDesc.NodeString,
@@ -185,6 +272,101 @@ static NodeData* LookupNodeName(FabricData_t *fabricp, char *name)
 	return NULL;
 }
 
+/****************************************************************************/
+/* ExpectedNode NodeDesc index */
+
+// While links are validated, each PortSelector with only a NodeDesc would
+// otherwise scan all of ExpectedSWs and ExpectedFIs.  These indexes map a hash
+// of NodeDesc to the 1st ExpectedNode (in list order) with that NodeDesc,
+// one map per list so lookups keep FindExpectedNodeByNodeDesc's precedence.
+// They are only valid during TopologyValidate.
+typedef struct ExpectedNameEntry_s {
+	cl_map_item_t	ExpectedNameMapEntry;	// key is TopologyHash of NodeDesc
+	ExpectedNode	*enodep;
+} ExpectedNameEntry;
+
+static cl_qmap_t g_ExpectedSWNameMap;
+static cl_qmap_t g_ExpectedFINameMap;
+static ExpectedNameEntry *g_ExpectedNames = NULL;	// NULL if no index
+
+static void ExpectedNameIndexAdd(cl_qmap_t *mapp, QUICK_LIST *listp, uint32 *ip)
+{
+	LIST_ITEM *it;
+
+	cl_qmap_init(mapp, NULL);
+	for (it = QListHead(listp); it != NULL; it = QListNext(listp, it)) {
+		ExpectedNode *enodep = PARENT_STRUCT(it, ExpectedNode, ExpectedNodesEntry);
+
+		if (! enodep->NodeDesc)
+			continue;
+		// if NodeDesc is a duplicate, insert leaves the 1st node in the map
+		g_ExpectedNames[*ip].enodep = enodep;
+		cl_qmap_insert(mapp, NodeNameHash(enodep->NodeDesc),
+			&g_ExpectedNames[*ip].ExpectedNameMapEntry);
+		(*ip)++;
+	}
+}
+
+static void ExpectedNameIndexBuild(FabricData_t *fabricp)
+{
+	uint32 count = QListCount(&fabricp->ExpectedSWs)
+					+ QListCount(&fabricp->ExpectedFIs);
+	uint32 i = 0;
+
+	if (! count)
+		return;
+	g_ExpectedNames = (ExpectedNameEntry*)MemoryAllocate2AndClear(sizeof(ExpectedNameEntry)*count, IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	if (! g_ExpectedNames)
+		return;	// LookupExpectedName will do a linear search
+	ExpectedNameIndexAdd(&g_ExpectedSWNameMap, &fabricp->ExpectedSWs, &i);
+	ExpectedNameIndexAdd(&g_ExpectedFINameMap, &fabricp->ExpectedFIs, &i);
+}
+
+static void ExpectedNameIndexFree(void)
+{
+	if (g_ExpectedNames) {
+		MemoryDeallocate(g_ExpectedNames);
+		g_ExpectedNames = NULL;
+	}
+}
+
+// returns NULL if not in mapp, sets *collision if the hash matched a
+// different NodeDesc
+static ExpectedNode* LookupExpectedNameMap(cl_qmap_t *mapp, const char *name,
+							uint64 hash, boolean *collision)
+{
+	cl_map_item_t *p;
+	ExpectedNode *enodep;
+
+	p = cl_qmap_get(mapp, hash);
+	if (p == cl_qmap_end(mapp))
+		return NULL;
+	enodep = PARENT_STRUCT(p, ExpectedNameEntry, ExpectedNameMapEntry)->enodep;
+	if (strncmp(enodep->NodeDesc, name, STL_NODE_DESCRIPTION_ARRAY_SIZE) == 0)
+		return enodep;
+	*collision = TRUE;
+	return NULL;
+}
+
+// same results as FindExpectedNodeByNodeDesc
+static ExpectedNode* LookupExpectedName(FabricData_t *fabricp, const char *name, uint8 NodeType)
+{
+	ExpectedNode *enodep = NULL;
+	boolean collision = FALSE;
+	uint64 hash;
+
+	if (! g_ExpectedNames)
+		return FindExpectedNodeByNodeDesc(fabricp, name, NodeType);
+	hash = NodeNameHash(name);
+	if (NodeType != STL_NODE_FI)
+		enodep = LookupExpectedNameMap(&g_ExpectedSWNameMap, name, hash, &collision);
+	if (! enodep && ! collision && NodeType != STL_NODE_SW)
+		enodep = LookupExpectedNameMap(&g_ExpectedFINameMap, name, hash, &collision);
+	if (collision)
+		return FindExpectedNodeByNodeDesc(fabricp, name, NodeType);
+	return enodep;
+}
+
 // resolve as much as we can about the given Port Selector
 static void ResolvePortSelector(FabricData_t *fabricp, PortSelector *portselp, NodeData **nodepp, PortData **portpp, PortSelMatchLevel_t *matchLevel)
 {
@@ -1143,7 +1325,7 @@ static FSTATUS TopologyValidateLinkPort(FabricData_t *fabricp, ExpectedLink *eli
 			}
 		}		
 	} else if (portselp->NodeDesc) {
-		enodep = FindExpectedNodeByNodeDesc(fabricp,portselp->NodeDesc, portselp->NodeType);
+		enodep = LookupExpectedName(fabricp, portselp->NodeDesc, portselp->NodeType);
 		if(!enodep){
 			fprintf(stderr, "Topology file line %"PRIu64": No node found with matching NodeDesc for link port: %s\n",
 				elinkp->lineno, FormatPortSelector(portselp));
@@ -1278,7 +1460,9 @@ FSTATUS TopologyValidateNoLinksDisjoint(FabricData_t *fabricp)
 	return status;
 }
 
-static FSTATUS TopologyValidate(FabricData_t *fabricp, int quiet, TopoVal_t validation)
+// clean is optional, it is set to TRUE if nothing was found to report,
+// even when the validation level would not fail for what was reported
+static FSTATUS TopologyValidate(FabricData_t *fabricp, int quiet, TopoVal_t validation, boolean *clean)
 {
 	FSTATUS status = FSUCCESS;
 	LIST_ITEM *it;
@@ -1286,6 +1470,10 @@ static FSTATUS TopologyValidate(FabricData_t *fabricp, int quiet, TopoVal_t vali
 	int resolved = 0;
 	int bad_input = 0;
 	int input_checked = 0;
+	int mismatched = 0;
+
+	if (clean)
+		*clean = FALSE;
 
 	//make sure input file contains at least one link
 	if(QListHead(&fabricp->ExpectedLinks) == NULL) {
@@ -1302,6 +1490,7 @@ static FSTATUS TopologyValidate(FabricData_t *fabricp, int quiet, TopoVal_t vali
 				&& enodep->ports[0]->PortGuid && enodep->NodeGUID
 				&& enodep->ports[0]->PortGuid != NodeGUIDtoPortGUID(enodep->NodeGUID, 0)) {
 			fprintf(stderr, "Topology file line %"PRIu64": mismatched IfAddr and MgmtIfAddr for switch port 0: %s\n", enodep->lineno, FormatExpectedNode(enodep));
+			mismatched++;
 			if (TOPOVAL_SOMEWHAT_STRICT <= validation)
 				status = FERROR;
 		}
@@ -1315,6 +1504,7 @@ static FSTATUS TopologyValidate(FabricData_t *fabricp, int quiet, TopoVal_t vali
 	//to that link stored in its ExpectedPort struct, and a pointer to the
 	//node stored in the ExpectedLink portselp
 	if (! quiet) ProgressPrint(TRUE, "Resolving Links against Nodes...");
+	ExpectedNameIndexBuild(fabricp);
 	for(it = QListHead(&fabricp->ExpectedLinks); it != NULL; it = QListNext(&fabricp->ExpectedLinks, it)) {
 		ExpectedLink* elinkp = PARENT_STRUCT(it, ExpectedLink, ExpectedLinksEntry);
 		int ends = 0;
@@ -1362,6 +1552,7 @@ static FSTATUS TopologyValidate(FabricData_t *fabricp, int quiet, TopoVal_t vali
 		if (ends >= 2)
 			resolved++;
 	}
+	ExpectedNameIndexFree();
 	if (! quiet) ProgressPrint(TRUE, "Done Resolving Links");
 	if (! quiet || bad_input)
 		fprintf(stderr, "%u of %u Input Links Checked, %u Resolved, %u Bad Input Skipped\n",
@@ -1373,6 +1564,8 @@ static FSTATUS TopologyValidate(FabricData_t *fabricp, int quiet, TopoVal_t vali
 		if(TopologyValidateNoLinksDisjoint(fabricp) != FSUCCESS)
 			status = FERROR;
 	}
+	if (clean)
+		*clean = (FSUCCESS == status && ! bad_input && ! mismatched);
 
 	if (TOPOVAL_SOMEWHAT_STRICT <= validation)
 		return status;
@@ -1388,40 +1581,597 @@ FSTATUS Xml2ParseTopology(const char *input_file, int quiet, FabricData_t *fabri
 {
 	unsigned tags_found, fields_found;
 	const char *filename=input_file;
+	FSTATUS status;
 
 	if(fabricp == NULL || fabricp->AllNodes.state != CL_INITIALIZED) {
 		if (!quiet) ProgressPrint(TRUE, "Error: input FabricData_t was null or uninitialized!");
 		return FERROR;
 	}
 
+	NodeNameIndexBuild(fabricp);
 	if (strcmp(input_file, "-") == 0) {
 		if (! quiet) ProgressPrint(TRUE, "Parsing stdin...");
 		filename = "stdin";
-		if (FSUCCESS != IXmlParseFile(stdin, "stdin", IXML_PARSER_FLAG_NONE, TopLevelFields, NULL, fabricp, NULL, NULL, &tags_found, &fields_found
+		status = IXmlParseFile(stdin, "stdin", IXML_PARSER_FLAG_NONE, TopLevelFields, NULL, fabricp, NULL, NULL, &tags_found, &fields_found
 #ifdef __VXWORKS__
 																	, memsuite
 #endif
-																			)) {
-			return FERROR;
-		}
+																			);
 	} else {
 		if (! quiet) ProgressPrint(TRUE, "Parsing %s...", Top_truncate_str(input_file));
-		if (FSUCCESS != IXmlParseInputFile(input_file, IXML_PARSER_FLAG_NONE, TopLevelFields, NULL, fabricp, NULL, NULL, &tags_found, &fields_found
+		status = IXmlParseInputFile(input_file, IXML_PARSER_FLAG_NONE, TopLevelFields, NULL, fabricp, NULL, NULL, &tags_found, &fields_found
 #ifdef __VXWORKS__
 																	, memsuite
 #endif
-																			)) {
-			return FERROR;
-		}
+																			);
 	}
+	NodeNameIndexFree();
+	if (FSUCCESS != status)
+		return FERROR;
 	if (tags_found != 1 || fields_found != 1) {
 		fprintf(stderr, "Warning: potentially inaccurate input '%s': found %u recognized top level tags, expected 1\n", filename, tags_found);
 	}
 	if(TOPOVAL_NONE != validation)
-		return TopologyValidate(fabricp, quiet, validation);
+		return TopologyValidate(fabricp, quiet, validation, NULL);
+	else
+		return FSUCCESS;
+}
+
+#ifndef __VXWORKS__
+/****************************************************************************/
+/* Topology cache */
+
+// The cache is a binary sidecar holding the ExpectedNodes and ExpectedLinks
+// of a topology_input file, after validation, keyed by the size and hash of
+// the file and the validation level.  It does not hold anything about the
+// fabric, the resolution to NodeData and PortData is always redone.
+// Fields are stored in host byte order at their native size, so bump
+// TOPOLOGY_CACHE_VERSION if the format or the size of a field changes.
+#define TOPOLOGY_CACHE_MAGIC	0x54504f54	// "TOPT"
+#define TOPOLOGY_CACHE_VERSION	1
+#define TOPOLOGY_CACHE_FLAGS	(FF_EXPECTED_NODES|FF_EXPECTED_LINKS|FF_EXPECTED_EXTLINKS|FF_CABLEDATA)
+
+typedef struct TopologyCacheHeader_s {
+	uint32 magic;
+	uint32 version;
+	uint32 validation;		// TopoVal_t
+	uint32 flags;			// FabricFlags_t, TOPOLOGY_CACHE_FLAGS only
+	uint64 file_size;
+	uint64 file_hash;		// TopologyHash of file contents
+	uint32 FICount;
+	uint32 SWCount;
+	uint32 LinkCount;
+	char plane[HPN_NODE_COMMUNITY_ARRAY_SIZE];
+} TopologyCacheHeader_t;
+
+// index of each ExpectedNode, so PortSelector.enodep can be saved
+typedef struct TopologyCacheIndex_s {
+	cl_map_item_t	IndexMapEntry;	// key is ExpectedNode pointer
+	uint32			index;			// 1 based, FIs then SWs
+} TopologyCacheIndex_t;
+
+typedef struct TopologyCacheWriter_s {
+	FILE *f;
+	uint64 hash;			// TopologyHash of all data written
+} TopologyCacheWriter_t;
+
+typedef struct TopologyCacheReader_s {
+	const uint8 *p;
+	const uint8 *end;
+	boolean error;
+} TopologyCacheReader_t;
+
+static void TopologyCachePut(TopologyCacheWriter_t *w, const void *data, size_t len)
+{
+	(void)fwrite(data, len, 1, w->f);
+	w->hash = TopologyHash(data, len, w->hash);
+}
+
+static void TopologyCachePutStr(TopologyCacheWriter_t *w, const char *str)
+{
+	uint32 len = str ? strlen(str)+1 : 0;	// 0 for NULL
+
+	TopologyCachePut(w, &len, sizeof(len));
+	if (len)
+		TopologyCachePut(w, str, len);
+}
+
+static void TopologyCacheGet(TopologyCacheReader_t *r, void *data, size_t len)
+{
+	if (r->error || (size_t)(r->end - r->p) < len) {
+		r->error = TRUE;
+		MemoryClear(data, len);
+		return;
+	}
+	MemoryCopy(data, r->p, len);
+	r->p += len;
+}
+
+static char *TopologyCacheGetStr(TopologyCacheReader_t *r)
+{
+	uint32 len;
+	char *str;
+
+	TopologyCacheGet(r, &len, sizeof(len));
+	if (r->error || ! len)
+		return NULL;
+	if ((size_t)(r->end - r->p) < len || r->p[len-1] != '\0') {
+		r->error = TRUE;
+		return NULL;
+	}
+	str = (char*)MemoryAllocate2(len, IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	if (! str) {
+		r->error = TRUE;
+		return NULL;
+	}
+	MemoryCopy(str, r->p, len);
+	r->p += len;
+	return str;
+}
+
+static void TopologyCachePutNodes(TopologyCacheWriter_t *w, QUICK_LIST *listp)
+{
+	LIST_ITEM *it;
+
+	for (it = QListHead(listp); it != NULL; it = QListNext(listp, it)) {
+		ExpectedNode *enodep = PARENT_STRUCT(it, ExpectedNode, ExpectedNodesEntry);
+		uint16 count = 0;
+		int i;
+
+		TopologyCachePut(w, &enodep->NodeGUID, sizeof(enodep->NodeGUID));
+		TopologyCachePut(w, &enodep->SystemImageGUID, sizeof(enodep->SystemImageGUID));
+		TopologyCachePut(w, &enodep->NodeType, sizeof(enodep->NodeType));
+		TopologyCachePut(w, &enodep->connected, sizeof(enodep->connected));
+		TopologyCachePut(w, &enodep->lineno, sizeof(enodep->lineno));
+		TopologyCachePutStr(w, enodep->NodeDesc);
+		TopologyCachePutStr(w, enodep->details);
+		for (i = 0; i < enodep->portsSize; i++) {
+			if (enodep->ports[i])
+				count++;
+		}
+		TopologyCachePut(w, &count, sizeof(count));
+		for (i = 0; i < enodep->portsSize; i++) {
+			ExpectedPort *eportp = enodep->ports[i];
+
+			if (! eportp)
+				continue;
+			TopologyCachePut(w, &eportp->PortNum, sizeof(eportp->PortNum));
+			TopologyCachePut(w, &eportp->lid, sizeof(eportp->lid));
+			TopologyCachePut(w, &eportp->PortGuid, sizeof(eportp->PortGuid));
+			TopologyCachePutStr(w, eportp->PortId);
+		}
+	}
+}
+
+static void TopologyCachePutPortSelector(TopologyCacheWriter_t *w, PortSelector *portselp, cl_qmap_t *indexp)
+{
+	uint32 index = 0;
+
+	TopologyCachePut(w, &portselp->PortGUID, sizeof(portselp->PortGUID));
+	TopologyCachePut(w, &portselp->NodeGUID, sizeof(portselp->NodeGUID));
+	TopologyCachePut(w, &portselp->PortNum, sizeof(portselp->PortNum));
+	TopologyCachePut(w, &portselp->gotPortNum, sizeof(portselp->gotPortNum));
+	TopologyCachePut(w, &portselp->NodeType, sizeof(portselp->NodeType));
+	TopologyCachePutStr(w, portselp->PortId);
+	TopologyCachePutStr(w, portselp->NodeDesc);
+	TopologyCachePutStr(w, portselp->details);
+	if (portselp->enodep) {
+		cl_map_item_t *p = cl_qmap_get(indexp, (uint64)(uintn)portselp->enodep);
+		if (p != cl_qmap_end(indexp))
+			index = PARENT_STRUCT(p, TopologyCacheIndex_t, IndexMapEntry)->index;
+	}
+	TopologyCachePut(w, &index, sizeof(index));
+}
+
+static void TopologyCachePutLinks(TopologyCacheWriter_t *w, FabricData_t *fabricp, cl_qmap_t *indexp)
+{
+	LIST_ITEM *it;
+
+	for (it = QListHead(&fabricp->ExpectedLinks); it != NULL; it = QListNext(&fabricp->ExpectedLinks, it)) {
+		ExpectedLink *elinkp = PARENT_STRUCT(it, ExpectedLink, ExpectedLinksEntry);
+		uint8 ports = (elinkp->portselp1 ? 1 : 0) | (elinkp->portselp2 ? 2 : 0);
+
+		TopologyCachePut(w, &elinkp->expected_rate, sizeof(elinkp->expected_rate));
+		TopologyCachePut(w, &elinkp->expected_mtu, sizeof(elinkp->expected_mtu));
+		TopologyCachePut(w, &elinkp->expected_mtu2, sizeof(elinkp->expected_mtu2));
+		TopologyCachePut(w, &elinkp->internal, sizeof(elinkp->internal));
+		TopologyCachePut(w, &elinkp->lineno, sizeof(elinkp->lineno));
+		TopologyCachePutStr(w, elinkp->details);
+		TopologyCachePutStr(w, elinkp->CableData.length);
+		TopologyCachePutStr(w, elinkp->CableData.label);
+		TopologyCachePutStr(w, elinkp->CableData.details);
+		TopologyCachePut(w, &ports, sizeof(ports));
+		if (elinkp->portselp1)
+			TopologyCachePutPortSelector(w, elinkp->portselp1, indexp);
+		if (elinkp->portselp2)
+			TopologyCachePutPortSelector(w, elinkp->portselp2, indexp);
+	}
+}
+
+// save the ExpectedNodes and ExpectedLinks of fabricp in cache_file
+// failures are silent, the next run will simply parse input again
+static void TopologyCacheSave(const char *cache_file, FabricData_t *fabricp,
+				TopoVal_t validation, uint64 file_size, uint64 file_hash)
+{
+	TopologyCacheHeader_t header;
+	TopologyCacheIndex_t *index;
+	cl_qmap_t indexMap;
+	LIST_ITEM *it;
+	uint32 i = 0;
+	char tmp_file[PATH_MAX];
+	TopologyCacheWriter_t w;
+	int err;
+
+	MemoryClear(&header, sizeof(header));
+	header.magic = TOPOLOGY_CACHE_MAGIC;
+	header.version = TOPOLOGY_CACHE_VERSION;
+	header.validation = validation;
+	header.flags = fabricp->flags & TOPOLOGY_CACHE_FLAGS;
+	header.file_size = file_size;
+	header.file_hash = file_hash;
+	header.FICount = QListCount(&fabricp->ExpectedFIs);
+	header.SWCount = QListCount(&fabricp->ExpectedSWs);
+	header.LinkCount = QListCount(&fabricp->ExpectedLinks);
+	snprintf(header.plane, sizeof(header.plane), "%s", fabricp->name);
+
+	index = (TopologyCacheIndex_t*)MemoryAllocate2AndClear(
+				sizeof(TopologyCacheIndex_t)*(header.FICount+header.SWCount+1),
+				IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	if (! index)
+		return;
+	cl_qmap_init(&indexMap, NULL);
+	for (it = QListHead(&fabricp->ExpectedFIs); it != NULL; it = QListNext(&fabricp->ExpectedFIs, it)) {
+		index[i].index = i+1;
+		cl_qmap_insert(&indexMap, (uint64)(uintn)QListObj(it), &index[i].IndexMapEntry);
+		i++;
+	}
+	for (it = QListHead(&fabricp->ExpectedSWs); it != NULL; it = QListNext(&fabricp->ExpectedSWs, it)) {
+		index[i].index = i+1;
+		cl_qmap_insert(&indexMap, (uint64)(uintn)QListObj(it), &index[i].IndexMapEntry);
+		i++;
+	}
+
+	// write a temporary file and rename, so a reader never sees a partial one
+	snprintf(tmp_file, sizeof(tmp_file), "%s.%d", cache_file, (int)getpid());
+	w.f = fopen(tmp_file, "w");
+	if (! w.f) {
+		MemoryDeallocate(index);
+		return;
+	}
+	w.hash = TOPOLOGY_HASH_INIT;
+	TopologyCachePut(&w, &header, sizeof(header));
+	TopologyCachePutNodes(&w, &fabricp->ExpectedFIs);
+	TopologyCachePutNodes(&w, &fabricp->ExpectedSWs);
+	TopologyCachePutLinks(&w, fabricp, &indexMap);
+	// trailer is a hash of all the above, to detect a damaged cache
+	(void)fwrite(&w.hash, sizeof(w.hash), 1, w.f);
+	err = ferror(w.f);
+	if (fclose(w.f) || err || rename(tmp_file, cache_file))
+		(void)unlink(tmp_file);
+	MemoryDeallocate(index);
+}
+
+static ExpectedNode *TopologyCacheGetNode(TopologyCacheReader_t *r)
+{
+	ExpectedNode *enodep;
+	uint16 count;
+	uint16 i;
+
+	enodep = (ExpectedNode*)MemoryAllocate2AndClear(sizeof(ExpectedNode), IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	if (! enodep) {
+		r->error = TRUE;
+		return NULL;
+	}
+	ListItemInitState(&enodep->ExpectedNodesEntry);
+	QListSetObj(&enodep->ExpectedNodesEntry, enodep);
+	TopologyCacheGet(r, &enodep->NodeGUID, sizeof(enodep->NodeGUID));
+	TopologyCacheGet(r, &enodep->SystemImageGUID, sizeof(enodep->SystemImageGUID));
+	TopologyCacheGet(r, &enodep->NodeType, sizeof(enodep->NodeType));
+	TopologyCacheGet(r, &enodep->connected, sizeof(enodep->connected));
+	TopologyCacheGet(r, &enodep->lineno, sizeof(enodep->lineno));
+	enodep->NodeDesc = TopologyCacheGetStr(r);
+	enodep->details = TopologyCacheGetStr(r);
+	TopologyCacheGet(r, &count, sizeof(count));
+	for (i = 0; i < count && ! r->error; i++) {
+		ExpectedPort *eportp = MemoryAllocate2AndClear(sizeof(ExpectedPort),
+			IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+
+		if (! eportp) {
+			r->error = TRUE;
+			break;
+		}
+		TopologyCacheGet(r, &eportp->PortNum, sizeof(eportp->PortNum));
+		TopologyCacheGet(r, &eportp->lid, sizeof(eportp->lid));
+		TopologyCacheGet(r, &eportp->PortGuid, sizeof(eportp->PortGuid));
+		eportp->PortId = TopologyCacheGetStr(r);
+		if (r->error || FSUCCESS != ExpectedNodeAddPort(enodep, eportp)) {
+			if (eportp->PortId)
+				MemoryDeallocate(eportp->PortId);
+			MemoryDeallocate(eportp);
+			r->error = TRUE;
+		}
+	}
+	return enodep;
+}
+
+static PortSelector *TopologyCacheGetPortSelector(TopologyCacheReader_t *r,
+				ExpectedNode **enodes, uint32 enodeCount)
+{
+	PortSelector *portselp;
+	uint32 index;
+
+	portselp = (PortSelector*)MemoryAllocate2AndClear(sizeof(PortSelector), IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	if (! portselp) {
+		r->error = TRUE;
+		return NULL;
+	}
+	TopologyCacheGet(r, &portselp->PortGUID, sizeof(portselp->PortGUID));
+	TopologyCacheGet(r, &portselp->NodeGUID, sizeof(portselp->NodeGUID));
+	TopologyCacheGet(r, &portselp->PortNum, sizeof(portselp->PortNum));
+	TopologyCacheGet(r, &portselp->gotPortNum, sizeof(portselp->gotPortNum));
+	TopologyCacheGet(r, &portselp->NodeType, sizeof(portselp->NodeType));
+	portselp->PortId = TopologyCacheGetStr(r);
+	portselp->NodeDesc = TopologyCacheGetStr(r);
+	portselp->details = TopologyCacheGetStr(r);
+	TopologyCacheGet(r, &index, sizeof(index));
+	if (index > enodeCount)
+		r->error = TRUE;
+	else if (index)
+		portselp->enodep = enodes[index-1];
+	return portselp;
+}
+
+// restore the ExpectedPort.elinkp TopologyValidate set for each link end
+static boolean TopologyCacheLinkPort(ExpectedLink *elinkp, PortSelector *portselp)
+{
+	ExpectedPort *eportp;
+
+	if (! portselp || ! portselp->enodep)
+		return TRUE;
+	eportp = ExpectedNodeGetPort(portselp->enodep, portselp->PortNum);
+	if (! eportp || eportp->elinkp)
+		return FALSE;
+	eportp->elinkp = elinkp;
+	return TRUE;
+}
+
+static ExpectedLink *TopologyCacheGetLink(TopologyCacheReader_t *r,
+				ExpectedNode **enodes, uint32 enodeCount)
+{
+	ExpectedLink *elinkp;
+	uint8 ports = 0;
+
+	elinkp = (ExpectedLink*)MemoryAllocate2AndClear(sizeof(ExpectedLink), IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	if (! elinkp) {
+		r->error = TRUE;
+		return NULL;
+	}
+	ListItemInitState(&elinkp->ExpectedLinksEntry);
+	QListSetObj(&elinkp->ExpectedLinksEntry, elinkp);
+	TopologyCacheGet(r, &elinkp->expected_rate, sizeof(elinkp->expected_rate));
+	TopologyCacheGet(r, &elinkp->expected_mtu, sizeof(elinkp->expected_mtu));
+	TopologyCacheGet(r, &elinkp->expected_mtu2, sizeof(elinkp->expected_mtu2));
+	TopologyCacheGet(r, &elinkp->internal, sizeof(elinkp->internal));
+	TopologyCacheGet(r, &elinkp->lineno, sizeof(elinkp->lineno));
+	elinkp->details = TopologyCacheGetStr(r);
+	elinkp->CableData.length = TopologyCacheGetStr(r);
+	elinkp->CableData.label = TopologyCacheGetStr(r);
+	elinkp->CableData.details = TopologyCacheGetStr(r);
+	TopologyCacheGet(r, &ports, sizeof(ports));
+	if (ports & 1)
+		elinkp->portselp1 = TopologyCacheGetPortSelector(r, enodes, enodeCount);
+	if (ports & 2)
+		elinkp->portselp2 = TopologyCacheGetPortSelector(r, enodes, enodeCount);
+	if (! r->error
+		&& (! TopologyCacheLinkPort(elinkp, elinkp->portselp1)
+			|| ! TopologyCacheLinkPort(elinkp, elinkp->portselp2)))
+		r->error = TRUE;
+	return elinkp;
+}
+
+// load the ExpectedNodes and ExpectedLinks saved by TopologyCacheSave
+// returns FNOT_FOUND if cache_file is missing, stale or unusable, in which
+// case nothing is added to fabricp
+static FSTATUS TopologyCacheLoad(const char *cache_file, FabricData_t *fabricp,
+				TopoVal_t validation, uint64 file_size, uint64 file_hash)
+{
+	TopologyCacheHeader_t header;
+	TopologyCacheReader_t r;
+	ExpectedNode **enodes = NULL;
+	uint32 enodeCount = 0;
+	uint32 i;
+	uint64 hash;
+	struct stat st;
+	const uint8 *base;
+	int fd;
+
+	fd = open(cache_file, O_RDONLY);
+	if (fd < 0)
+		return FNOT_FOUND;
+	if (fstat(fd, &st) < 0 || ! S_ISREG(st.st_mode)
+		|| st.st_size < (off_t)(sizeof(header)+sizeof(hash))) {
+		close(fd);
+		return FNOT_FOUND;
+	}
+	base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+		return FNOT_FOUND;
+	r.p = base;
+	r.end = base + st.st_size - sizeof(hash);
+	r.error = FALSE;
+	MemoryCopy(&hash, r.end, sizeof(hash));
+	if (hash != TopologyHash(base, st.st_size - sizeof(hash), TOPOLOGY_HASH_INIT))
+		goto fail;
+
+	TopologyCacheGet(&r, &header, sizeof(header));
+	if (header.magic != TOPOLOGY_CACHE_MAGIC
+		|| header.version != TOPOLOGY_CACHE_VERSION
+		|| header.validation != validation
+		|| header.file_size != file_size
+		|| header.file_hash != file_hash
+		|| header.plane[sizeof(header.plane)-1] != '\0')
+		goto fail;
+
+	enodes = (ExpectedNode**)MemoryAllocate2AndClear(
+				sizeof(ExpectedNode*)*(header.FICount+header.SWCount+1),
+				IBA_MEM_FLAG_PREMPTABLE, MYTAG);
+	if (! enodes)
+		goto fail;
+	for (i = 0; i < header.FICount + header.SWCount && ! r.error; i++) {
+		QUICK_LIST *listp = (i < header.FICount) ? &fabricp->ExpectedFIs : &fabricp->ExpectedSWs;
+		ExpectedNode *enodep = TopologyCacheGetNode(&r);
+
+		if (! enodep)
+			break;
+		QListInsertTail(listp, &enodep->ExpectedNodesEntry);
+		if (enodep->NodeGUID)
+			cl_qmap_insert(&fabricp->ExpectedNodeGuidMap, enodep->NodeGUID, &enodep->ExpectedNodeGuidMapEntry);
+		enodes[enodeCount++] = enodep;
+	}
+	for (i = 0; i < header.LinkCount && ! r.error; i++) {
+		ExpectedLink *elinkp = TopologyCacheGetLink(&r, enodes, enodeCount);
+
+		if (! elinkp)
+			break;
+		QListInsertTail(&fabricp->ExpectedLinks, &elinkp->ExpectedLinksEntry);
+	}
+	if (r.error || r.p != r.end)
+		goto fail;
+
+	// same handling of plane attribute as TopologyXmlParserStart
+	if (fabricp->name[0] && strncmp(fabricp->name, header.plane, HPN_NODE_COMMUNITY_ARRAY_SIZE))
+		fprintf(stderr, "Warning: Mismatched plane: expect '%s', actual '%s'\n",
+				fabricp->name, header.plane);
 	else
+		snprintf(fabricp->name, HPN_NODE_COMMUNITY_ARRAY_SIZE, "%s", header.plane);
+	fabricp->flags |= header.flags & TOPOLOGY_CACHE_FLAGS;
+
+	MemoryDeallocate(enodes);
+	munmap((void*)base, st.st_size);
+	return FSUCCESS;
+
+fail:
+	// nothing has been resolved against the fabric yet
+	ExpectedLinkFreeAll(fabricp);
+	ExpectedNodesFreeAll(fabricp, &fabricp->ExpectedFIs);
+	ExpectedNodesFreeAll(fabricp, &fabricp->ExpectedSWs);
+	if (enodes)
+		MemoryDeallocate(enodes);
+	munmap((void*)base, st.st_size);
+	return FNOT_FOUND;
+}
+
+// resolve a topology loaded from the cache against the fabric, in the order
+// LinkXmlParserEnd, ExpectedFIXmlParserEnd and ExpectedSWXmlParserEnd would
+// have while parsing, since the 1st ExpectedNode or best ExpectedLink
+// resolved to a given NodeData or PortData is the one associated with it
+static void TopologyCacheResolve(FabricData_t *fabricp)
+{
+	LIST_ITEM *fi = QListHead(&fabricp->ExpectedFIs);
+	LIST_ITEM *sw = QListHead(&fabricp->ExpectedSWs);
+	LIST_ITEM *it;
+
+	while (fi || sw) {
+		ExpectedNode *enodep_fi = fi ? PARENT_STRUCT(fi, ExpectedNode, ExpectedNodesEntry) : NULL;
+		ExpectedNode *enodep_sw = sw ? PARENT_STRUCT(sw, ExpectedNode, ExpectedNodesEntry) : NULL;
+
+		if (enodep_fi && (! enodep_sw || enodep_fi->lineno <= enodep_sw->lineno)) {
+			ResolveNode(fabricp, enodep_fi);
+			fi = QListNext(&fabricp->ExpectedFIs, fi);
+		} else {
+			ResolveNode(fabricp, enodep_sw);
+			sw = QListNext(&fabricp->ExpectedSWs, sw);
+		}
+	}
+	for (it = QListHead(&fabricp->ExpectedLinks); it != NULL; it = QListNext(&fabricp->ExpectedLinks, it))
+		ResolvePorts(fabricp, PARENT_STRUCT(it, ExpectedLink, ExpectedLinksEntry));
+}
+
+FSTATUS Xml2ParseTopologyCached(const char *input_file, const char *cache_file,
+				int quiet, FabricData_t *fabricp, TopoVal_t validation)
+{
+	unsigned tags_found, fields_found;
+	IXmlParserState_t state;
+	uint64 file_hash;
+	boolean clean = TRUE;
+	boolean warned;
+	const char *base;
+	struct stat st;
+	FSTATUS status;
+	int fd;
+
+	// the cache is only used for a topology_input file parsed into
+	// an otherwise empty set of ExpectedNodes and ExpectedLinks
+	if (! cache_file || strcmp(input_file, "-") == 0
+		|| fabricp == NULL || fabricp->AllNodes.state != CL_INITIALIZED
+		|| QListCount(&fabricp->ExpectedLinks)
+		|| QListCount(&fabricp->ExpectedFIs)
+		|| QListCount(&fabricp->ExpectedSWs))
+		return Xml2ParseTopology(input_file, quiet, fabricp, validation);
+
+	fd = open(input_file, O_RDONLY);
+	if (fd < 0)
+		return Xml2ParseTopology(input_file, quiet, fabricp, validation);	// reports the error
+	if (fstat(fd, &st) < 0 || ! S_ISREG(st.st_mode) || ! st.st_size) {
+		close(fd);
+		return Xml2ParseTopology(input_file, quiet, fabricp, validation);
+	}
+	base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+		return Xml2ParseTopology(input_file, quiet, fabricp, validation);
+	file_hash = TopologyHash(base, st.st_size, TOPOLOGY_HASH_INIT);
+
+	if (FSUCCESS == TopologyCacheLoad(cache_file, fabricp, validation, st.st_size, file_hash)) {
+		if (! quiet) ProgressPrint(TRUE, "Using cached %s...", Top_truncate_str(input_file));
+		NodeNameIndexBuild(fabricp);
+		TopologyCacheResolve(fabricp);
+		NodeNameIndexFree();
+		// only clean validations are cached, so all links were resolved
+		if (! quiet && TOPOVAL_NONE != validation)
+			fprintf(stderr, "%u of %u Input Links Checked, %u Resolved, %u Bad Input Skipped\n",
+				QListCount(&fabricp->ExpectedLinks), QListCount(&fabricp->ExpectedLinks),
+				QListCount(&fabricp->ExpectedLinks), 0);
+		munmap((void*)base, st.st_size);
 		return FSUCCESS;
+	}
+
+	// parse the contents we hashed, so the cache matches what was parsed
+	if (! quiet) ProgressPrint(TRUE, "Parsing %s...", Top_truncate_str(input_file));
+	if (FSUCCESS != IXmlParserInit(&state, IXML_PARSER_FLAG_NONE, TopLevelFields, NULL, fabricp, NULL, NULL, NULL)) {
+		fprintf(stderr, "Couldn't initialize parser\n");
+		munmap((void*)base, st.st_size);
+		return FERROR;
+	}
+	NodeNameIndexBuild(fabricp);
+	if (FSUCCESS != IXmlParserReadBuffer(&state, base, st.st_size, TRUE)
+		|| FSUCCESS != IXmlParserCheckSubfields(&state, &tags_found, &fields_found)) {
+		IXmlParserPrintError(&state, "Fatal error parsing file '%s'", input_file);
+		IXmlParserDestroy(&state);
+		NodeNameIndexFree();
+		munmap((void*)base, st.st_size);
+		return FERROR;
+	}
+	warned = (state.warning_cnt || state.error_cnt);
+	IXmlParserDestroy(&state);
+	NodeNameIndexFree();
+	munmap((void*)base, st.st_size);
+
+	if (tags_found != 1 || fields_found != 1) {
+		fprintf(stderr, "Warning: potentially inaccurate input '%s': found %u recognized top level tags, expected 1\n", input_file, tags_found);
+		warned = TRUE;
+	}
+	if(TOPOVAL_NONE != validation)
+		status = TopologyValidate(fabricp, quiet, validation, &clean);
+	else
+		status = FSUCCESS;
+	// a cache hit would not repeat any messages, so only cache a clean input
+	if (FSUCCESS == status && clean && ! warned)
+		TopologyCacheSave(cache_file, fabricp, validation, st.st_size, file_hash);
+	return status;
 }
+#endif /* __VXWORKS__ */
 
 static void *DummyParserStart(IXmlParserState_t *state _UNUSED_, void *parent _UNUSED_, const char **attr _UNUSED_)
 {
@@ -141,6 +141,13 @@ typedef struct PortData_s {
 			uint32		recvAllPaths;
 			uint32		xmitAllPaths;
 		} routes;			// for TabulateRoutes of any topology
+		struct {
+			uint8		portProblems;	// discrepancies of this port vs input
+			// fields below only valid for "from" port in link
+			uint8		linkProblems;	// discrepancies of link attributes
+			uint8		result;			// overall result for link
+			uint8		flags;			// classification of link for reports
+		} verify;			// for verification of links against input topology
 	} analysisData;	// per port holding space for transient analysis data
 	STL_BUFFER_CONTROL_TABLE *pBufCtrlTable;
 	// 128 table entries allocate when needed
@@ -202,6 +209,11 @@ typedef struct ExpectedLink_s {
 	char *details;	// user description of link
 	CableData CableData;	// user supplied info about cable
 	uint64	lineno;	// line number in XML of starting tag, for error messages
+	struct {
+		uint8 result;	// overall result for link
+		uint8 problems;	// discrepancies of link vs fabric
+		uint8 flags;	// classification of link for reports
+	} verify;	// holding space for transient verification against fabric
 } ExpectedLink;
 
 /*
@@ -564,6 +576,34 @@ typedef struct SnmpNodeConfigParamData_s {
 	uint8 NodeType;
 } SnmpNodeConfigParamData_t;
 
+// SNMP sweep telemetry, per OID column queried from a host
+#define SNMP_STATS_MAX_COLUMNS	64
+typedef struct SnmpColumnStats_s {
+	const char *oid;			// OID of the column as queried
+	uint32 requests;			// PDUs sent, including GETBULK continuations
+	uint32 vars;				// variables returned
+	uint32 maxLatency;			// slowest response in usec
+	uint64 latency;				// total response time in usec
+} SnmpColumnStats_t;
+
+// SNMP sweep telemetry, per host queried by the last sweep
+typedef struct SnmpHostStats_s {
+	char name[STL_NODE_DESCRIPTION_ARRAY_SIZE+1];
+	uint8 nodeType;				// STL_NODE_FI or STL_NODE_SW
+	char sysObjectID[HPN_NODE_COMMUNITY_ARRAY_SIZE];	// model, "" if unknown
+	uint32 connectTime;			// usec in snmp_open, SNMPv3 engine discovery
+	uint32 totalTime;			// usec from first request to last response
+	uint32 processTime;			// usec of phase 1 (per host) data processing
+	uint32 requests;			// PDUs sent
+	uint32 responses;			// PDUs received
+	uint32 vars;				// variables received
+	uint64 bytes;				// value bytes received
+	uint32 timeouts;			// requests which timed out after all retries
+	uint32 retries;				// retransmissions
+	uint32 numColumns;
+	SnmpColumnStats_t columns[SNMP_STATS_MAX_COLUMNS];
+} SnmpHostStats_t;
+
 typedef enum {
 	FF_NONE				=0,
 	FF_STATS			=0x000000001,	// PortCounters fetched
@@ -664,6 +704,14 @@ typedef struct FabricData_s {
 	char SnmpAuthenticationPassphrase[HPN_NODE_COMMUNITY_ARRAY_SIZE];
 	char SnmpEncryptionProtocol[HPN_NODE_COMMUNITY_ARRAY_SIZE];
 	char SnmpEncryptionPassphrase[HPN_NODE_COMMUNITY_ARRAY_SIZE];
+	const char *SnmpFocus;			// node:/nodepat: focus limiting the sweep
+								// to matching hosts and their neighbors
+	boolean SnmpFocusLimitStats;	// only query counters of focused hosts
+	boolean SnmpCountersOnly;	// only refresh counters of the cached topology,
+								// cleared by the sweep if the cache is stale
+	SnmpHostStats_t *SnmpStats;	// telemetry of the last SNMP sweep, one entry
+								// per configured host, NULL if not swept
+	uint32 SnmpStatsCount;
 } FabricData_t;
 
 // these callbacks are called when an object with a non-null application
@@ -1214,6 +1262,12 @@ typedef enum {
 									// in ExpectedNode in topology file
 #ifndef __VXWORKS__
 extern FSTATUS Xml2ParseTopology(const char *input_file, int quiet, FabricData_t *fabricp, TopoVal_t validation);
+// same as Xml2ParseTopology, but keeps the parsed and validated topology in
+// cache_file, keyed by the contents of input_file and validation.  When
+// input_file is unchanged, later calls load cache_file instead of parsing and
+// validating input_file again, only resolving it against the fabric.
+// If cache_file is NULL or input_file is stdin, no cache is used.
+extern FSTATUS Xml2ParseTopologyCached(const char *input_file, const char *cache_file, int quiet, FabricData_t *fabricp, TopoVal_t validation);
 #else
 extern FSTATUS Xml2ParseTopology(const char *input_file, int quiet, FabricData_t *fabricp, XML_Memory_Handling_Suite* memsuite, TopoVal_t validation);
 #endif
@@ -1234,6 +1288,14 @@ typedef enum {
 } SweepFlags_t;
 
 extern FSTATUS Sweep(EUI64 portGuid, FabricData_t *fabricp, FabricFlags_t fflags, SweepFlags_t flags, int quiet, int ms_timeout, void *cparamsp);
+// same as Sweep, but when focus is a node: or nodepat: focus only the matching
+// hosts and their one hop LLDP neighbors are swept.  With limitstats counters
+// are only queried for the matching hosts.  Other focus formats sweep all hosts
+extern FSTATUS SweepFocused(EUI64 portGuid, FabricData_t *fabricp, FabricFlags_t fflags, SweepFlags_t flags, int quiet, int ms_timeout, void *cparamsp, const char *focus, boolean limitstats);
+// refresh only the port counters of a fabric read earlier (typically from a
+// snapshot).  If the fabric has changed since, fabricp is replaced by a full
+// sweep with FF_STATS
+extern FSTATUS SweepCounters(EUI64 portGuid, FabricData_t *fabricp, FabricFlags_t fflags, SweepFlags_t flags, int quiet, int ms_timeout, void *cparamsp);
 
 //extern FSTATUS GetPathToPort(EUI64 portGuid, PortData *portp, uint16 pkey);
 extern FSTATUS GetPaths(struct omgt_port *port, PortData *portp1, PortData *portp2,
@@ -1613,6 +1675,10 @@ extern PortData *FIPortIteratorHead(FIPortIterator *pFIPortIterator, Point *pFoc
 extern PortData *FIPortIteratorNext(FIPortIterator *pFIPortIterator);
 
 extern void setTopologySnmpVerbose(FILE* file, uint8 level);
+// record every SNMP request and response of a sweep to file, see ethsnmpsim
+extern void setTopologySnmpCapture(FILE* file);
+// write fabricp->SnmpStats to file, as CSV if file ends in .csv else as JSON
+extern FSTATUS WriteSnmpSweepStats(FabricData_t *fabricp, const char *file);
 
 #ifdef __cplusplus
 };
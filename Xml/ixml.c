@@ -785,15 +785,12 @@ static void IXmlParserPush(IXmlParserState_t *state)
 	ASSERT(state->stack.sp < STACK_DEPTH-1);
 	state->stack.entries[state->stack.sp] = state->current;
 	state->stack.sp++;
-	state->current.tag = NULL;	// be paranoid and ensure no double reference
 }
 
 static void IXmlParserPop(IXmlParserState_t *state)
 {
 	ASSERT(state->stack.sp >= 1);
 	state->stack.sp--;
-	if (state->current.tag)
-		free(state->current.tag);
 	state->current = state->stack.entries[state->stack.sp];
 }
 
@@ -1257,7 +1254,7 @@ IXmlParserStartTag(void *data, const char *el _UNUSED_, const char **attr)
 
 // verify manditory subfields (and don't permit contents on tags with subfields)
 // tags_found and fields_found optionally return counts (0 if no subfields)
-static FSTATUS
+FSTATUS
 IXmlParserCheckSubfields(IXmlParserState_t *state,
 							unsigned *tags_found, unsigned *fields_found)
 {
@@ -1311,21 +1308,31 @@ IXmlParserCheckSubfields(IXmlParserState_t *state,
 	return ret;
 }
 
+// for c, p, s, t and w formats we keep leading and trailing spaces
+// we know we output these tags without any extra spaces
+static _inline boolean IXmlFormatKeepsSpaces(char format)
+{
+	switch (format) {
+	case 'c': case 'C':
+	case 'p': case 'P':
+	case 's': case 'S':
+	case 't': case 'T':
+	case 'w': case 'W':
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
 static void XMLCALL
 IXmlParserEndTag(void *data, const char *el _UNUSED_)
 {
 	IXmlParserState_t *state = (IXmlParserState_t *) data;
 
-	// for c, p, s, t and w formats we keep leading and trailing spaces
-	// we know we output these tags without any extra spaces
 	// if tag had child tags, we also discard whitespace
 	if (state->len
 		&& (state->current.tags_found
-			|| (tolower(state->current.field->format) != 'c'
-				&& tolower(state->current.field->format) != 'p'
-				&& tolower(state->current.field->format) != 's'
-				&& tolower(state->current.field->format) != 't'
-				&& tolower(state->current.field->format) != 'w'))) {
+			|| ! IXmlFormatKeepsSpaces(state->current.field->format))) {
 		IXmlParserTrimWhitespace(state);
 	}
 
@@ -1353,18 +1360,179 @@ IXmlParserEndTag(void *data, const char *el _UNUSED_)
 		}
 	}
 
-	if (state->content) {
-		free(state->content);
-		state->content = NULL;
-		state->len = 0;
+	// content_buf is kept for the next element
+	state->content = NULL;
+	state->len = 0;
+}
+
+/* Tag lookup.
+ * Each IXML_FIELD table is hashed by tag the first time a parser looks up a
+ * child tag in it, and kept until IXmlParserDestroy.  The current tag name
+ * points to the field's static tag, only tags matched by a "*" field are
+ * copied, once per distinct name, into the parser's intern table.
+ */
+#define IXML_INDEX_BUCKETS	64		/* field tables per parser, power of 2 */
+#define IXML_INTERN_BUCKETS	256		/* distinct "*" tags, power of 2 */
+
+typedef struct IXmlFieldIndex {
+	struct IXmlFieldIndex *next;	/* next table in same bucket */
+	const IXML_FIELD *subfields;	/* table indexed */
+	int wildcard;					/* index of first "*" field, -1 if none */
+	unsigned mask;					/* slots - 1, slots is a power of 2 */
+	int *slots;						/* field index, -1 if empty */
+} IXmlFieldIndex_t;
+
+typedef struct IXmlInternTag {
+	struct IXmlInternTag *next;		/* next tag in same bucket */
+	char tag[1];					/* allocated to fit */
+} IXmlInternTag_t;
+
+typedef struct IXmlParserIndex {
+	IXmlFieldIndex_t *tables[IXML_INDEX_BUCKETS];
+	IXmlInternTag_t *tags[IXML_INTERN_BUCKETS];
+} IXmlParserIndex_t;
+
+static _inline unsigned IXmlHashTag(const char *tag)
+{
+	unsigned hash = 2166136261U;	/* FNV-1a */
+
+	while (*tag)
+		hash = (hash ^ (unsigned char)*tag++) * 16777619U;
+	return hash;
+}
+
+static _inline unsigned IXmlHashTable(const IXML_FIELD *subfields)
+{
+	return (unsigned)(((uintptr_t)subfields >> 4) & (IXML_INDEX_BUCKETS-1));
+}
+
+static IXmlFieldIndex_t *IXmlBuildFieldIndex(const IXML_FIELD *subfields)
+{
+	IXmlFieldIndex_t *index;
+	unsigned count, slots, i, h;
+
+	for (count = 0; subfields[count].tag; count++)
+		;
+	for (slots = 4; slots < count * 2; slots <<= 1)
+		;
+	index = (IXmlFieldIndex_t *)malloc(sizeof(*index) + slots * sizeof(int));
+	if (! index)
+		return NULL;
+	index->next = NULL;
+	index->subfields = subfields;
+	index->wildcard = -1;
+	index->mask = slots - 1;
+	index->slots = (int *)(index + 1);
+	for (i = 0; i < slots; i++)
+		index->slots[i] = -1;
+	for (i = 0; i < count; i++) {
+		if (strcmp(subfields[i].tag, "*") == 0) {
+			if (index->wildcard < 0)
+				index->wildcard = i;
+			continue;
+		}
+		// first of duplicate tags wins, as with a linear search
+		for (h = IXmlHashTag(subfields[i].tag) & index->mask;
+			index->slots[h] >= 0
+				&& strcmp(subfields[index->slots[h]].tag, subfields[i].tag) != 0;
+			h = (h + 1) & index->mask)
+			;
+		if (index->slots[h] < 0)
+			index->slots[h] = i;
+	}
+	return index;
+}
+
+// find index of subfields, building it on first use
+static const IXmlFieldIndex_t *IXmlParserGetFieldIndex(IXmlParserState_t *state,
+						const IXML_FIELD *subfields)
+{
+	IXmlFieldIndex_t **bucket;
+	IXmlFieldIndex_t *index;
+
+	if (! state->index) {
+		state->index = (IXmlParserIndex_t *)calloc(1, sizeof(*state->index));
+		if (! state->index)
+			return NULL;
+	}
+	bucket = &state->index->tables[IXmlHashTable(subfields)];
+	for (index = *bucket; index; index = index->next) {
+		if (index->subfields == subfields)
+			return index;
+	}
+	index = IXmlBuildFieldIndex(subfields);
+	if (index) {
+		index->next = *bucket;
+		*bucket = index;
+	}
+	return index;
+}
+
+// index of field matching tag, same result as first match by a linear
+// search where "*" matches any tag, -1 if no match
+static int IXmlFieldIndexLookup(const IXmlFieldIndex_t *index, const char *tag)
+{
+	unsigned h;
+	int i;
+
+	for (h = IXmlHashTag(tag) & index->mask; (i = index->slots[h]) >= 0;
+		h = (h + 1) & index->mask) {
+		if (strcmp(index->subfields[i].tag, tag) == 0)
+			return (index->wildcard >= 0 && index->wildcard < i) ? index->wildcard : i;
 	}
+	return index->wildcard;
+}
+
+// return a copy of tag which lives until IXmlParserDestroy
+static const char *IXmlParserInternTag(IXmlParserState_t *state, const char *tag)
+{
+	IXmlInternTag_t **bucket = &state->index->tags[IXmlHashTag(tag) & (IXML_INTERN_BUCKETS-1)];
+	IXmlInternTag_t *p;
+	size_t len;
+
+	for (p = *bucket; p; p = p->next) {
+		if (strcmp(p->tag, tag) == 0)
+			return p->tag;
+	}
+	len = strlen(tag);
+	p = (IXmlInternTag_t *)malloc(sizeof(*p) + len);
+	if (! p)
+		return NULL;
+	memcpy(p->tag, tag, len+1);
+	p->next = *bucket;
+	*bucket = p;
+	return p->tag;
+}
+
+static void IXmlParserFreeIndex(IXmlParserState_t *state)
+{
+	unsigned i;
+
+	if (! state->index)
+		return;
+	for (i = 0; i < IXML_INDEX_BUCKETS; i++) {
+		while (state->index->tables[i]) {
+			IXmlFieldIndex_t *index = state->index->tables[i];
+			state->index->tables[i] = index->next;
+			free(index);
+		}
+	}
+	for (i = 0; i < IXML_INTERN_BUCKETS; i++) {
+		while (state->index->tags[i]) {
+			IXmlInternTag_t *p = state->index->tags[i];
+			state->index->tags[i] = p->next;
+			free(p);
+		}
+	}
+	free(state->index);
+	state->index = NULL;
 }
 
 static void
 IXmlParserRawStart(void *data, const char *el, const char **attr) {
 	IXmlParserState_t *state = (IXmlParserState_t *) data;
 	const IXML_FIELD *p;
-	unsigned i;
+	int i;
 
 #if DEBUG_IXML_PARSER
 	printf("start field %s\n", el);
@@ -1384,31 +1552,43 @@ IXmlParserRawStart(void *data, const char *el, const char **attr) {
 		return;
 	}
 	if (! state->skip && state->current.subfields) {
-		for (i=0,p=state->current.subfields; p->tag; p++,i++) {
-			if (strcmp(el, p->tag) == 0 || strcmp("*", p->tag) == 0) {
-				char *tagname;
-				if (i < 64)
-					state->current.fields_found |= ((uint64)1)<<i;
-				state->current.tags_found++;
+		if (! state->current.subfields_index) {
+			state->current.subfields_index =
+				IXmlParserGetFieldIndex(state, state->current.subfields);
+			if (! state->current.subfields_index) {
+				IXmlParserPrintError(state, "Unable to allocate memory");
+				return;
+			}
+		}
+		i = IXmlFieldIndexLookup(state->current.subfields_index, el);
+		if (i >= 0) {
+			const char *tagname;
+
+			p = &state->current.subfields[i];
+			if (i < 64)
+				state->current.fields_found |= ((uint64)1)<<i;
+			state->current.tags_found++;
 #if DEBUG_IXML_PARSER
-				printf("tags_found=%u fields_found=0x%"PRIx64"\n", state->current.tags_found, state->current.fields_found);
+			printf("tags_found=%u fields_found=0x%"PRIx64"\n", state->current.tags_found, state->current.fields_found);
 #endif
-				tagname = strdup(el);
+			if (strcmp(p->tag, el) == 0) {
+				tagname = p->tag;
+			} else {
+				tagname = IXmlParserInternTag(state, el);
 				if (! tagname) {
 					IXmlParserPrintError(state, "Unable to allocate memory");
 					return;
 				}
-				IXmlParserPush(state);
-				state->current.tag = tagname;
-				state->current.field = p;
-				state->current.subfields = p->subfields;
-				state->current.fields_found = 0;
-				state->current.tags_found = 0;
-				IXmlParserStartTag(state, state->current.tag, attr);   /* rest of start handling */
-				break;
 			}
-		}
-		if (!p->tag) {
+			IXmlParserPush(state);
+			state->current.tag = tagname;
+			state->current.field = p;
+			state->current.subfields = p->subfields;
+			state->current.subfields_index = NULL;
+			state->current.fields_found = 0;
+			state->current.tags_found = 0;
+			IXmlParserStartTag(state, state->current.tag, attr);   /* rest of start handling */
+		} else {
 			/* unknown tag, skip it and child tags */
 			if (state->flags & IXML_PARSER_FLAG_STRICT) {
 				IXmlParserPrintWarning(state, "Unexpected tag ignored: %s", el);
@@ -1436,34 +1616,41 @@ IXmlParserRawEnd(void *data, const char *el) {
 		state->skip = 0;
 }
 
+#define IXML_CONTENT_MIN_SIZE	256	/* initial characters in content_buf */
+
 static void
 IXmlParserCharHandler(void *data, const XML_Char *buf, int len)
 {
 	IXmlParserState_t *state = (IXmlParserState_t *) data;
 
-	// for c, p, s, t and w formats we keep leading and trailing spaces
-	// we know we output these tags without any extra spaces
 	if (! state->content
-		&& tolower(state->current.field->format) != 'c'
-		&& tolower(state->current.field->format) != 'p'
-		&& tolower(state->current.field->format) != 's'
-		&& tolower(state->current.field->format) != 't'
-		&& tolower(state->current.field->format) != 'w') {
-		/* skip leading spaces */
+		&& ! IXmlFormatKeepsSpaces(state->current.field->format)) {
+		/* skip leading spaces, typically a whole chunk of indentation */
 		while (len && isspace(*buf)) {
 			buf++; len--;
 		}
 	}
-	if (len) {
-		state->content = realloc(state->content, (state->len + len + 1)*sizeof(XML_Char));
-		if (state->content) {
-			MemoryCopy(state->content+state->len, buf, len);
-			state->len += len;
-			state->content[state->len] = 0;
-		} else {
+	if (! len)
+		return;
+	if (state->len + len + 1 > state->content_size) {
+		// grow geometrically, expat may deliver content in many small chunks
+		unsigned size = state->content_size ? state->content_size : IXML_CONTENT_MIN_SIZE;
+		XML_Char *p;
+
+		while (size < state->len + len + 1)
+			size *= 2;
+		p = realloc(state->content_buf, size*sizeof(XML_Char));
+		if (! p) {
 			(state->printError)("Couldn't allocate memory for content.");
+			return;
 		}
+		state->content_buf = p;
+		state->content_size = size;
 	}
+	state->content = state->content_buf;
+	MemoryCopy(state->content+state->len, buf, len*sizeof(XML_Char));
+	state->len += len;
+	state->content[state->len] = 0;
 }
 
 static void
@@ -1514,6 +1701,7 @@ IXmlParserInit(IXmlParserState_t *state, IXmlParserFlags_t flags, const IXML_FIE
 	state->current.tag = NULL;
 	state->current.field = NULL;
 	state->current.subfields = subfields;
+	state->current.subfields_index = NULL;
 	state->current.object = object;
 	state->current.fields_found = 0;
 	state->current.tags_found = 0;
@@ -1587,6 +1775,29 @@ FSTATUS IXmlParserReadFile(IXmlParserState_t *state, FILE *file)
 	return FSUCCESS;
 }
 
+/* largest piece handed to expat in one call, XML_Parse takes an int length */
+#define IXML_PARSE_MAX_PIECE	(1024*1024*1024)
+
+FSTATUS IXmlParserReadBuffer(IXmlParserState_t *state, const char *buf, size_t len, boolean done)
+{
+	for (;;) {
+		int n = (len > IXML_PARSE_MAX_PIECE) ? IXML_PARSE_MAX_PIECE : (int)len;
+		int last = done && (size_t)n == len;
+
+		if (XML_Parse(state->parser, buf, n, last) == XML_STATUS_ERROR) {
+			/* if IXmlParserFailed, we already output an error */
+			if (! IXmlParserFailed(state))
+				IXmlParserPrintErrorString(state);
+			return FINVALID_STATE;
+		}
+		buf += n;
+		len -= n;
+		if (! len)
+			break;
+	}
+	return FSUCCESS;
+}
+
 void
 IXmlParserDestroy(IXmlParserState_t *state) {
 
@@ -1607,9 +1818,14 @@ IXmlParserDestroy(IXmlParserState_t *state) {
 	XML_ParserFree(state->parser);
 	state->parser = NULL;	// make sure not used by mistake after destroy
 	state->context = NULL;	// make sure not used by mistake after destroy
-	if (state->current.tag)
-		free(state->current.tag);
 	state->current.tag = NULL;	// make sure not used by mistake after destroy
+	IXmlParserFreeIndex(state);
+	if (state->content_buf)
+		free(state->content_buf);
+	state->content_buf = NULL;
+	state->content = NULL;
+	state->content_size = 0;
+	state->len = 0;
 }
 
 #ifndef VXWORKS
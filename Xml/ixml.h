@@ -359,10 +359,14 @@ extern void IXmlOutputOptionalStruct(IXmlOutputState_t *state, const char *tag,
 /*****************************************************************************/
 /* XML Parser declarations */
 /* these structures should not be directly used by callers */
+struct IXmlFieldIndex;
+struct IXmlParserIndex;
+
 typedef struct IXmlParserStackEntry {
-	char *tag;				// locally allocated copy
+	const char *tag;		// field's tag or interned copy for "*" fields
 	const IXML_FIELD *field;
 	const IXML_FIELD *subfields;
+	const struct IXmlFieldIndex *subfields_index;	// NULL until first lookup
 	void *object;
 	unsigned tags_found;	// total subfield tags encountered including dups
 	uint64 fields_found;	// bit mask of indexes into subfields
@@ -386,14 +390,17 @@ typedef struct IXmlParserState {
 	unsigned	depth;	/* how many nested elements deep >= 1 */
 	unsigned 	skip;	/* skip all elements until we return to this depth */
 	IXmlParserStackEntry_t current; /* state of current element being parsed */
-	XML_Char *content;	/* text contents of current element */
+	XML_Char *content;	/* text contents of current element, NULL if none */
 	unsigned len;		/* number of characters in content */
+	XML_Char *content_buf;	/* buffer content points to, reused by elements */
+	unsigned content_size;	/* characters allocated in content_buf */
 	IXmlParserStack_t stack;	/* stack of parent elements' states */
 	unsigned error_cnt;
 	unsigned warning_cnt;
 	void *context;	/* caller supplied context */
 	IXmlParserPrintMessage printError;
 	IXmlParserPrintMessage printWarning;
+	struct IXmlParserIndex *index;	/* hashed field tables, interned tags */
 } IXmlParserState_t;
 
 /* get access to caller supplied context for input */
@@ -512,6 +519,16 @@ extern FSTATUS IXmlParserInit(IXmlParserState_t *state, IXmlParserFlags_t flags,
 				XML_Memory_Handling_Suite* memsuite);
 
 extern FSTATUS IXmlParserReadFile(IXmlParserState_t *state, FILE *file);
+/* parse a document held in memory.  May be called repeatedly with
+ * successive pieces of one document, done must be TRUE on the last piece
+ */
+extern FSTATUS IXmlParserReadBuffer(IXmlParserState_t *state, const char *buf,
+				size_t len, boolean done);
+/* verify mandatory subfields of the current tag, after the last piece of a
+ * document is parsed this gives the top level counts IXmlParseFile returns
+ */
+extern FSTATUS IXmlParserCheckSubfields(IXmlParserState_t *state,
+				unsigned *tags_found, unsigned *fields_found);
 extern void IXmlParserDestroy(IXmlParserState_t *state);
 
 #ifndef VXWORKS